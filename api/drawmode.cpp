@@ -22,224 +22,157 @@
 \*****************************************************************************/
 
 
+#include <algorithm>
 #include <limits>
 #include <time.h>
 #include <stdlib.h>
-#include <map>
 #include <math.h>
 
 #include "drawmode.h"
 
 using std::vector;
-using std::map;
+using std::pair;
 
-// LAST is the default method
-template <DrawModeMethod method>
-inline TSemanticValue selectMethod( vector<TSemanticValue>& v )
-{
-  return v[ v.size() -1 ];
-}
-
-template <>
-inline TSemanticValue selectMethod<DrawModeMethod::DRAW_MAXIMUM>( vector<TSemanticValue>& v )
+TSemanticValue DrawMode::selectValue( vector<TSemanticValue>& v,
+                                      DrawModeMethod method )
 {
-#if __cplusplus >= 201103L
-  TSemanticValue max = std::numeric_limits<TSemanticValue>::lowest();
-#else
-  TSemanticValue max = -std::numeric_limits<TSemanticValue>::max();
-#endif
+  DrawModeReducer tmpReducer( method );
 
   for( vector<TSemanticValue>::iterator it = v.begin(); it != v.end(); ++it )
-  {
-    if( *it > max ) max = *it;
-  }
+    tmpReducer.add( *it );
 
-  return max;
+  return tmpReducer.getValue();
 }
 
-template <>
-inline TSemanticValue selectMethod<DrawModeMethod::DRAW_MINNOTZERO>( vector<TSemanticValue>& v )
+
+DrawModeReducer::DrawModeReducer( DrawModeMethod whichMethod ) :
+  method( whichMethod )
 {
-  TSemanticValue min = std::numeric_limits<TSemanticValue>::max();
+  reset();
+}
 
-  for( vector<TSemanticValue>::iterator it = v.begin(); it != v.end(); ++it )
+void DrawModeReducer::reset()
+{
+  switch ( method )
   {
-    if( *it != 0.0 && *it < min ) min = *it;
-  }
+    case DrawModeMethod::DRAW_MAXIMUM:
+    case DrawModeMethod::DRAW_ABSOLUTE_MAXIMUM:
+#if __cplusplus >= 201103L
+      value = std::numeric_limits<TSemanticValue>::lowest();
+#else
+      value = -std::numeric_limits<TSemanticValue>::max();
+#endif
+      break;
 
-  if( min == std::numeric_limits<TSemanticValue>::max() )
-    return 0;
+    case DrawModeMethod::DRAW_MINNOTZERO:
+    case DrawModeMethod::DRAW_ABSOLUTE_MINNOTZERO:
+      value = std::numeric_limits<TSemanticValue>::max();
+      break;
 
-  return min;
-}
+    default:
+      value = 0.0;
+      break;
+  }
 
+  sum = 0.0;
+  count = 0;
+  values.clear();
+}
 
-template <>
-inline TSemanticValue selectMethod<DrawModeMethod::DRAW_ABSOLUTE_MINNOTZERO>( vector<TSemanticValue>& v )
+TSemanticValue DrawModeReducer::getValue()
 {
-   TSemanticValue min = std::numeric_limits<TSemanticValue>::max();
-
-  for( vector<TSemanticValue>::iterator it = v.begin(); it != v.end(); ++it )
+  switch ( method )
   {
-    if( *it != 0.0 && fabs(*it) < min ) min = *it;
-  }
+    case DrawModeMethod::DRAW_MINNOTZERO:
+    case DrawModeMethod::DRAW_ABSOLUTE_MINNOTZERO:
+      if( value == std::numeric_limits<TSemanticValue>::max() )
+        return 0;
+      return value;
 
-  if( min == std::numeric_limits<TSemanticValue>::max() )
-    return 0;
+    case DrawModeMethod::DRAW_RANDOM:
+      return getRandom( false );
 
-  return min;
-}
+    case DrawModeMethod::DRAW_RANDNOTZERO:
+      return getRandom( true );
 
+    case DrawModeMethod::DRAW_AVERAGE:
+      return sum / count;
 
+    case DrawModeMethod::DRAW_AVERAGENOTZERO:
+      if( count == 0 )
+        return 0.0;
+      return sum / count;
 
-template <>
-inline TSemanticValue selectMethod<DrawModeMethod::DRAW_ABSOLUTE_MAXIMUM>( vector<TSemanticValue>& v )
-{
-#if __cplusplus >= 201103L
-  TSemanticValue max = std::numeric_limits<TSemanticValue>::lowest();
-#else
-  TSemanticValue max = -std::numeric_limits<TSemanticValue>::max();
-#endif
+    case DrawModeMethod::DRAW_MODE:
+      return getMode();
 
-  for( vector<TSemanticValue>::iterator it = v.begin(); it != v.end(); ++it )
-  {
-    if( fabs(*it) > max ) max = *it;
+    default:
+      break;
   }
 
-  return max;
+  return value;
 }
 
-
-template <>
-inline TSemanticValue selectMethod<DrawModeMethod::DRAW_RANDOM>( vector<TSemanticValue>& v )
+TSemanticValue DrawModeReducer::getRandom( bool notZero ) const
 {
-  int pos;
-
-  pos = v.size() * rand() / RAND_MAX;
-  if( pos >= (int) v.size() )
-    pos = v.size() - 1;
-
-  return v[ pos ];
-}
+  if( values.empty() )
+    return 0;
 
-template <>
-inline TSemanticValue selectMethod<DrawModeMethod::DRAW_RANDNOTZERO>( vector<TSemanticValue>& v )
-{
   int pos;
 
-  pos = v.size() * rand() / RAND_MAX;
-  if( pos >= (int) v.size() )
-    pos = v.size() - 1;
+  pos = values.size() * rand() / RAND_MAX;
+  if( pos >= (int) values.size() )
+    pos = values.size() - 1;
+
+  if( !notZero )
+    return values[ pos ];
 
   PRV_UINT32 i = 0;
-  while( v[ pos ] == 0 )
+  while( values[ pos ] == 0 )
   {
     ++pos;
-    pos = pos % v.size();
+    pos = pos % values.size();
     i++;
-    if( i == v.size() ) return 0;
+    if( i == values.size() ) return 0;
   }
 
-  return v[ pos ];
+  return values[ pos ];
 }
 
-template <>
-inline TSemanticValue selectMethod<DrawModeMethod::DRAW_AVERAGE>( vector<TSemanticValue>& v )
+// The first value reaching the highest count: sorting by value and position,
+// that is the value whose last position is the lowest among the most repeated
+TSemanticValue DrawModeReducer::getMode()
 {
-  TSemanticValue avg = 0.0;
-
-  for( vector<TSemanticValue>::iterator it = v.begin(); it != v.end(); ++it )
+  sortedValues.clear();
+  for( PRV_UINT32 i = 0; i < values.size(); ++i )
   {
-    avg += *it;
+    if( values[ i ] == values[ i ] )
+      sortedValues.push_back( pair<TSemanticValue, PRV_UINT32>( values[ i ], i ) );
   }
+  std::sort( sortedValues.begin(), sortedValues.end() );
 
-  return avg / v.size();
-}
-
-template <>
-inline TSemanticValue selectMethod<DrawModeMethod::DRAW_AVERAGENOTZERO>( vector<TSemanticValue>& v )
-{
-  TSemanticValue avg = 0.0;
-  TSemanticValue times = 0.0;
-
-  for( vector<TSemanticValue>::iterator it = v.begin(); it != v.end(); ++it )
-  {
-    if( *it != 0.0 )
-    {
-      avg += *it;
-      ++times;
-    }
-  }
-
-  if( times == 0.0 )
-    return 0.0;
-  return avg / times;
-}
-
-template<>
-inline TSemanticValue selectMethod<DrawModeMethod::DRAW_MODE>( vector<TSemanticValue>& v )
-{
-  map<TSemanticValue, int> modes;
   TSemanticValue currentMode = 0;
-  int currentModeCount = 0;
+  PRV_UINT32 currentModeCount = 0;
+  PRV_UINT32 currentModePos = 0;
 
-  for( vector<TSemanticValue>::iterator it = v.begin(); it != v.end(); ++it )
+  vector<pair<TSemanticValue, PRV_UINT32> >::iterator it = sortedValues.begin();
+  while( it != sortedValues.end() )
   {
-    modes[ *it ]++;
-    if( modes[ *it ] > currentModeCount )
+    vector<pair<TSemanticValue, PRV_UINT32> >::iterator itEnd = it;
+    while( itEnd != sortedValues.end() && itEnd->first == it->first )
+      ++itEnd;
+
+    PRV_UINT32 tmpCount = itEnd - it;
+    PRV_UINT32 tmpPos = ( itEnd - 1 )->second;
+    if( tmpCount > currentModeCount || ( tmpCount == currentModeCount && tmpPos < currentModePos ) )
     {
-      currentMode = *it;
-      currentModeCount = modes[ *it ];
+      currentMode = ( itEnd - 1 )->first;
+      currentModeCount = tmpCount;
+      currentModePos = tmpPos;
     }
-  }
-
-  return currentMode;
-}
-
-TSemanticValue DrawMode::selectValue( vector<TSemanticValue>& v,
-                                      DrawModeMethod method )
-{
-  switch ( method )
-  {
-    case DrawModeMethod::DRAW_MAXIMUM:
-      return selectMethod<DrawModeMethod::DRAW_MAXIMUM>( v );
-      break;
-
-    case DrawModeMethod::DRAW_MINNOTZERO:
-      return selectMethod<DrawModeMethod::DRAW_MINNOTZERO>( v );
-      break;
-
-    case DrawModeMethod::DRAW_ABSOLUTE_MINNOTZERO:
-      return selectMethod<DrawModeMethod::DRAW_ABSOLUTE_MINNOTZERO>( v );
-      break;
 
-    case DrawModeMethod::DRAW_ABSOLUTE_MAXIMUM:
-      return selectMethod<DrawModeMethod::DRAW_ABSOLUTE_MAXIMUM>( v );
-      break;
-
-    case DrawModeMethod::DRAW_RANDOM:
-      return selectMethod<DrawModeMethod::DRAW_RANDOM>( v );
-      break;
-
-    case DrawModeMethod::DRAW_RANDNOTZERO:
-      return selectMethod<DrawModeMethod::DRAW_RANDNOTZERO>( v );
-      break;
-
-    case DrawModeMethod::DRAW_AVERAGE:
-      return selectMethod<DrawModeMethod::DRAW_AVERAGE>( v );
-      break;
-
-    case DrawModeMethod::DRAW_AVERAGENOTZERO:
-      return selectMethod<DrawModeMethod::DRAW_AVERAGENOTZERO>( v );
-      break;
-
-    case DrawModeMethod::DRAW_MODE:
-      return selectMethod<DrawModeMethod::DRAW_MODE>( v );
-      break;
-
-    default:
-      break;
+    it = itEnd;
   }
 
-  return selectMethod<DrawModeMethod::DRAW_LAST>( v );
+  return currentMode;
 }
@@ -25,6 +25,8 @@
 #pragma once
 
 
+#include <math.h>
+#include <utility>
 #include <vector>
 #include "paraverkerneltypes.h"
 
@@ -53,3 +55,110 @@ class DrawMode
 };
 
 
+// Same result as DrawMode::selectValue, fed value by value. Only random and
+// mode methods keep the values, in buffers reused after each reset.
+class DrawModeReducer
+{
+  public:
+    DrawModeReducer( DrawModeMethod whichMethod );
+
+    void reset();
+
+    void add( TSemanticValue whichValue );
+
+    TSemanticValue getValue();
+
+  private:
+    DrawModeMethod method;
+    TSemanticValue value;
+    TSemanticValue sum;
+    PRV_UINT32 count;
+    std::vector<TSemanticValue> values;
+    std::vector<std::pair<TSemanticValue, PRV_UINT32> > sortedValues;
+
+    // LAST is the default method
+    template <DrawModeMethod whichMethod>
+    void addValue( TSemanticValue whichValue )
+    {
+      value = whichValue;
+    }
+
+    TSemanticValue getRandom( bool notZero ) const;
+    TSemanticValue getMode();
+};
+
+
+template <>
+inline void DrawModeReducer::addValue<DrawModeMethod::DRAW_MAXIMUM>( TSemanticValue whichValue )
+{
+  if( whichValue > value ) value = whichValue;
+}
+
+template <>
+inline void DrawModeReducer::addValue<DrawModeMethod::DRAW_MINNOTZERO>( TSemanticValue whichValue )
+{
+  if( whichValue != 0.0 && whichValue < value ) value = whichValue;
+}
+
+template <>
+inline void DrawModeReducer::addValue<DrawModeMethod::DRAW_ABSOLUTE_MINNOTZERO>( TSemanticValue whichValue )
+{
+  if( whichValue != 0.0 && fabs( whichValue ) < value ) value = whichValue;
+}
+
+template <>
+inline void DrawModeReducer::addValue<DrawModeMethod::DRAW_ABSOLUTE_MAXIMUM>( TSemanticValue whichValue )
+{
+  if( fabs( whichValue ) > value ) value = whichValue;
+}
+
+template <>
+inline void DrawModeReducer::addValue<DrawModeMethod::DRAW_AVERAGE>( TSemanticValue whichValue )
+{
+  sum += whichValue;
+  ++count;
+}
+
+template <>
+inline void DrawModeReducer::addValue<DrawModeMethod::DRAW_AVERAGENOTZERO>( TSemanticValue whichValue )
+{
+  if( whichValue != 0.0 )
+  {
+    sum += whichValue;
+    ++count;
+  }
+}
+
+inline void DrawModeReducer::add( TSemanticValue whichValue )
+{
+  switch ( method )
+  {
+    case DrawModeMethod::DRAW_MAXIMUM:
+      addValue<DrawModeMethod::DRAW_MAXIMUM>( whichValue );
+      break;
+    case DrawModeMethod::DRAW_MINNOTZERO:
+      addValue<DrawModeMethod::DRAW_MINNOTZERO>( whichValue );
+      break;
+    case DrawModeMethod::DRAW_RANDOM:
+    case DrawModeMethod::DRAW_RANDNOTZERO:
+    case DrawModeMethod::DRAW_MODE:
+      values.push_back( whichValue );
+      break;
+    case DrawModeMethod::DRAW_AVERAGE:
+      addValue<DrawModeMethod::DRAW_AVERAGE>( whichValue );
+      break;
+    case DrawModeMethod::DRAW_AVERAGENOTZERO:
+      addValue<DrawModeMethod::DRAW_AVERAGENOTZERO>( whichValue );
+      break;
+    case DrawModeMethod::DRAW_ABSOLUTE_MAXIMUM:
+      addValue<DrawModeMethod::DRAW_ABSOLUTE_MAXIMUM>( whichValue );
+      break;
+    case DrawModeMethod::DRAW_ABSOLUTE_MINNOTZERO:
+      addValue<DrawModeMethod::DRAW_ABSOLUTE_MINNOTZERO>( whichValue );
+      break;
+    default:
+      addValue<DrawModeMethod::DRAW_LAST>( whichValue );
+      break;
+  }
+}
+
@@ -0,0 +1,210 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                               libparaver-api                              *
+ *                       Paraver Main Computing Library                      *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+
+
+// Benchmark of every DrawModeMethod on dense rows: many values per pixel,
+// as when a long trace is drawn on few pixels. The reused DrawModeReducer
+// is timed against the former way, gathering the values of each pixel and
+// selecting one. Both results must match, so it also runs as a test.
+// Usage: drawmodebench [pixels] [values per pixel]
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "drawmode.h"
+
+using namespace std;
+
+namespace
+{
+  const char *methodNames[] =
+  {
+    "last", "maximum", "min not zero", "random", "random not zero",
+    "average", "average not zero", "mode", "abs maximum", "abs min not zero"
+  };
+
+  // Former DrawMode::selectValue, on the gathered values of a pixel
+  TSemanticValue formerSelectValue( vector< TSemanticValue >& v, DrawModeMethod method )
+  {
+    TSemanticValue result;
+    TSemanticValue sum = 0.0;
+    TSemanticValue times = 0.0;
+    int pos;
+
+    switch ( method )
+    {
+      case DrawModeMethod::DRAW_MAXIMUM:
+        result = numeric_limits< TSemanticValue >::lowest();
+        for ( TSemanticValue value : v )
+          if ( value > result ) result = value;
+        return result;
+
+      case DrawModeMethod::DRAW_ABSOLUTE_MAXIMUM:
+        result = numeric_limits< TSemanticValue >::lowest();
+        for ( TSemanticValue value : v )
+          if ( fabs( value ) > result ) result = value;
+        return result;
+
+      case DrawModeMethod::DRAW_MINNOTZERO:
+      case DrawModeMethod::DRAW_ABSOLUTE_MINNOTZERO:
+        result = numeric_limits< TSemanticValue >::max();
+        for ( TSemanticValue value : v )
+        {
+          TSemanticValue compared = method == DrawModeMethod::DRAW_MINNOTZERO ? value : fabs( value );
+          if ( value != 0.0 && compared < result ) result = value;
+        }
+        return result == numeric_limits< TSemanticValue >::max() ? 0.0 : result;
+
+      case DrawModeMethod::DRAW_RANDOM:
+      case DrawModeMethod::DRAW_RANDNOTZERO:
+      {
+        pos = v.size() * rand() / RAND_MAX;
+        if ( pos >= (int) v.size() )
+          pos = v.size() - 1;
+        if ( method == DrawModeMethod::DRAW_RANDOM )
+          return v[ pos ];
+
+        PRV_UINT32 i = 0;
+        while ( v[ pos ] == 0 )
+        {
+          ++pos;
+          pos = pos % v.size();
+          i++;
+          if ( i == v.size() ) return 0;
+        }
+        return v[ pos ];
+      }
+
+      case DrawModeMethod::DRAW_AVERAGE:
+        for ( TSemanticValue value : v )
+          sum += value;
+        return sum / v.size();
+
+      case DrawModeMethod::DRAW_AVERAGENOTZERO:
+        for ( TSemanticValue value : v )
+        {
+          if ( value != 0.0 )
+          {
+            sum += value;
+            ++times;
+          }
+        }
+        return times == 0.0 ? 0.0 : sum / times;
+
+      case DrawModeMethod::DRAW_MODE:
+      {
+        map< TSemanticValue, int > modes;
+        int currentModeCount = 0;
+        result = 0.0;
+        for ( TSemanticValue value : v )
+        {
+          if ( ++modes[ value ] > currentModeCount )
+          {
+            result = value;
+            currentModeCount = modes[ value ];
+          }
+        }
+        return result;
+      }
+
+      default:
+        return v[ v.size() - 1 ];
+    }
+  }
+}
+
+
+int main( int argc, char *argv[] )
+{
+  size_t numPixels = argc > 1 ? strtoull( argv[ 1 ], nullptr, 10 ) : 1000;
+  size_t valuesPerPixel = argc > 2 ? strtoull( argv[ 2 ], nullptr, 10 ) : 1000;
+
+  // States like values: a few repeated, with some zeros and negatives
+  mt19937_64 generator( 1 );
+  vector< TSemanticValue > row( numPixels * valuesPerPixel );
+  for ( TSemanticValue& value : row )
+    value = static_cast< TSemanticValue >( static_cast< int >( generator() % 40 ) - 8 ) / 2;
+
+  cout << numPixels << " pixels x " << valuesPerPixel << " values" << endl;
+  cout << setw( 18 ) << left << "method" << right
+       << setw( 16 ) << "reducer ns/val" << setw( 16 ) << "former ns/val" << endl;
+
+  bool ok = true;
+  for ( int iMethod = 0; iMethod < static_cast< int >( DrawModeMethod::DRAW_NUMMETHODS ); ++iMethod )
+  {
+    DrawModeMethod method = static_cast< DrawModeMethod >( iMethod );
+    vector< TSemanticValue > reducerResults( numPixels );
+    vector< TSemanticValue > vectorResults( numPixels );
+
+    srand( 1 );
+    auto timeBegin = chrono::steady_clock::now();
+    DrawModeReducer reducer( method );
+    for ( size_t iPixel = 0; iPixel < numPixels; ++iPixel )
+    {
+      reducer.reset();
+      for ( size_t i = iPixel * valuesPerPixel; i < ( iPixel + 1 ) * valuesPerPixel; ++i )
+        reducer.add( row[ i ] );
+      reducerResults[ iPixel ] = reducer.getValue();
+    }
+    double reducerSeconds = chrono::duration< double >( chrono::steady_clock::now() - timeBegin ).count();
+
+    srand( 1 );
+    timeBegin = chrono::steady_clock::now();
+    for ( size_t iPixel = 0; iPixel < numPixels; ++iPixel )
+    {
+      vector< TSemanticValue > pixelValues;
+      for ( size_t i = iPixel * valuesPerPixel; i < ( iPixel + 1 ) * valuesPerPixel; ++i )
+        pixelValues.push_back( row[ i ] );
+      vectorResults[ iPixel ] = formerSelectValue( pixelValues, method );
+    }
+    double vectorSeconds = chrono::duration< double >( chrono::steady_clock::now() - timeBegin ).count();
+
+    size_t wrongResults = 0;
+    for ( size_t iPixel = 0; iPixel < numPixels; ++iPixel )
+    {
+      if ( reducerResults[ iPixel ] != vectorResults[ iPixel ] )
+        ++wrongResults;
+    }
+
+    cout << setw( 18 ) << left << methodNames[ iMethod ] << right << fixed << setprecision( 2 )
+         << setw( 16 ) << reducerSeconds * 1e9 / row.size()
+         << setw( 16 ) << vectorSeconds * 1e9 / row.size();
+    if ( wrongResults > 0 )
+    {
+      cout << "  " << wrongResults << " WRONG RESULTS";
+      ok = false;
+    }
+    cout << endl;
+  }
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -46,6 +46,7 @@ class TraceShifter;
 class TraceEditSequence;
 class EventDrivenCutter;
 class EventTranslator;
+class TraceLoader;
 
 typedef std::pair< TEventType, TEventValue > TTypeValuePair;
 
@@ -84,6 +85,7 @@ class KernelConnection
     virtual ProgressController *newProgressController() const = 0;
     virtual Filter *newFilter( Filter *concreteFilter ) const = 0;
     virtual TraceEditSequence *newTraceEditSequence() const = 0;
+    virtual TraceLoader *newTraceLoader( size_t maxConcurrentLoads = 0 ) = 0;
 
     virtual std::string getToolID( const std::string &toolName ) const = 0;
     virtual std::string getToolName( const std::string &toolID ) const = 0;
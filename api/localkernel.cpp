@@ -65,6 +65,7 @@
 #include "ktraceshifter.h"
 #include "keventdrivencutter.h"
 #include "keventtranslator.h"
+#include "traceloader.h"
 #include "tracestream.h"
 #include <string.h>
 
@@ -311,6 +312,12 @@ TraceEditSequence *LocalKernel::newTraceEditSequence() const
 }
 
 
+TraceLoader *LocalKernel::newTraceLoader( size_t maxConcurrentLoads )
+{
+  return new TraceLoader( this, maxConcurrentLoads );
+}
+
+
 // TODO: repeated code
 string LocalKernel::getToolID( const string &toolName ) const
 {
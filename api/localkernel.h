@@ -56,6 +56,7 @@ class LocalKernel: public KernelConnection
     virtual ProgressController *newProgressController() const override;
     virtual Filter *newFilter( Filter *concreteFilter ) const override;
     virtual TraceEditSequence *newTraceEditSequence() const override;
+    virtual TraceLoader *newTraceLoader( size_t maxConcurrentLoads = 0 ) override;
 
     virtual std::string getToolID( const std::string &toolName ) const override;
     virtual std::string getToolName( const std::string &toolID ) const override;
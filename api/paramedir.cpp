@@ -28,7 +28,23 @@
 #include <iomanip>
 #include <map>
 #include <set>
+#include <limits>
 #include <algorithm>
+#include <sstream>
+#include <cstring>
+#include <deque>
+#include <thread>
+#include <exception>
+#include <csignal>
+#ifndef _WIN32
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#else
+#include <io.h>
+#endif
 
 //#include <boost/filesystem.hpp>
 //#include <boost/error_code.hpp>
@@ -44,6 +60,7 @@
 #include "paraverkernelexception.h"
 #include "paraverconfig.h"
 #include "textoutput.h"
+#include "traceloader.h"
 #include "traceoptions.h"
 #include "labelconstructor.h" // for getDate
 
@@ -74,10 +91,13 @@ enum TOptionID
   // GENERAL
   SHOW_HELP = 0,
   SHOW_VERSION,
+  BATCH_CFGS,
+  LOAD_JOBS,
 
   // FILES
   MANY_FILES,
   OUTPUT_NAME,
+  BINARY_CACHE,
 
   // TIMELINES
   TIMELINE_OBJECT_HIERARCHY,
@@ -116,10 +136,13 @@ TOptionParamedir definedOption[] =
   // GENERAL
   { "-h", "--help", false, 0, "", "", "Show help" },
   { "-v", "--version", false, 0, "", "", "Show version" },
+  { "-b", "--batch", false, 0, "", "", "Load all cfgs first and compute only once those differing just in names or histogram statistic" },
+  { "-j", "--jobs", false, 1, "", "<num-traces>", "Maximum number of traces loaded at the same time when many traces or a directory are given (default: 2)" },
 
   // FILES
   { "-m", "--many-files", false, 0, "", "", "Allows to separate cfg output (default in a unique file)" },
   { "-o", "--output-name", false, 1, "", "<tracename>",  "Output trace name (only for processing trace)" },
+  { "-bc", "--binary-cache", false, 0, "", "", "Use or create binary caches next to the trace ('<prv>.bcache', '<prv.gz>.gzi') to speed up later loads" },
 
   // TIMELINES
   { "-obj", "--object-hierarchy", false, 0, "", "", "Print object hierarchy in timelines instead of global object order" },
@@ -156,8 +179,10 @@ std::map< TOptionID, TOptionParamedir > option;
 
 // PRVs
 string sourceTraceName( "" );
+vector< string > sourceTraceNames;
 string outputTraceName( "" );
 Trace *trace;
+size_t maxConcurrentLoads = 0;
 
 // CFGs
 std::map< string, string > cfgs;
@@ -271,7 +296,9 @@ void printHelp()
   std::cout << "  General info:" << std::endl;
   std::cout << "      paramedir [-h] [-v]" << std::endl << std::endl;
   std::cout << "  Compute numeric data from trace using histogram or timeline CFG's (cfgs can be chained, trace is loaded):" << std::endl;
-  std::cout << "      paramedir [-e] [-m] [-p] [-npr] <prv> [ <cfg> | <cfg> <ouput-data-file> ]+" << std::endl << std::endl;
+  std::cout << "      paramedir [-b] [-e] [-m] [-p] [-npr] <prv> [ <cfg> | <cfg> <ouput-data-file> ]+" << std::endl << std::endl;
+  std::cout << "  Compute numeric data from many traces using the same CFG's (traces are loaded concurrently):" << std::endl;
+  std::cout << "      paramedir [-b] [-e] [-m] [-p] [-npr] [-j <num-traces>] [ <prv> | <directory> ]+ [ <cfg> | <cfg> <ouput-data-file> ]+" << std::endl << std::endl;
   std::cout << "  Process paraver trace (pipelined as flags are declared, using XML configuration parameters and without trace load):" << std::endl;
   std::cout << "      paramedir [-c] [-f] [-s] [-o <output-file>] <prv> <xml>" << std::endl << std::endl;
   std::cout << "  Process paraver trace (direct parametrization, don't load trace):" << std::endl;
@@ -281,7 +308,7 @@ void printHelp()
   std::cout << "  Process paraver trace (event_translator):" << std::endl;
   std::cout << "      paramedir -et <reference_prv> <source_prv> [-o <translated_prv> ]" << std::endl << std::endl;
   std::cout << "  Compute numeric data from processed trace using histogram or timeline CFG's (all combined, trace is loaded):" << std::endl;
-  std::cout << "      paramedir [-e] [-m] [-p] [-c] [-f] [-s] [-o <output-file>] [-g <event-type>] \\" << std::endl;
+  std::cout << "      paramedir [-b] [-e] [-m] [-p] [-c] [-f] [-s] [-o <output-file>] [-g <event-type>] \\" << std::endl;
   std::cout << "                [-t <shift-times-file>] <prv> [ <xml> ] [ <cfg> | <cfg> <ouput-data-file> ]+" << std::endl << std::endl;
 
   std::cout << std::endl;
@@ -316,9 +343,11 @@ void printHelp()
   std::cout << std::endl;
   std::cout << "  Parameters:" << std::endl;
   std::cout << "    prv: Paraver trace filename; can be gzipped (extensions allowed: only '.prv' or '.prv.gz' )." << std::endl;
+  std::cout << "    directory: All the paraver traces inside are used, as if given one by one." << std::endl;
   std::cout << "    xml: Options for cutter/filter/software counters ( with extension '.xml' )." << std::endl;
   std::cout << "    cfg: Paraver configuration filename ( with extension '.cfg' ). If present, trace's loaded." << std::endl;
   std::cout << "    ouput-data-file: Filename for cfg output data ( if missing, cfg name's used, changing '.cfg' extension with '.mcr' )." << std::endl;
+  std::cout << "                     With many traces, it is prefixed with the trace name ( 'linpack.prv' => 'linpack.<ouput-data-file>' )." << std::endl;
   std::cout << std::endl;
   std::cout << "  Examples:" << std::endl;
   std::cout << "    paramedir linpack.prv.gz mpi_stats.cfg" << std::endl;
@@ -327,6 +356,9 @@ void printHelp()
   std::cout << "    paramedir linpack.prv mpi_stats.cfg my_data.txt total_MPI_activity.cfg" << std::endl;
   std::cout << "      Computes the mpi_stats.cfg and total_MPI_activity.cfg analysis of linpack.prv, saving first one in 'my_data.txt' file." << std::endl;
   std::cout << std::endl;
+  std::cout << "    paramedir -j 4 traces/ mpi_stats.cfg" << std::endl;
+  std::cout << "      Computes the mpi_stats.cfg analysis of every trace in 'traces' directory, loading up to 4 of them at the same time." << std::endl;
+  std::cout << std::endl;
   std::cout << "    paramedir -c linpack.prv cutter.xml" << std::endl;
   std::cout << "      Reads parameters of the cutter from the xml and applies them to linpack.prv trace." << std::endl;
   std::cout << std::endl;
@@ -408,6 +440,56 @@ void registerTool( TOptionID whichOption,
 }
 
 
+bool isDirectory( const string& whichPath )
+{
+#ifndef _WIN32
+  struct stat tmpStat;
+  return stat( whichPath.c_str(), &tmpStat ) == 0 && S_ISDIR( tmpStat.st_mode );
+#else
+  struct _stat tmpStat;
+  return _stat( whichPath.c_str(), &tmpStat ) == 0 && ( tmpStat.st_mode & _S_IFDIR );
+#endif
+}
+
+
+// Appends the traces found in the directory, sorted by name
+void addDirectoryTraces( KernelConnection *myKernel, const string& whichDirectory )
+{
+  vector< string > fileNames;
+  string tmpPath = whichDirectory;
+  if ( tmpPath.rfind( myKernel->getPathSeparator() ) != tmpPath.length() - 1 )
+    tmpPath += myKernel->getPathSeparator();
+
+#ifndef _WIN32
+  DIR *tmpDir = opendir( whichDirectory.c_str() );
+  if ( tmpDir == nullptr )
+    return;
+
+  struct dirent *tmpEntry;
+  while ( ( tmpEntry = readdir( tmpDir ) ) != nullptr )
+    fileNames.push_back( tmpEntry->d_name );
+  closedir( tmpDir );
+#else
+  struct _finddata_t tmpEntry;
+  intptr_t tmpHandle = _findfirst( ( tmpPath + "*" ).c_str(), &tmpEntry );
+  if ( tmpHandle == -1 )
+    return;
+
+  do
+    fileNames.push_back( tmpEntry.name );
+  while ( _findnext( tmpHandle, &tmpEntry ) == 0 );
+  _findclose( tmpHandle );
+#endif
+
+  std::sort( fileNames.begin(), fileNames.end() );
+  for ( auto it : fileNames )
+  {
+    if ( myKernel->isTraceFile( tmpPath + it ) )
+      sourceTraceNames.push_back( tmpPath + it );
+  }
+}
+
+
 bool parseArguments( KernelConnection *myKernel,
                      int argc,
                      char *arguments[],
@@ -482,12 +564,26 @@ bool parseArguments( KernelConnection *myKernel,
       {
         eventTranslatorReferenceName = currentArgument;
       }
+      else if ( option[ LOAD_JOBS ].active && maxConcurrentLoads == 0 )
+      {
+        std::stringstream sstr( currentArgument );
+        if( !( sstr >> maxConcurrentLoads ) || maxConcurrentLoads == 0 )
+        {
+          std::cerr << "  [ERROR] '" << currentArgument << "' not a valid number of traces." << std::endl;
+          parseOK = false;
+          break;
+        }
+      }
 
       --readParameter;
     }
     else if ( myKernel->isTraceFile( currentArgument ) )
     {
-      sourceTraceName = currentArgument;
+      sourceTraceNames.push_back( currentArgument );
+    }
+    else if ( isDirectory( currentArgument ) )
+    {
+      addDirectoryTraces( myKernel, currentArgument );
     }
     else if ( TraceOptions::isTraceToolsOptionsFile( currentArgument ) )
     {
@@ -519,6 +615,9 @@ bool parseArguments( KernelConnection *myKernel,
     parseOK = false;
   }
 
+  if ( !sourceTraceNames.empty() )
+    sourceTraceName = sourceTraceNames[ 0 ];
+
   if( sourceTraceName.empty() )
   {
     std::cerr << "  [ERROR] Missing tracefile or unrecognized tracefile format." << std::endl;
@@ -534,6 +633,11 @@ bool parseArguments( KernelConnection *myKernel,
     std::cerr << "  [ERROR] Source trace and output trace are the same." << std::endl;
     parseOK = false;
   }
+  else if ( sourceTraceNames.size() > 1 && registeredTool.size() > 0 )
+  {
+    std::cerr << "  [ERROR] Trace processing tools accept only one trace." << std::endl;
+    parseOK = false;
+  }
 
   return parseOK;
 }
@@ -562,6 +666,250 @@ std::string appendPathWorkingDirectory( KernelConnection *myKernel,
 }
 
 
+// Name of the trace written by registeredTool[ whichTool ]
+string getToolTraceName( KernelConnection *myKernel,
+                         vector< string > &registeredTool,
+                         size_t whichTool,
+                         const string& intermediateNameIn,
+                         const string& destinyTraceName )
+{
+  string intermediateNameOut;
+
+  bool commitName;
+  if ( whichTool < registeredTool.size() - 1 )
+  {
+    // Intermediate trace:
+    //   Get partial name (suffix for one tool)
+    //   Don't modify global list of recent treated traces
+    commitName = false;
+    intermediateNameOut = myKernel->getNewTraceName( intermediateNameIn, registeredTool[ whichTool ], commitName );
+  }
+  else
+  {
+    // Final trace:
+    if ( outputTraceName.empty() )
+    {
+      //   Get full name (including all tools)
+      commitName = true;
+      intermediateNameOut = myKernel->getNewTraceName( destinyTraceName, registeredTool, commitName );
+    }
+    else
+    {
+      // Force outputName
+      intermediateNameOut = destinyTraceName;
+
+      //   Remember name in global list of recent treated traces
+      myKernel->commitNewTraceName( destinyTraceName );
+    }
+  }
+
+  return intermediateNameOut;
+}
+
+
+// Runs cutter, filter or software counters over the .prv only
+void executeStreamableTool( KernelConnection *myKernel,
+                            const string& whichTool,
+                            const string& intermediateNameIn,
+                            const string& intermediateNameOut )
+{
+  if ( whichTool == TraceCutter::getID() )
+  {
+    traceCutter = TraceCutter::create( myKernel, intermediateNameIn, intermediateNameOut, traceOptions, nullptr );
+    traceCutter->execute( (char *)intermediateNameIn.c_str(), (char *)intermediateNameOut.c_str() );
+  }
+  else if ( whichTool == TraceFilter::getID() )
+  {
+    std::map< TTypeValuePair, TTypeValuePair > translation;
+#if 1
+    traceFilter = myKernel->newTraceFilter( (char *)intermediateNameIn.c_str(),
+                                            (char *)intermediateNameOut.c_str(),
+                                            traceOptions,
+                                            translation );
+#else
+    //translation[ make_pair( 30000000, 2 ) ] = make_pair( 666, 999 );
+    translation[ make_pair( 50000001, 1 ) ] = make_pair( 666666, 999999 );
+    translation[ make_pair( 50000002, 9 ) ] = make_pair( 666666666, 999999999 );
+    translation[ make_pair( 50000003, 31 ) ] = make_pair( 666666666666, 999999999999 );
+
+    TraceOptions *opts = myKernel->newTraceOptions( );
+
+    opts->set_filter_by_call_time( false );
+
+    opts->set_filter_states( true );
+    opts->set_all_states( true );
+
+    opts->set_filter_events( true );
+    opts->set_discard_given_types( true );
+    TraceOptions::TFilterTypes dummyTypes;
+    dummyTypes[0].type = 1234567890;
+    opts->set_filter_last_type( 1 );
+
+    opts->set_filter_comms( true );
+    opts->set_min_comm_size( 1 );
+
+    traceFilter = myKernel->newTraceFilter( (char *)intermediateNameIn.c_str(), (char *)intermediateNameOut.c_str(), opts, translation );
+#endif
+  }
+  else if ( whichTool == TraceSoftwareCounters::getID() )
+  {
+    traceSoftwareCounters = myKernel->newTraceSoftwareCounters( (char *)intermediateNameIn.c_str(),
+                                                                (char *)intermediateNameOut.c_str(),
+                                                                traceOptions );
+  }
+}
+
+
+#ifndef _WIN32
+// Cutter, filter and software counters read their input once from front to back,
+// so consecutive ones can be fed through named pipes and run at the same time.
+bool isStreamableTool( const string& whichTool )
+{
+  return whichTool == TraceCutter::getID() ||
+         whichTool == TraceFilter::getID() ||
+         whichTool == TraceSoftwareCounters::getID();
+}
+
+
+bool canStreamOutput( const string& whichTool )
+{
+  // Software counters append their types to the output .pcf while running
+  if ( whichTool == TraceSoftwareCounters::getID() )
+    return false;
+
+  // Cutting by size measures the output file, unless it goes first to a temporary one
+  if ( whichTool == TraceCutter::getID() )
+    return traceOptions != nullptr &&
+           ( !traceOptions->get_original_time() || traceOptions->get_max_trace_size() == 0 );
+
+  return isStreamableTool( whichTool );
+}
+
+
+// Opens and closes both ends of a pipe, so a failed stage doesn't leave its neighbours blocked
+void releasePipe( const string& pipeName )
+{
+  int fd = open( pipeName.c_str(), O_RDWR | O_NONBLOCK );
+  if ( fd != -1 )
+    close( fd );
+}
+
+
+// Creates a directory only readable by the user for the pipes of a streamed run
+string createPipesDirectory()
+{
+  string tmpDir = ParaverConfig::getInstance()->getGlobalTmpPath() + "/paramedir_XXXXXX";
+  vector< char > tmpName( tmpDir.begin(), tmpDir.end() );
+  tmpName.push_back( '\0' );
+
+  if ( mkdtemp( tmpName.data() ) == nullptr )
+  {
+    std::cerr << "  [ERROR] Cannot create a temporary directory in '"
+              << ParaverConfig::getInstance()->getGlobalTmpPath() << "'." << std::endl;
+    exit( 1 );
+  }
+
+  return string( tmpName.data() );
+}
+
+
+// Runs registeredTool[ firstTool..lastTool ] concurrently, every intermediate trace being a pipe
+// in a private temporary directory. The names of the intermediate traces are still generated,
+// so the final one is the same as running the tools one by one.
+// .pcf and .row files don't depend on the records, so they are written beforehand.
+string executeStreamedTools( KernelConnection *myKernel,
+                             vector< string > &registeredTool,
+                             size_t firstTool,
+                             size_t lastTool,
+                             string intermediateNameIn,
+                             const string& destinyTraceName,
+                             vector< string > &tmpFiles )
+{
+  vector< string > namesIn, namesOut;
+  string pipesDir = createPipesDirectory();
+
+  for ( size_t i = firstTool; i <= lastTool; ++i )
+  {
+    string tmpNameIn = namesOut.empty() ? intermediateNameIn : namesOut.back();
+    namesIn.push_back( tmpNameIn );
+    intermediateNameIn = getToolTraceName( myKernel, registeredTool, i, intermediateNameIn, destinyTraceName );
+
+    if ( i < lastTool )
+    {
+      namesOut.push_back( pipesDir + "/" + std::to_string( i - firstTool ) + ".prv" );
+      if ( mkfifo( namesOut.back().c_str(), S_IRUSR | S_IWUSR ) != 0 )
+      {
+        std::cerr << "  [ERROR] Cannot create pipe '" << namesOut.back() << "'." << std::endl;
+        exit( 1 );
+      }
+    }
+    else
+      namesOut.push_back( intermediateNameIn );
+
+    if ( registeredTool[ i ] != TraceSoftwareCounters::getID() )
+      myKernel->copyPCF( namesIn.back(), namesOut.back() );
+    myKernel->copyROW( namesIn.back(), namesOut.back() );
+  }
+
+  size_t numStages = namesOut.size();
+  vector< std::thread > stages;
+  vector< std::exception_ptr > stageErrors( numStages );
+
+  for ( size_t iStage = 0; iStage < numStages; ++iStage )
+  {
+    stages.emplace_back( [&, iStage]()
+      {
+        // A cutter stops reading once past its time range. Writing to its pipe must fail
+        // with EPIPE instead of killing the process, without touching the global handler.
+        sigset_t pipeSignal;
+        sigemptyset( &pipeSignal );
+        sigaddset( &pipeSignal, SIGPIPE );
+        pthread_sigmask( SIG_BLOCK, &pipeSignal, nullptr );
+
+        try
+        {
+          executeStreamableTool( myKernel, registeredTool[ firstTool + iStage ], namesIn[ iStage ], namesOut[ iStage ] );
+        }
+        catch( ... )
+        {
+          stageErrors[ iStage ] = std::current_exception();
+          if ( iStage > 0 )
+            releasePipe( namesIn[ iStage ] );
+          if ( iStage < numStages - 1 )
+            releasePipe( namesOut[ iStage ] );
+        }
+
+        // Discard the SIGPIPE raised by this thread, if any
+        struct timespec noWait = { 0, 0 };
+        while ( sigtimedwait( &pipeSignal, nullptr, &noWait ) == SIGPIPE )
+          ;
+      } );
+  }
+
+  for ( std::thread& stage : stages )
+    stage.join();
+
+  for ( size_t iStage = 0; iStage < numStages - 1; ++iStage )
+  {
+    remove( namesOut[ iStage ].c_str() );
+    remove( LocalKernel::composeName( namesOut[ iStage ], string( "pcf" ) ).c_str() );
+    remove( LocalKernel::composeName( namesOut[ iStage ], string( "row" ) ).c_str() );
+  }
+  rmdir( pipesDir.c_str() );
+
+  tmpFiles.push_back( namesOut.back() );
+
+  for ( std::exception_ptr& error : stageErrors )
+  {
+    if ( error )
+      std::rethrow_exception( error );
+  }
+
+  return namesOut.back();
+}
+#endif
+
+
 string applyFilters( KernelConnection *myKernel,
                      vector< string > &registeredTool,
                      vector< string > &tmpFiles )
@@ -607,81 +955,35 @@ string applyFilters( KernelConnection *myKernel,
   {
     intermediateNameIn = intermediateNameOut;
 
-    bool commitName;
-    if ( i < registeredTool.size() - 1 )
+#ifndef _WIN32
+    size_t lastStreamed = i;
+    while ( lastStreamed < registeredTool.size() - 1 &&
+            canStreamOutput( registeredTool[ lastStreamed ] ) &&
+            isStreamableTool( registeredTool[ lastStreamed + 1 ] ) )
+      ++lastStreamed;
+
+    if ( lastStreamed > i )
     {
-      // Intermediate trace:
-      //   Get partial name (suffix for one tool)
-      //   Don't modify global list of recent treated traces
-      commitName = false;
-      intermediateNameOut = myKernel->getNewTraceName( intermediateNameIn, registeredTool[ i ], commitName );
+      intermediateNameOut = executeStreamedTools( myKernel, registeredTool, i, lastStreamed,
+                                                  intermediateNameIn, destinyTraceName, tmpFiles );
+      i = lastStreamed;
+      continue;
     }
-    else
-    {
-      // Final trace:
-      if ( outputTraceName.empty() )
-      {
-        //   Get full name (including all tools)
-        commitName = true;
-        intermediateNameOut = myKernel->getNewTraceName( destinyTraceName, registeredTool, commitName );
-      }
-      else
-      {
-        // Force outputName
-        intermediateNameOut = destinyTraceName;
+#endif
 
-        //   Remember name in global list of recent treated traces
-        myKernel->commitNewTraceName( destinyTraceName );
-      }
-    }
+    intermediateNameOut = getToolTraceName( myKernel, registeredTool, i, intermediateNameIn, destinyTraceName );
 
     bool copyRow = true;
 
-    if ( registeredTool[ i ] == TraceCutter::getID() )
-    {
-      traceCutter = TraceCutter::create( myKernel, intermediateNameIn, intermediateNameOut, traceOptions, nullptr );
-      traceCutter->execute( (char *)intermediateNameIn.c_str(), (char *)intermediateNameOut.c_str() );
-      myKernel->copyPCF( intermediateNameIn, intermediateNameOut );
-    }
-    else if ( registeredTool[ i ] == TraceFilter::getID() )
+    if ( registeredTool[ i ] == TraceCutter::getID() ||
+         registeredTool[ i ] == TraceFilter::getID() )
     {
-      std::map< TTypeValuePair, TTypeValuePair > translation;
-#if 1
-      traceFilter = myKernel->newTraceFilter( (char *)intermediateNameIn.c_str(),
-                                              (char *)intermediateNameOut.c_str(),
-                                              traceOptions,
-                                              translation );
-#else
-      //translation[ make_pair( 30000000, 2 ) ] = make_pair( 666, 999 );
-      translation[ make_pair( 50000001, 1 ) ] = make_pair( 666666, 999999 );
-      translation[ make_pair( 50000002, 9 ) ] = make_pair( 666666666, 999999999 );
-      translation[ make_pair( 50000003, 31 ) ] = make_pair( 666666666666, 999999999999 );
-
-      TraceOptions *opts = myKernel->newTraceOptions( );
-
-      opts->set_filter_by_call_time( false );
-
-      opts->set_filter_states( true );
-      opts->set_all_states( true );
-
-      opts->set_filter_events( true );
-      opts->set_discard_given_types( true );
-      TraceOptions::TFilterTypes dummyTypes;
-      dummyTypes[0].type = 1234567890;
-      opts->set_filter_last_type( 1 );
-
-      opts->set_filter_comms( true );
-      opts->set_min_comm_size( 1 );
-
-      traceFilter = myKernel->newTraceFilter( (char *)intermediateNameIn.c_str(), (char *)intermediateNameOut.c_str(), opts, translation );
-#endif
+      executeStreamableTool( myKernel, registeredTool[ i ], intermediateNameIn, intermediateNameOut );
       myKernel->copyPCF( intermediateNameIn, intermediateNameOut );
     }
     else if ( registeredTool[ i ] == TraceSoftwareCounters::getID() )
     {
-      traceSoftwareCounters = myKernel->newTraceSoftwareCounters( (char *)intermediateNameIn.c_str(),
-                                                                  (char *)intermediateNameOut.c_str(),
-                                                                  traceOptions );
+      executeStreamableTool( myKernel, registeredTool[ i ], intermediateNameIn, intermediateNameOut );
     }
     else if ( registeredTool[ i ] == TraceShifter::getID() )
     {
@@ -756,6 +1058,34 @@ bool loadTrace( KernelConnection *myKernel )
 }
 
 
+void setOutputOptions( TextOutput& output )
+{
+  output.setMultipleFiles( option[ MANY_FILES ].active );
+  output.setObjectHierarchy( option[ TIMELINE_OBJECT_HIERARCHY ].active );
+  output.setWindowTimeUnits( !option[ TIMELINE_TRACE_UNITS ].active );
+}
+
+
+void deleteCFGObjects( vector<Timeline *>& windows, vector<Histogram *>& histograms )
+{
+  for ( PRV_UINT32 i = 0; i < histograms.size(); ++i )
+  {
+    if ( histograms[ i ] != nullptr )
+      delete histograms[ i ];
+  }
+
+  histograms.clear();
+
+  for ( PRV_UINT32 i = 0; i < windows.size(); ++i )
+  {
+    if ( windows[ i ] != nullptr )
+      delete windows[ i ];
+  }
+
+  windows.clear();
+}
+
+
 void loadCFGs( KernelConnection *myKernel )
 {
   for( std::map< string, string >::iterator it = cfgs.begin(); it != cfgs.end(); ++it )
@@ -768,9 +1098,7 @@ void loadCFGs( KernelConnection *myKernel )
     if ( CFGLoader::loadCFG( myKernel, it->first, trace, windows, histograms, options ) )
     {
       TextOutput output;
-      output.setMultipleFiles( option[ MANY_FILES ].active );
-      output.setObjectHierarchy( option[ TIMELINE_OBJECT_HIERARCHY ].active );
-      output.setWindowTimeUnits( !option[ TIMELINE_TRACE_UNITS ].active );
+      setOutputOptions( output );
 
       if ( histograms.begin() != histograms.end() &&
            histograms[ histograms.size() - 1 ] != nullptr )
@@ -787,22 +1115,354 @@ void loadCFGs( KernelConnection *myKernel )
     else
       std::cerr << "  [Warning] Cannot load '" << it->first << "' file." << std::endl;
 
-    for ( PRV_UINT32 i = 0; i < histograms.size(); ++i )
+    deleteCFGObjects( windows, histograms );
+  }
+}
+
+
+typedef struct TBatchCFG
+{
+  std::map< string, string >::iterator cfg;
+  vector<Timeline *> windows;
+  vector<Histogram *> histograms;
+  Timeline *window = nullptr;       // Output object: window or histogram
+  Histogram *histogram = nullptr;
+  string outputFile;
+}
+TBatchCFG;
+
+
+// Everything that changes the computed values of the output object: the
+// semantic signature of its timelines plus the time range, or the histogram
+// parameters. Names, geometry and the histogram statistic are left out,
+// because the kernel always computes all statistics.
+string getCFGSignature( const TBatchCFG& whichCFG )
+{
+  std::ostringstream signature;
+  signature.precision( std::numeric_limits<double>::max_digits10 );
+
+  if ( whichCFG.histogram == nullptr )
+  {
+    Timeline *tmpWindow = whichCFG.window;
+    signature << tmpWindow->getSemanticSignature() << ';'
+              << tmpWindow->getWindowBeginTime() << ' ' << tmpWindow->getWindowEndTime();
+    return signature.str();
+  }
+
+  Histogram *tmpHisto = whichCFG.histogram;
+  for ( Timeline *tmpWindow : { tmpHisto->getControlWindow(), tmpHisto->getDataWindow(), tmpHisto->getExtraControlWindow() } )
+  {
+    signature << '{';
+    if ( tmpWindow != nullptr )
+      signature << tmpWindow->getSemanticSignature();
+    signature << '}';
+  }
+
+  signature << tmpHisto->getBeginTime() << ' ' << tmpHisto->getEndTime() << ' '
+            << static_cast<int>( tmpHisto->getTimeUnit() ) << ';'
+            << tmpHisto->getThreeDimensions() << ' ' << tmpHisto->getUseFixedDelta() << ' '
+            << tmpHisto->getControlMin() << ' ' << tmpHisto->getControlMax() << ' '
+            << tmpHisto->getControlDelta() << ' '
+            << tmpHisto->getExtraControlMin() << ' ' << tmpHisto->getExtraControlMax() << ' '
+            << tmpHisto->getExtraControlDelta() << ' '
+            << tmpHisto->getDataMin() << ' ' << tmpHisto->getDataMax() << ' '
+            << tmpHisto->getBurstMin() << ' ' << tmpHisto->getBurstMax() << ' '
+            << tmpHisto->getCommSizeMin() << ' ' << tmpHisto->getCommSizeMax() << ' '
+            << tmpHisto->getCommTagMin() << ' ' << tmpHisto->getCommTagMax() << ' '
+            << ( tmpHisto->getInclusiveEnabled() && tmpHisto->getInclusive() ) << ';'
+            << tmpHisto->getNumColumns() << ' ' << tmpHisto->getComputeScale() << ' '
+            << tmpHisto->getCompute2DScale() << ' ' << tmpHisto->getCompute2DScaleZero() << ' '
+            << tmpHisto->getCompute3DScale() << ' ' << tmpHisto->getPlaneMinValue() << ' '
+            << tmpHisto->getSelectedPlane() << ' ' << tmpHisto->getCommSelectedPlane() << ';'
+            << tmpHisto->getHorizontal() << ' ' << tmpHisto->getHideColumns() << ' '
+            << tmpHisto->getOnlyTotals() << ' ' << tmpHisto->getShortLabels() << ' '
+            << tmpHisto->getScientificNotation() << ' ' << tmpHisto->getNumDecimals() << ' '
+            << tmpHisto->getThousandSeparator() << ' ' << tmpHisto->getShowUnits() << ' '
+            << tmpHisto->getCodeColor() << ' ' << tmpHisto->getSemanticSortColumns() << ' '
+            << static_cast<int>( tmpHisto->getSemanticSortCriteria() ) << ' '
+            << tmpHisto->getSemanticSortReverse() << ' ' << tmpHisto->getFixedSemanticSort() << ';';
+
+  for ( TObjectOrder iRow : tmpHisto->getSelectedRows() )
+    signature << iRow << ' ';
+
+  return signature.str();
+}
+
+
+bool isTimelineUsed( Timeline *whichWindow, const std::set< Timeline * >& usedWindows )
+{
+  if ( usedWindows.count( whichWindow ) > 0 )
+    return true;
+
+  return whichWindow->isDerivedWindow() &&
+         ( isTimelineUsed( whichWindow->getParent( 0 ), usedWindows ) ||
+           isTimelineUsed( whichWindow->getParent( 1 ), usedWindows ) );
+}
+
+
+void markTimelineUsed( Timeline *whichWindow, std::set< Timeline * >& usedWindows )
+{
+  usedWindows.insert( whichWindow );
+  if ( whichWindow->isDerivedWindow() )
+  {
+    markTimelineUsed( whichWindow->getParent( 0 ), usedWindows );
+    markTimelineUsed( whichWindow->getParent( 1 ), usedWindows );
+  }
+}
+
+
+// Adds whichWindow and its parents to the timelines shared by every cfg of
+// the batch. A parent is replaced by an equal timeline loaded from a former
+// cfg, so all of them build a single DAG, but never by one already used by
+// the same output object: windows computed together advance their parents.
+void shareTimeline( Timeline *whichWindow,
+                    std::map< string, Timeline * >& sharedWindows,
+                    std::set< Timeline * >& usedWindows )
+{
+  if ( !usedWindows.insert( whichWindow ).second )
+    return;
+
+  if ( whichWindow->isDerivedWindow() )
+  {
+    TTraceLevel tmpLevel = whichWindow->getLevel();
+
+    for ( PRV_UINT16 iParent = 0; iParent < 2; ++iParent )
     {
-      if ( histograms[ i ] != nullptr )
-        delete histograms[ i ];
+      Timeline *tmpParent = whichWindow->getParent( iParent );
+      auto itShared = sharedWindows.find( tmpParent->getSemanticSignature() );
+      if ( itShared != sharedWindows.end() && itShared->second != tmpParent &&
+           !isTimelineUsed( itShared->second, usedWindows ) )
+      {
+        whichWindow->setParent( iParent, itShared->second );
+        markTimelineUsed( itShared->second, usedWindows );
+      }
+      else
+        shareTimeline( tmpParent, sharedWindows, usedWindows );
     }
 
-    histograms.clear();
+    // Setting a parent resets the level to the minimum one
+    if ( whichWindow->getLevel() != tmpLevel )
+      whichWindow->setLevel( tmpLevel );
+  }
+
+  sharedWindows.insert( std::make_pair( whichWindow->getSemanticSignature(), whichWindow ) );
+}
 
-    for ( PRV_UINT32 i = 0; i < windows.size(); ++i )
+
+void copyOutputFile( const string& fromFile, const string& toFile )
+{
+  std::ifstream source( fromFile.c_str(), std::ios::binary );
+  std::ofstream destiny( toFile.c_str(), std::ios::binary );
+  destiny << source.rdbuf();
+}
+
+
+// Same output files as loadCFGs, but cfgs whose results are identical are
+// computed once: the histogram is executed only for the first cfg and then
+// dumped with the statistic of every other one; identical timelines are
+// dumped once and copied. Timelines equal to others of former cfgs are
+// replaced by them where they are parents, so the batch shares them.
+void loadCFGsInBatch( KernelConnection *myKernel )
+{
+  vector<TBatchCFG> batchCFGs;
+  batchCFGs.reserve( cfgs.size() );
+
+  for( std::map< string, string >::iterator it = cfgs.begin(); it != cfgs.end(); ++it )
+  {
+    SaveOptions options;
+    TBatchCFG tmpCFG;
+    tmpCFG.cfg = it;
+    tmpCFG.outputFile = it->second;
+
+    currentCFG = it;
+    if ( CFGLoader::loadCFG( myKernel, it->first, trace, tmpCFG.windows, tmpCFG.histograms, options ) )
     {
-      if ( windows[ i ] != nullptr )
-        delete windows[ i ];
+      if ( !tmpCFG.histograms.empty() && tmpCFG.histograms.back() != nullptr )
+        tmpCFG.histogram = tmpCFG.histograms.back();
+      else if( !tmpCFG.windows.empty() && tmpCFG.windows.back() != nullptr )
+        tmpCFG.window = tmpCFG.windows.back();
     }
+    else
+      std::cerr << "  [Warning] Cannot load '" << it->first << "' file." << std::endl;
 
-    windows.clear();
+    batchCFGs.push_back( tmpCFG );
   }
+
+  // Groups of cfgs with the same signature, in command line order
+  std::map< string, vector<size_t> > groups;
+  vector< vector<size_t> * > orderedGroups;
+  std::map< string, Timeline * > sharedWindows;
+  for ( size_t i = 0; i < batchCFGs.size(); ++i )
+  {
+    if ( batchCFGs[ i ].histogram == nullptr && batchCFGs[ i ].window == nullptr )
+      continue;
+
+    std::set< Timeline * > usedWindows;
+    if ( batchCFGs[ i ].histogram != nullptr )
+    {
+      for ( Timeline *tmpWindow : { batchCFGs[ i ].histogram->getControlWindow(),
+                                    batchCFGs[ i ].histogram->getDataWindow(),
+                                    batchCFGs[ i ].histogram->getExtraControlWindow() } )
+      {
+        if ( tmpWindow != nullptr )
+          shareTimeline( tmpWindow, sharedWindows, usedWindows );
+      }
+    }
+    else
+      shareTimeline( batchCFGs[ i ].window, sharedWindows, usedWindows );
+
+    string signature = getCFGSignature( batchCFGs[ i ] );
+    // Timelines in many files and unsaved cfgs are never shared
+    if ( signature.empty() || ( batchCFGs[ i ].window != nullptr && option[ MANY_FILES ].active ) )
+      signature = batchCFGs[ i ].cfg->first;
+
+    vector<size_t>& tmpGroup = groups[ signature ];
+    if ( tmpGroup.empty() )
+      orderedGroups.push_back( &tmpGroup );
+    tmpGroup.push_back( i );
+  }
+
+  for ( auto itGroup : orderedGroups )
+  {
+    TBatchCFG& leader = batchCFGs[ ( *itGroup )[ 0 ] ];
+    TextOutput output;
+    setOutputOptions( output );
+
+    currentCFG = leader.cfg;
+    if ( leader.histogram != nullptr )
+    {
+      string leaderStat = leader.histogram->getCurrentStat();
+      bool recalcHisto = true;
+
+      for ( size_t iCFG : *itGroup )
+      {
+        currentCFG = batchCFGs[ iCFG ].cfg;
+        leader.histogram->setCurrentStat( batchCFGs[ iCFG ].histogram->getCurrentStat() );
+        output.dumpHistogram( leader.histogram,
+                              batchCFGs[ iCFG ].outputFile,
+                              option[ PRINT_PLANE ].active,
+                              option[ EMPTY_COLUMNS ].active,
+                              true,
+                              !option[ PREFERENCES_PRECISION ].active,
+                              recalcHisto );
+        recalcHisto = false;
+      }
+
+      leader.histogram->setCurrentStat( leaderStat );
+    }
+    else
+    {
+      output.dumpWindow( leader.window, leader.outputFile );
+
+      for ( auto itCFG = itGroup->begin() + 1; itCFG != itGroup->end(); ++itCFG )
+      {
+        string tmpOutputFile = batchCFGs[ *itCFG ].outputFile;
+        if( tmpOutputFile.rfind( string( ".csv" ) ) == string::npos )
+          tmpOutputFile += ".csv";
+        copyOutputFile( leader.outputFile, tmpOutputFile );
+      }
+    }
+  }
+
+  // Histograms release their windows, which may belong to other cfgs now
+  for ( auto& itCFG : batchCFGs )
+  {
+    for ( Histogram *tmpHisto : itCFG.histograms )
+      delete tmpHisto;
+    itCFG.histograms.clear();
+  }
+
+  for ( auto& itCFG : batchCFGs )
+    deleteCFGObjects( itCFG.windows, itCFG.histograms );
+}
+
+
+void computeCFGs( KernelConnection *myKernel )
+{
+  if ( option[ DUMP_TRACE ].active )
+    trace->dumpFile( sourceTraceName + ".new.global" );
+
+  if ( option[ BATCH_CFGS ].active )
+    loadCFGsInBatch( myKernel );
+  else
+    loadCFGs( myKernel );
+}
+
+
+// Trace name without path and prv extension
+string getTraceBaseName( KernelConnection *myKernel, const string& whichTrace )
+{
+  string baseName = whichTrace.substr( whichTrace.rfind( myKernel->getPathSeparator() ) + 1 );
+
+  if ( baseName.length() > GZIPPED_PRV_SUFFIX.length() &&
+       baseName.compare( baseName.length() - GZIPPED_PRV_SUFFIX.length(), GZIPPED_PRV_SUFFIX.length(), GZIPPED_PRV_SUFFIX ) == 0 )
+    baseName.erase( baseName.length() - GZIPPED_PRV_SUFFIX.length() );
+  else if ( baseName.length() > PRV_SUFFIX.length() &&
+            baseName.compare( baseName.length() - PRV_SUFFIX.length(), PRV_SUFFIX.length(), PRV_SUFFIX ) == 0 )
+    baseName.erase( baseName.length() - PRV_SUFFIX.length() );
+
+  return baseName;
+}
+
+
+// Computes the cfgs for every source trace. Traces are loaded by a pool of
+// workers while the cfgs of the already loaded ones are computed in command
+// line order. The trace being computed counts against the pool size, so no
+// more than that many traces are in memory at once.
+void processManyTraces( KernelConnection *myKernel )
+{
+  const std::map< string, string > traceCFGs( cfgs );
+  TraceLoader *loader = myKernel->newTraceLoader( maxConcurrentLoads );
+  std::deque< TraceLoader::TLoadHandle > loads;
+  size_t nextLoad = 0;
+
+  auto loadAhead = [&]()
+  {
+    while ( nextLoad < sourceTraceNames.size() && loads.size() < loader->getMaxConcurrentLoads() )
+      loads.push_back( loader->load( sourceTraceNames[ nextLoad++ ], option[ NO_LOAD ].active ) );
+  };
+
+  loadAhead();
+
+  for ( auto itTrace : sourceTraceNames )
+  {
+    sourceTraceName = itTrace;
+    trace = nullptr;
+    try
+    {
+      trace = loads.front().get();
+    }
+    catch ( ParaverKernelException& ex )
+    {
+      ex.printMessage();
+    }
+    loads.pop_front();
+
+    if ( trace == nullptr )
+    {
+      std::cerr << "  [ERROR] Cannot load " << sourceTraceName << std::endl;
+      loadAhead();
+      continue;
+    }
+
+    string prefix = getTraceBaseName( myKernel, sourceTraceName ) + ".";
+    cfgs.clear();
+    for ( auto itCFG : traceCFGs )
+    {
+      string outputFile = itCFG.second;
+      outputFile.insert( outputFile.rfind( myKernel->getPathSeparator() ) + 1, prefix );
+      cfgs[ itCFG.first ] = outputFile;
+    }
+
+    computeCFGs( myKernel );
+
+    delete trace;
+    loadAhead();
+  }
+
+  delete loader;
+
+  cfgs = traceCFGs;
 }
 
 
@@ -978,6 +1638,9 @@ int main( int argc, char *argv[] )
 
     if ( parseArguments( myKernel, argc, argv, registeredTool ) )
     {
+      if ( option[ BINARY_CACHE ].active )
+        ParaverConfig::getInstance()->setGlobalTraceBinaryCache( true );
+
       if ( option[ SHOW_HELP ].active )
         printHelp();
       else if ( option[ SHOW_VERSION ].active )
@@ -1018,18 +1681,22 @@ int main( int argc, char *argv[] )
           }
 
           cfgs = validCfgs;
-          if ( !loadTrace( myKernel ) )
+          if ( sourceTraceNames.size() > 1 )
           {
-            std::cerr << "  [ERROR] Cannot load " << sourceTraceName << std::endl;
-            exit( 1 );
+            processManyTraces( myKernel );
           }
+          else
+          {
+            if ( !loadTrace( myKernel ) )
+            {
+              std::cerr << "  [ERROR] Cannot load " << sourceTraceName << std::endl;
+              exit( 1 );
+            }
 
-          if ( option[ DUMP_TRACE ].active )
-            trace->dumpFile( sourceTraceName + ".new.global" );
-
-          loadCFGs( myKernel );
+            computeCFGs( myKernel );
 
-          delete trace;
+            delete trace;
+          }
         }
       }
     }
@@ -24,6 +24,7 @@
 
 #include <string>
 #include <fstream>
+#include <mutex>
 #include <sstream>
 #include <stdlib.h>
 #ifdef _WIN32
@@ -49,8 +50,13 @@ ParaverConfig *ParaverConfig::instance = nullptr;
 
 ParaverConfig *ParaverConfig::getInstance()
 {
-  if ( ParaverConfig::instance == nullptr )
-    ParaverConfig::instance = new ParaverConfig();
+  // Traces may be loaded from several threads
+  static std::once_flag instanceFlag;
+  std::call_once( instanceFlag, []()
+  {
+    if ( ParaverConfig::instance == nullptr )
+      ParaverConfig::instance = new ParaverConfig();
+  } );
   return ParaverConfig::instance;
 }
 
@@ -165,6 +171,8 @@ ParaverConfig::ParaverConfig() : isModified( false )
   xmlGlobal.helpContentsQuestionAnswered = false;
   xmlGlobal.disableTimelineZoomMouseWheel = false;
   xmlGlobal.appsChecked = false;
+  xmlGlobal.traceBinaryCache = false;
+  xmlGlobal.noLoadCacheSize = 256;
 
   xmlTimeline.defaultName = "New window # %N";
   xmlTimeline.nameFormat = "%W @ %T";
@@ -408,6 +416,18 @@ void ParaverConfig::setDisableTimelineZoomMouseWheel( bool disable )
   xmlGlobal.disableTimelineZoomMouseWheel = disable;
 }
 
+void ParaverConfig::setGlobalTraceBinaryCache( bool whichTraceBinaryCache )
+{
+  isModified = isModified || ( xmlGlobal.traceBinaryCache != whichTraceBinaryCache );
+  xmlGlobal.traceBinaryCache = whichTraceBinaryCache;
+}
+
+void ParaverConfig::setGlobalNoLoadCacheSize( PRV_UINT32 whichNoLoadCacheSize )
+{
+  isModified = isModified || ( xmlGlobal.noLoadCacheSize != whichNoLoadCacheSize );
+  xmlGlobal.noLoadCacheSize = whichNoLoadCacheSize;
+}
+
 void ParaverConfig::setAppsChecked() // will always set to true
 {
   xmlGlobal.appsChecked = true;
@@ -494,6 +514,16 @@ bool ParaverConfig::getDisableTimelineZoomMouseWheel() const
   return xmlGlobal.disableTimelineZoomMouseWheel;
 }
 
+bool ParaverConfig::getGlobalTraceBinaryCache() const
+{
+  return xmlGlobal.traceBinaryCache;
+}
+
+PRV_UINT32 ParaverConfig::getGlobalNoLoadCacheSize() const
+{
+  return xmlGlobal.noLoadCacheSize;
+}
+
 
 // TIMELINES XML SECTION
 void ParaverConfig::setTimelineDefaultName( string whichDefaultName )
@@ -109,6 +109,8 @@ class ParaverConfig
     void setGlobalHelpContentsQuestionAnswered( bool isHelpContentsQuestionAnswered );
     void setAppsChecked(); // will always set to true
     void setDisableTimelineZoomMouseWheel( bool disable );
+    void setGlobalTraceBinaryCache( bool whichTraceBinaryCache );
+    void setGlobalNoLoadCacheSize( PRV_UINT32 whichNoLoadCacheSize );
 
     std::string getGlobalTracesPath() const;
     std::string getGlobalCFGsPath() const;
@@ -128,6 +130,8 @@ class ParaverConfig
     bool getGlobalHelpContentsQuestionAnswered() const;
     bool getAppsChecked() const;
     bool getDisableTimelineZoomMouseWheel() const;
+    bool getGlobalTraceBinaryCache() const;
+    PRV_UINT32 getGlobalNoLoadCacheSize() const;
 
     // TIMELINES XML SECTION
     void setTimelineDefaultName( std::string whichDefaultName );
@@ -404,6 +408,14 @@ class ParaverConfig
         {
           ar & boost::serialization::make_nvp( "disable_timeline_zoom_mouse_wheel", disableTimelineZoomMouseWheel );
         }
+        if ( version >= 10 )
+        {
+          ar & boost::serialization::make_nvp( "trace_binary_cache", traceBinaryCache );
+        }
+        if ( version >= 11 )
+        {
+          ar & boost::serialization::make_nvp( "no_load_cache_size", noLoadCacheSize );
+        }
       }
 
       std::string tracesPath; // also for paraload.sig!
@@ -423,6 +435,8 @@ class ParaverConfig
       bool helpContentsQuestionAnswered;
       bool disableTimelineZoomMouseWheel;
       bool appsChecked;
+      bool traceBinaryCache;
+      PRV_UINT32 noLoadCacheSize; // MB of parsed records kept by not loaded traces
 
     } xmlGlobal;
 
@@ -823,7 +837,7 @@ class ParaverConfig
 
 // Second version: introducing some structure
 BOOST_CLASS_VERSION( ParaverConfig, 3 )
-BOOST_CLASS_VERSION( ParaverConfig::XMLPreferencesGlobal, 9 )
+BOOST_CLASS_VERSION( ParaverConfig::XMLPreferencesGlobal, 11 )
 BOOST_CLASS_VERSION( ParaverConfig::XMLPreferencesTimeline, 5 )
 BOOST_CLASS_VERSION( ParaverConfig::XMLPreferencesHistogram, 8 )
 BOOST_CLASS_VERSION( ParaverConfig::XMLPreferencesCutter, 1 )
@@ -25,7 +25,10 @@
 #pragma once
 
 
+#include <cstddef>
 #include <set>
+#include <memory>
+#include <vector>
 #include "paraverkerneltypes.h"
 
 class KernelConnection;
@@ -173,10 +176,137 @@ struct ltrecord
 };
 
 
+// Pool of equally sized nodes owned by one record list. Freed nodes are kept
+// for reuse, so clearing the list between rows doesn't return memory to the
+// heap and the next calcNext doesn't ask for it again.
+class RecordListArena
+{
+  public:
+    RecordListArena() = default;
+    RecordListArena( const RecordListArena& ) = delete;
+    RecordListArena& operator=( const RecordListArena& ) = delete;
+
+    ~RecordListArena()
+    {
+      for ( char *chunk : chunks )
+        ::operator delete( chunk );
+    }
+
+    void *allocate( size_t whichSize )
+    {
+      if ( slotSize == 0 )
+        slotSize = ( ( whichSize + alignof( std::max_align_t ) - 1 ) / alignof( std::max_align_t ) ) * alignof( std::max_align_t );
+      else if ( whichSize > slotSize )
+        return ::operator new( whichSize );
+
+      if ( freeSlots != nullptr )
+      {
+        void *tmpSlot = freeSlots;
+        freeSlots = *static_cast<void **>( freeSlots );
+        return tmpSlot;
+      }
+
+      if ( nextSlot == endSlot )
+      {
+        chunks.push_back( static_cast<char *>( ::operator new( slotSize * SLOTS_PER_CHUNK ) ) );
+        nextSlot = chunks.back();
+        endSlot = nextSlot + slotSize * SLOTS_PER_CHUNK;
+      }
+
+      void *tmpSlot = nextSlot;
+      nextSlot += slotSize;
+      return tmpSlot;
+    }
+
+    void deallocate( void *whichSlot, size_t whichSize )
+    {
+      if ( whichSize > slotSize )
+      {
+        ::operator delete( whichSlot );
+        return;
+      }
+
+      *static_cast<void **>( whichSlot ) = freeSlots;
+      freeSlots = whichSlot;
+    }
+
+  private:
+    static constexpr size_t SLOTS_PER_CHUNK = 256;
+
+    size_t slotSize = 0;
+    std::vector<char *> chunks;
+    char *nextSlot = nullptr;
+    char *endSlot = nullptr;
+    void *freeSlots = nullptr;
+};
+
+// Every list gets its own arena: copies made by the copy constructor start a
+// new one, while moves and swaps carry the arena along with the nodes.
+template< typename T >
+class RecordListAllocator
+{
+  public:
+    typedef T value_type;
+    typedef std::false_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    RecordListAllocator() : arena( std::make_shared<RecordListArena>() )
+    {}
+
+    template< typename U >
+    RecordListAllocator( const RecordListAllocator<U>& other ) : arena( other.arena )
+    {}
+
+    T *allocate( size_t n )
+    {
+      if ( n != 1 )
+        return static_cast<T *>( ::operator new( n * sizeof( T ) ) );
+      return static_cast<T *>( arena->allocate( sizeof( T ) ) );
+    }
+
+    void deallocate( T *p, size_t n )
+    {
+      if ( n != 1 )
+        ::operator delete( p );
+      else
+        arena->deallocate( p, sizeof( T ) );
+    }
+
+    RecordListAllocator select_on_container_copy_construction() const
+    {
+      return RecordListAllocator();
+    }
+
+    template< typename U >
+    bool operator==( const RecordListAllocator<U>& other ) const
+    {
+      return arena == other.arena;
+    }
+
+    template< typename U >
+    bool operator!=( const RecordListAllocator<U>& other ) const
+    {
+      return arena != other.arena;
+    }
+
+  private:
+    std::shared_ptr<RecordListArena> arena;
+
+    template< typename U > friend class RecordListAllocator;
+};
+
+#ifdef RECORD_LIST_POOL_ENABLED
+typedef std::multiset<RLRecord, ltrecord, RecordListAllocator<RLRecord> > TRecordListContainer;
+#else
+typedef std::multiset<RLRecord, ltrecord> TRecordListContainer;
+#endif
+
+
 class RecordList
 {
   public:
-    typedef std::multiset<RLRecord, ltrecord>::iterator iterator;
+    typedef TRecordListContainer::iterator iterator;
 
     static RecordList *create( RecordList *whichList );
 
@@ -0,0 +1,380 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                               libparaver-api                              *
+ *                       Paraver Main Computing Library                      *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+
+
+
+
+
+#include <algorithm>
+#include <cmath>
+
+#include "semanticpyramid.h"
+
+
+void SemanticPyramid::TSummary::add( TSemanticValue whichValue )
+{
+  if ( whichValue != 0.0 )
+  {
+    if ( countNotZero == 0 || whichValue > maxNotZero )
+      maxNotZero = whichValue;
+    if ( countNotZero == 0 || whichValue < minNotZero )
+      minNotZero = whichValue;
+    ++countNotZero;
+  }
+
+  sum += whichValue;
+  last = whichValue;
+  ++count;
+}
+
+
+void SemanticPyramid::TSummary::merge( const TSummary& whichSummary )
+{
+  if ( whichSummary.count == 0 )
+    return;
+
+  if ( whichSummary.countNotZero > 0 )
+  {
+    if ( countNotZero == 0 || whichSummary.maxNotZero > maxNotZero )
+      maxNotZero = whichSummary.maxNotZero;
+    if ( countNotZero == 0 || whichSummary.minNotZero < minNotZero )
+      minNotZero = whichSummary.minNotZero;
+    countNotZero += whichSummary.countNotZero;
+  }
+
+  sum += whichSummary.sum;
+  last = whichSummary.last;
+  count += whichSummary.count;
+}
+
+
+TSemanticValue SemanticPyramid::TSummary::selectValue( DrawModeMethod whichMethod ) const
+{
+  switch ( whichMethod )
+  {
+    case DrawModeMethod::DRAW_MAXIMUM:
+      if ( countNotZero == 0 || ( countNotZero < count && maxNotZero < 0.0 ) )
+        return 0.0;
+      return maxNotZero;
+
+    case DrawModeMethod::DRAW_MINNOTZERO:
+      return countNotZero == 0 ? 0.0 : minNotZero;
+
+    case DrawModeMethod::DRAW_AVERAGE:
+      return sum / count;
+
+    case DrawModeMethod::DRAW_AVERAGENOTZERO:
+      return countNotZero == 0 ? 0.0 : sum / countNotZero;
+
+    default:
+      break;
+  }
+
+  return last;
+}
+
+
+bool SemanticPyramid::TSummary::outOfScale( TSemanticValue whichMinimum, TSemanticValue whichMaximum ) const
+{
+  return countNotZero > 0 && ( minNotZero < whichMinimum || maxNotZero > whichMaximum );
+}
+
+
+// Same limits TimelineProxy::calcNext computes for every value
+void SemanticPyramid::TSummary::updateLimits( TSemanticValue& rowComputedMaxY,
+                                              TSemanticValue& rowComputedMinY,
+                                              int& rowComputedZeros ) const
+{
+  rowComputedZeros = rowComputedZeros || countNotZero < count;
+  if ( countNotZero == 0 )
+    return;
+
+  if ( rowComputedMaxY < maxNotZero )
+    rowComputedMaxY = maxNotZero;
+  if ( rowComputedMinY == 0 || rowComputedMinY > minNotZero )
+    rowComputedMinY = minNotZero;
+}
+
+
+SemanticPyramid::TSummary SemanticPyramid::TNode::getValues() const
+{
+  TSummary tmpValues;
+  tmpValues.add( head );
+  tmpValues.merge( body );
+
+  return tmpValues;
+}
+
+
+std::list<SemanticPyramid *> SemanticPyramid::recentPyramids;
+std::mutex SemanticPyramid::recentPyramidsMutex;
+
+
+SemanticPyramid::SemanticPyramid() :
+    traceEndTime( 0.0 ), bucketWidth( 0.0 ), numBuckets( 0 )
+{
+  std::lock_guard<std::mutex> lock( recentPyramidsMutex );
+  recentPyramids.push_back( this );
+}
+
+
+SemanticPyramid::~SemanticPyramid()
+{
+  std::lock_guard<std::mutex> lock( recentPyramidsMutex );
+  recentPyramids.remove( this );
+}
+
+
+void SemanticPyramid::setup( const std::string& whichSignature, TObjectOrder numRows, TRecordTime whichEndTime )
+{
+  if ( whichSignature != signature || numRows != rows.size() || whichEndTime != traceEndTime )
+  {
+    signature = whichSignature;
+    traceEndTime = whichEndTime;
+    rows.clear();
+    rows.resize( numRows );
+
+    // Power of two buckets, as many as fit in the window share for every row
+    size_t maxRowBuckets = numRows == 0 ? 0 : MAX_WINDOW_MEMORY / ( 2 * sizeof( TNode ) * numRows );
+    numBuckets = MAX_BUCKETS;
+    while ( numBuckets >= MIN_BUCKETS && numBuckets > maxRowBuckets )
+      numBuckets >>= 1;
+
+    if ( numBuckets < MIN_BUCKETS || traceEndTime <= 0.0 )
+      numBuckets = 0;
+
+    bucketWidth = numBuckets == 0 ? 0.0 : traceEndTime / numBuckets;
+  }
+
+  reserveMemory();
+}
+
+
+bool SemanticPyramid::isEnabled() const
+{
+  return numBuckets > 0;
+}
+
+
+bool SemanticPyramid::isMethodSupported( DrawModeMethod whichMethod )
+{
+  switch ( whichMethod )
+  {
+    case DrawModeMethod::DRAW_LAST:
+    case DrawModeMethod::DRAW_MAXIMUM:
+    case DrawModeMethod::DRAW_MINNOTZERO:
+    case DrawModeMethod::DRAW_AVERAGE:
+    case DrawModeMethod::DRAW_AVERAGENOTZERO:
+      return true;
+
+    default:
+      break;
+  }
+
+  return false;
+}
+
+
+bool SemanticPyramid::isSummarized( std::vector<TObjectOrder>::const_iterator firstRow,
+                                    std::vector<TObjectOrder>::const_iterator lastRow,
+                                    TRecordTime rangeDuration ) const
+{
+  if ( numBuckets == 0 || rangeDuration < MIN_BUCKETS_PER_RANGE * bucketWidth )
+    return false;
+
+  for ( std::vector<TObjectOrder>::const_iterator itRow = firstRow; itRow <= lastRow; ++itRow )
+  {
+    if ( !rows[ *itRow ].built )
+      return false;
+  }
+
+  return true;
+}
+
+
+void SemanticPyramid::beginRow( TObjectOrder whichRow )
+{
+  TRow& tmpRow = rows[ whichRow ];
+
+  tmpRow.built = false;
+  tmpRow.nodes.assign( 2 * numBuckets, TNode() );
+  tmpRow.nextHead = 0;
+}
+
+
+// Intervals must come in time order from the beginning of the trace
+void SemanticPyramid::addInterval( TObjectOrder whichRow,
+                                   TRecordTime beginTime,
+                                   TRecordTime endTime,
+                                   TSemanticValue whichValue )
+{
+  if ( beginTime >= traceEndTime )
+    return;
+
+  TRow& tmpRow = rows[ whichRow ];
+  PRV_UINT32 tmpBucket = getBucket( beginTime );
+  TNode& tmpLeaf = tmpRow.nodes[ numBuckets + tmpBucket ];
+
+  if ( tmpBucket >= tmpRow.nextHead )
+  {
+    // Begins just at the bucket boundary
+    tmpLeaf.entry.add( whichValue );
+    if ( endTime > beginTime )
+    {
+      tmpLeaf.head = whichValue;
+      tmpRow.nextHead = tmpBucket + 1;
+    }
+  }
+  else
+    tmpLeaf.body.add( whichValue );
+
+  // Following buckets beginning inside the interval
+  for ( PRV_UINT32 iBucket = tmpRow.nextHead; iBucket < numBuckets && iBucket * bucketWidth < endTime; ++iBucket )
+  {
+    tmpRow.nodes[ numBuckets + iBucket ].head = whichValue;
+    tmpRow.nextHead = iBucket + 1;
+  }
+}
+
+
+void SemanticPyramid::endRow( TObjectOrder whichRow )
+{
+  TRow& tmpRow = rows[ whichRow ];
+
+  for ( PRV_UINT32 iNode = numBuckets - 1; iNode > 0; --iNode )
+    tmpRow.nodes[ iNode ] = merge( tmpRow.nodes[ 2 * iNode ], tmpRow.nodes[ 2 * iNode + 1 ] );
+
+  tmpRow.built = true;
+}
+
+
+void SemanticPyramid::discardRow( TObjectOrder whichRow )
+{
+  TRow& tmpRow = rows[ whichRow ];
+
+  tmpRow.built = false;
+  std::vector<TNode>().swap( tmpRow.nodes );
+}
+
+
+SemanticPyramid::TNode SemanticPyramid::getRange( TObjectOrder whichRow, TRecordTime beginTime, TRecordTime endTime ) const
+{
+  const std::vector<TNode>& tmpNodes = rows[ whichRow ].nodes;
+
+  PRV_UINT32 firstBucket = getBoundary( beginTime );
+  if ( firstBucket >= numBuckets )
+    firstBucket = numBuckets - 1;
+  PRV_UINT32 lastBucket = getBoundary( endTime );
+  if ( lastBucket <= firstBucket )
+    lastBucket = firstBucket + 1;
+
+  TNode leftNode;
+  TNode rightNode;
+  bool hasLeft = false;
+  bool hasRight = false;
+  for ( PRV_UINT32 l = firstBucket + numBuckets, r = lastBucket + numBuckets; l < r; l >>= 1, r >>= 1 )
+  {
+    if ( l & 1 )
+    {
+      leftNode = hasLeft ? merge( leftNode, tmpNodes[ l ] ) : tmpNodes[ l ];
+      hasLeft = true;
+      ++l;
+    }
+    if ( r & 1 )
+    {
+      --r;
+      rightNode = hasRight ? merge( tmpNodes[ r ], rightNode ) : tmpNodes[ r ];
+      hasRight = true;
+    }
+  }
+
+  if ( !hasLeft )
+    return rightNode;
+  if ( !hasRight )
+    return leftNode;
+  return merge( leftNode, rightNode );
+}
+
+
+PRV_UINT32 SemanticPyramid::getBucket( TRecordTime whichTime ) const
+{
+  PRV_UINT32 tmpBucket = static_cast<PRV_UINT32>( whichTime / bucketWidth );
+  return tmpBucket < numBuckets ? tmpBucket : numBuckets - 1;
+}
+
+
+PRV_UINT32 SemanticPyramid::getBoundary( TRecordTime whichTime ) const
+{
+  TRecordTime tmpBoundary = std::round( whichTime / bucketWidth );
+  return tmpBoundary < numBuckets ? static_cast<PRV_UINT32>( tmpBoundary ) : numBuckets;
+}
+
+
+size_t SemanticPyramid::getMemory() const
+{
+  size_t tmpMemory = 0;
+  for ( const TRow& itRow : rows )
+    tmpMemory += itRow.nodes.capacity() * sizeof( TNode );
+
+  return tmpMemory;
+}
+
+
+void SemanticPyramid::releaseRows()
+{
+  for ( TObjectOrder iRow = 0; iRow < rows.size(); ++iRow )
+    discardRow( iRow );
+}
+
+
+// Empties the least recently set up pyramids until this one fits whole
+void SemanticPyramid::reserveMemory()
+{
+  std::lock_guard<std::mutex> lock( recentPyramidsMutex );
+
+  recentPyramids.splice( recentPyramids.begin(), recentPyramids,
+                         std::find( recentPyramids.begin(), recentPyramids.end(), this ) );
+
+  size_t tmpNeeded = 2 * sizeof( TNode ) * numBuckets * rows.size();
+  size_t tmpUsed = 0;
+  for ( std::list<SemanticPyramid *>::iterator it = std::next( recentPyramids.begin() ); it != recentPyramids.end(); ++it )
+    tmpUsed += ( *it )->getMemory();
+
+  for ( std::list<SemanticPyramid *>::reverse_iterator it = recentPyramids.rbegin();
+        tmpUsed + tmpNeeded > MAX_MEMORY && *it != this; ++it )
+  {
+    tmpUsed -= ( *it )->getMemory();
+    ( *it )->releaseRows();
+  }
+}
+
+
+SemanticPyramid::TNode SemanticPyramid::merge( const TNode& leftNode, const TNode& rightNode )
+{
+  TNode tmpNode = leftNode;
+  tmpNode.body.merge( rightNode.entry );
+  tmpNode.body.merge( rightNode.body );
+
+  return tmpNode;
+}
@@ -0,0 +1,143 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                               libparaver-api                              *
+ *                       Paraver Main Computing Library                      *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+
+
+
+#pragma once
+
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "paraverkerneltypes.h"
+#include "drawmode.h"
+
+// Summaries of the semantic values of each row by time buckets, so that a
+// zoomed out timeline can be drawn without computing every interval again.
+// Rows are filled while drawing the whole trace; nodes above the buckets
+// summarize 2^k of them and any time range is merged in O(log buckets).
+class SemanticPyramid
+{
+  public:
+    // Values of consecutive intervals, in time order
+    struct TSummary
+    {
+      PRV_UINT32 count = 0;
+      PRV_UINT32 countNotZero = 0;
+      TSemanticValue sum = 0.0;
+      TSemanticValue last = 0.0;
+      TSemanticValue maxNotZero = 0.0;
+      TSemanticValue minNotZero = 0.0;
+
+      void add( TSemanticValue whichValue );
+      void merge( const TSummary& whichSummary );
+
+      TSemanticValue selectValue( DrawModeMethod whichMethod ) const;
+      bool outOfScale( TSemanticValue whichMinimum, TSemanticValue whichMaximum ) const;
+      void updateLimits( TSemanticValue& rowComputedMaxY,
+                         TSemanticValue& rowComputedMinY,
+                         int& rowComputedZeros ) const;
+    };
+
+    // Same values a pixel is drawn from: the interval at the beginning of the
+    // range (head) and all the intervals beginning after it (body).
+    // Entry keeps the intervals beginning just at the range begin, needed
+    // to merge it after another range.
+    struct TNode
+    {
+      TSemanticValue head = 0.0;
+      TSummary entry;
+      TSummary body;
+
+      TSummary getValues() const;
+    };
+
+    SemanticPyramid();
+    SemanticPyramid( const SemanticPyramid& ) = delete;
+    SemanticPyramid& operator=( const SemanticPyramid& ) = delete;
+    ~SemanticPyramid();
+
+    // Drops every row when the semantics or the rows change, and makes room
+    // in the shared budget for the whole pyramid. Must be called before
+    // drawing, outside parallel regions.
+    void setup( const std::string& whichSignature, TObjectOrder numRows, TRecordTime whichEndTime );
+
+    bool isEnabled() const;
+    static bool isMethodSupported( DrawModeMethod whichMethod );
+
+    // Each range must span several buckets to be summarized
+    bool isSummarized( std::vector<TObjectOrder>::const_iterator firstRow,
+                       std::vector<TObjectOrder>::const_iterator lastRow,
+                       TRecordTime rangeDuration ) const;
+
+    void beginRow( TObjectOrder whichRow );
+    void addInterval( TObjectOrder whichRow,
+                      TRecordTime beginTime,
+                      TRecordTime endTime,
+                      TSemanticValue whichValue );
+    void endRow( TObjectOrder whichRow );
+    void discardRow( TObjectOrder whichRow );
+
+    // Range rounded to the nearest bucket boundaries
+    TNode getRange( TObjectOrder whichRow, TRecordTime beginTime, TRecordTime endTime ) const;
+
+  private:
+    struct TRow
+    {
+      bool built = false;
+      std::vector<TNode> nodes;
+
+      // Only while building
+      PRV_UINT32 nextHead = 0;
+    };
+
+    static constexpr size_t MAX_MEMORY = 256 * 1024 * 1024;
+    static constexpr size_t MAX_WINDOW_MEMORY = MAX_MEMORY / 4;
+    static constexpr PRV_UINT32 MAX_BUCKETS = 16384;
+    static constexpr PRV_UINT32 MIN_BUCKETS = 512;
+    static constexpr PRV_UINT32 MIN_BUCKETS_PER_RANGE = 4;
+
+    std::string signature;
+    TRecordTime traceEndTime;
+    TRecordTime bucketWidth;
+    PRV_UINT32 numBuckets;
+    std::vector<TRow> rows;
+
+    // Most recently set up first
+    static std::list<SemanticPyramid *> recentPyramids;
+    static std::mutex recentPyramidsMutex;
+
+    PRV_UINT32 getBucket( TRecordTime whichTime ) const;
+    PRV_UINT32 getBoundary( TRecordTime whichTime ) const;
+
+    size_t getMemory() const;
+    void releaseRows();
+    void reserveMemory();
+
+    static TNode merge( const TNode& leftNode, const TNode& rightNode );
+};
+
+
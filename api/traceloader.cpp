@@ -0,0 +1,196 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                               libparaver-api                              *
+ *                       Paraver Main Computing Library                      *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+
+
+
+#include <algorithm>
+
+#include "kernelconnection.h"
+#include "progresscontroller.h"
+#include "trace.h"
+#include "traceloader.h"
+
+#ifdef PARALLEL_ENABLED
+#include "omp.h"
+#endif
+
+using std::string;
+
+TraceLoader::TraceLoader( KernelConnection *whichKernel, size_t maxConcurrentLoads ) :
+    myKernel( whichKernel ), finishing( false )
+{
+  if ( maxConcurrentLoads == 0 )
+    maxConcurrentLoads = DefaultConcurrentLoads;
+
+  workers.reserve( maxConcurrentLoads );
+  for ( size_t i = 0; i < maxConcurrentLoads; ++i )
+    workers.emplace_back( &TraceLoader::workerLoop, this, maxConcurrentLoads );
+}
+
+
+TraceLoader::~TraceLoader()
+{
+  cancelAll();
+
+  {
+    std::lock_guard<std::mutex> lock( jobsMutex );
+    finishing = true;
+  }
+  jobAvailable.notify_all();
+
+  for ( auto& it : workers )
+    it.join();
+}
+
+
+TraceLoader::TLoadHandle TraceLoader::load( const string& whichFile, bool noLoad, ProgressController *progress )
+{
+  TLoadJob *tmpJob = new TLoadJob;
+  tmpJob->fileName = whichFile;
+  tmpJob->noLoad = noLoad;
+  tmpJob->progress = progress;
+  TLoadHandle tmpHandle = tmpJob->result.get_future().share();
+
+  {
+    std::lock_guard<std::mutex> lock( jobsMutex );
+    pendingJobs.push_back( tmpJob );
+  }
+  jobAvailable.notify_one();
+
+  return tmpHandle;
+}
+
+
+void TraceLoader::cancelAll()
+{
+  std::deque<TLoadJob *> cancelledJobs;
+
+  {
+    std::lock_guard<std::mutex> lock( jobsMutex );
+    cancelledJobs.swap( pendingJobs );
+    for ( auto it : runningJobs )
+    {
+      if ( it->progress != nullptr )
+        it->progress->setStop( true );
+    }
+  }
+  jobFinished.notify_all();
+
+  for ( auto it : cancelledJobs )
+  {
+    it->result.set_value( nullptr );
+    delete it;
+  }
+}
+
+
+void TraceLoader::wait()
+{
+  std::unique_lock<std::mutex> lock( jobsMutex );
+  jobFinished.wait( lock, [this]{ return pendingJobs.empty() && runningJobs.empty(); } );
+}
+
+
+size_t TraceLoader::getMaxConcurrentLoads() const
+{
+  return workers.size();
+}
+
+
+size_t TraceLoader::getPendingLoads() const
+{
+  std::lock_guard<std::mutex> lock( jobsMutex );
+  return pendingJobs.size() + runningJobs.size();
+}
+
+
+void TraceLoader::workerLoop( size_t numWorkers )
+{
+#ifdef PARALLEL_ENABLED
+  // Parallel body reading inside every load shares the cores with the other
+  // workers
+  omp_set_num_threads( std::max( omp_get_max_threads() / static_cast<int>( numWorkers ), 1 ) );
+#endif
+
+  while ( true )
+  {
+    TLoadJob *tmpJob;
+
+    {
+      std::unique_lock<std::mutex> lock( jobsMutex );
+      jobAvailable.wait( lock, [this]{ return finishing || !pendingJobs.empty(); } );
+      if ( pendingJobs.empty() )
+        return;
+
+      tmpJob = pendingJobs.front();
+      pendingJobs.pop_front();
+      runningJobs.push_back( tmpJob );
+    }
+
+    runJob( tmpJob );
+
+    {
+      std::lock_guard<std::mutex> lock( jobsMutex );
+      runningJobs.erase( std::find( runningJobs.begin(), runningJobs.end(), tmpJob ) );
+    }
+    jobFinished.notify_all();
+
+    delete tmpJob;
+  }
+}
+
+
+void TraceLoader::runJob( TLoadJob *whichJob )
+{
+  if ( isStopped( whichJob ) )
+  {
+    whichJob->result.set_value( nullptr );
+    return;
+  }
+
+  try
+  {
+    Trace *tmpTrace = Trace::create( myKernel, whichJob->fileName, whichJob->noLoad, whichJob->progress );
+
+    // A stopped load leaves the trace half read
+    if ( isStopped( whichJob ) )
+    {
+      delete tmpTrace;
+      tmpTrace = nullptr;
+    }
+
+    whichJob->result.set_value( tmpTrace );
+  }
+  catch ( ... )
+  {
+    whichJob->result.set_exception( std::current_exception() );
+  }
+}
+
+
+bool TraceLoader::isStopped( const TLoadJob *whichJob )
+{
+  return whichJob->progress != nullptr && whichJob->progress->getStop();
+}
+
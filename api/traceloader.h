@@ -0,0 +1,93 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                               libparaver-api                              *
+ *                       Paraver Main Computing Library                      *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+
+
+#pragma once
+
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class KernelConnection;
+class ProgressController;
+class Trace;
+
+// Loads traces in a bounded pool of worker threads. Every load returns a
+// future that becomes ready with the same Trace that Trace::create would give,
+// or with nullptr if the load was cancelled; loading exceptions are rethrown
+// by get(). Progress handlers of the given controllers are called from the
+// worker threads.
+class TraceLoader
+{
+  public:
+    typedef std::shared_future<Trace *> TLoadHandle;
+
+    // Every loaded trace stays in memory until its owner deletes it, so only
+    // a couple of loads run ahead by default
+    static constexpr size_t DefaultConcurrentLoads = 2;
+
+    // maxConcurrentLoads == 0 means DefaultConcurrentLoads workers
+    TraceLoader( KernelConnection *whichKernel, size_t maxConcurrentLoads = 0 );
+    ~TraceLoader();
+
+    TLoadHandle load( const std::string& whichFile, bool noLoad, ProgressController *progress = nullptr );
+
+    // Pending loads are discarded and running ones are stopped through their
+    // progress controller
+    void cancelAll();
+    // Blocks until every queued load has finished
+    void wait();
+
+    size_t getMaxConcurrentLoads() const;
+    size_t getPendingLoads() const;
+
+  private:
+    struct TLoadJob
+    {
+      std::string fileName;
+      bool noLoad;
+      ProgressController *progress;
+      std::promise<Trace *> result;
+    };
+
+    KernelConnection *myKernel;
+    std::vector<std::thread> workers;
+    std::deque<TLoadJob *> pendingJobs;
+    std::vector<TLoadJob *> runningJobs;
+    mutable std::mutex jobsMutex;
+    std::condition_variable jobAvailable;
+    std::condition_variable jobFinished;
+    bool finishing;
+
+    void workerLoop( size_t numWorkers );
+    void runJob( TLoadJob *whichJob );
+    static bool isStopped( const TLoadJob *whichJob );
+};
+
+
@@ -522,6 +522,14 @@ void TimelineProxy::computeYScale( ProgressController *progress )
     setComputeYMaxOnInit( false );
     init( winBeginTime, NOCREATE );
 
+    if( computeYScaleFromPyramid( selected ) )
+    {
+      maximumY = computedMaxY;
+      minimumY = computedMinY;
+      existSemanticZero = computedZeros;
+      return;
+    }
+
     std::string previousMessage;
     double currentObject = 0.0;
     int progressSteps = 0;
@@ -628,6 +636,39 @@ void TimelineProxy::computeYScale( ProgressController *progress )
   existSemanticZero = computedZeros;
 }
 
+void TimelineProxy::updateSemanticPyramid()
+{
+  semanticPyramid.setup( getSemanticSignature(), getWindowLevelObjects(), myTrace->getEndTime() );
+}
+
+// Only the whole trace is exact, summarized in the top of the pyramid
+bool TimelineProxy::computeYScaleFromPyramid( vector< TObjectOrder >& selected )
+{
+  if( selected.empty() || winBeginTime > 0 || winEndTime < myTrace->getEndTime() )
+    return false;
+
+  updateSemanticPyramid();
+  if( !semanticPyramid.isSummarized( selected.begin(), selected.end() - 1, winEndTime - winBeginTime ) )
+    return false;
+
+  for( vector< TObjectOrder >::iterator obj = selected.begin(); obj != selected.end(); ++obj )
+  {
+    TSemanticValue rowComputedMaxY = 0.0;
+    TSemanticValue rowComputedMinY = 0.0;
+    int rowComputedZeros = false;
+    semanticPyramid.getRange( *obj, winBeginTime, winEndTime ).getValues().updateLimits( rowComputedMaxY, rowComputedMinY, rowComputedZeros );
+
+    computedZeros = computedZeros || rowComputedZeros;
+    computedMaxY = computedMaxY > rowComputedMaxY ? computedMaxY : rowComputedMaxY;
+    if ( computedMinY == 0.0 )
+      computedMinY = rowComputedMinY;
+    else if( rowComputedMinY != 0.0 )
+      computedMinY = computedMinY < rowComputedMinY ? computedMinY : rowComputedMinY;
+  }
+
+  return true;
+}
+
 void TimelineProxy::setComputeYMaxOnInit( bool newValue )
 {
   computeYMaxOnInit = newValue;
@@ -1383,6 +1424,11 @@ SemanticInfoType TimelineProxy::getSemanticInfoType() const
   return myWindow->getSemanticInfoType();
 }
 
+string TimelineProxy::getSemanticSignature() const
+{
+  return myWindow->getSemanticSignature();
+}
+
 void TimelineProxy::getAllSemanticFunctions( TSemanticGroup whichGroup,
     vector<string>& onVector ) const
 {
@@ -2159,6 +2205,8 @@ void TimelineProxy::computeSemanticParallel( vector< TObjectOrder >& selectedSet
   if( getWindowBeginTime() == getWindowEndTime() )
     return;
 
+  updateSemanticPyramid();
+
   int numRows = 0;
   if( isFusedLinesColorSet() )
   {
@@ -2362,34 +2410,68 @@ void TimelineProxy::computeSemanticRowParallel( int numRows,
 {
   float magnify = float( getPixelSize() );
 
-  vector<TSemanticValue> timeValues;
-  vector<TSemanticValue> rowValues;
+  DrawModeReducer timeValues( getDrawModeTime() );
+  DrawModeReducer rowValues( getDrawModeObject() );
 
   vector<TObjectOrder>::iterator first = find( selectedSet.begin(), selectedSet.end(), firstRow );
   vector<TObjectOrder>::iterator last  = find( selectedSet.begin(), selectedSet.end(), lastRow );
 
   TRecordTime tmpLastTime = getWindowBeginTime();
 
-  for( vector<TObjectOrder>::iterator row = first; row <= last; ++row )
+  // Events and communications can't be drawn from the summaries
+  bool usePyramid = ( isFusedLinesColorSet() || ( !getDrawFlags() && !getDrawCommLines() ) ) &&
+                    SemanticPyramid::isMethodSupported( getDrawModeTime() ) &&
+                    semanticPyramid.isSummarized( first, last, timeStep );
+  bool buildPyramid = !usePyramid && semanticPyramid.isEnabled() &&
+                      getWindowBeginTime() == 0 && getWindowEndTime() >= myTrace->getEndTime();
+
+  auto addPyramidInterval = [ & ]( TObjectOrder whichRow )
   {
-    if( isFusedLinesColorSet() )
-      initRow( *row, getWindowBeginTime(), NOCREATE, rowComputedMaxY, rowComputedMinY, rowComputedZeros );
-    else
-      initRow( *row, getWindowBeginTime(), CREATECOMMS + CREATEEVENTS, rowComputedMaxY, rowComputedMinY, rowComputedZeros );
+    if( buildPyramid )
+      semanticPyramid.addInterval( whichRow, getBeginTime( whichRow ), getEndTime( whichRow ), getValue( whichRow ) );
+  };
+
+  if( !usePyramid )
+  {
+    for( vector<TObjectOrder>::iterator row = first; row <= last; ++row )
+    {
+      if( isFusedLinesColorSet() )
+        initRow( *row, getWindowBeginTime(), NOCREATE, rowComputedMaxY, rowComputedMinY, rowComputedZeros );
+      else
+        initRow( *row, getWindowBeginTime(), CREATECOMMS + CREATEEVENTS, rowComputedMaxY, rowComputedMinY, rowComputedZeros );
+
+      if( buildPyramid )
+        semanticPyramid.beginRow( *row );
+      addPyramidInterval( *row );
+    }
   }
 
   TTime currentTime = getWindowBeginTime() + timeStep;
   while( currentTime <= getWindowEndTime() && currentTime <= getTrace()->getEndTime() )
   {
-    rowValues.clear();
+    rowValues.reset();
     for( vector<TObjectOrder>::iterator row = first; row <= last; ++row )
     {
-      timeValues.clear();
+      if( usePyramid )
+      {
+        SemanticPyramid::TNode tmpNode = semanticPyramid.getRange( *row, currentTime - timeStep, currentTime );
+        SemanticPyramid::TSummary tmpValues = tmpNode.getValues();
+        tmpValues.updateLimits( rowComputedMaxY, rowComputedMinY, rowComputedZeros );
+        if( tmpNode.body.outOfScale( getMinimumY(), getMaximumY() ) )
+          drawCaution = true;
+        rowValues.add( tmpValues.selectValue( getDrawModeTime() ) );
+        continue;
+      }
+
+      timeValues.reset();
 
       while( getEndTime( *row ) <= currentTime - timeStep )
+      {
         calcNext( *row, rowComputedMaxY, rowComputedMinY, rowComputedZeros );
+        addPyramidInterval( *row );
+      }
 
-      timeValues.push_back( getValue( *row ) );
+      timeValues.add( getValue( *row ) );
       while( getEndTime( *row ) < currentTime )
       {
         // Making cancel button more responsive for 1 row drawing
@@ -2397,13 +2479,14 @@ void TimelineProxy::computeSemanticRowParallel( int numRows,
           break;
 
         calcNext( *row, rowComputedMaxY, rowComputedMinY, rowComputedZeros );
+        addPyramidInterval( *row );
         TSemanticValue currentValue = getValue( *row );
-        timeValues.push_back( currentValue );
+        timeValues.add( currentValue );
         if( currentValue != 0 && ( currentValue < getMinimumY()
                                    || currentValue > getMaximumY() ) )
           drawCaution = true;
       }
-      rowValues.push_back( DrawMode::selectValue( timeValues, getDrawModeTime() ) );
+      rowValues.add( timeValues.getValue() );
 
       RecordList *rl = getRecordList( *row );
       if( rl != nullptr && !isFusedLinesColorSet() )
@@ -2413,7 +2496,7 @@ void TimelineProxy::computeSemanticRowParallel( int numRows,
                                     selected, objectPosList,
                                     eventsToDraw, commsToDraw );
     }
-    valuesToDraw.push_back( DrawMode::selectValue( rowValues, getDrawModeObject() ) );
+    valuesToDraw.push_back( rowValues.getValue() );
     timePos += (int) magnify;
 
     if( progress != nullptr )
@@ -2443,6 +2526,20 @@ void TimelineProxy::computeSemanticRowParallel( int numRows,
     }
   }
 
+  if( usePyramid )
+    return;
+
+  if( buildPyramid )
+  {
+    for( vector<TObjectOrder>::iterator row = first; row <= last; ++row )
+    {
+      if( progress != nullptr && progress->getStop() )
+        semanticPyramid.discardRow( *row );
+      else
+        semanticPyramid.endRow( *row );
+    }
+  }
+
   for( vector<TObjectOrder>::iterator row = first; row <= last; ++row )
   {
     TSemanticValue dumbMinMax = 0.0;
@@ -2779,6 +2876,7 @@ void TimelineProxy::computeSemanticRowPunctualParallel( int numRows,
 
   vector<pair<TSemanticValue,TSemanticValue> > values;
   pair<TSemanticValue,TSemanticValue> tmpPairSemantic;
+  DrawModeReducer tmpValues( getDrawModeTime() );
 
   vector<TObjectOrder>::iterator first = find( selectedSet.begin(), selectedSet.end(), firstRow );
   vector<TObjectOrder>::iterator last  = find( selectedSet.begin(), selectedSet.end(), lastRow );
@@ -2811,17 +2909,19 @@ void TimelineProxy::computeSemanticRowPunctualParallel( int numRows,
           while( getBeginTime( *row ) >= punctualColorWindow->getEndTime( *row ) )
             punctualColorWindow->calcNext( *row, dummyMaxY, dummyMinY, dummyZeros );
 
-          vector<TSemanticValue> tmpValues;
+          bool emptyValues = true;
+          tmpValues.reset();
           while( getEndTime( *row ) >= punctualColorWindow->getEndTime( *row ) )
           {
-            tmpValues.push_back( punctualColorWindow->getValue( *row ) );
+            tmpValues.add( punctualColorWindow->getValue( *row ) );
+            emptyValues = false;
             punctualColorWindow->calcNext( *row, dummyMaxY, dummyMinY, dummyZeros );
           }
 
-          if( tmpValues.empty() )
-            tmpValues.push_back( punctualColorWindow->getValue( *row ) );
+          if( emptyValues )
+            tmpValues.add( punctualColorWindow->getValue( *row ) );
 
-          tmpPairSemantic.second = DrawMode::selectValue( tmpValues, getDrawModeTime() );
+          tmpPairSemantic.second = tmpValues.getValue();
         }
         values.push_back( tmpPairSemantic );
       }
@@ -31,6 +31,7 @@
 #include "paraverkerneltypes.h"
 #include "semanticcolor.h"
 #include "drawmode.h"
+#include "semanticpyramid.h"
 #include "zoomhistory.h"
 #include "selectionmanagement.h"
 #include "paraverlabels.h"
@@ -328,6 +329,8 @@ class Timeline
     virtual TRecordTime traceUnitsToWindowUnits( TRecordTime whichTime ) const = 0;
     virtual TRecordTime windowUnitsToTraceUnits( TRecordTime whichTime ) const = 0;
     virtual SemanticInfoType getSemanticInfoType() const = 0;
+    // Changes whenever the values computed by the window change
+    virtual std::string getSemanticSignature() const = 0;
 
     // Specific functions for WindowProxy
     virtual Timeline *getConcrete() const
@@ -966,6 +969,7 @@ class TimelineProxy: public Timeline
     virtual TRecordTime traceUnitsToWindowUnits( TRecordTime whichTime ) const override;
     virtual TRecordTime windowUnitsToTraceUnits( TRecordTime whichTime ) const override;
     virtual SemanticInfoType getSemanticInfoType() const override;
+    virtual std::string getSemanticSignature() const override;
     virtual void getAllSemanticFunctions( TSemanticGroup whichGroup,
                                           std::vector<std::string>& onVector ) const override;
 
@@ -1222,6 +1226,9 @@ class TimelineProxy: public Timeline
     TSemanticValue computedMinY;
     bool computedZeros;
 
+    // Summaries of the whole trace for zoomed out views
+    SemanticPyramid semanticPyramid;
+
     std::vector<RecordList *> myLists;
 
     // Must store the associated proxies
@@ -1289,6 +1296,9 @@ class TimelineProxy: public Timeline
 
     void getAllLevelsSelectedRows( TWindowLevel onLevel, std::vector< TObjectOrder > &selected );
 
+    void updateSemanticPyramid();
+    bool computeYScaleFromPyramid( std::vector< TObjectOrder >& selected );
+
 #ifdef _MSC_VER
     void computeSemanticRowPunctualParallel( int numRows,
                                              TObjectOrder firstRow,
@@ -0,0 +1,92 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                               libparaver-api                              *
+ *                       Paraver Main Computing Library                      *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+
+
+#pragma once
+
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "paraverkerneltypes.h"
+
+// Reductions over the children values of an aggregated interval, updated one
+// child at a time. Maximums and minimums are kept in a segment tree, so
+// changing a child costs O(log N) instead of a new pass over all of them.
+// The sum is a running total, only given while it is exact: every child is
+// an integer small enough for any partial sum to be representable, so it
+// matches adding the children in order to the last bit.
+class ChildrenAggregation
+{
+  public:
+    typedef PRV_UINT16 TAggregations;
+
+    static constexpr TAggregations NO_AGGREGATION = 0x00;
+    static constexpr TAggregations SUM            = 0x01;
+    static constexpr TAggregations MAXIMUM        = 0x02;
+    static constexpr TAggregations MINIMUM        = 0x04; // Also tracks zeros and negatives
+    static constexpr TAggregations COUNT          = 0x08; // Children by value
+
+    ChildrenAggregation();
+
+    void init( TAggregations whichAggregations, const std::vector<TSemanticValue>& whichValues );
+    void update( PRV_UINT32 whichChild, TSemanticValue oldValue, TSemanticValue newValue );
+
+    PRV_UINT32 size() const;
+    // Returns false if the sum may differ from adding the children in order
+    bool getSum( TSemanticValue& onSum ) const;
+    TSemanticValue getMaximum() const;
+    // Minimum of children fromChild..size()-1
+    TSemanticValue getMinimum( PRV_UINT32 fromChild = 0 ) const;
+    PRV_UINT32 getNegatives() const;
+    // Returns false if no child is 0
+    bool getLastZero( PRV_UINT32& whichChild ) const;
+    PRV_UINT32 countValue( TSemanticValue whichValue ) const;
+
+  private:
+    TAggregations aggregations;
+    PRV_UINT32 numChildren;
+
+    TSemanticValue sum;
+    TSemanticValue maxExactValue;
+    PRV_UINT32 inexactValues;
+
+    // Leaves at [ numChildren, 2 * numChildren ), root at 1
+    std::vector<TSemanticValue> maximums;
+    std::vector<TSemanticValue> minimums;
+
+    std::set<PRV_UINT32> zeros;
+    PRV_UINT32 negatives;
+    std::unordered_map<TSemanticValue, PRV_UINT32> valueCount;
+
+    void build( std::vector<TSemanticValue>& onTree, const std::vector<TSemanticValue>& whichValues,
+                TSemanticValue (*combine)( TSemanticValue, TSemanticValue ) );
+    void set( std::vector<TSemanticValue>& onTree, PRV_UINT32 whichChild, TSemanticValue whichValue,
+              TSemanticValue (*combine)( TSemanticValue, TSemanticValue ) );
+    bool isExact( TSemanticValue whichValue ) const;
+    void addSum( TSemanticValue whichValue );
+    void removeSum( TSemanticValue whichValue );
+    void addCount( TSemanticValue whichValue, PRV_UINT32 whichChild );
+    void removeCount( TSemanticValue whichValue, PRV_UINT32 whichChild );
+};
@@ -51,18 +51,26 @@ class Column
     void setNextCell( );
     void setFirstCell( );
     bool endCell( );
+    void finish( );
 
     bool getCellValue( ValueType& semVal, int whichRow, short idStat ) const;
     bool getNotZeroValue( int whichRow, short idStat ) const;
     bool getCellValue( std::array<ValueType, NStats>& semVal, int whichRow ) const;
 
   private:
+    // Dense row index is built on finish while at least 1 of every
+    // DENSE_OCCUPANCY rows has a cell; sparser columns use binary search.
+    static constexpr size_t DENSE_OCCUPANCY = 4;
+
     std::vector<Cell<ValueType, NStats> > cells;
     typename std::vector<Cell<ValueType, NStats> >::iterator it_cell;
+    std::vector<PRV_INT32> rowIndex; // cell position + 1, 0 if the row has no cell
 
     Cell<ValueType, NStats> current_cell;
     bool modified;
     bool *finished;
+
+    typename std::vector<Cell<ValueType, NStats> >::const_iterator findCell( int whichRow ) const;
 };
 
 #include "column_impl.h"
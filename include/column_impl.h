@@ -22,6 +22,7 @@
 \*****************************************************************************/
 
 
+#include <algorithm>
 #include <string>
 #include <iostream>
 
@@ -48,6 +49,7 @@ Column<ValueType, NStats>::Column( const Column<ValueType, NStats>& source ):
   current_cell = Cell<ValueType, NStats>( source.current_cell );
 
   cells = source.cells;
+  rowIndex = source.rowIndex;
 }
 
 
@@ -235,17 +237,53 @@ inline bool Column<ValueType, NStats>::endCell( )
 }
 
 
+template <typename ValueType, size_t NStats>
+inline void Column<ValueType, NStats>::finish( )
+{
+  rowIndex.clear();
+  if ( cells.empty() )
+    return;
+
+  size_t numRows = (size_t)cells.back().getRow() + 1;
+  if ( numRows > cells.size() * DENSE_OCCUPANCY )
+    return;
+
+  rowIndex.resize( numRows, 0 );
+  for ( size_t i = 0; i < cells.size(); ++i )
+    rowIndex[ cells[ i ].getRow() ] = (PRV_INT32)i + 1;
+}
+
+
+// Cells are appended row by row, so they are always sorted by row
+template <typename ValueType, size_t NStats>
+inline typename std::vector<Cell<ValueType, NStats> >::const_iterator Column<ValueType, NStats>::findCell( int whichRow ) const
+{
+  if ( whichRow < 0 )
+    return cells.end();
+
+  if ( !rowIndex.empty() )
+  {
+    if ( (size_t)whichRow >= rowIndex.size() || rowIndex[ whichRow ] == 0 )
+      return cells.end();
+    return cells.begin() + ( rowIndex[ whichRow ] - 1 );
+  }
+
+  typename std::vector<Cell<ValueType, NStats> >::const_iterator result =
+    std::lower_bound( cells.begin(), cells.end(), whichRow,
+                      []( const Cell<ValueType, NStats>& cell, int row ) { return (int)cell.getRow() < row; } );
+  if ( result != cells.end() && (int)result->getRow() != whichRow )
+    return cells.end();
+
+  return result;
+}
+
+
 template <typename ValueType, size_t NStats>
 inline bool Column<ValueType, NStats>::getCellValue( ValueType& semVal,
                                                      int whichRow,
                                                      short idStat ) const
 {
-  Cell<ValueType, NStats> tmpCell( whichRow );
-
-  typename std::vector<Cell<ValueType, NStats> >::const_iterator result;
-  for( result = cells.begin(); result != cells.end(); ++result )
-    if( result->getRow() == whichRow ) break;
-
+  typename std::vector<Cell<ValueType, NStats> >::const_iterator result = findCell( whichRow );
   if( result == cells.end() )
     return false;
   else
@@ -258,12 +296,7 @@ inline bool Column<ValueType, NStats>::getCellValue( ValueType& semVal,
 template <typename ValueType, size_t NStats>
 inline bool Column<ValueType, NStats>::getNotZeroValue( int whichRow, short idStat ) const
 {
-  Cell<ValueType, NStats> tmpCell( whichRow );
-
-  typename std::vector<Cell<ValueType, NStats> >::const_iterator result;
-  for( result = cells.begin(); result != cells.end(); ++result )
-    if( result->getRow() == whichRow ) break;
-
+  typename std::vector<Cell<ValueType, NStats> >::const_iterator result = findCell( whichRow );
   if( result != cells.end() )
     return result->getNotZeroValue( idStat );
 
@@ -275,9 +308,7 @@ template <typename ValueType, size_t NStats>
 inline bool Column<ValueType, NStats>::getCellValue( std::array<ValueType, NStats>& semVal,
                                                      int whichRow ) const
 {
-  Cell<ValueType, NStats> tmpCell( whichRow, 0 );
-
-  typename std::vector<Cell<ValueType, NStats> >::iterator result = find( cells.begin(), cells.end(), tmpCell );
+  typename std::vector<Cell<ValueType, NStats> >::const_iterator result = findCell( whichRow );
   if( result == cells.end() )
     return false;
   else
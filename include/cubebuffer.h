@@ -29,6 +29,59 @@
 
 #include "paraverkerneltypes.h" 
 
+// Cells of one buffer row, stored contiguously in insertion order.
+// Columns are looked up by a linear scan while the row is short, then by a
+// dense column index, or by a hash index if the row is too sparse for it.
+template< size_t NStats >
+class CubeBufferRow
+{
+  public:
+    CubeBufferRow();
+
+    size_t size() const
+    {
+      return columns.size();
+    }
+
+    THistogramColumn getColumn( size_t whichCell ) const
+    {
+      return columns[ whichCell ];
+    }
+
+    const std::array< TSemanticValue, NStats >& getValues( size_t whichCell ) const
+    {
+      return values[ whichCell ];
+    }
+
+    bool getNotZeroValue( size_t whichCell ) const
+    {
+      return notZeroValues[ whichCell ] != 0;
+    }
+
+    void addValue( THistogramColumn col, const std::array< TSemanticValue, NStats >& semVal, bool isNotZeroValue );
+    void setValue( THistogramColumn col, const std::array< TSemanticValue, NStats >& semVal );
+    bool getCellValue( std::array< TSemanticValue, NStats >& semVal, THistogramColumn col ) const;
+
+  private:
+    static constexpr size_t LINEAR_CELLS = 8;
+    // Dense index is used while at least 1 of every DENSE_OCCUPANCY columns has a cell
+    static constexpr size_t DENSE_OCCUPANCY = 4;
+
+    std::vector< THistogramColumn > columns;
+    std::vector< std::array< TSemanticValue, NStats > > values;
+    std::vector< char > notZeroValues;
+
+    bool useDenseIndex;
+    THistogramColumn maxColumn;
+    std::vector< PRV_INT32 > denseIndex; // position + 1, 0 if the column has no cell
+    std::unordered_map< THistogramColumn, PRV_INT32 > sparseIndex;
+
+    PRV_INT32 findCell( THistogramColumn col ) const;
+    void insertCell( THistogramColumn col, const std::array< TSemanticValue, NStats >& semVal, bool isNotZeroValue );
+    void buildIndex();
+};
+
+
 template< size_t NStats >
 class CubeBuffer
 {
@@ -39,12 +92,10 @@ class CubeBuffer
     void setValue( PRV_UINT32 plane, PRV_UINT32 row, THistogramColumn col, const std::array< TSemanticValue, NStats >& semVal );
     bool getCellValue( std::array< TSemanticValue, NStats >& semVal, PRV_UINT32 plane, PRV_UINT32 row, PRV_UINT32 col ) const;
 
-    const std::unordered_map< THistogramColumn, std::array< TSemanticValue, NStats > >& getRowValues( PRV_UINT32 plane, PRV_UINT32 row ) const;
-    const std::unordered_map< THistogramColumn, bool >& getNotZeroValue( PRV_UINT32 plane, PRV_UINT32 row ) const;
+    const CubeBufferRow< NStats >& getRowValues( PRV_UINT32 plane, PRV_UINT32 row ) const;
 
   private:
-    std::vector< std::vector< std::unordered_map< THistogramColumn, std::array< TSemanticValue, NStats > > > > buffer;
-    std::vector< std::vector< std::unordered_map< THistogramColumn, bool > > > bufferNotZeroValue;
+    std::vector< std::vector< CubeBufferRow< NStats > > > buffer;
 };
 
 #include "cubebuffer_impl.h"
@@ -24,72 +24,173 @@
 //#include "cubebuffer.h"
 
 template< size_t NStats >
-CubeBuffer<NStats>::CubeBuffer( PRV_UINT32 numPlanes, PRV_UINT32 numRows )
+CubeBufferRow<NStats>::CubeBufferRow():
+  useDenseIndex( false ), maxColumn( 0 )
+{}
+
+
+template< size_t NStats >
+inline PRV_INT32 CubeBufferRow<NStats>::findCell( THistogramColumn col ) const
 {
-  std::unordered_map< THistogramColumn, std::array< TSemanticValue, NStats > > tmpRow;
-  std::vector< std::unordered_map< THistogramColumn, std::array< TSemanticValue, NStats > > > tmpMatrix( numRows, tmpRow );
+  if ( columns.size() <= LINEAR_CELLS )
+  {
+    for ( size_t i = 0; i < columns.size(); ++i )
+    {
+      if ( columns[ i ] == col )
+        return (PRV_INT32)i;
+    }
+    return -1;
+  }
 
-  std::unordered_map< THistogramColumn, bool > tmpRowNotZeroValue;
-  std::vector< std::unordered_map< THistogramColumn, bool > > tmpMatrixNotZeroValue( numRows, tmpRowNotZeroValue );
+  if ( useDenseIndex )
+  {
+    if ( col >= denseIndex.size() )
+      return -1;
+    return denseIndex[ col ] - 1;
+  }
 
-  buffer.insert( buffer.begin(), numPlanes, tmpMatrix );
-  bufferNotZeroValue.insert( bufferNotZeroValue.begin(), numPlanes, tmpMatrixNotZeroValue );
+  auto it = sparseIndex.find( col );
+  if ( it == sparseIndex.end() )
+    return -1;
+  return it->second;
 }
 
 
 template< size_t NStats >
-void CubeBuffer<NStats>::addValue( PRV_UINT32 plane, PRV_UINT32 row, THistogramColumn col, const std::array< TSemanticValue, NStats >& semVal, bool isNotZeroValue )
+void CubeBufferRow<NStats>::buildIndex()
 {
-  std::unordered_map< THistogramColumn, std::array< TSemanticValue, NStats > >& currentRow = ( ( buffer[ plane ] )[ row ] );
-  typename std::unordered_map< THistogramColumn, std::array< TSemanticValue, NStats > >::iterator it = currentRow.find( col );
-
-  std::unordered_map< THistogramColumn, bool >& currentRowNotZeroValue = ( ( bufferNotZeroValue[ plane ] )[ row ] );
-  std::unordered_map< THistogramColumn, bool >::iterator itNotZeroValue = currentRowNotZeroValue.find( col );
+  useDenseIndex = ( (size_t)maxColumn + 1 ) <= columns.size() * DENSE_OCCUPANCY;
 
-  if ( it != currentRow.end() )
+  denseIndex.clear();
+  sparseIndex.clear();
+  if ( useDenseIndex )
   {
-    for( PRV_UINT32 i = 0; i < semVal.size(); ++i )
-      ( it->second )[ i ] += semVal[ i ];
+    denseIndex.resize( (size_t)maxColumn + 1, 0 );
+    for ( size_t i = 0; i < columns.size(); ++i )
+      denseIndex[ columns[ i ] ] = (PRV_INT32)i + 1;
+  }
+  else
+  {
+    sparseIndex.reserve( columns.size() * 2 );
+    for ( size_t i = 0; i < columns.size(); ++i )
+      sparseIndex[ columns[ i ] ] = (PRV_INT32)i;
+  }
+}
 
-    itNotZeroValue->second = itNotZeroValue->second || isNotZeroValue;
+
+template< size_t NStats >
+void CubeBufferRow<NStats>::insertCell( THistogramColumn col, const std::array< TSemanticValue, NStats >& semVal, bool isNotZeroValue )
+{
+  PRV_INT32 newCell = (PRV_INT32)columns.size();
+
+  columns.push_back( col );
+  values.push_back( semVal );
+  notZeroValues.push_back( isNotZeroValue );
+  if ( col > maxColumn )
+    maxColumn = col;
+
+  if ( columns.size() <= LINEAR_CELLS )
+    return;
+
+  if ( columns.size() == LINEAR_CELLS + 1 )
+  {
+    buildIndex();
+  }
+  else if ( useDenseIndex )
+  {
+    if ( col >= denseIndex.size() )
+    {
+      if ( ( (size_t)col + 1 ) > columns.size() * DENSE_OCCUPANCY )
+      {
+        buildIndex();
+        return;
+      }
+      denseIndex.resize( (size_t)col + 1, 0 );
+    }
+    denseIndex[ col ] = newCell + 1;
   }
   else
   {
-    currentRow[ col ] = semVal;
-    currentRowNotZeroValue[ col ] = isNotZeroValue;
+    sparseIndex[ col ] = newCell;
+    // Check again for a dense index each time the row doubles
+    if ( ( columns.size() & ( columns.size() - 1 ) ) == 0 )
+      buildIndex();
   }
 }
 
 
 template< size_t NStats >
-void CubeBuffer<NStats>::setValue( PRV_UINT32 plane, PRV_UINT32 row, THistogramColumn col, const std::array< TSemanticValue, NStats >& semVal )
+void CubeBufferRow<NStats>::addValue( THistogramColumn col, const std::array< TSemanticValue, NStats >& semVal, bool isNotZeroValue )
 {
-  ( ( buffer[ plane ] )[ row ] )[ col ] = semVal;
+  PRV_INT32 cell = findCell( col );
+
+  if ( cell < 0 )
+  {
+    insertCell( col, semVal, isNotZeroValue );
+    return;
+  }
+
+  std::array< TSemanticValue, NStats >& cellValues = values[ cell ];
+  for ( size_t i = 0; i < NStats; ++i )
+    cellValues[ i ] += semVal[ i ];
+  notZeroValues[ cell ] = notZeroValues[ cell ] || isNotZeroValue;
 }
 
 
 template< size_t NStats >
-bool CubeBuffer<NStats>::getCellValue( std::array< TSemanticValue, NStats >& semVal, PRV_UINT32 plane, PRV_UINT32 row, PRV_UINT32 col ) const
+void CubeBufferRow<NStats>::setValue( THistogramColumn col, const std::array< TSemanticValue, NStats >& semVal )
 {
-  const std::unordered_map< THistogramColumn, std::array< TSemanticValue, NStats > >& currentRow = ( ( buffer[ plane ] )[ row ] );
-  typename std::unordered_map< THistogramColumn, std::array< TSemanticValue, NStats > >::const_iterator it = currentRow.find( col );
+  PRV_INT32 cell = findCell( col );
 
-  if ( it == currentRow.end() )
+  if ( cell < 0 )
+    insertCell( col, semVal, true );
+  else
+    values[ cell ] = semVal;
+}
+
+
+template< size_t NStats >
+bool CubeBufferRow<NStats>::getCellValue( std::array< TSemanticValue, NStats >& semVal, THistogramColumn col ) const
+{
+  PRV_INT32 cell = findCell( col );
+
+  if ( cell < 0 )
     return false;
 
-  semVal = it->second;
+  semVal = values[ cell ];
   return true;
 }
 
 
 template< size_t NStats >
-const std::unordered_map< THistogramColumn, std::array< TSemanticValue, NStats > >& CubeBuffer<NStats>::getRowValues( PRV_UINT32 plane, PRV_UINT32 row ) const
+CubeBuffer<NStats>::CubeBuffer( PRV_UINT32 numPlanes, PRV_UINT32 numRows ):
+  buffer( numPlanes, std::vector< CubeBufferRow< NStats > >( numRows ) )
+{}
+
+
+template< size_t NStats >
+void CubeBuffer<NStats>::addValue( PRV_UINT32 plane, PRV_UINT32 row, THistogramColumn col, const std::array< TSemanticValue, NStats >& semVal, bool isNotZeroValue )
+{
+  buffer[ plane ][ row ].addValue( col, semVal, isNotZeroValue );
+}
+
+
+template< size_t NStats >
+void CubeBuffer<NStats>::setValue( PRV_UINT32 plane, PRV_UINT32 row, THistogramColumn col, const std::array< TSemanticValue, NStats >& semVal )
 {
-  return ( ( buffer[ plane ] )[ row ] );
+  buffer[ plane ][ row ].setValue( col, semVal );
 }
 
+
+template< size_t NStats >
+bool CubeBuffer<NStats>::getCellValue( std::array< TSemanticValue, NStats >& semVal, PRV_UINT32 plane, PRV_UINT32 row, PRV_UINT32 col ) const
+{
+  return buffer[ plane ][ row ].getCellValue( semVal, col );
+}
+
+
 template< size_t NStats >
-const std::unordered_map< THistogramColumn, bool >& CubeBuffer<NStats>::getNotZeroValue( PRV_UINT32 plane, PRV_UINT32 row ) const
+const CubeBufferRow< NStats >& CubeBuffer<NStats>::getRowValues( PRV_UINT32 plane, PRV_UINT32 row ) const
 {
-  return ( ( bufferNotZeroValue[ plane ] )[ row ] );
+  return buffer[ plane ][ row ];
 }
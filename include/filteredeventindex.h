@@ -0,0 +1,89 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                               libparaver-api                              *
+ *                       Paraver Main Computing Library                      *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "memorytrace.h"
+
+class KSingleWindow;
+
+// Events of every thread that pass the filter of a window, in trace order.
+// Lookups first walk a few records from the current one; only when that
+// finds nothing the thread is indexed, in chunks of records beginning at
+// the query time, so that functions looking ahead for the next event skip
+// long runs of records with a binary search. A window and its clones share
+// the index while their filter doesn't change.
+class FilteredEventIndex
+{
+  public:
+    struct TEventEntry
+    {
+      TRecordTime time;
+      TEventType type;
+      TSemanticValue value;
+    };
+
+    FilteredEventIndex( const std::string& whichSignature, TThreadOrder numThreads );
+    ~FilteredEventIndex();
+
+    const std::string& getSignature() const;
+
+    // Next event passing the filter after the record of whichThread pointed
+    // by it; returns false if there is none.
+    bool getNextEvent( KSingleWindow *whichWindow,
+                       TThreadOrder whichThread,
+                       MemoryTrace::iterator *it,
+                       TEventEntry& onEvent );
+
+  private:
+    // Every record of the thread with time in [begin time, endTime)
+    struct TChunk
+    {
+      TRecordTime endTime;
+      // First record after the chunk while no chunk follows it
+      MemoryTrace::iterator *endRecord;
+      std::vector<TEventEntry> events;
+    };
+
+    typedef std::map<TRecordTime, TChunk> TThreadChunks;
+
+    static constexpr size_t SCAN_RECORDS = 64;
+    static constexpr size_t CHUNK_RECORDS = 4096;
+
+    std::string signature;
+    std::vector<TThreadChunks> threadChunks;
+    std::vector<std::mutex> threadMutex;
+
+    static bool isFilteredEvent( KSingleWindow *whichWindow, MemoryTrace::iterator *it );
+    static TThreadChunks::iterator findChunk( TThreadChunks& whichChunks, TRecordTime whichTime );
+    static TThreadChunks::iterator indexChunk( KSingleWindow *whichWindow,
+                                               TThreadChunks& whichChunks,
+                                               MemoryTrace::iterator *firstRecord );
+};
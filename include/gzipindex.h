@@ -0,0 +1,142 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                               libparaver-api                              *
+ *                       Paraver Main Computing Library                      *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+
+#pragma once
+
+#include <deque>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+#include "paraverkerneltypes.h"
+
+// Access points inside a gzip file where decompression can be restarted,
+// so a compressed trace can be read from any uncompressed offset.
+// Points are added while the trace is decompressed sequentially and the
+// index is saved as "<trace>.gzi" once complete, if binary caches are enabled.
+class GzipIndex
+{
+  public:
+    // Uncompressed bytes between consecutive access points
+    static constexpr TTraceSize SPAN = 8 * 1024 * 1024;
+    static constexpr size_t WINDOW_SIZE = 32768;
+
+    struct TAccessPoint
+    {
+      TTraceSize uncompressedOffset;
+      TTraceSize compressedOffset; // first byte not fully consumed
+      int bits;                    // bits of the previous byte still pending
+      std::vector<unsigned char> window;
+    };
+
+    // Same instance for every stream open on the same file
+    static std::shared_ptr<GzipIndex> getIndex( const std::string& whichFile );
+    // Size known without decompressing: from a complete index in use or a saved one
+    static bool getKnownUncompressedSize( const std::string& whichFile, TTraceSize& onSize );
+
+    GzipIndex( const std::string& whichFile );
+
+    const std::string& getFileName() const;
+    bool isComplete() const;
+    TTraceSize getUncompressedSize() const;
+
+    // Nearest point at or before offset; nullptr means the beginning of the file.
+    // Returned points are never moved nor removed.
+    const TAccessPoint *findPoint( TTraceSize offset ) const;
+    bool needsPoint( TTraceSize offset ) const;
+    // Splits [offset, end of data) at the access points, up to maxRanges ranges
+    void getRanges( TTraceSize offset,
+                    size_t maxRanges,
+                    std::vector< std::pair< TTraceSize, TTraceSize > >& ranges ) const;
+    void addPoint( TAccessPoint&& whichPoint );
+    void setComplete( TTraceSize whichUncompressedSize );
+
+  private:
+    static constexpr char MAGIC[ 8 ] = { 'P', 'R', 'V', 'G', 'Z', 'I', 'D', 'X' };
+    static constexpr PRV_UINT32 FORMAT_VERSION = 1;
+
+    static std::mutex registryMutex;
+    static std::map< std::string, std::weak_ptr<GzipIndex> > registry;
+
+    std::string fileName;
+    TTraceSize fileSize = 0;
+    PRV_INT64 fileTime = 0;
+
+    mutable std::mutex indexMutex;
+    std::deque<TAccessPoint> points;
+    bool complete = false;
+    TTraceSize uncompressedSize = 0;
+
+    bool readFileStamp();
+    bool sameFileStamp() const;
+    static std::string getIndexFileName( const std::string& whichFile );
+    static bool readHeader( std::ifstream& indexFile, TTraceSize whichFileSize, PRV_INT64 whichFileTime,
+                            TTraceSize& onUncompressedSize, PRV_UINT64& onNumPoints );
+    bool load();
+    void save() const;
+};
+
+
+// Inflates a gzip file from any offset using a GzipIndex, adding new access
+// points to it while decompressing past the last known one.
+class GzipDecoder
+{
+  public:
+    GzipDecoder( std::shared_ptr<GzipIndex> whichIndex );
+    ~GzipDecoder();
+
+    // Restarts at the nearest access point and skips up to offset.
+    // Returns the reached offset, lower than offset only at the end of data.
+    TTraceSize seek( TTraceSize offset );
+
+    // Appends up to maxBytes decompressed bytes; 0 means end of data
+    size_t read( std::vector<char>& out, size_t maxBytes );
+    // Writes up to maxBytes decompressed bytes to out; 0 means end of data
+    size_t read( char *out, size_t maxBytes );
+
+    TTraceSize tell() const;
+
+  private:
+    static constexpr size_t INPUT_SIZE = 256 * 1024;
+
+    std::shared_ptr<GzipIndex> index;
+    std::ifstream file;
+    z_stream strm;
+    bool strmInitialized = false;
+    bool rawMode = false;
+    bool endOfData = false;
+    TTraceSize inputOffset = 0;
+    TTraceSize outputOffset = 0;
+    std::vector<unsigned char> input;
+    std::vector<unsigned char> window;
+
+    bool fillInput();
+    bool skipInput( size_t bytes );
+    bool nextMember();
+    void recordPoint();
+};
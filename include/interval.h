@@ -28,6 +28,7 @@
 #include <set>
 #include "memorytrace.h"
 #include "krecordlist.h"
+#include "intervalcheckpoints.h"
 
 class KTimeline;
 
@@ -112,6 +113,28 @@ class Interval
 
     virtual KTimeline *getWindow() = 0;
 
+    // True when begin, end and value are all the state the interval and its
+    // children keep between calcNext calls, so they can be checkpointed
+    virtual bool hasPlainState()
+    {
+      return false;
+    }
+
+    virtual void saveState( std::vector<IntervalCheckpoints::TIntervalState>& onVector ) const
+    {
+      onVector.push_back( { std::shared_ptr<MemoryTrace::iterator>( begin->clone() ),
+                            std::shared_ptr<MemoryTrace::iterator>( end->clone() ),
+                            currentValue } );
+    }
+
+    virtual void restoreState( std::vector<IntervalCheckpoints::TIntervalState>::const_iterator& whichState )
+    {
+      *begin = *whichState->begin;
+      *end = *whichState->end;
+      currentValue = whichState->value;
+      ++whichState;
+    }
+
   protected:
     TObjectOrder order;
     MemoryTrace::iterator *begin;
@@ -119,6 +142,7 @@ class Interval
     TSemanticValue currentValue;
     KRecordList myDisplayList;
     bool notWindowInits;
+    IntervalCheckpoints checkpoints;
 
   private:
 
@@ -0,0 +1,77 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                               libparaver-api                              *
+ *                       Paraver Main Computing Library                      *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "memorytrace.h"
+
+class Interval;
+class SemanticFunction;
+
+// Snapshots of a row taken while an interval whose semantic function must
+// start from the beginning of the trace walks forward. A later init resumes
+// from the latest snapshot before its initial time instead of replaying the
+// whole trace. Snapshots are dropped when the window signature changes.
+class IntervalCheckpoints
+{
+  public:
+    // Steps between checkpoints; doubled each time MAX_CHECKPOINTS is reached
+    static constexpr size_t STEP = 1024;
+    static constexpr size_t MAX_CHECKPOINTS = 256;
+
+    // Begin, end and value of one interval of the chain below the owner
+    struct TIntervalState
+    {
+      std::shared_ptr<MemoryTrace::iterator> begin;
+      std::shared_ptr<MemoryTrace::iterator> end;
+      TSemanticValue value;
+    };
+
+    struct TCheckpoint
+    {
+      TRecordTime endTime;
+      std::vector<TIntervalState> intervals;
+      std::vector<TSemanticValue> functionState;
+    };
+
+    IntervalCheckpoints();
+
+    // Moves whichInterval to the latest checkpoint ending at or before
+    // whichTime, if any is ahead of its current position.
+    bool restore( const std::string& whichSignature,
+                  TRecordTime whichTime,
+                  Interval *whichInterval,
+                  SemanticFunction *whichFunction );
+    // Called after every calcNext of the replay
+    void step( Interval *whichInterval, SemanticFunction *whichFunction );
+
+  private:
+    std::string signature;
+    std::vector<TCheckpoint> checkpoints;
+    size_t stepSize;
+    size_t stepsToNext;
+};
@@ -94,6 +94,10 @@ class IntervalCompose: public IntervalHigh
       childIntervals.push_back( whichChild );
     }
 
+    virtual bool hasPlainState() override;
+    virtual void saveState( std::vector<IntervalCheckpoints::TIntervalState>& onVector ) const override;
+    virtual void restoreState( std::vector<IntervalCheckpoints::TIntervalState>::const_iterator& whichState ) override;
+
   protected:
     KTimeline *window;
     SemanticCompose *function;
@@ -125,4 +129,5 @@ class IntervalCompose: public IntervalHigh
     MemoryTrace::iterator *beginRecord;
 
     void copyRecordContent( MemoryTrace::iterator *whichRecord );
+    bool useCheckpoints( TCreateList create );
 };
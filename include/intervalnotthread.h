@@ -25,7 +25,7 @@
 #pragma once
 
 
-#include <map>
+#include "childrenaggregation.h"
 #include "intervalhigh.h"
 #include "semanticnotthread.h"
 
@@ -142,8 +142,39 @@ class IntervalNotThread: public IntervalHigh
     virtual TWindowLevel getComposeLevel( TTraceLevel whichLevel ) const override;
 
   private:
+    // Tournament tree of the children by end time, O(log N) per change.
+    // Ties go to the child that was set first.
+    class ChildrenQueue
+    {
+      public:
+        void init( PRV_UINT32 numChildren );
+        void set( PRV_UINT32 whichChild, TRecordTime whichTime );
+        PRV_UINT32 top() const
+        {
+          return winners[ 1 ];
+        }
+        TRecordTime topTime() const
+        {
+          return times[ winners[ 1 ] ];
+        }
+
+      private:
+        PRV_UINT32 numLeaves;
+        PRV_UINT64 lastSequence;
+        std::vector<TRecordTime> times;
+        std::vector<PRV_UINT64> sequence;
+        // Winner of every match; leaves at [ numLeaves, 2 * numLeaves )
+        std::vector<PRV_UINT32> winners;
+
+        PRV_UINT32 match( PRV_UINT32 first, PRV_UINT32 second ) const;
+    };
+
     SemanticHighInfo info;
-    std::multimap<TRecordTime,TObjectOrder> orderedChildren;
+    ChildrenQueue orderedChildren;
+    ChildrenAggregation aggregation;
+    bool useAggregation;
+
+    void setChildValue( TObjectOrder whichChild );
 };
 
 
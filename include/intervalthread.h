@@ -79,6 +79,8 @@ class IntervalThread: public Interval
 
     MemoryTrace::iterator *getTraceEnd() const override;
 
+    virtual bool hasPlainState() override;
+
   protected:
     KSingleWindow *window;
     SemanticThread *function;
@@ -89,6 +91,8 @@ class IntervalThread: public Interval
                                                   KRecordList *displayList );
     virtual MemoryTrace::iterator *getPrevRecord( MemoryTrace::iterator *it,
                                                   KRecordList *displayList );
+    void skipUnusedRecords( MemoryTrace::iterator *it, TRecordType validateMask ) const;
+    bool useCheckpoints( TCreateList create ) const;
 
 };
 
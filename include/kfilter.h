@@ -515,6 +515,8 @@ class KFilter : public Filter
 
     KFilter *clone( KTimeline *clonedWindow );
 
+    void getSignature( std::ostream& onStream ) const;
+
   private:
     KSingleWindow *window;
 
@@ -298,10 +298,11 @@ class KHistogram : public Histogram
     TCommTag commTagMin;
     TCommTag commTagMax;
 
+    // One byte per row, so parallel rows never share a word
     bool controlOutOfLimits;
-    std::vector<bool> tmpControlOutOfLimits;
+    std::vector<char> tmpControlOutOfLimits;
     bool xtraOutOfLimits;
-    std::vector<bool> tmpXtraOutOfLimits;
+    std::vector<char> tmpXtraOutOfLimits;
 
     bool inclusive;
 
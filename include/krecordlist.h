@@ -50,7 +50,7 @@ class KRecordList: public RecordList
   protected:
 
   private:
-    std::multiset<RLRecord, ltrecord> list;
+    TRecordListContainer list;
     bool newRec;
 };
 
@@ -27,6 +27,7 @@
 #include <set>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "memorytrace.h"
@@ -172,6 +173,7 @@ class KTrace: public Trace
                                 TRecordTime whichTime ) const;
     void getRecordByTimeCPU( std::vector<MemoryTrace::iterator *>& listIter,
                              TRecordTime whichTime ) const;
+    bool recordsInMemory() const;
 
     const std::set<TState>& getLoadedStates() const override;
     const std::set<TEventType>& getLoadedEvents() const override;
@@ -228,7 +230,15 @@ class KTrace: public Trace
     bool fillStateGaps;
     MetadataManager myTraceInfo;
 
+    // Minimum body bytes given to every thread when loading in parallel
+    static constexpr TTraceSize PARALLEL_LOAD_CHUNK_SIZE = 16 * 1024 * 1024;
+    static constexpr TTraceSize PARALLEL_LOAD_PROGRESS_STEP = 1024 * 1024;
+
     void parseDateTime( string &whichDateTime );
+    bool parallelReadBody( TraceStream *file,
+                           ProgressController *progress,
+                           std::unordered_set<TState>& hashstates,
+                           std::unordered_set<TEventType>& hashevents );
 
 };
 
@@ -57,6 +57,13 @@ class KTraceCutter : public TraceCutter
                           ProgressController *progress ) override;
 
   private:
+    /* Seeking the cut begin: binary search stops at this size, then lines are read */
+    static const TTraceSize SEEK_LINEAR_SIZE = 64 * 1024;
+    static const TTraceSize BACKWARD_CHUNK_SIZE = 4 * 1024 * 1024;
+    /* Backward scan limit; past it the cut is processed from the body begin */
+    static const TTraceSize MAX_BACKWARD_SCAN_SIZE = 16 * BACKWARD_CHUNK_SIZE;
+    static const size_t OUTPUT_BUFFER_SIZE = 4 * 1024 * 1024;
+
     unsigned int min_perc;
     unsigned int max_perc;
     bool by_time;
@@ -74,6 +81,7 @@ class KTraceCutter : public TraceCutter
     unsigned long long current_size;
     unsigned long long total_size;
     unsigned long long trace_time;
+    TThreadOrder traceTotalThreads;
     int useful_tasks;
     bool init_useful_tasks;
     bool remFirstStates;
@@ -177,6 +185,8 @@ class KTraceCutter : public TraceCutter
     void load_counters_of_pcf( char *trace_name );
     void shiftLeft_TraceTimes_ToStartFromZero( const char *originalTraceName, const char *nameIn, const char *nameOut, ProgressController *progress );
     bool is_selected_task( int task_id );
+    bool canSeekCutBegin( const std::string& fileName, TraceStream *whichFile ) const;
+    TTraceSize findCutBegin( TraceStream *whichFile, TTraceSize bodyBegin );
 
     ThreadInfo& initThreadInfo( unsigned int appl, unsigned int task, unsigned int thread, unsigned int cpu, bool& reset_counters );
 };
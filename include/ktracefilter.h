@@ -26,10 +26,14 @@
 
 
 #include <map>
+#include <string>
+#include <vector>
 
 #include "ktraceoptions.h"
-#include "zlib.h"
 #include "tracefilter.h"
+#include "utils/traceparser/processmodel.h"
+
+class TraceStream;
 
 class KTraceFilter: public TraceFilter
 {
@@ -43,13 +47,15 @@ class KTraceFilter: public TraceFilter
     virtual void execute( char *trace_in, char *trace_out, ProgressController *progress );
 
   private:
+    /* Bytes of trace body given to each worker when filtering ranges */
+    static constexpr unsigned long long RANGE_SIZE = 4 * 1024 * 1024;
+
     /* Buffer for reading trace records */
     char line[MAX_LINE_SIZE];
 
     /* Trace in and trace out */
-    FILE *infile;
+    TraceStream *infile;
     FILE *outfile;
-    gzFile gzInfile;
 
     /* Parameters for showing percentage */
     unsigned long long total_trace_size;
@@ -96,12 +102,20 @@ class KTraceFilter: public TraceFilter
     struct buffer_elem *buffer_first;
     struct buffer_elem *buffer_last;
 
-    struct buffer_elem *thread_call_info[MAX_APPL][MAX_TASK][MAX_THREAD];
+    /* Sized from the process model of the trace header, one per thread */
+    ProcessModel<> traceProcessModel;
+    std::vector< struct buffer_elem * > thread_call_info;
 
     std::map<TTypeValuePair, TTypeValuePair> translationTable;
 
     void read_params();
-    void filter_process_header( char *header );
+    void filter_process_header( std::string& output );
+    struct buffer_elem **get_call_info( int appl, int task, int thread );
+    void filter_record( const char *lineBegin, const char *lineEnd, std::string& output );
+#if defined(PARALLEL_ENABLED) && !defined(_WIN32)
+    bool can_filter_ranges( char *file_name ) const;
+    void filter_ranges( char *file_name, ProgressController *progress );
+#endif
     int filter_allowed_type(  int appl, int task, int thread,
                               unsigned long long time,
                               unsigned long long type,
@@ -109,7 +123,7 @@ class KTraceFilter: public TraceFilter
     void ini_progress_bar( char *file_name, ProgressController *progress );
     void show_progress_bar( ProgressController *progress );
     void load_pcf( char *pcf_name );
-    void dump_buffer();
+    void dump_buffer( std::string& output );
 };
 
 
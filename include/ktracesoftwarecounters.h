@@ -25,9 +25,17 @@
 #pragma once
 
 
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "ktraceoptions.h"
 #include "tracesoftwarecounters.h"
 
+class TraceStream;
+
 class KTraceSoftwareCounters : public TraceSoftwareCounters
 {
   public:
@@ -80,8 +88,8 @@ class KTraceSoftwareCounters : public TraceSoftwareCounters
       int appl;
       int task;
       int thread;
-      struct counter counters[150];
-      int next_free_counter;
+      std::vector< struct counter > counters; /* In creation order */
+      std::vector< int > counter_index;       /* Open addressing over counters, -1 if free */
       struct stack calls;
       unsigned long long last_time_of_sc;
       unsigned long long ini_burst_time;
@@ -110,13 +118,6 @@ class KTraceSoftwareCounters : public TraceSoftwareCounters
       int next_free_slot;
     };
 
-    struct state_queue_elem
-    {
-      unsigned long long last_state_end_time;
-      int thread_id;
-      struct state_queue_elem *next;
-    };
-
     char line[MAX_LINE_SIZE];  /* Buffer for reading trace records */
 
     /* Execution parameters */
@@ -138,33 +139,51 @@ class KTraceSoftwareCounters : public TraceSoftwareCounters
     int frequency;
 
     /* Trace in and trace out */
-    FILE *infile, *outfile;
+    TraceStream *infile;
+    FILE *outfile;
+    bool is_zip;
     KTraceOptions *exec_options;
 
-    /* Pointers to the thread struct, for avoiding to much searches */
-    int thread_pointer[MAX_APPL][MAX_TASK][MAX_THREAD];
+    /* Position of every thread in threads, by thread_key */
+    std::unordered_map< unsigned long long, int > thread_pointer;
 
     /* Buffer for Paraver trace events */
     struct ParaverEvent *first_Paraver_event;
     struct ParaverEvent *last_Paraver_event;
 
     /* Info and counters of the threads */
-    struct thread_info threads[MAX_THREADS];
-    int next_thread_slot;
+    std::vector< struct thread_info > threads;
+
+    /* Pool of counter events, reused through their next pointer */
+    static const size_t EVENT_BLOCK_SIZE = 4096;
+    std::vector< std::unique_ptr< struct counter_event[] > > event_blocks;
+    struct counter_event *free_events;
 
     /* Parameters for showing percentage */
     unsigned long long total_trace_size;
     unsigned long long current_read_size;
     unsigned long total_iters;
 
-    /* Struct needed for the mode SC_BY_STATE */
-    struct state_queue_elem *first_state_elem;
+    /* Threads by end time of their last state, needed for the mode SC_BY_STATE */
+    std::multimap< unsigned long long, int > state_queue;
 
     /* Estruct for keeping some types on trace */
     struct sc_kept_types types_to_keep;
 
     void read_sc_args();
-    void proces_header( char *header, FILE *in, FILE *out );
+    void proces_header();
+    bool read_record( int& id, int& cpu, int& appl, int& task, int& thread,
+                      unsigned long long& time, const char *&fields, const char *&fieldsEnd );
+    int find_thread( int appl, int task, int thread ) const;
+    int new_thread( int appl, int task, int thread );
+    int find_counter( const struct thread_info& whichThread,
+                      unsigned long long type, unsigned long long value ) const;
+    int add_counter( struct thread_info& whichThread,
+                     unsigned long long type, unsigned long long value );
+    void index_counter( struct thread_info& whichThread, int whichCounter );
+    struct counter_event *new_counter_event();
+    void free_counter_event( struct counter_event *event );
+    void append_counter_event( struct thread_info& whichThread, struct counter_event *event );
     void write_pcf( char *file_out );
     bool allowed_type( unsigned long long type, unsigned long long value );
     bool allowed_type_mark( unsigned long long type );
@@ -181,8 +200,7 @@ class KTraceSoftwareCounters : public TraceSoftwareCounters
     void flush_counter_buffers( void );
     void sc_by_event( ProgressController *progress );
     void insert_in_queue_state( int thread_id, unsigned long long time );
-    void put_counters_on_state( struct KTraceSoftwareCounters::state_queue_elem *p,
-                                struct KTraceSoftwareCounters::state_queue_elem *q );
+    void put_counters_on_state( std::multimap< unsigned long long, int >::iterator p );
     void sc_by_states( ProgressController *progress );
 };
 
@@ -25,6 +25,7 @@
 #pragma once
 
 
+#include <memory>
 #include <vector>
 #include "kwindowexception.h"
 #include "ktrace.h"
@@ -37,6 +38,7 @@
 #include "semanticthread.h"
 #include "semanticcompose.h"
 #include "kfilter.h"
+#include "filteredeventindex.h"
 #include "window.h"
 
 class KTimeline: public Timeline
@@ -253,6 +255,18 @@ class KSingleWindow: public KTimeline
       return myFilter->passFilter( it );
     }
 
+    // Changes whenever the semantics of the window change
+    const std::string& getCheckpointSignature() const
+    {
+      return checkpointSignature;
+    }
+
+    // Only present while the thread function asks for it
+    FilteredEventIndex *getEventIndex() const
+    {
+      return eventIndex.get();
+    }
+
     virtual bool setLevelFunction( TWindowLevel whichLevel,
                                    const std::string& whichFunction ) override;
     virtual std::string getLevelFunction( TWindowLevel whichLevel ) const override;
@@ -315,6 +329,7 @@ class KSingleWindow: public KTimeline
     }
 
     SemanticInfoType getSemanticInfoType() const override;
+    std::string getSemanticSignature() const override;
 
     virtual KTimeline *clone( bool recursiveClone = false ) override;
 
@@ -349,6 +364,11 @@ class KSingleWindow: public KTimeline
 
     SemanticFunction *functions[ COMPOSECPU + 1 ];
     KFilter *myFilter;
+    std::string checkpointSignature;
+    std::shared_ptr<FilteredEventIndex> eventIndex;
+
+    void updateCheckpointSignature();
+    void updateEventIndex();
 };
 
 
@@ -477,6 +497,7 @@ class KDerivedWindow: public KTimeline
     }
 
     SemanticInfoType getSemanticInfoType() const override;
+    std::string getSemanticSignature() const override;
 
     virtual KTimeline *clone( bool recursiveClone = false ) override;
 
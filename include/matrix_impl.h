@@ -146,6 +146,8 @@ template <typename ValueType, size_t NStats>
 inline void Matrix<ValueType, NStats>::finish( )
 {
   finished = true;
+  for ( PRV_UINT32 ii = 0; ii < ( PRV_UINT32 )cols.size(); ii++ )
+    cols[ ii ].finish();
 }
 
 
@@ -30,8 +30,27 @@
 class MemoryBlocks;
 class Trace;
 
+namespace Plain
+{
+  struct TRecord;
+}
+
 typedef struct {} TData;
 
+// Contiguous run of in-memory records: [first, last)
+struct TRecordSpan
+{
+  const Plain::TRecord *first;
+  const Plain::TRecord *last;
+};
+
+// Run of pointers to in-memory records: [first, last)
+struct TRecordPtrSpan
+{
+  const Plain::TRecord * const *first;
+  const Plain::TRecord * const *last;
+};
+
 class MemoryTrace
 {
   public:
@@ -79,6 +98,18 @@ class MemoryTrace
         virtual void         setRecordType( const TRecordType whichType ) = 0;
         virtual void         setStateEndTime( const TRecordTime whichEndTime ) = 0;
 
+        // Batch access: the run of records starting at the current one that
+        // is stored contiguously. Empty if the trace doesn't keep Plain::TRecord.
+        virtual TRecordSpan getRecords() const
+        {
+          return TRecordSpan{ nullptr, nullptr };
+        }
+        virtual void skipRecords( size_t whichCount )
+        {
+          for ( ; whichCount > 0; --whichCount )
+            ++( *this );
+        }
+
         virtual TData *getRecord() const
         {
           return record;
@@ -117,6 +148,30 @@ class MemoryTrace
     virtual void getRecordByTimeCPU( std::vector<MemoryTrace::iterator *>& listIter,
                                      TRecordTime whichTime ) const = 0;
 
+    // Batch access: appends the runs of records with time in [beginTime, endTime].
+    // Returns false if the trace doesn't keep its records in memory.
+    virtual bool getThreadRecords( TThreadOrder whichThread,
+                                   TRecordTime beginTime,
+                                   TRecordTime endTime,
+                                   std::vector<TRecordSpan>& spans ) const
+    {
+      return false;
+    }
+    virtual bool getCPURecords( TCPUOrder whichCPU,
+                                TRecordTime beginTime,
+                                TRecordTime endTime,
+                                std::vector<TRecordPtrSpan>& spans ) const
+    {
+      return false;
+    }
+
+    // True if iterators stay valid while the trace is open, so they can be
+    // kept around cheaply (e.g. by interval checkpoints).
+    virtual bool recordsInMemory() const
+    {
+      return false;
+    }
+
   protected:
 
   private:
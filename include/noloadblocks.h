@@ -25,7 +25,9 @@
 
 
 #include <fstream>
+#include <list>
 #include <map>
+#include <unordered_map>
 #include "memoryblocks.h"
 #include "utils/traceparser/resourcemodel.h"
 #include "utils/traceparser/processmodel.h"
@@ -50,14 +52,19 @@ namespace NoLoad
         file = nullptr;
       }
 
+      // Parsed records are kept in pages of pageSize bytes of the file, up to
+      // maxCacheSize bytes of memory; pages not used by any iterator are
+      // evicted least recently used first. Communications of not ordered
+      // traces are kept in the page defining them too.
       NoLoadBlocks( const ResourceModel<>& resource, const ProcessModel<>& process,
-                    TraceBodyIO< PARAM_TRACEBODY_CLASS > *whichBody, TraceStream *whichFile, TRecordTime endTime );
+                    TraceBodyIO< PARAM_TRACEBODY_CLASS > *whichBody, TraceStream *whichFile, TRecordTime endTime,
+                    size_t maxCacheSize = defaultCacheSize );
 
       virtual ~NoLoadBlocks();
 
       virtual TData *getLastRecord( PRV_UINT16 position ) const override;
       virtual void newRecord() override;
-      virtual void newRecord( TThreadOrder whichThread ) override {}
+      virtual void newRecord( TThreadOrder whichThread ) override;
       virtual void setRecordType( TRecordType whichType ) override;
       virtual void setTime( TRecordTime whichTime ) override;
       virtual void setThread( TThreadOrder whichThread ) override;
@@ -76,7 +83,7 @@ namespace NoLoad
       // Then you must call newComm( false )
       // If not, the function creates all necessary records by default.
       virtual void newComm( bool createRecords = true ) override;
-      virtual void newComm( TThreadOrder whichSenderThread, TThreadOrder whichReceiverThread, bool createRecords = true ) override {}
+      virtual void newComm( TThreadOrder whichSenderThread, TThreadOrder whichReceiverThread, bool createRecords = true ) override;
       virtual void setSenderThread( TThreadOrder whichThread ) override;
       virtual void setSenderThread( TApplOrder whichAppl,
                                     TTaskOrder whichTask,
@@ -135,15 +142,35 @@ namespace NoLoad
       virtual void setFileLoaded( TRecordTime traceEndTime ) override;
       virtual void setFirstOffset( PRV_INT64 whichOffset );
 
+      PRV_UINT64 getCacheHits() const;
+      PRV_UINT64 getCacheMisses() const;
+      size_t getCacheSize() const;
+
+      static constexpr PRV_INT64 pageSize = 1024 * 1024;
+      static constexpr size_t defaultCacheSize = 256 * 1024 * 1024;
+
     protected:
 
     private:
       struct fileLineData
       {
-        PRV_INT16 numUseds;
+        PRV_INT64 offset;
         PRV_INT64 endOffset;
+        PRV_UINT32 firstRecord;
+        PRV_UINT16 numRecords;
         TThreadOrder thread;
+      };
+
+      // Lines beginning inside one page of the file, parsed in one shot
+      struct filePage
+      {
+        PRV_INT64 index;
+        PRV_INT64 numUseds;
+        size_t memorySize;
+        std::vector<fileLineData> lines;
         std::vector<TRecord> records;
+        std::vector<TCommInfo> comms;
+        std::list<PRV_INT64>::iterator unusedPosition;
       };
 
       const ResourceModel<>& resourceModel;
@@ -154,16 +181,23 @@ namespace NoLoad
       PRV_INT64 initialOffset;
 
       std::vector<Index<PRV_INT64> > traceIndex;
-      std::map<PRV_INT64, fileLineData *> blocks;
       std::vector<PRV_INT64> beginThread;
 
+      std::unordered_map<PRV_INT64, filePage *> pages;
+      std::list<PRV_INT64> unusedPages; // Least recently used first
+      size_t maxCacheSize = defaultCacheSize;
+      size_t cacheSize = 0;
+      PRV_UINT64 cacheHits = 0;
+      PRV_UINT64 cacheMisses = 0;
+      filePage *loadingPage = nullptr;
+
       TRecord globalBeginRec;
       TRecord globalEndRec;
 
       std::vector<TRecord> emptyBeginRecords;
       std::vector<TRecord> emptyEndRecords;
 
-      std::vector<TCommInfo *> communications;
+      std::vector<TCommInfo> communications;
       TCommID currentComm;
       TRecord *logSend;
       TRecord *logRecv;
@@ -171,7 +205,7 @@ namespace NoLoad
       TRecord *phyRecv;
 
       fileLineData *lastData;
-      PRV_INT16 lastRecord;
+      PRV_UINT32 lastRecord;
       PRV_INT64 lastPos;
 
       bool fileLoaded;
@@ -184,7 +218,23 @@ namespace NoLoad
       MetadataManager dummyTraceInfo;
       TTime dummyEndTime;
 
-      void goToPrevLine();
+      // Ids of page communications are pageIndex * pageSize + position
+      TCommInfo& getComm( TCommID whichComm );
+      const TCommInfo& getComm( TCommID whichComm ) const;
+      TCommInfo& getCurrentComm();
+
+      filePage *getPage( PRV_INT64 whichPage );
+      void loadPage( PRV_INT64 whichPage, filePage *onPage );
+      void evictPages();
+      void pinPage( filePage *whichPage );
+      void unpinPage( filePage *whichPage );
+
+      // Line beginning exactly at offset, only among loaded pages
+      bool findLoadedLine( PRV_INT64 offset, filePage *&page, fileLineData *&line ) const;
+      // First line with records beginning at or after offset
+      bool findNextLine( PRV_INT64 offset, filePage *&page, fileLineData *&line );
+      // Last line with records beginning before offset
+      bool findPrevLine( PRV_INT64 offset, filePage *&page, fileLineData *&line );
   };
 }
 
@@ -129,7 +129,7 @@ namespace Plain
       std::vector<TRecord *> currentBlock;
       std::vector<TLastRecord> lastRecords;
       std::vector<std::vector<TRecord *> > blocks;
-      std::vector<TCommInfo *> communications;
+      std::vector<TCommInfo> communications;
       TCommID currentComm;
       const ResourceModel<>& resourceModel;
       const ProcessModel<>& processModel;
@@ -105,6 +105,9 @@ namespace Plain
 
           virtual ThreadIterator *clone() const override;
 
+          virtual TRecordSpan getRecords() const override;
+          virtual void skipRecords( size_t whichCount ) override;
+
         private:
           TThreadOrder thread;
           PRV_UINT32 block;
@@ -171,6 +174,16 @@ namespace Plain
       virtual void getRecordByTimeCPU( std::vector<MemoryTrace::iterator *>& listIter,
                                        TRecordTime whichTime ) const override;
 
+      virtual bool getThreadRecords( TThreadOrder whichThread,
+                                     TRecordTime beginTime,
+                                     TRecordTime endTime,
+                                     std::vector<TRecordSpan>& spans ) const override;
+
+      virtual bool recordsInMemory() const override
+      {
+        return true;
+      }
+
     protected:
 
     private:
@@ -30,6 +30,10 @@
 
 namespace Plain
 {
+  // Payloads are packed to 4 bytes so that the record type, thread and CPU
+  // fill the tail of the union instead of padding: a record takes 32 bytes
+  // with 16 and 32 bits object orders (40 before with 32 bits).
+#pragma pack( push, 4 )
   typedef struct TEventRecord
   {
     TEventValue     value;
@@ -51,6 +55,7 @@ namespace Plain
     TCommID index;
   }
   TCommRecord;
+#pragma pack( pop )
 
 
   typedef struct TCommInfo
@@ -69,20 +74,35 @@ namespace Plain
   TCommInfo;
 
 
+#ifdef COMPACT_RECORDS_ENABLED
+  // Compact layout: records are packed to 2 bytes, so they take 26 bytes
+  // with 16 bits object orders and 30 with 32 bits. Times and payloads of
+  // most records are not 8 bytes aligned then.
+#pragma pack( push, 2 )
+#endif
   typedef struct TRecord : public TData
   {
     TRecordTime  time;
-    TRecordType  type;
-    TThreadOrder thread; // Needed by trace edit sequence
-    TCPUOrder    CPU;
     union
     {
       TStateRecord stateRecord;
       TEventRecord eventRecord;
       TCommRecord  commRecord;
     } URecordInfo;
+    TRecordType  type;
+    TThreadOrder thread; // Needed by trace edit sequence
+    TCPUOrder    CPU;
   }
   TRecord;
+#ifdef COMPACT_RECORDS_ENABLED
+#pragma pack( pop )
+
+  static_assert( sizeof( TRecord ) == sizeof( TRecordTime ) + sizeof( TEventRecord ) +
+                 sizeof( TRecordType ) + sizeof( TThreadOrder ) + sizeof( TCPUOrder ),
+                 "Plain::TRecord compact layout has padding" );
+#else
+  static_assert( sizeof( TRecord ) == 32, "Plain::TRecord layout has padding" );
+#endif
 
   static inline TRecordTime getTime( const TRecord *record )
   {
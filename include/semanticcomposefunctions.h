@@ -26,7 +26,6 @@
 
 
 #include <cmath>
-#include <list>
 #include <stack>
 #include <unordered_map>
 
@@ -1490,6 +1489,9 @@ class ComposeStackedValue: public SemanticCompose
       return new ComposeStackedValue( *this );
     }
 
+    virtual bool getRowState( TObjectOrder whichRow, std::vector<TSemanticValue>& onVector ) override;
+    virtual void setRowState( TObjectOrder whichRow, const std::vector<TSemanticValue>& whichState ) override;
+
     virtual SemanticInfoType getSemanticInfoType() const override
     {
       return SAME_TYPE;
@@ -1516,7 +1518,7 @@ class ComposeStackedValue: public SemanticCompose
       return "";
     }
 
-    virtual std::unordered_map<TObjectOrder, std::vector<TSemanticValue> > *getStack() override
+    virtual std::vector<std::vector<TSemanticValue> > *getStack() override
     {
       return &myStack;
     }
@@ -1525,7 +1527,7 @@ class ComposeStackedValue: public SemanticCompose
     static const bool initFromBegin = true;
     static std::string name;
 
-    std::unordered_map<TObjectOrder, std::vector<TSemanticValue> > myStack;
+    std::vector<std::vector<TSemanticValue> > myStack;
 };
 
 
@@ -1565,6 +1567,9 @@ class ComposeInStackedValue: public SemanticCompose
       return new ComposeInStackedValue( *this );
     }
 
+    virtual bool getRowState( TObjectOrder whichRow, std::vector<TSemanticValue>& onVector ) override;
+    virtual void setRowState( TObjectOrder whichRow, const std::vector<TSemanticValue>& whichState ) override;
+
 
   protected:
     virtual const bool getMyInitFromBegin() override
@@ -1589,7 +1594,7 @@ class ComposeInStackedValue: public SemanticCompose
       return "Value";
     }
 
-    virtual std::unordered_map<TObjectOrder, std::vector<TSemanticValue> > *getStack() override
+    virtual std::vector<std::vector<TSemanticValue> > *getStack() override
     {
       return &myStack;
     }
@@ -1598,7 +1603,7 @@ class ComposeInStackedValue: public SemanticCompose
     static const bool initFromBegin = true;
     static std::string name;
 
-    std::unordered_map<TObjectOrder, std::vector<TSemanticValue> > myStack;
+    std::vector<std::vector<TSemanticValue> > myStack;
 };
 
 
@@ -1637,6 +1642,9 @@ class ComposeNestingLevel: public SemanticCompose
       return new ComposeNestingLevel( *this );
     }
 
+    virtual bool getRowState( TObjectOrder whichRow, std::vector<TSemanticValue>& onVector ) override;
+    virtual void setRowState( TObjectOrder whichRow, const std::vector<TSemanticValue>& whichState ) override;
+
 
   protected:
     virtual const bool getMyInitFromBegin() override
@@ -1663,7 +1671,7 @@ class ComposeNestingLevel: public SemanticCompose
     static const bool initFromBegin = true;
     static std::string name;
 
-    std::unordered_map<TObjectOrder, TSemanticValue> myStack;
+    std::vector<TSemanticValue> myStack;
 };
 
 class ComposeLRUDepth: public SemanticCompose
@@ -1702,6 +1710,9 @@ class ComposeLRUDepth: public SemanticCompose
       return new ComposeLRUDepth( *this );
     }
 
+    virtual bool getRowState( TObjectOrder whichRow, std::vector<TSemanticValue>& onVector ) override;
+    virtual void setRowState( TObjectOrder whichRow, const std::vector<TSemanticValue>& whichState ) override;
+
 
   protected:
     virtual const bool getMyInitFromBegin() override
@@ -1732,7 +1743,34 @@ class ComposeLRUDepth: public SemanticCompose
     static const bool initFromBegin = true;
     static std::string name;
 
-    std::unordered_map<TObjectOrder, std::list< TSemanticValue > > LRUStack;
+    static constexpr PRV_UINT32 MIN_SLOTS = 64;
+    static constexpr size_t MAX_STACK_SIZE = 1 << 30;
+
+    // Every use gets a new time slot; the depth of a value is the number of
+    // live slots after its last use, counted with a Fenwick tree. Slots are
+    // renumbered when they run out, growing up to twice the stack size
+    // while more than half of them are live.
+    struct TLRUStack
+    {
+      std::unordered_map<TSemanticValue, PRV_UINT32> lastUse;
+      std::vector<TSemanticValue> slotValue;
+      std::vector<bool> slotUsed;
+      std::vector<PRV_UINT32> usedTree;
+      PRV_UINT32 nextSlot = 0;
+      PRV_UINT32 oldestSlot = 0;
+      PRV_UINT32 numUsed = 0;
+      PRV_UINT32 maxSlots = 0;
+    };
+
+    std::vector<TLRUStack> LRUStack;
+
+    size_t getStackSize() const;
+    static void setupStack( TLRUStack& whichStack, size_t stackSize );
+    static void resetSlots( TLRUStack& whichStack, PRV_UINT32 numSlots );
+    static void pushValue( TLRUStack& whichStack, TSemanticValue whichValue );
+    static void removeSlot( TLRUStack& whichStack, PRV_UINT32 whichSlot );
+    static PRV_UINT32 countUsedUntil( const TLRUStack& whichStack, PRV_UINT32 whichSlot );
+    static void compactSlots( TLRUStack& whichStack );
 };
 
 
@@ -1771,6 +1809,11 @@ class ComposeEnumerate: public SemanticCompose
       return new ComposeEnumerate( *this );
     }
 
+    virtual bool getRowState( TObjectOrder whichRow, std::vector<TSemanticValue>& onVector ) override
+    {
+      return true;
+    }
+
 
   protected:
     virtual const bool getMyInitFromBegin() override
@@ -1835,6 +1878,11 @@ class ComposeAccumulate: public SemanticCompose
       return new ComposeAccumulate( *this );
     }
 
+    virtual bool getRowState( TObjectOrder whichRow, std::vector<TSemanticValue>& onVector ) override
+    {
+      return true;
+    }
+
 
   protected:
     virtual const bool getMyInitFromBegin() override
@@ -1898,6 +1946,9 @@ class ComposeDelta: public SemanticCompose
       return new ComposeDelta( *this );
     }
 
+    virtual bool getRowState( TObjectOrder whichRow, std::vector<TSemanticValue>& onVector ) override;
+    virtual void setRowState( TObjectOrder whichRow, const std::vector<TSemanticValue>& whichState ) override;
+
   protected:
     virtual const bool getMyInitFromBegin() override
     {
@@ -87,7 +87,7 @@ class SemanticFunction
 
     virtual SemanticFunction *clone() = 0;
 
-    virtual std::unordered_map<TObjectOrder, std::vector<TSemanticValue> > *getStack()
+    virtual std::vector<std::vector<TSemanticValue> > *getStack()
     {
       return nullptr;
     }
@@ -97,6 +97,17 @@ class SemanticFunction
       return NO_TYPE;
     }
 
+    // State kept for one row between executions, used by interval checkpoints.
+    // Functions that start from the beginning of the trace must override both
+    // to be checkpointed; returns false if the state can't be saved.
+    virtual bool getRowState( TObjectOrder whichRow, std::vector<TSemanticValue>& onVector )
+    {
+      return !getMyInitFromBegin();
+    }
+
+    virtual void setRowState( TObjectOrder whichRow, const std::vector<TSemanticValue>& whichState )
+    {}
+
   protected:
     std::vector<TParamValue> parameters;
     std::vector<std::string> parametersName;
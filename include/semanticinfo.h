@@ -30,6 +30,8 @@
 #include "interval.h"
 #include "memorytrace.h"
 
+class ChildrenAggregation;
+
 struct SemanticInfo
 {
   Interval *callingInterval;
@@ -49,6 +51,8 @@ struct SemanticHighInfo: public SemanticInfo
   TRecordTime dataBeginTime;
   TRecordTime dataEndTime;
   bool newControlBurst;
+  // Kept up to date by IntervalNotThread if the function asks for it
+  const ChildrenAggregation *aggregation = nullptr;
 };
 
 
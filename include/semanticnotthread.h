@@ -25,6 +25,7 @@
 #pragma once
 
 
+#include "childrenaggregation.h"
 #include "semantichigh.h"
 
 class SemanticNotThread: public SemanticHigh
@@ -36,6 +37,13 @@ class SemanticNotThread: public SemanticHigh
     virtual ~SemanticNotThread()
     {}
 
+    // Reductions of the children values that execute() reads from
+    // info->aggregation instead of going through all of them
+    virtual ChildrenAggregation::TAggregations getAggregations() const
+    {
+      return ChildrenAggregation::NO_AGGREGATION;
+    }
+
   protected:
 
   private:
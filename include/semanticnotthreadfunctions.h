@@ -62,6 +62,11 @@ class Adding: public SemanticNotThread
       return new Adding( *this );
     }
 
+    virtual ChildrenAggregation::TAggregations getAggregations() const override
+    {
+      return ChildrenAggregation::SUM;
+    }
+
 
   protected:
     virtual const bool getMyInitFromBegin() override
@@ -122,6 +127,11 @@ class AddingSign: public SemanticNotThread
       return new AddingSign( *this );
     }
 
+    virtual ChildrenAggregation::TAggregations getAggregations() const override
+    {
+      return ChildrenAggregation::SUM;
+    }
+
 
   protected:
     virtual const bool getMyInitFromBegin() override
@@ -183,6 +193,11 @@ class Average: public SemanticNotThread
       return new Average( *this );
     }
 
+    virtual ChildrenAggregation::TAggregations getAggregations() const override
+    {
+      return ChildrenAggregation::SUM;
+    }
+
 
   protected:
     virtual const bool getMyInitFromBegin() override
@@ -244,6 +259,11 @@ class Maximum: public SemanticNotThread
       return new Maximum( *this );
     }
 
+    virtual ChildrenAggregation::TAggregations getAggregations() const override
+    {
+      return ChildrenAggregation::MAXIMUM;
+    }
+
     virtual SemanticInfoType getSemanticInfoType() const override
     {
       return SAME_TYPE;
@@ -309,6 +329,11 @@ class Minimum: public SemanticNotThread
       return new Minimum( *this );
     }
 
+    virtual ChildrenAggregation::TAggregations getAggregations() const override
+    {
+      return ChildrenAggregation::MINIMUM;
+    }
+
     virtual SemanticInfoType getSemanticInfoType() const override
     {
       return SAME_TYPE;
@@ -375,6 +400,11 @@ class Activity: public SemanticNotThread
       return new Activity( *this );
     }
 
+    virtual ChildrenAggregation::TAggregations getAggregations() const override
+    {
+      return ChildrenAggregation::COUNT;
+    }
+
   protected:
     virtual const bool getMyInitFromBegin() override
     {
@@ -441,6 +471,11 @@ class InActivity: public SemanticNotThread
       return new InActivity( *this );
     }
 
+    virtual ChildrenAggregation::TAggregations getAggregations() const override
+    {
+      return ChildrenAggregation::COUNT;
+    }
+
 
   protected:
     virtual const bool getMyInitFromBegin() override
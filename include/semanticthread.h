@@ -37,9 +37,12 @@ class SemanticThread : public SemanticFunction
 
     virtual bool validRecord( MemoryTrace::iterator *record )
     {
-      TRecordType type = record->getRecordType();
-      TRecordType mask = getValidateMask();
+      return validRecordType( record->getRecordType(), getValidateMask() );
+    }
 
+    // Necessary condition for validRecord, depending only on the record type
+    static bool validRecordType( TRecordType type, TRecordType mask )
+    {
       if ( type == EMPTYREC )
         return true;
 
@@ -64,10 +67,17 @@ class SemanticThread : public SemanticFunction
       return ( ( mask & type ) == mask );
     }
 
-  protected:
     // Valid records for this function
     virtual const TRecordType getValidateMask() = 0;
 
+    // Looks for the next event passing the filter on every execution
+    virtual bool getNeedsEventIndex() const
+    {
+      return false;
+    }
+
+  protected:
+
   private:
 };
 
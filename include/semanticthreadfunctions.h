@@ -26,6 +26,7 @@
 
 #include <unordered_map>
 
+#include "filteredeventindex.h"
 #include "semanticthread.h"
 #include "paraverconfig.h"
 
@@ -34,6 +35,8 @@ class KSingleWindow;
 
 // Semantic auxiliar functions
 void getNextEvent( MemoryTrace::iterator *it, KSingleWindow *window );
+// Same as getNextEvent, through the window event index when there is one
+bool getNextEvent( const SemanticThreadInfo *info, FilteredEventIndex::TEventEntry& onEvent );
 
 TSemanticValue getTotalCommSize( MemoryTrace::iterator *itBegin,
                                  MemoryTrace::iterator *itEnd,
@@ -773,6 +776,11 @@ class NextEventType: public SemanticThread
       return new NextEventType( *this );
     }
 
+    virtual bool getNeedsEventIndex() const override
+    {
+      return true;
+    }
+
     virtual SemanticInfoType getSemanticInfoType() const override
     {
       return EVENTTYPE_TYPE;
@@ -838,6 +846,11 @@ class NextEventValue: public SemanticThread
       return new NextEventValue( *this );
     }
 
+    virtual bool getNeedsEventIndex() const override
+    {
+      return true;
+    }
+
     virtual SemanticInfoType getSemanticInfoType() const override
     {
       return EVENTVALUE_TYPE;
@@ -904,6 +917,11 @@ class AverageNextEventValue: public SemanticThread
       return new AverageNextEventValue( *this );
     }
 
+    virtual bool getNeedsEventIndex() const override
+    {
+      return true;
+    }
+
 
   protected:
     virtual const TRecordType getValidateMask() override
@@ -971,6 +989,11 @@ class AverageLastEventValue: public SemanticThread
       return new AverageLastEventValue( *this );
     }
 
+    virtual bool getNeedsEventIndex() const override
+    {
+      return true;
+    }
+
 
   protected:
     virtual const TRecordType getValidateMask() override
@@ -1175,6 +1198,11 @@ class IntervalBetweenEvents: public SemanticThread
       return new IntervalBetweenEvents( *this );
     }
 
+    virtual bool getNeedsEventIndex() const override
+    {
+      return true;
+    }
+
     virtual SemanticInfoType getSemanticInfoType() const override
     {
       return TIME_TYPE;
@@ -1968,6 +1996,11 @@ class SendBytesInTransit: public SemanticThread
       return new SendBytesInTransit( *this );
     }
 
+    virtual bool getRowState( TObjectOrder whichRow, std::vector<TSemanticValue>& onVector ) override
+    {
+      return true;
+    }
+
     virtual SemanticInfoType getSemanticInfoType() const override
     {
       return COMMSIZE_TYPE;
@@ -2033,6 +2066,11 @@ class SendMessagesInTransit: public SemanticThread
       return new SendMessagesInTransit( *this );
     }
 
+    virtual bool getRowState( TObjectOrder whichRow, std::vector<TSemanticValue>& onVector ) override
+    {
+      return true;
+    }
+
 
   protected:
     virtual const TRecordType getValidateMask() override
@@ -2166,6 +2204,11 @@ class RecvBytesInTransit: public SemanticThread
       return new RecvBytesInTransit( *this );
     }
 
+    virtual bool getRowState( TObjectOrder whichRow, std::vector<TSemanticValue>& onVector ) override
+    {
+      return true;
+    }
+
     virtual SemanticInfoType getSemanticInfoType() const override
     {
       return COMMSIZE_TYPE;
@@ -2231,6 +2274,11 @@ class RecvMessagesInTransit: public SemanticThread
       return new RecvMessagesInTransit( *this );
     }
 
+    virtual bool getRowState( TObjectOrder whichRow, std::vector<TSemanticValue>& onVector ) override
+    {
+      return true;
+    }
+
 
   protected:
     virtual const TRecordType getValidateMask() override
@@ -2364,6 +2412,11 @@ class RecvNegativeMessages: public SemanticThread
       return new RecvNegativeMessages( *this );
     }
 
+    virtual bool getRowState( TObjectOrder whichRow, std::vector<TSemanticValue>& onVector ) override
+    {
+      return true;
+    }
+
 
   protected:
     virtual const TRecordType getValidateMask() override
@@ -2425,6 +2478,11 @@ class RecvNegativeBytes: public SemanticThread
       return new RecvNegativeBytes( *this );
     }
 
+    virtual bool getRowState( TObjectOrder whichRow, std::vector<TSemanticValue>& onVector ) override
+    {
+      return true;
+    }
+
     virtual SemanticInfoType getSemanticInfoType() const override
     {
       return COMMSIZE_TYPE;
@@ -2490,6 +2548,11 @@ class NumberReceives: public SemanticThread
       return new NumberReceives( *this );
     }
 
+    virtual bool getRowState( TObjectOrder whichRow, std::vector<TSemanticValue>& onVector ) override
+    {
+      return true;
+    }
+
 
   protected:
     virtual const TRecordType getValidateMask() override
@@ -2551,6 +2614,11 @@ class NumberReceiveBytes: public SemanticThread
       return new NumberReceiveBytes( *this );
     }
 
+    virtual bool getRowState( TObjectOrder whichRow, std::vector<TSemanticValue>& onVector ) override
+    {
+      return true;
+    }
+
     virtual SemanticInfoType getSemanticInfoType() const override
     {
       return COMMSIZE_TYPE;
@@ -73,10 +73,18 @@ class TraceBodyIO_v2 : public TraceBodyIO<TraceStream,
     void writeCommInfo( std::fstream& whichStream,
                         const KTrace& whichTrace,
                         PRV_INT32 numIter = 1 ) const;
+    // Records are kept in a buffer until it is full or the output stream
+    // changes; callers must flush it before closing the stream.
+    void flushBuffer() const;
 
   protected:
 
   private:
+    static constexpr size_t OutputBufferSize = 4194304;
+
+    mutable std::fstream *outputStream = nullptr;
+    mutable std::string outputBuffer;
+
     void readState( const string& line, 
                     const ProcessModel<>& whichProcessModel,
                     const ResourceModel<>& whichResourceModel,
@@ -92,13 +100,21 @@ class TraceBodyIO_v2 : public TraceBodyIO<TraceStream,
                    const ResourceModel<>& whichResourceModel,
                    MemoryBlocks& records ) const;
     void readGlobalComm( const std::string& line, MemoryBlocks& records ) const;
-    bool readCommon( std::istringstream& line,
+    bool readCommon( const char *&it,
+                     const char *end,
                      const ProcessModel<>& whichProcessModel,
                      const ResourceModel<>& whichResourceModel,
                      TCPUOrder& CPU,
                      TThreadOrder& thread,
                      TRecordTime& time ) const;
 
+    template< typename T >
+    static void appendNumber( std::string& buffer, T value );
+    static void appendNumber( std::string& buffer, double value );
+
+    void beginRecord( std::fstream& whichStream ) const;
+    void endRecord() const;
+
     bool writeState( std::string& line,
                      const ProcessModel<>& whichProcessModel,
                      const ResourceModel<>& whichResourceModel,
@@ -113,7 +129,7 @@ class TraceBodyIO_v2 : public TraceBodyIO<TraceStream,
     bool writeGlobalComm( std::string& line,
                           const ProcessModel<>& whichProcessModel,
                           MemoryTrace::iterator *record ) const;
-    void writeCommon( std::ostringstream& line,
+    void writeCommon( std::string& line,
                       const ProcessModel<>& whichProcessModel,
                       const ResourceModel<>& whichResourceModel,
                       MemoryTrace::iterator *record ) const;
@@ -0,0 +1,77 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                               libparaver-api                              *
+ *                       Paraver Main Computing Library                      *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+
+#pragma once
+
+#include <set>
+#include <string>
+#include <unordered_set>
+
+#include "paraverkerneltypes.h"
+#include "ParaverMetadataManager.h"
+
+class VectorBlocks;
+
+// Binary sidecar of a fully loaded trace body ("<trace>.bcache").
+// It is validated against the size, modification time and a checksum of
+// the original trace, so a stale cache is just ignored and rewritten.
+class TraceCache
+{
+  public:
+    static std::string getCacheFileName( const std::string& whichTraceFile );
+
+    // Fills blocks (already built from the trace header) with the cached body.
+    // Returns false if there is no valid cache for the trace.
+    static bool load( const std::string& whichTraceFile,
+                      VectorBlocks& blocks,
+                      std::unordered_set<TState>& states,
+                      std::unordered_set<TEventType>& events,
+                      MetadataManager& traceInfo );
+
+    // Must be called after blocks->setFileLoaded. Errors are silently ignored.
+    static void save( const std::string& whichTraceFile,
+                      const VectorBlocks& blocks,
+                      const std::set<TState>& states,
+                      const std::set<TEventType>& events,
+                      MetadataManager& traceInfo );
+
+  private:
+    static constexpr char MAGIC[ 8 ] = { 'P', 'R', 'V', 'C', 'A', 'C', 'H', 'E' };
+    static constexpr PRV_UINT32 FORMAT_VERSION = 3;
+    static constexpr size_t CHECKSUM_BLOCK_SIZE = 1024 * 1024;
+
+    struct THeader
+    {
+      char magic[ 8 ];
+      PRV_UINT32 formatVersion;
+      PRV_UINT32 recordSize;
+      PRV_UINT32 commSize;
+      PRV_UINT32 padding;
+      PRV_UINT64 traceFileSize;
+      PRV_INT64  traceFileTime;
+      PRV_UINT64 traceChecksum;
+    };
+
+    static bool readTraceStamp( const std::string& whichTraceFile, THeader& header );
+};
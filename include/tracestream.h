@@ -26,9 +26,12 @@
 
 
 #include <fstream>
+#include <memory>
 #include <string>
+#include <vector>
 #include <zlib.h>
 #include "paraverkerneltypes.h"
+#include "gzipindex.h"
 
 class TraceStream
 {
@@ -47,6 +50,9 @@ class TraceStream
     virtual void open( const std::string& filename ) = 0;
     virtual void close() = 0;
     virtual void getline( std::string& strLine ) = 0;
+    // Points lineBegin/lineEnd to the next line, without its '\n'.
+    // The range is valid until the next read from the stream.
+    virtual void getlineView( const char *&lineBegin, const char *&lineEnd );
     virtual bool eof() = 0;
     virtual void seekbegin() = 0;
     virtual void seekend() = 0;
@@ -59,6 +65,7 @@ class TraceStream
 
     static TraceStream *openFile( const std::string& filename );
 
+    // Uncompressed size; estimated for gzipped traces never decompressed
     static TTraceSize getTraceFileSize( const std::string& filename );
 
     static const double GZIP_COMPRESSION_RATIO;
@@ -67,6 +74,9 @@ class TraceStream
     virtual void setFilename( const std::string &newFile );
   protected:
     std::string filename;
+
+  private:
+    std::string lineBuffer;
 };
 
 
@@ -102,6 +112,47 @@ private:
 };
 
 
+#ifndef _WIN32
+// Uncompressed trace mapped in memory. Lines are given as ranges inside the
+// mapping, so no data is copied and seeking only moves the current offset.
+class MemoryMapped: public TraceStream
+{
+  public:
+    MemoryMapped()
+    {}
+
+    MemoryMapped( const std::string& filename );
+
+    virtual ~MemoryMapped();
+
+    virtual void open( const std::string& filename ) override;
+    virtual void close() override;
+    virtual void getline( std::string& strLine ) override;
+    virtual void getlineView( const char *&lineBegin, const char *&lineEnd ) override;
+    virtual bool eof() override;
+    virtual void seekbegin() override;
+    virtual void seekend() override;
+    virtual void seekg( std::streampos pos ) override;
+    virtual std::streampos tellg() override;
+    virtual bool canseekend() override;
+    virtual bool good() const override;
+    virtual void clear() override;
+    virtual int peek() override;
+
+  private:
+    const char *mappedData = nullptr;
+    TTraceSize mappedSize = 0;
+    TTraceSize currentPos = 0;
+    bool isOpen = false;
+    bool endOfFile = false;
+
+};
+#endif
+
+
+// gzipped trace decompressed through a GzipIndex, so seeking is cheap on any
+// zone already decompressed once. When the index is complete, consecutive
+// ranges between access points are decompressed in parallel.
 class Compressed: public TraceStream
 {
   public:
@@ -116,6 +167,7 @@ class Compressed: public TraceStream
     virtual void open( const std::string& filename ) override;
     virtual void close() override;
     virtual void getline( std::string& strLine ) override;
+    virtual void getlineView( const char *&lineBegin, const char *&lineEnd ) override;
     virtual bool eof() override;
     virtual void seekbegin() override;
     virtual void seekend() override;
@@ -129,10 +181,20 @@ class Compressed: public TraceStream
     static TTraceSize getTraceFileSize( const std::string& filename );
 
   private:
-    static const PRV_UINT32 LINESIZE = 1000 * 1024;
-    gzFile file;
-    char tmpLine[ LINESIZE ];
+    static const size_t READ_SIZE = 1024 * 1024;
+
+    std::shared_ptr<GzipIndex> index;
+    std::unique_ptr<GzipDecoder> decoder;
+    bool decoderInPlace = false; // decoder continues where buffer ends
+    std::vector< std::unique_ptr<GzipDecoder> > rangeDecoders; // kept between parallel refills
+
+    std::vector<char> buffer;
+    size_t bufferPos = 0;
+    TTraceSize bufferOffset = 0; // uncompressed offset of buffer[ 0 ]
+    bool isOpen = false;
+    bool endOfFile = false;
 
+    bool fillBuffer();
 };
 
 
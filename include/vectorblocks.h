@@ -100,7 +100,12 @@ class VectorBlocks : public MemoryBlocks
     virtual TRecordTime getLastRecordTime() const override;
 
     virtual void setFileLoaded( TRecordTime traceEndTime ) override;
-    
+
+    // Appends the records and communications read on each partition, in
+    // partition order, so the result is the same as a single ordered read.
+    // Partitions are left empty.
+    void mergePartitions( std::vector< VectorBlocks * >& partitions );
+
   private:
     std::vector< TThreadRecordContainer > threadRecords;
     std::vector< TCPURecordContainer > cpuRecords;
@@ -134,5 +139,6 @@ class VectorBlocks : public MemoryBlocks
 
     friend class VectorTrace;
     friend class VectorTrace::iterator;
+    friend class TraceCache;
 
 };
\ No newline at end of file
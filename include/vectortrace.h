@@ -63,6 +63,9 @@ class VectorTrace : public MemoryTrace
         virtual void setRecordType( const TRecordType whichType ) override;
         virtual void setStateEndTime( const TRecordTime whichEndTime ) override;
 
+        virtual TRecordSpan getRecords() const override;
+        virtual void skipRecords( size_t whichCount ) override;
+
       private:
         TThreadRecordContainer::iterator it;
         VectorBlocks *myBlocks;
@@ -122,6 +125,20 @@ class VectorTrace : public MemoryTrace
     virtual void getRecordByTimeCPU( std::vector<MemoryTrace::iterator *>& listIter,
                                      TRecordTime whichTime ) const override;
 
+    virtual bool getThreadRecords( TThreadOrder whichThread,
+                                   TRecordTime beginTime,
+                                   TRecordTime endTime,
+                                   std::vector<TRecordSpan>& spans ) const override;
+    virtual bool getCPURecords( TCPUOrder whichCPU,
+                                TRecordTime beginTime,
+                                TRecordTime endTime,
+                                std::vector<TRecordPtrSpan>& spans ) const override;
+
+    virtual bool recordsInMemory() const override
+    {
+      return true;
+    }
+
   private:
     VectorBlocks *myBlocks;
     Trace *myTrace;
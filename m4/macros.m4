@@ -36,6 +36,46 @@ AC_DEFUN([AX_PROG_ENABLE_EXTENDED_OBJECTS],
 
 
 
+# AX_PROG_ENABLE_COMPACT_RECORDS
+# -------------------------------
+AC_DEFUN([AX_PROG_ENABLE_COMPACT_RECORDS],
+[
+   AC_ARG_ENABLE(compact_records,
+      AC_HELP_STRING(
+         [--enable-compact-records],
+         [Pack trace records without alignment padding, using less memory per record (default: disabled)]
+      ),
+      [enable_compact_records="${enableval}"],
+      [enable_compact_records="no"]
+   )
+
+   if test "${enable_compact_records}" = "yes" ; then
+     AC_DEFINE([COMPACT_RECORDS_ENABLED], 1, [Trace records packed without alignment padding.])
+   fi
+])
+
+
+
+# AX_PROG_ENABLE_RECORD_LIST_POOL
+# -------------------------------
+AC_DEFUN([AX_PROG_ENABLE_RECORD_LIST_POOL],
+[
+   AC_ARG_ENABLE(record_list_pool,
+      AC_HELP_STRING(
+         [--disable-record-list-pool],
+         [Allocate timeline record lists from the heap instead of a per-list node pool (default: pool enabled)]
+      ),
+      [enable_record_list_pool="${enableval}"],
+      [enable_record_list_pool="yes"]
+   )
+
+   if test "${enable_record_list_pool}" = "yes" ; then
+     AC_DEFINE([RECORD_LIST_POOL_ENABLED], 1, [Record lists use a per-list node pool.])
+   fi
+])
+
+
+
 # AX_PROG_ENABLE_OMPSS
 # --------------------
 AC_DEFUN([AX_PROG_ENABLE_OMPSS],
@@ -0,0 +1,246 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                               libparaver-api                              *
+ *                       Paraver Main Computing Library                      *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+
+
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "childrenaggregation.h"
+
+static TSemanticValue maxValue( TSemanticValue a, TSemanticValue b )
+{
+  return a > b ? a : b;
+}
+
+static TSemanticValue minValue( TSemanticValue a, TSemanticValue b )
+{
+  return a < b ? a : b;
+}
+
+
+ChildrenAggregation::ChildrenAggregation() :
+    aggregations( NO_AGGREGATION ), numChildren( 0 ),
+    sum( 0 ), maxExactValue( 0 ), inexactValues( 0 ), negatives( 0 )
+{}
+
+
+void ChildrenAggregation::init( TAggregations whichAggregations, const std::vector<TSemanticValue>& whichValues )
+{
+  aggregations = whichAggregations;
+  numChildren = whichValues.size();
+
+  sum = 0;
+  inexactValues = 0;
+  maximums.clear();
+  minimums.clear();
+  zeros.clear();
+  negatives = 0;
+  valueCount.clear();
+
+  if ( aggregations & SUM )
+  {
+    // Integers up to 2^53 are exact, and no partial sum of numChildren
+    // values plus the one being added can go beyond that
+    maxExactValue = std::ldexp( 1.0, std::numeric_limits<TSemanticValue>::digits ) / ( numChildren + 1 );
+    for ( PRV_UINT32 i = 0; i < numChildren; ++i )
+      addSum( whichValues[ i ] );
+  }
+  if ( aggregations & MAXIMUM )
+    build( maximums, whichValues, maxValue );
+  if ( aggregations & MINIMUM )
+    build( minimums, whichValues, minValue );
+
+  if ( aggregations & ( MINIMUM | COUNT ) )
+  {
+    for ( PRV_UINT32 i = 0; i < numChildren; ++i )
+      addCount( whichValues[ i ], i );
+  }
+}
+
+
+void ChildrenAggregation::update( PRV_UINT32 whichChild, TSemanticValue oldValue, TSemanticValue newValue )
+{
+  if ( oldValue == newValue )
+    return;
+
+  if ( aggregations & SUM )
+  {
+    removeSum( oldValue );
+    addSum( newValue );
+  }
+  if ( aggregations & MAXIMUM )
+    set( maximums, whichChild, newValue, maxValue );
+  if ( aggregations & MINIMUM )
+    set( minimums, whichChild, newValue, minValue );
+
+  if ( aggregations & ( MINIMUM | COUNT ) )
+  {
+    removeCount( oldValue, whichChild );
+    addCount( newValue, whichChild );
+  }
+}
+
+
+PRV_UINT32 ChildrenAggregation::size() const
+{
+  return numChildren;
+}
+
+
+bool ChildrenAggregation::getSum( TSemanticValue& onSum ) const
+{
+  if ( inexactValues > 0 )
+    return false;
+
+  onSum = sum;
+  return true;
+}
+
+
+TSemanticValue ChildrenAggregation::getMaximum() const
+{
+  return numChildren == 0 ? 0 : maximums[ 1 ];
+}
+
+
+TSemanticValue ChildrenAggregation::getMinimum( PRV_UINT32 fromChild ) const
+{
+  TSemanticValue tmp = std::numeric_limits<TSemanticValue>::max();
+
+  for ( PRV_UINT32 l = fromChild + numChildren, r = 2 * numChildren; l < r; l >>= 1, r >>= 1 )
+  {
+    if ( l & 1 )
+      tmp = minValue( tmp, minimums[ l++ ] );
+    if ( r & 1 )
+      tmp = minValue( tmp, minimums[ --r ] );
+  }
+
+  return tmp;
+}
+
+
+PRV_UINT32 ChildrenAggregation::getNegatives() const
+{
+  return negatives;
+}
+
+
+bool ChildrenAggregation::getLastZero( PRV_UINT32& whichChild ) const
+{
+  if ( zeros.empty() )
+    return false;
+
+  whichChild = *zeros.rbegin();
+  return true;
+}
+
+
+PRV_UINT32 ChildrenAggregation::countValue( TSemanticValue whichValue ) const
+{
+  std::unordered_map<TSemanticValue, PRV_UINT32>::const_iterator it = valueCount.find( whichValue );
+  if ( it == valueCount.end() )
+    return 0;
+  return it->second;
+}
+
+
+void ChildrenAggregation::build( std::vector<TSemanticValue>& onTree, const std::vector<TSemanticValue>& whichValues,
+                                 TSemanticValue (*combine)( TSemanticValue, TSemanticValue ) )
+{
+  onTree.resize( 2 * numChildren );
+  std::copy( whichValues.begin(), whichValues.end(), onTree.begin() + numChildren );
+  for ( PRV_UINT32 i = numChildren; i-- > 1; )
+    onTree[ i ] = combine( onTree[ 2 * i ], onTree[ 2 * i + 1 ] );
+}
+
+
+void ChildrenAggregation::set( std::vector<TSemanticValue>& onTree, PRV_UINT32 whichChild, TSemanticValue whichValue,
+                               TSemanticValue (*combine)( TSemanticValue, TSemanticValue ) )
+{
+  PRV_UINT32 i = whichChild + numChildren;
+  onTree[ i ] = whichValue;
+  for ( i >>= 1; i > 0; i >>= 1 )
+    onTree[ i ] = combine( onTree[ 2 * i ], onTree[ 2 * i + 1 ] );
+}
+
+
+bool ChildrenAggregation::isExact( TSemanticValue whichValue ) const
+{
+  return whichValue == std::trunc( whichValue ) && std::fabs( whichValue ) <= maxExactValue;
+}
+
+
+void ChildrenAggregation::addSum( TSemanticValue whichValue )
+{
+  if ( isExact( whichValue ) )
+    sum += whichValue;
+  else
+    ++inexactValues;
+}
+
+
+void ChildrenAggregation::removeSum( TSemanticValue whichValue )
+{
+  if ( isExact( whichValue ) )
+    sum -= whichValue;
+  else
+    --inexactValues;
+}
+
+
+void ChildrenAggregation::addCount( TSemanticValue whichValue, PRV_UINT32 whichChild )
+{
+  if ( aggregations & MINIMUM )
+  {
+    if ( whichValue == 0 )
+      zeros.insert( whichChild );
+    else if ( whichValue < 0 )
+      ++negatives;
+  }
+
+  // NaN would never be found again to be removed
+  if ( ( aggregations & COUNT ) && whichValue == whichValue )
+    ++valueCount[ whichValue ];
+}
+
+
+void ChildrenAggregation::removeCount( TSemanticValue whichValue, PRV_UINT32 whichChild )
+{
+  if ( aggregations & MINIMUM )
+  {
+    if ( whichValue == 0 )
+      zeros.erase( whichChild );
+    else if ( whichValue < 0 )
+      --negatives;
+  }
+
+  if ( ( aggregations & COUNT ) && whichValue == whichValue )
+  {
+    std::unordered_map<TSemanticValue, PRV_UINT32>::iterator it = valueCount.find( whichValue );
+    if ( --it->second == 0 )
+      valueCount.erase( it );
+  }
+}
@@ -0,0 +1,185 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                               libparaver-api                              *
+ *                       Paraver Main Computing Library                      *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+
+
+
+#include <algorithm>
+#include <limits>
+
+#include "filteredeventindex.h"
+#include "kwindow.h"
+
+
+FilteredEventIndex::FilteredEventIndex( const std::string& whichSignature, TThreadOrder numThreads ) :
+    signature( whichSignature ), threadChunks( numThreads ), threadMutex( numThreads )
+{}
+
+
+FilteredEventIndex::~FilteredEventIndex()
+{
+  for ( auto& itThread : threadChunks )
+  {
+    for ( auto& itChunk : itThread )
+      delete itChunk.second.endRecord;
+  }
+}
+
+
+const std::string& FilteredEventIndex::getSignature() const
+{
+  return signature;
+}
+
+
+bool FilteredEventIndex::getNextEvent( KSingleWindow *whichWindow,
+                                       TThreadOrder whichThread,
+                                       MemoryTrace::iterator *it,
+                                       TEventEntry& onEvent )
+{
+  // Nearby events are found walking the trace. The walk always ends at the
+  // first record of its time, where a chunk can begin.
+  MemoryTrace::iterator *nextRecord = it->clone();
+  TRecordTime lastTime = it->getTime();
+  size_t numRecords = 0;
+  for ( ++( *nextRecord );
+        !nextRecord->isNull() && ( numRecords < SCAN_RECORDS || nextRecord->getTime() == lastTime );
+        ++( *nextRecord ) )
+  {
+    if ( isFilteredEvent( whichWindow, nextRecord ) )
+    {
+      onEvent = { nextRecord->getTime(), nextRecord->getEventType(), nextRecord->getEventValue() };
+      delete nextRecord;
+      return true;
+    }
+    lastTime = nextRecord->getTime();
+    ++numRecords;
+  }
+
+  if ( nextRecord->isNull() )
+  {
+    delete nextRecord;
+    return false;
+  }
+
+  TRecordTime fromTime = nextRecord->getTime();
+
+  std::lock_guard<std::mutex> lock( threadMutex[ whichThread ] );
+  TThreadChunks& chunks = threadChunks[ whichThread ];
+
+  TThreadChunks::iterator itChunk = findChunk( chunks, fromTime );
+  if ( itChunk == chunks.end() )
+    itChunk = indexChunk( whichWindow, chunks, nextRecord );
+  else
+    delete nextRecord;
+
+  auto compareTime = []( const TEventEntry& entry, TRecordTime time ) { return entry.time < time; };
+  while ( true )
+  {
+    const std::vector<TEventEntry>& events = itChunk->second.events;
+    std::vector<TEventEntry>::const_iterator itEvent =
+            std::lower_bound( events.begin(), events.end(), fromTime, compareTime );
+    if ( itEvent != events.end() )
+    {
+      onEvent = *itEvent;
+      return true;
+    }
+
+    TChunk& tmpChunk = itChunk->second;
+    if ( tmpChunk.endTime == std::numeric_limits<TRecordTime>::infinity() )
+      return false;
+
+    TThreadChunks::iterator itNext = std::next( itChunk );
+    if ( itNext != chunks.end() && itNext->first == tmpChunk.endTime )
+      itChunk = itNext;
+    else
+    {
+      MemoryTrace::iterator *tmpRecord = tmpChunk.endRecord;
+      tmpChunk.endRecord = nullptr;
+      itChunk = indexChunk( whichWindow, chunks, tmpRecord );
+    }
+  }
+}
+
+
+bool FilteredEventIndex::isFilteredEvent( KSingleWindow *whichWindow, MemoryTrace::iterator *it )
+{
+  return it->getRecordType() & EVENT && whichWindow->passFilter( it );
+}
+
+
+FilteredEventIndex::TThreadChunks::iterator FilteredEventIndex::findChunk( TThreadChunks& whichChunks,
+                                                                           TRecordTime whichTime )
+{
+  TThreadChunks::iterator itChunk = whichChunks.upper_bound( whichTime );
+  if ( itChunk == whichChunks.begin() )
+    return whichChunks.end();
+
+  --itChunk;
+  if ( whichTime < itChunk->second.endTime )
+    return itChunk;
+
+  return whichChunks.end();
+}
+
+
+// firstRecord must be the first record of its time and out of every chunk.
+// It is owned by the new chunk, which ends at a time change after
+// CHUNK_RECORDS records, at the next chunk or at the end of the thread.
+FilteredEventIndex::TThreadChunks::iterator FilteredEventIndex::indexChunk( KSingleWindow *whichWindow,
+                                                                            TThreadChunks& whichChunks,
+                                                                            MemoryTrace::iterator *firstRecord )
+{
+  TRecordTime beginTime = firstRecord->getTime();
+  TThreadChunks::iterator itNext = whichChunks.upper_bound( beginTime );
+  TRecordTime limitTime = itNext == whichChunks.end() ? std::numeric_limits<TRecordTime>::infinity() : itNext->first;
+
+  TChunk tmpChunk;
+  TRecordTime lastTime = beginTime;
+  size_t numRecords = 0;
+  while ( !firstRecord->isNull() && firstRecord->getTime() < limitTime &&
+          ( numRecords < CHUNK_RECORDS || firstRecord->getTime() == lastTime ) )
+  {
+    if ( isFilteredEvent( whichWindow, firstRecord ) )
+      tmpChunk.events.push_back( { firstRecord->getTime(), firstRecord->getEventType(), firstRecord->getEventValue() } );
+    lastTime = firstRecord->getTime();
+    ++numRecords;
+    ++( *firstRecord );
+  }
+  tmpChunk.events.shrink_to_fit();
+
+  if ( firstRecord->isNull() )
+    tmpChunk.endTime = std::numeric_limits<TRecordTime>::infinity();
+  else
+    tmpChunk.endTime = firstRecord->getTime();
+
+  if ( firstRecord->isNull() || tmpChunk.endTime == limitTime )
+  {
+    delete firstRecord;
+    tmpChunk.endRecord = nullptr;
+  }
+  else
+    tmpChunk.endRecord = firstRecord;
+
+  return whichChunks.emplace( beginTime, std::move( tmpChunk ) ).first;
+}
@@ -0,0 +1,535 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                               libparaver-api                              *
+ *                       Paraver Main Computing Library                      *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <sys/stat.h>
+
+#include "gzipindex.h"
+#include "paraverconfig.h"
+
+using std::string;
+using std::vector;
+
+constexpr char GzipIndex::MAGIC[ 8 ];
+
+
+std::mutex GzipIndex::registryMutex;
+std::map< string, std::weak_ptr<GzipIndex> > GzipIndex::registry;
+
+
+std::shared_ptr<GzipIndex> GzipIndex::getIndex( const string& whichFile )
+{
+  std::lock_guard<std::mutex> lock( registryMutex );
+
+  std::shared_ptr<GzipIndex> tmpIndex = registry[ whichFile ].lock();
+  if ( tmpIndex == nullptr || !tmpIndex->sameFileStamp() )
+  {
+    tmpIndex = std::make_shared<GzipIndex>( whichFile );
+    registry[ whichFile ] = tmpIndex;
+  }
+
+  return tmpIndex;
+}
+
+
+bool GzipIndex::getKnownUncompressedSize( const string& whichFile, TTraceSize& onSize )
+{
+  {
+    std::lock_guard<std::mutex> lock( registryMutex );
+
+    auto it = registry.find( whichFile );
+    std::shared_ptr<GzipIndex> tmpIndex;
+    if ( it != registry.end() )
+      tmpIndex = it->second.lock();
+    if ( tmpIndex != nullptr && tmpIndex->sameFileStamp() && tmpIndex->isComplete() )
+    {
+      onSize = tmpIndex->getUncompressedSize();
+      return true;
+    }
+  }
+
+  if ( !ParaverConfig::getInstance()->getGlobalTraceBinaryCache() )
+    return false;
+
+  // Only the header of the saved index is read
+  struct stat fileStat;
+  if ( stat( whichFile.c_str(), &fileStat ) != 0 )
+    return false;
+
+  std::ifstream indexFile( getIndexFileName( whichFile ).c_str(), std::ios::binary );
+  PRV_UINT64 numPoints;
+
+  return readHeader( indexFile, fileStat.st_size, fileStat.st_mtime, onSize, numPoints );
+}
+
+
+GzipIndex::GzipIndex( const string& whichFile )
+  : fileName( whichFile )
+{
+  if ( readFileStamp() && ParaverConfig::getInstance()->getGlobalTraceBinaryCache() )
+    load();
+}
+
+
+const string& GzipIndex::getFileName() const
+{
+  return fileName;
+}
+
+
+bool GzipIndex::isComplete() const
+{
+  std::lock_guard<std::mutex> lock( indexMutex );
+  return complete;
+}
+
+
+TTraceSize GzipIndex::getUncompressedSize() const
+{
+  std::lock_guard<std::mutex> lock( indexMutex );
+  return uncompressedSize;
+}
+
+
+const GzipIndex::TAccessPoint *GzipIndex::findPoint( TTraceSize offset ) const
+{
+  std::lock_guard<std::mutex> lock( indexMutex );
+
+  auto it = std::upper_bound( points.begin(), points.end(), offset,
+                              []( TTraceSize value, const TAccessPoint& point )
+                              { return value < point.uncompressedOffset; } );
+  if ( it == points.begin() )
+    return nullptr;
+
+  return &( *( --it ) );
+}
+
+
+bool GzipIndex::needsPoint( TTraceSize offset ) const
+{
+  std::lock_guard<std::mutex> lock( indexMutex );
+  return !complete && offset >= ( points.empty() ? 0 : points.back().uncompressedOffset ) + SPAN;
+}
+
+
+void GzipIndex::getRanges( TTraceSize offset,
+                           size_t maxRanges,
+                           vector< std::pair< TTraceSize, TTraceSize > >& ranges ) const
+{
+  std::lock_guard<std::mutex> lock( indexMutex );
+
+  ranges.clear();
+  auto it = std::upper_bound( points.begin(), points.end(), offset,
+                              []( TTraceSize value, const TAccessPoint& point )
+                              { return value < point.uncompressedOffset; } );
+  while ( offset < uncompressedSize && ranges.size() < maxRanges )
+  {
+    TTraceSize rangeEnd = ( it == points.end() ? uncompressedSize : it->uncompressedOffset );
+    ranges.emplace_back( offset, rangeEnd );
+    offset = rangeEnd;
+    if ( it != points.end() )
+      ++it;
+  }
+}
+
+
+void GzipIndex::addPoint( TAccessPoint&& whichPoint )
+{
+  std::lock_guard<std::mutex> lock( indexMutex );
+
+  // Other decoder could have added it meanwhile
+  if ( complete ||
+       whichPoint.uncompressedOffset < ( points.empty() ? 0 : points.back().uncompressedOffset ) + SPAN )
+    return;
+
+  points.push_back( std::move( whichPoint ) );
+}
+
+
+void GzipIndex::setComplete( TTraceSize whichUncompressedSize )
+{
+  {
+    std::lock_guard<std::mutex> lock( indexMutex );
+    if ( complete )
+      return;
+    complete = true;
+    uncompressedSize = whichUncompressedSize;
+  }
+
+  if ( ParaverConfig::getInstance()->getGlobalTraceBinaryCache() )
+    save();
+}
+
+
+bool GzipIndex::readFileStamp()
+{
+  struct stat fileStat;
+  if ( stat( fileName.c_str(), &fileStat ) != 0 )
+    return false;
+
+  fileSize = fileStat.st_size;
+  fileTime = fileStat.st_mtime;
+  return true;
+}
+
+
+bool GzipIndex::sameFileStamp() const
+{
+  struct stat fileStat;
+  if ( stat( fileName.c_str(), &fileStat ) != 0 )
+    return false;
+
+  return fileSize == TTraceSize( fileStat.st_size ) && fileTime == PRV_INT64( fileStat.st_mtime );
+}
+
+
+string GzipIndex::getIndexFileName( const string& whichFile )
+{
+  return whichFile + ".gzi";
+}
+
+
+bool GzipIndex::readHeader( std::ifstream& indexFile, TTraceSize whichFileSize, PRV_INT64 whichFileTime,
+                            TTraceSize& onUncompressedSize, PRV_UINT64& onNumPoints )
+{
+  if ( !indexFile.good() )
+    return false;
+
+  char tmpMagic[ 8 ];
+  PRV_UINT32 tmpVersion;
+  TTraceSize tmpFileSize;
+  PRV_INT64 tmpFileTime;
+
+  indexFile.read( tmpMagic, sizeof( tmpMagic ) );
+  indexFile.read( reinterpret_cast<char *>( &tmpVersion ), sizeof( tmpVersion ) );
+  indexFile.read( reinterpret_cast<char *>( &tmpFileSize ), sizeof( tmpFileSize ) );
+  indexFile.read( reinterpret_cast<char *>( &tmpFileTime ), sizeof( tmpFileTime ) );
+  indexFile.read( reinterpret_cast<char *>( &onUncompressedSize ), sizeof( onUncompressedSize ) );
+  indexFile.read( reinterpret_cast<char *>( &onNumPoints ), sizeof( onNumPoints ) );
+
+  return indexFile.good() &&
+         memcmp( tmpMagic, MAGIC, sizeof( MAGIC ) ) == 0 &&
+         tmpVersion == FORMAT_VERSION &&
+         tmpFileSize == whichFileSize &&
+         tmpFileTime == whichFileTime &&
+         onNumPoints <= whichFileSize;
+}
+
+
+bool GzipIndex::load()
+{
+  std::ifstream indexFile( getIndexFileName( fileName ).c_str(), std::ios::binary );
+  TTraceSize tmpUncompressedSize;
+  PRV_UINT64 numPoints;
+
+  if ( !readHeader( indexFile, fileSize, fileTime, tmpUncompressedSize, numPoints ) )
+    return false;
+
+  std::deque<TAccessPoint> tmpPoints( numPoints );
+  for ( auto& point : tmpPoints )
+  {
+    PRV_INT32 tmpBits;
+    indexFile.read( reinterpret_cast<char *>( &point.uncompressedOffset ), sizeof( point.uncompressedOffset ) );
+    indexFile.read( reinterpret_cast<char *>( &point.compressedOffset ), sizeof( point.compressedOffset ) );
+    indexFile.read( reinterpret_cast<char *>( &tmpBits ), sizeof( tmpBits ) );
+    point.bits = tmpBits;
+    point.window.resize( WINDOW_SIZE );
+    indexFile.read( reinterpret_cast<char *>( point.window.data() ), WINDOW_SIZE );
+
+    if ( !indexFile.good() || point.bits < 0 || point.bits > 7 || point.compressedOffset > fileSize )
+      return false;
+  }
+
+  std::lock_guard<std::mutex> lock( indexMutex );
+  points.swap( tmpPoints );
+  uncompressedSize = tmpUncompressedSize;
+  complete = true;
+
+  return true;
+}
+
+
+void GzipIndex::save() const
+{
+  string indexFileName = getIndexFileName( fileName );
+  string tmpFileName = indexFileName + ".tmp";
+
+  std::ofstream indexFile( tmpFileName.c_str(), std::ios::binary | std::ios::trunc );
+  if ( !indexFile.good() )
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock( indexMutex );
+
+    PRV_UINT64 numPoints = points.size();
+    indexFile.write( MAGIC, sizeof( MAGIC ) );
+    indexFile.write( reinterpret_cast<const char *>( &FORMAT_VERSION ), sizeof( FORMAT_VERSION ) );
+    indexFile.write( reinterpret_cast<const char *>( &fileSize ), sizeof( fileSize ) );
+    indexFile.write( reinterpret_cast<const char *>( &fileTime ), sizeof( fileTime ) );
+    indexFile.write( reinterpret_cast<const char *>( &uncompressedSize ), sizeof( uncompressedSize ) );
+    indexFile.write( reinterpret_cast<const char *>( &numPoints ), sizeof( numPoints ) );
+
+    for ( const auto& point : points )
+    {
+      PRV_INT32 tmpBits = point.bits;
+      indexFile.write( reinterpret_cast<const char *>( &point.uncompressedOffset ), sizeof( point.uncompressedOffset ) );
+      indexFile.write( reinterpret_cast<const char *>( &point.compressedOffset ), sizeof( point.compressedOffset ) );
+      indexFile.write( reinterpret_cast<const char *>( &tmpBits ), sizeof( tmpBits ) );
+      indexFile.write( reinterpret_cast<const char *>( point.window.data() ), WINDOW_SIZE );
+    }
+  }
+
+  indexFile.close();
+
+  if ( indexFile.fail() || rename( tmpFileName.c_str(), indexFileName.c_str() ) != 0 )
+    remove( tmpFileName.c_str() );
+}
+
+
+
+GzipDecoder::GzipDecoder( std::shared_ptr<GzipIndex> whichIndex )
+  : index( whichIndex ),
+    file( whichIndex->getFileName().c_str(), std::ios::binary ),
+    input( INPUT_SIZE ),
+    window( GzipIndex::WINDOW_SIZE )
+{
+  memset( &strm, 0, sizeof( strm ) );
+  endOfData = !file.good();
+}
+
+
+GzipDecoder::~GzipDecoder()
+{
+  if ( strmInitialized )
+    inflateEnd( &strm );
+}
+
+
+TTraceSize GzipDecoder::seek( TTraceSize offset )
+{
+  if ( strmInitialized )
+    inflateEnd( &strm );
+  memset( &strm, 0, sizeof( strm ) );
+  strmInitialized = false;
+
+  file.clear();
+  if ( !file.is_open() )
+  {
+    endOfData = true;
+    return 0;
+  }
+  endOfData = false;
+
+  const GzipIndex::TAccessPoint *point = index->findPoint( offset );
+  if ( point == nullptr )
+  {
+    // Automatic gzip or zlib header detection
+    if ( inflateInit2( &strm, 47 ) != Z_OK )
+    {
+      endOfData = true;
+      return 0;
+    }
+    rawMode = false;
+    inputOffset = 0;
+    outputOffset = 0;
+    file.seekg( 0 );
+  }
+  else
+  {
+    if ( inflateInit2( &strm, -15 ) != Z_OK )
+    {
+      endOfData = true;
+      return 0;
+    }
+    rawMode = true;
+    inputOffset = point->compressedOffset - ( point->bits > 0 ? 1 : 0 );
+    outputOffset = point->uncompressedOffset;
+    file.seekg( inputOffset );
+
+    if ( point->bits > 0 )
+    {
+      int c = file.get();
+      if ( c == EOF )
+        endOfData = true;
+      else
+        inflatePrime( &strm, point->bits, c >> ( 8 - point->bits ) );
+      ++inputOffset;
+    }
+    inflateSetDictionary( &strm, point->window.data(), GzipIndex::WINDOW_SIZE );
+    std::copy( point->window.begin(), point->window.end(), window.begin() );
+  }
+  strmInitialized = true;
+  strm.next_out = window.data();
+  strm.avail_out = 0;
+
+  char discarded[ GzipIndex::WINDOW_SIZE ];
+  while ( outputOffset < offset )
+  {
+    if ( read( discarded, std::min<TTraceSize>( offset - outputOffset, GzipIndex::WINDOW_SIZE ) ) == 0 )
+      break;
+  }
+
+  return outputOffset;
+}
+
+
+size_t GzipDecoder::read( vector<char>& out, size_t maxBytes )
+{
+  size_t previousSize = out.size();
+  out.resize( previousSize + maxBytes );
+  size_t totalRead = read( out.data() + previousSize, maxBytes );
+  out.resize( previousSize + totalRead );
+
+  return totalRead;
+}
+
+
+size_t GzipDecoder::read( char *out, size_t maxBytes )
+{
+  size_t totalRead = 0;
+
+  while ( totalRead < maxBytes && !endOfData && strmInitialized )
+  {
+    if ( strm.avail_in == 0 && !fillInput() )
+    {
+      // Truncated file
+      endOfData = true;
+      break;
+    }
+
+    // window is a circular buffer holding the last decompressed bytes
+    size_t windowLeft = window.data() + GzipIndex::WINDOW_SIZE - strm.next_out;
+    if ( windowLeft == 0 )
+    {
+      strm.next_out = window.data();
+      windowLeft = GzipIndex::WINDOW_SIZE;
+    }
+    strm.avail_out = std::min( windowLeft, maxBytes - totalRead );
+
+    unsigned char *outBegin = strm.next_out;
+    int ret = inflate( &strm, Z_BLOCK );
+    size_t produced = strm.next_out - outBegin;
+    memcpy( out + totalRead, outBegin, produced );
+    outputOffset += produced;
+    totalRead += produced;
+
+    if ( ret == Z_STREAM_END )
+    {
+      if ( !nextMember() )
+      {
+        endOfData = true;
+        index->setComplete( outputOffset );
+      }
+    }
+    else if ( ret == Z_BUF_ERROR && ( strm.avail_in == 0 || strm.avail_out == 0 ) )
+      continue;
+    else if ( ret != Z_OK )
+      endOfData = true;
+    else if ( ( strm.data_type & 128 ) && !( strm.data_type & 64 ) && index->needsPoint( outputOffset ) )
+      recordPoint();
+  }
+
+  return totalRead;
+}
+
+
+TTraceSize GzipDecoder::tell() const
+{
+  return outputOffset;
+}
+
+
+bool GzipDecoder::fillInput()
+{
+  file.read( reinterpret_cast<char *>( input.data() ), INPUT_SIZE );
+  std::streamsize bytesRead = file.gcount();
+  if ( bytesRead <= 0 )
+    return false;
+
+  strm.next_in = input.data();
+  strm.avail_in = bytesRead;
+  inputOffset += bytesRead;
+
+  return true;
+}
+
+
+bool GzipDecoder::skipInput( size_t bytes )
+{
+  while ( bytes > 0 )
+  {
+    if ( strm.avail_in == 0 && !fillInput() )
+      return false;
+
+    size_t skipped = std::min<size_t>( bytes, strm.avail_in );
+    strm.next_in += skipped;
+    strm.avail_in -= skipped;
+    bytes -= skipped;
+  }
+
+  return true;
+}
+
+
+bool GzipDecoder::nextMember()
+{
+  // Raw inflate leaves the gzip trailer unread
+  if ( rawMode && !skipInput( 8 ) )
+    return false;
+
+  if ( strm.avail_in == 0 && !fillInput() )
+    return false;
+
+  // Anything but another gzip member is ignored
+  if ( strm.next_in[ 0 ] != 0x1f )
+    return false;
+
+  if ( rawMode )
+    inflateReset2( &strm, 31 );
+  else
+    inflateReset( &strm );
+  rawMode = false;
+
+  return true;
+}
+
+
+void GzipDecoder::recordPoint()
+{
+  GzipIndex::TAccessPoint point;
+  point.uncompressedOffset = outputOffset;
+  point.compressedOffset = inputOffset - strm.avail_in;
+  point.bits = strm.data_type & 7;
+
+  // Unroll the circular window, oldest bytes first
+  size_t windowLeft = window.data() + GzipIndex::WINDOW_SIZE - strm.next_out;
+  point.window.reserve( GzipIndex::WINDOW_SIZE );
+  point.window.insert( point.window.end(), strm.next_out, window.data() + GzipIndex::WINDOW_SIZE );
+  point.window.insert( point.window.end(), window.begin(), window.begin() + ( GzipIndex::WINDOW_SIZE - windowLeft ) );
+
+  index->addPoint( std::move( point ) );
+}
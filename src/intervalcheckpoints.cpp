@@ -0,0 +1,94 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                               libparaver-api                              *
+ *                       Paraver Main Computing Library                      *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+
+#include <algorithm>
+
+#include "intervalcheckpoints.h"
+#include "interval.h"
+#include "semanticfunction.h"
+
+
+IntervalCheckpoints::IntervalCheckpoints() : stepSize( STEP ), stepsToNext( STEP )
+{}
+
+
+bool IntervalCheckpoints::restore( const std::string& whichSignature,
+                                   TRecordTime whichTime,
+                                   Interval *whichInterval,
+                                   SemanticFunction *whichFunction )
+{
+  if ( whichSignature != signature )
+  {
+    checkpoints.clear();
+    signature = whichSignature;
+    stepSize = STEP;
+  }
+  stepsToNext = stepSize;
+
+  // The replay goes on while the end is <= whichTime, so every checkpoint
+  // ending there would have been reached
+  auto it = std::upper_bound( checkpoints.begin(), checkpoints.end(), whichTime,
+                              []( TRecordTime time, const TCheckpoint& el ) { return time < el.endTime; } );
+  if ( it == checkpoints.begin() )
+    return false;
+  --it;
+
+  if ( it->endTime <= whichInterval->getEndTime() )
+    return false;
+
+  std::vector<TIntervalState>::const_iterator itState = it->intervals.cbegin();
+  whichInterval->restoreState( itState );
+  whichFunction->setRowState( whichInterval->getOrder(), it->functionState );
+
+  return true;
+}
+
+
+void IntervalCheckpoints::step( Interval *whichInterval, SemanticFunction *whichFunction )
+{
+  if ( --stepsToNext > 0 )
+    return;
+  stepsToNext = stepSize;
+
+  TRecordTime endTime = whichInterval->getEndTime();
+  if ( !checkpoints.empty() && endTime <= checkpoints.back().endTime )
+    return;
+
+  TCheckpoint tmpCheckpoint;
+  tmpCheckpoint.endTime = endTime;
+  if ( !whichFunction->getRowState( whichInterval->getOrder(), tmpCheckpoint.functionState ) )
+    return;
+  whichInterval->saveState( tmpCheckpoint.intervals );
+  checkpoints.push_back( std::move( tmpCheckpoint ) );
+
+  if ( checkpoints.size() >= MAX_CHECKPOINTS )
+  {
+    // Keep every other one
+    size_t iDest = 0;
+    for ( size_t iSrc = 1; iSrc < checkpoints.size(); iSrc += 2 )
+      checkpoints[ iDest++ ] = std::move( checkpoints[ iSrc ] );
+    checkpoints.resize( iDest );
+    stepSize *= 2;
+  }
+}
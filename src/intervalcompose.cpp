@@ -108,14 +108,57 @@ KRecordList *IntervalCompose::init( TRecordTime initialTime, TCreateList create,
   
   if ( function->getInitFromBegin() )
   {
+    bool withCheckpoints = useCheckpoints( create );
+    if ( withCheckpoints )
+      checkpoints.restore( ( ( KSingleWindow * ) window )->getCheckpointSignature(), initialTime, this, function );
+
     while ( end->getTime() <= initialTime )
+    {
       calcNext( displayList );
+      if ( withCheckpoints )
+        checkpoints.step( this, function );
+    }
   }
 
   return displayList;
 }
 
 
+// Records listed before initialTime would be lost when resuming from a
+// checkpoint, so only plain computations are checkpointed
+bool IntervalCompose::useCheckpoints( TCreateList create )
+{
+  return create == NOCREATE &&
+         !notWindowInits &&
+         !IsDerivedWindow() &&
+         behaviour == TBehaviour::REGULAR &&
+         getWindowTrace()->recordsInMemory() &&
+         childIntervals[ 0 ]->hasPlainState();
+}
+
+
+bool IntervalCompose::hasPlainState()
+{
+  return behaviour == TBehaviour::REGULAR &&
+         !function->getInitFromBegin() &&
+         childIntervals[ 0 ]->hasPlainState();
+}
+
+
+void IntervalCompose::saveState( std::vector<IntervalCheckpoints::TIntervalState>& onVector ) const
+{
+  Interval::saveState( onVector );
+  childIntervals[ 0 ]->saveState( onVector );
+}
+
+
+void IntervalCompose::restoreState( std::vector<IntervalCheckpoints::TIntervalState>::const_iterator& whichState )
+{
+  Interval::restoreState( whichState );
+  childIntervals[ 0 ]->restoreState( whichState );
+}
+
+
 KRecordList *IntervalCompose::calcNext( KRecordList *displayList, bool initCalc )
 {
   if ( displayList == nullptr )
@@ -22,12 +22,11 @@
 \*****************************************************************************/
 
 
+#include <limits>
+
 #include "kwindow.h"
 #include "intervalnotthread.h"
 
-using std::multimap;
-using std::pair;
-
 KRecordList *IntervalNotThread::init( TRecordTime initialTime, TCreateList create,
                                       KRecordList *displayList )
 {
@@ -35,7 +34,6 @@ KRecordList *IntervalNotThread::init( TRecordTime initialTime, TCreateList creat
   info.values.clear();
   info.callingInterval = this;
   info.lastChanged = 0;
-  orderedChildren.clear();
 
   createList = create;
   currentValue = 0.0;
@@ -64,6 +62,8 @@ KRecordList *IntervalNotThread::init( TRecordTime initialTime, TCreateList creat
 
   info.callingInterval = this;
 
+  orderedChildren.init( childIntervals.size() );
+
   for ( TObjectOrder i = 0; i < childIntervals.size(); ++i )
   {
     childIntervals[ i ]->init( myInitTime, createList, displayList );
@@ -87,9 +87,19 @@ KRecordList *IntervalNotThread::init( TRecordTime initialTime, TCreateList creat
     }
 
     info.values.push_back( childIntervals[ i ]->getValue() );
-    pair<TRecordTime,TObjectOrder> tmpChild( childIntervals[ i ]->getEnd()->getTime(), i );
-    orderedChildren.insert( tmpChild );
+    orderedChildren.set( i, childIntervals[ i ]->getEnd()->getTime() );
   }
+
+  ChildrenAggregation::TAggregations tmpAggregations = function->getAggregations();
+  useAggregation = tmpAggregations != ChildrenAggregation::NO_AGGREGATION;
+  if ( useAggregation )
+  {
+    aggregation.init( tmpAggregations, info.values );
+    info.aggregation = &aggregation;
+  }
+  else
+    info.aggregation = nullptr;
+
   currentValue = function->execute( &info );
 
   while ( end->getTime() < initialTime && begin->getTime() < window->getTrace()->getEndTime() )
@@ -107,26 +117,24 @@ KRecordList *IntervalNotThread::calcNext( KRecordList *displayList, bool initCal
   *begin = *end;
 
   TObjectOrder i = 0;
-  std::multimap<TRecordTime,TObjectOrder>::iterator itChild = orderedChildren.begin();
-  while( itChild->first == begin->getTime() )
+  TObjectOrder currentChild = orderedChildren.top();
+  while( orderedChildren.topTime() == begin->getTime() )
   {
-    if ( childIntervals[ itChild->second ]->getEnd()->getTime() <= begin->getTime() )
+    if ( childIntervals[ currentChild ]->getEnd()->getTime() <= begin->getTime() )
     {
-      childIntervals[ itChild->second ]->calcNext( displayList );
-      info.lastChanged = itChild->second;
+      childIntervals[ currentChild ]->calcNext( displayList );
+      info.lastChanged = currentChild;
     }
 
-    info.values[ itChild->second ] = childIntervals[ itChild->second ]->getValue();
-    pair<TRecordTime,TObjectOrder> tmpChild( childIntervals[ itChild->second ]->getEnd()->getTime(), itChild->second );
-    orderedChildren.erase( itChild );
-    orderedChildren.insert( tmpChild );
-    itChild = orderedChildren.begin();
+    setChildValue( currentChild );
+    orderedChildren.set( currentChild, childIntervals[ currentChild ]->getEnd()->getTime() );
+    currentChild = orderedChildren.top();
 
     ++i;
     if( i >= childIntervals.size() ) break;
   }
 
-  *end = *childIntervals[ itChild->second ]->getEnd();
+  *end = *childIntervals[ currentChild ]->getEnd();
 
   currentValue = function->execute( &info );
 
@@ -142,23 +150,21 @@ KRecordList *IntervalNotThread::calcPrev( KRecordList *displayList, bool initCal
   *end = *begin;
 
   TObjectOrder i = 0;
-  std::multimap<TRecordTime,TObjectOrder>::iterator itChild = orderedChildren.begin();
-  while( itChild->first == end->getTime() )
+  TObjectOrder currentChild = orderedChildren.top();
+  while( orderedChildren.topTime() == end->getTime() )
   {
-    if ( childIntervals[ itChild->second ]->getBegin()->getTime() >= end->getTime() )
-      childIntervals[ itChild->second ]->calcPrev( displayList );
+    if ( childIntervals[ currentChild ]->getBegin()->getTime() >= end->getTime() )
+      childIntervals[ currentChild ]->calcPrev( displayList );
 
-    info.values[ itChild->second ] = childIntervals[ itChild->second ]->getValue();
-    pair<TRecordTime,TObjectOrder> tmpChild( childIntervals[ itChild->second ]->getEnd()->getTime(), itChild->second );
-    orderedChildren.erase( itChild );
-    orderedChildren.insert( tmpChild );
-    itChild = orderedChildren.begin();
+    setChildValue( currentChild );
+    orderedChildren.set( currentChild, childIntervals[ currentChild ]->getEnd()->getTime() );
+    currentChild = orderedChildren.top();
 
     ++i;
     if( i >= childIntervals.size() ) break;
   }
 
-  *begin = *childIntervals[ itChild->second ]->getBegin();
+  *begin = *childIntervals[ currentChild ]->getBegin();
 
   currentValue = function->execute( &info );
 
@@ -195,3 +201,47 @@ KTrace *IntervalNotThread::getWindowTrace() const
 {
   return (KTrace*)window->getTrace();
 }
+
+
+void IntervalNotThread::setChildValue( TObjectOrder whichChild )
+{
+  TSemanticValue tmpValue = childIntervals[ whichChild ]->getValue();
+
+  if ( useAggregation )
+    aggregation.update( whichChild, info.values[ whichChild ], tmpValue );
+  info.values[ whichChild ] = tmpValue;
+}
+
+
+void IntervalNotThread::ChildrenQueue::init( PRV_UINT32 numChildren )
+{
+  numLeaves = 1;
+  while ( numLeaves < numChildren )
+    numLeaves <<= 1;
+  lastSequence = 0;
+
+  // Index numChildren fills the empty leaves and never wins
+  times.assign( numChildren + 1, std::numeric_limits<TRecordTime>::max() );
+  sequence.assign( numChildren + 1, std::numeric_limits<PRV_UINT64>::max() );
+  winners.assign( 2 * numLeaves, numChildren );
+}
+
+
+void IntervalNotThread::ChildrenQueue::set( PRV_UINT32 whichChild, TRecordTime whichTime )
+{
+  times[ whichChild ] = whichTime;
+  sequence[ whichChild ] = lastSequence++;
+
+  PRV_UINT32 i = whichChild + numLeaves;
+  winners[ i ] = whichChild;
+  for ( i >>= 1; i > 0; i >>= 1 )
+    winners[ i ] = match( winners[ 2 * i ], winners[ 2 * i + 1 ] );
+}
+
+
+PRV_UINT32 IntervalNotThread::ChildrenQueue::match( PRV_UINT32 first, PRV_UINT32 second ) const
+{
+  if ( times[ first ] != times[ second ] )
+    return times[ first ] < times[ second ] ? first : second;
+  return sequence[ first ] < sequence[ second ] ? first : second;
+}
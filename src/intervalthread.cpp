@@ -24,6 +24,7 @@
 
 #include "kwindow.h"
 #include "intervalthread.h"
+#include "plaintypes.h"
 
 KRecordList *IntervalThread::init( TRecordTime initialTime, TCreateList create,
                                    KRecordList *displayList )
@@ -60,12 +61,35 @@ KRecordList *IntervalThread::init( TRecordTime initialTime, TCreateList create,
 
   createList = create;
   calcNext( displayList, true );
+
+  bool withCheckpoints = function->getInitFromBegin() && useCheckpoints( create );
+  if ( withCheckpoints )
+    checkpoints.restore( window->getCheckpointSignature(), initialTime, this, function );
+
   while ( ( !end->isNull() ) && ( end->getTime() <= initialTime ) )
+  {
     calcNext( displayList );
+    if ( withCheckpoints )
+      checkpoints.step( this, function );
+  }
 
   return displayList;
 }
 
+
+bool IntervalThread::hasPlainState()
+{
+  return !function->getInitFromBegin();
+}
+
+
+bool IntervalThread::useCheckpoints( TCreateList create ) const
+{
+  return create == NOCREATE &&
+         !notWindowInits &&
+         ( ( KTrace * ) window->getTrace() )->recordsInMemory();
+}
+
 MemoryTrace::iterator *IntervalThread::getTraceEnd() const
 {
   return window->getThreadEndRecord( order );
@@ -119,10 +143,35 @@ KRecordList *IntervalThread::calcPrev( KRecordList *displayList, bool initCalc )
 }
 
 
+// Steps over the records that can neither be listed nor be valid for the
+// semantic function, reading them in place instead of through the iterator.
+void IntervalThread::skipUnusedRecords( MemoryTrace::iterator *it, TRecordType validateMask ) const
+{
+  TRecordSpan records = it->getRecords();
+  const Plain::TRecord *current = records.first;
+
+  while ( current != records.last )
+  {
+    TRecordType type = current->type;
+    if ( ( ( createList & CREATEEVENTS ) && ( type & EVENT ) ) ||
+         ( ( createList & CREATECOMMS ) && ( type & COMM ) ) ||
+         SemanticThread::validRecordType( type, validateMask ) )
+      break;
+    ++current;
+  }
+
+  if ( current != records.first )
+    it->skipRecords( current - records.first );
+}
+
+
 MemoryTrace::iterator *IntervalThread::getNextRecord( MemoryTrace::iterator *it,
     KRecordList *displayList )
 {
+  TRecordType validateMask = function->getValidateMask();
+
   ++( *it );
+  skipUnusedRecords( it, validateMask );
   while ( !it->isNull() )
   {
     if ( window->passFilter( it ) )
@@ -136,6 +185,7 @@ MemoryTrace::iterator *IntervalThread::getNextRecord( MemoryTrace::iterator *it,
         break;
     }
     ++( *it );
+    skipUnusedRecords( it, validateMask );
   }
 
   if ( it->isNull() )
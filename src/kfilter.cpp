@@ -631,3 +631,25 @@ KFilter *KFilter::clone( KTimeline *clonedWindow )
 
   return clonedKFilter;
 }
+
+
+// Everything passFilter depends on, written in a comparable form
+void KFilter::getSignature( ostream& onStream ) const
+{
+  auto writeValues = [ &onStream ]( bool exists, const auto& values, FilterFunction *function )
+  {
+    onStream << exists << ' ' << function->getName() << ' ' << values.size();
+    for ( auto value : values )
+      onStream << ' ' << value;
+    onStream << ';';
+  };
+
+  onStream << logical << physical << opFromTo << opTagSize << opTypeValue << ';';
+  writeValues( existCommFrom, commFrom, functionCommFrom );
+  writeValues( existCommTo, commTo, functionCommTo );
+  writeValues( existCommTags, commTags, functionCommTags );
+  writeValues( existCommSize, commSizes, functionCommSizes );
+  writeValues( existBandWidth, bandWidth, functionBandWidth );
+  writeValues( existEventTypes, eventTypes, functionEventTypes );
+  writeValues( existEventValues, eventValues, functionEventValues );
+}
@@ -22,6 +22,8 @@
 \*****************************************************************************/
 
 
+#include <algorithm>
+#include <atomic>
 #include <math.h>
 #include <limits>
 #include "config.h"
@@ -1169,13 +1171,14 @@ void KHistogram::finishAllRows()
       for ( THistogramColumn iPlane = 0; iPlane < planeTranslator->totalColumns(); ++iPlane )
       {
         auto& rowValues = commBuffer->getRowValues( iPlane, iRow );
-        for ( auto it = rowValues.begin(); it != rowValues.end(); ++it )
+        for ( size_t iCell = 0; iCell < rowValues.size(); ++iCell )
         {
-          commValues = it->second;
-          commCube->setValue( iPlane, it->first, commValues );
+          THistogramColumn iColumn = rowValues.getColumn( iCell );
+          commValues = rowValues.getValues( iCell );
+          commCube->setValue( iPlane, iColumn, commValues );
           for ( PRV_UINT16 iStat = 0; iStat < NUM_COMM_STATS; ++iStat )
           {
-            commTotals->newValue( commValues[ iStat ], iStat, it->first, iPlane );
+            commTotals->newValue( commValues[ iStat ], iStat, iColumn, iPlane );
             rowCommTotals->newValue( commValues[ iStat ], iStat, iRow, iPlane );
           }
         }
@@ -1189,13 +1192,14 @@ void KHistogram::finishAllRows()
     for ( TObjectOrder iRow = 0; iRow < rowsTranslator->totalRows(); ++iRow )
     {
       auto& rowValues = commBuffer->getRowValues( 0, iRow );
-      for ( auto it = rowValues.begin(); it != rowValues.end(); ++it )
+      for ( size_t iCell = 0; iCell < rowValues.size(); ++iCell )
       {
-        commValues = it->second;
-        commMatrix->setValue( it->first, commValues );
+        THistogramColumn iColumn = rowValues.getColumn( iCell );
+        commValues = rowValues.getValues( iCell );
+        commMatrix->setValue( iColumn, commValues );
         for ( PRV_UINT16 iStat = 0; iStat < NUM_COMM_STATS; ++iStat )
         {
-          commTotals->newValue( commValues[ iStat ], iStat, it->first );
+          commTotals->newValue( commValues[ iStat ], iStat, iColumn );
           rowCommTotals->newValue( commValues[ iStat ], iStat, iRow );
         }
       }
@@ -1214,17 +1218,16 @@ void KHistogram::finishAllRows()
             ++iPlane )
       {
         auto& rowValues = semanticBuffer->getRowValues( iPlane, iRow );
-        auto& rowNotZeroValues = semanticBuffer->getNotZeroValue( iPlane, iRow );
-        auto itZero = rowNotZeroValues.begin();
 
-        for ( auto it = rowValues.begin(); it != rowValues.end(); ++it, ++itZero )
+        for ( size_t iCell = 0; iCell < rowValues.size(); ++iCell )
         {
-          semanticValues = it->second;
-          cube->setValue( iPlane, it->first, semanticValues, itZero->second );
+          THistogramColumn iColumn = rowValues.getColumn( iCell );
+          semanticValues = rowValues.getValues( iCell );
+          cube->setValue( iPlane, iColumn, semanticValues, rowValues.getNotZeroValue( iCell ) );
 
           for ( PRV_UINT16 iStat = 0; iStat < NUM_SEMANTIC_STATS; ++iStat )
           {
-            totals->newValue( semanticValues[ iStat ], iStat, it->first, iPlane );
+            totals->newValue( semanticValues[ iStat ], iStat, iColumn, iPlane );
             rowTotals->newValue( semanticValues[ iStat ], iStat, iRow, iPlane );
           }
         }
@@ -1238,17 +1241,16 @@ void KHistogram::finishAllRows()
     for ( TObjectOrder iRow = 0; iRow < rowsTranslator->totalRows(); ++iRow )
     {
       auto& rowValues = semanticBuffer->getRowValues( 0, iRow );
-      auto& rowNotZeroValues = semanticBuffer->getNotZeroValue( 0, iRow );
-      auto itZero = rowNotZeroValues.begin();
 
-      for ( auto it = rowValues.begin(); it != rowValues.end(); ++it, ++itZero )
+      for ( size_t iCell = 0; iCell < rowValues.size(); ++iCell )
       {
-        semanticValues = it->second;
-        matrix->setValue( it->first, semanticValues, itZero->second );
+        THistogramColumn iColumn = rowValues.getColumn( iCell );
+        semanticValues = rowValues.getValues( iCell );
+        matrix->setValue( iColumn, semanticValues, rowValues.getNotZeroValue( iCell ) );
 
         for ( PRV_UINT16 iStat = 0; iStat < NUM_SEMANTIC_STATS; ++iStat )
         {
-          totals->newValue( semanticValues[ iStat ], iStat, it->first, iPlane );
+          totals->newValue( semanticValues[ iStat ], iStat, iColumn, iPlane );
           rowTotals->newValue( semanticValues[ iStat ], iStat, iRow, iPlane );
         }
       }
@@ -1265,7 +1267,7 @@ void KHistogram::finishAllRows()
 void KHistogram::finishOutLimits()
 {
   controlOutOfLimits = false;
-  for( vector<bool>::iterator it = tmpControlOutOfLimits.begin();
+  for( vector<char>::iterator it = tmpControlOutOfLimits.begin();
        it != tmpControlOutOfLimits.end(); ++it )
   {
     if ( *it )
@@ -1279,7 +1281,7 @@ void KHistogram::finishOutLimits()
   if ( getThreeDimensions() )
   {
     xtraOutOfLimits = false;
-    for( vector<bool>::iterator it = tmpXtraOutOfLimits.begin();
+    for( vector<char>::iterator it = tmpXtraOutOfLimits.begin();
          it != tmpXtraOutOfLimits.end(); ++it )
     {
       if ( *it )
@@ -1298,7 +1300,8 @@ void KHistogram::parallelExecution( TRecordTime fromTime, TRecordTime toTime,
                                     std::vector<TObjectOrder>& selectedRows,
                                     ProgressController *progress )
 {
-  int currentRow = 0;
+  std::atomic<int> currentRow( 0 );
+  int lastReportedRow = 0;
   int progressDelta;
   if( progress != nullptr )
     progressDelta = (int)floor( selectedRows.size() * 0.005 );
@@ -1306,27 +1309,29 @@ void KHistogram::parallelExecution( TRecordTime fromTime, TRecordTime toTime,
   #pragma omp parallel
   {
     #pragma omp single
+    windowCloneManager.update( this );
+
+    // Rows only touch their own buffers, so they need no synchronization.
+    // Small dynamic chunks balance rows of very different cost.
+    TObjectOrder chunkSize = std::max( (TObjectOrder)1, (TObjectOrder)( ( toRow - fromRow + 1 ) / ( 16 * omp_get_num_threads() ) ) );
+
+    #pragma omp for schedule( dynamic, chunkSize )
+    for ( TObjectOrder i = fromRow; i <= toRow; ++i )
     {
-      windowCloneManager.update( this );
+      if( progress == nullptr ||
+          ( progress != nullptr && !progress->getStop() ) )
+        executionTask( fromTime, toTime, i, i, selectedRows, progress );
 
-      for ( TObjectOrder i = fromRow; i <= toRow; ++i )
+      if( progress != nullptr && numRows > 1 && !progress->getStop() )
       {
-        #pragma omp task firstprivate(fromTime, toTime, i) shared(selectedRows, progress, progressDelta)
-        {
-          if( progress == nullptr ||
-              ( progress != nullptr && !progress->getStop() ) )
-            executionTask( fromTime, toTime, i, i, selectedRows, progress );
+        int rowsDone = currentRow.fetch_add( 1, std::memory_order_relaxed ) + 1;
 
-          if( progress != nullptr && numRows > 1 && !progress->getStop() )
-          {
-            #pragma omp atomic
-            ++currentRow;
-            if( selectedRows.size() <= 200 || currentRow % progressDelta == 0 )
-            {
-              #pragma omp critical
-              progress->setCurrentProgress( currentRow );
-            }
-          }
+        // Only the master thread reports progress
+        if( omp_get_thread_num() == 0 &&
+            ( selectedRows.size() <= 200 || rowsDone - lastReportedRow >= progressDelta ) )
+        {
+          progress->setCurrentProgress( rowsDone );
+          lastReportedRow = rowsDone;
         }
       }
     }
@@ -1424,21 +1429,19 @@ void KHistogram::recursiveExecution( TRecordTime fromTime, TRecordTime toTime,
           if( progressSteps == 100000 )
           {
             progressSteps = 0;
-            #pragma omp critical
-            {
+#ifdef PARALLEL_ENABLED
+            if( omp_get_thread_num() == 0 )
+#endif
               progress->setCurrentProgress( progress->getCurrentProgress() );
-            }
           }
         }
         else
         {
           auto tmpEndTime = windowCloneManager( currentWindow )->getEndTime( iRow );
+          // A single row is computed by only one thread
           if( tmpEndTime - tmpLastTime > ( toTime - fromTime ) / 50 )
           {
-            #pragma omp critical
-            {
-              progress->setCurrentProgress( tmpEndTime - beginTime );
-            }
+            progress->setCurrentProgress( tmpEndTime - beginTime );
             tmpLastTime = tmpEndTime;
           }
         }
@@ -1581,8 +1584,10 @@ void KHistogram::calculate( TObjectOrder iRow,
     if ( inclusive )
     {
       THistogramColumn column;
-      auto *tmp = controlWindow->getFirstSemUsefulFunction()->getStack();
-      if( tmp->find( data->controlRow ) != tmp->end() )
+      // Each thread computes on its own clone of the control window
+      KTimeline *tmpControlWindow = ( KTimeline * ) windowCloneManager( controlWindow );
+      auto *tmp = tmpControlWindow->getFirstSemUsefulFunction()->getStack();
+      if( data->controlRow < tmp->size() )
       {
         vector<TSemanticValue>::iterator it = ( *tmp )[ data->controlRow ].begin();
         while ( it != ( *tmp )[ data->controlRow ].end() )
@@ -1652,11 +1657,11 @@ void KHistogram::finishRow( CalculateData *data )
     {
 #ifdef PARALLEL_ENABLED
       auto& rowValues = commBuffer->getRowValues( iPlane, data->row );
-      for ( auto it = rowValues.begin(); it != rowValues.end(); ++it )
+      for ( size_t iCell = 0; iCell < rowValues.size(); ++iCell )
       {
-        //values = it->second;
-        commValues = statistics.finishRowAllComm( it->second, it->first, data->row, iPlane );
-        commBuffer->setValue( iPlane, data->row, it->first, commValues );
+        THistogramColumn iColumn = rowValues.getColumn( iCell );
+        commValues = statistics.finishRowAllComm( rowValues.getValues( iCell ), iColumn, data->row, iPlane );
+        commBuffer->setValue( iPlane, data->row, iColumn, commValues );
       }
 #else
       if ( commCube->planeWithValues( iPlane ) )
@@ -1685,11 +1690,11 @@ void KHistogram::finishRow( CalculateData *data )
   {
 #ifdef PARALLEL_ENABLED
     auto& rowValues = commBuffer->getRowValues( 0, data->row );
-    for ( auto it = rowValues.begin(); it != rowValues.end(); ++it )
+    for ( size_t iCell = 0; iCell < rowValues.size(); ++iCell )
     {
-      //values = it->second;
-      commValues = statistics.finishRowAllComm( it->second, it->first, data->row );
-      commBuffer->setValue( 0, data->row, it->first, commValues );
+      THistogramColumn iColumn = rowValues.getColumn( iCell );
+      commValues = statistics.finishRowAllComm( rowValues.getValues( iCell ), iColumn, data->row );
+      commBuffer->setValue( 0, data->row, iColumn, commValues );
     }
 #else
     for ( TObjectOrder iColumn = 0;
@@ -1723,11 +1728,11 @@ void KHistogram::finishRow( CalculateData *data )
     {
 #ifdef PARALLEL_ENABLED
       auto& rowValues = semanticBuffer->getRowValues( iPlane, data->row );
-      for ( auto it = rowValues.begin(); it != rowValues.end(); ++it )
+      for ( size_t iCell = 0; iCell < rowValues.size(); ++iCell )
       {
-        //values = it->second;
-        semanticValues = statistics.finishRowAll( it->second, it->first, data->row, iPlane );
-        semanticBuffer->setValue( iPlane, data->row, it->first, semanticValues );
+        THistogramColumn iColumn = rowValues.getColumn( iCell );
+        semanticValues = statistics.finishRowAll( rowValues.getValues( iCell ), iColumn, data->row, iPlane );
+        semanticBuffer->setValue( iPlane, data->row, iColumn, semanticValues );
       }
 #else
       if ( cube->planeWithValues( iPlane ) )
@@ -1756,11 +1761,11 @@ void KHistogram::finishRow( CalculateData *data )
   {
 #ifdef PARALLEL_ENABLED
     auto& rowValues = semanticBuffer->getRowValues( 0, data->row );
-    for ( auto it = rowValues.begin(); it != rowValues.end(); ++it )
+    for ( size_t iCell = 0; iCell < rowValues.size(); ++iCell )
     {
-      //values = it->second;
-      semanticValues = statistics.finishRowAll( it->second, it->first, data->row );
-      semanticBuffer->setValue( 0, data->row, it->first, semanticValues );
+      THistogramColumn iColumn = rowValues.getColumn( iCell );
+      semanticValues = statistics.finishRowAll( rowValues.getValues( iCell ), iColumn, data->row );
+      semanticBuffer->setValue( 0, data->row, iColumn, semanticValues );
     }
 #else
     for ( THistogramColumn iColumn = 0; iColumn < columnTranslator->totalColumns(); ++iColumn )
@@ -21,8 +21,11 @@
  *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
 \*****************************************************************************/
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <fstream>
+#include <limits>
 #include <sstream>
 #ifdef _MSC_VER
 #include <hash_set>
@@ -33,6 +36,7 @@
 #include "ktrace.h"
 #include "traceheaderexception.h"
 #include "tracebodyiofactory.h"
+#include "utils/traceparser/tracebodyio_v1.h"
 #include "tracebodyio_v2.h"
 #include "tracestream.h"
 #include "kprogresscontroller.h"
@@ -41,11 +45,17 @@
 #include "noloadtrace.h"
 #include "noloadblocks.h"
 #include "traceeditblocks.h"
+#include "tracecache.h"
+#include "paraverconfig.h"
 #include "customalgorithms.h"
 #include "utils/traceparser/traceheader.h"
 #include "vectorblocks.h"
 #include "vectortrace.h"
 
+#ifdef PARALLEL_ENABLED
+#include "omp.h"
+#endif
+
 using namespace std;
 #ifdef _MSC_VER
 using namespace stdext;
@@ -425,29 +435,23 @@ void KTrace::dumpFileHeader( std::fstream& file, bool newFormat ) const
 
 void KTrace::dumpFile( const string& whichFile ) const
 {
-  ostringstream ostr;
-
-  ostr << fixed;
-  ostr << dec;
-  ostr.precision( 0 );
-
   std::fstream file( whichFile.c_str(), fstream::out | fstream::trunc );
   dumpFileHeader( file, true );
 
   MemoryTrace::iterator *it = memTrace->begin();
-  TraceBodyIO< PARAM_TRACEBODY_CLASS > *body = TraceBodyIOFactory::createTraceBody();
-  if( TraceBodyIO_v2 *tmpBody = dynamic_cast<TraceBodyIO_v2 *>( body ) )
-    tmpBody->writeCommInfo( file, *this );
+  TraceBodyIO_v2 body;
+  body.writeCommInfo( file, *this );
 
   while ( !it->isNull() )
   {
-    body->write( file, traceProcessModel, traceResourceModel, it );
+    body.write( file, traceProcessModel, traceResourceModel, it );
     ++( *it );
 
   }
 
   delete it;
 
+  body.flushBuffer();
   file.close();
 }
 
@@ -502,6 +506,12 @@ void KTrace::getRecordByTimeCPU( vector<MemoryTrace::iterator *>& listIter,
 }
 
 
+bool KTrace::recordsInMemory() const
+{
+  return memTrace->recordsInMemory();
+}
+
+
 void KTrace::parseDateTime( string &whichDateTime )
 {
   rawTraceTime = whichDateTime;
@@ -529,11 +539,12 @@ void KTrace::parseDateTime( string &whichDateTime )
     ""
   };
 
-  static vector<array<string, 3>> strFormatDate;
-  static vector<std::locale> formatDate;
-
-  if( strFormatDate.size() == 0 )
+  // Built once even if traces are loaded concurrently
+  static const vector<std::locale> formatDate = []()
   {
+    vector<array<string, 3>> strFormatDate;
+    vector<std::locale> tmpFormatDate;
+
     cartesian_product( std::back_inserter( strFormatDate ), strYearFormat.begin(), strYearFormat.end(),
                                                             strMidFormat.begin(),  strMidFormat.end(),
                                                             strHourFormat.begin(), strHourFormat.end() );
@@ -541,9 +552,11 @@ void KTrace::parseDateTime( string &whichDateTime )
     for( auto el: strFormatDate )
     {
       string tmp =  el[ 0 ] + el[ 1 ] + el[ 2 ];
-      formatDate.push_back(std::locale( std::locale::classic(), new time_input_facet( tmp ) ) );
+      tmpFormatDate.push_back(std::locale( std::locale::classic(), new time_input_facet( tmp ) ) );
     }
-  }
+
+    return tmpFormatDate;
+  }();
 
   try
   {
@@ -634,15 +647,16 @@ KTrace::KTrace( const string& whichFile, ProgressController *progress, bool noLo
 // Reading the body
   body = TraceBodyIOFactory::createTraceBody( file, this, traceProcessModel );
 
+  size_t noLoadCacheSize = static_cast<size_t>( ParaverConfig::getInstance()->getGlobalNoLoadCacheSize() ) * 1024 * 1024;
   if ( noLoad && body->ordered() )
   {
-    blocks = new NoLoadBlocks( traceResourceModel, traceProcessModel, body, file, traceEndTime );
+    blocks = new NoLoadBlocks( traceResourceModel, traceProcessModel, body, file, traceEndTime, noLoadCacheSize );
     memTrace = new NoLoadTrace( this, blocks, traceProcessModel, traceResourceModel );
     ( ( NoLoadBlocks * )blocks )->setFirstOffset( file->tellg() );
   }
   else if( noLoad && !body->ordered() )
   {
-    blocks = new TraceEditBlocks( traceResourceModel, traceProcessModel, body, file, traceEndTime );
+    blocks = new TraceEditBlocks( traceResourceModel, traceProcessModel, body, file, traceEndTime, noLoadCacheSize );
     memTrace = new NoLoadTrace( this, blocks, traceProcessModel, traceResourceModel );
     ( ( TraceEditBlocks * )blocks )->setFirstOffset( file->tellg() );
   }
@@ -662,11 +676,28 @@ KTrace::KTrace( const string& whichFile, ProgressController *progress, bool noLo
   unordered_set<TEventType> hashevents;
   unordered_set<TState> hashstates;
 
+  VectorBlocks *vectorBlocks = dynamic_cast<VectorBlocks *>( blocks );
+  bool useBinaryCache = !noLoad && vectorBlocks != nullptr &&
+                        ParaverConfig::getInstance()->getGlobalTraceBinaryCache();
+  bool loadedFromCache = useBinaryCache &&
+                         TraceCache::load( fileName, *vectorBlocks, hashstates, hashevents, myTraceInfo );
+
   unsigned long long count = 0;
-  if( !( noLoad && !body->ordered() ) )
+  if ( loadedFromCache )
+  {
+    memTrace->insert( blocks );
+
+    for ( unordered_set<TEventType>::iterator it = hashevents.begin(); it != hashevents.end(); ++it )
+      events.insert( *it );
+
+    for ( unordered_set<TState>::iterator it = hashstates.begin(); it != hashstates.end(); ++it )
+      states.insert( *it );
+  }
+  else if( !( noLoad && !body->ordered() ) )
   {
     int insertCounter = 0;
-    while ( !file->eof() )
+    bool loadedInParallel = !noLoad && parallelReadBody( file, progress, hashstates, hashevents );
+    while ( !loadedInParallel && !file->eof() )
     {
       ++insertCounter;
       body->read( *file, *blocks, traceProcessModel, traceResourceModel, hashstates, hashevents, myTraceInfo, traceEndTime );
@@ -725,11 +756,150 @@ KTrace::KTrace( const string& whichFile, ProgressController *progress, bool noLo
     file->clear();
   }
 
-  blocks->setFileLoaded( traceEndTime );
+  if ( !loadedFromCache )
+    blocks->setFileLoaded( traceEndTime );
+
+  if ( useBinaryCache && !loadedFromCache && ( progress == nullptr || !progress->getStop() ) )
+    TraceCache::save( fileName, *vectorBlocks, states, events, myTraceInfo );
 
   ready = true;
 }
 
+// Splits the body in byte ranges aligned to line boundaries and parses every
+// range on its own thread into a VectorBlocks partition. Partitions are merged
+// in file order, so the loaded trace is the same as reading it sequentially.
+// Returns false if the trace can't be read this way.
+bool KTrace::parallelReadBody( TraceStream *file,
+                               ProgressController *progress,
+                               unordered_set<TState>& hashstates,
+                               unordered_set<TEventType>& hashevents )
+{
+#ifdef PARALLEL_ENABLED
+  typedef TraceBodyIO_v1< PARAM_TRACEBODY_CLASS > TBodyV1;
+
+  VectorBlocks *vectorBlocks = dynamic_cast<VectorBlocks *>( blocks );
+  TBodyV1 *bodyV1 = dynamic_cast<TBodyV1 *>( body );
+  if ( vectorBlocks == nullptr || bodyV1 == nullptr || !file->canseekend() )
+    return false;
+
+  TTraceSize bodyBegin = file->tellg();
+  file->seekend();
+  TTraceSize bodyEnd = file->tellg();
+  file->seekg( bodyBegin );
+
+  size_t numChunks = std::min( static_cast<TTraceSize>( omp_get_max_threads() ),
+                               ( bodyEnd - bodyBegin ) / PARALLEL_LOAD_CHUNK_SIZE );
+  if ( numChunks < 2 )
+    return false;
+
+  // Every chunk begins on the first line starting at or after its nominal offset
+  vector<TTraceSize> chunkBegin( numChunks + 1 );
+  chunkBegin[ 0 ] = bodyBegin;
+  chunkBegin[ numChunks ] = bodyEnd;
+
+  TraceStream *boundaryFile = TraceStream::openFile( fileName );
+  string tmpLine;
+  for ( size_t iChunk = 1; iChunk < numChunks; ++iChunk )
+  {
+    TTraceSize nominalBegin = bodyBegin + iChunk * ( ( bodyEnd - bodyBegin ) / numChunks );
+    boundaryFile->seekg( nominalBegin - 1 );
+    boundaryFile->getline( tmpLine );
+    chunkBegin[ iChunk ] = std::min( std::max<TTraceSize>( nominalBegin + tmpLine.size(), chunkBegin[ iChunk - 1 ] ),
+                                     bodyEnd );
+  }
+  boundaryFile->close();
+  delete boundaryFile;
+
+  // First chunk is read directly on the trace blocks
+  vector<VectorBlocks *> partitions( numChunks, nullptr );
+  partitions[ 0 ] = vectorBlocks;
+  for ( size_t iChunk = 1; iChunk < numChunks; ++iChunk )
+    partitions[ iChunk ] = new VectorBlocks( traceResourceModel, traceProcessModel, traceEndTime, nullptr );
+
+  vector<unordered_set<TState>> chunkStates( numChunks );
+  vector<unordered_set<TEventType>> chunkEvents( numChunks );
+  vector<vector<string>> chunkComments( numChunks );
+
+  TTraceSize bytesRead = 0;
+  bool stopLoading = false;
+
+  int iChunk;
+  #pragma omp parallel for schedule( static, 1 ) \
+                           private( iChunk ) \
+                           default( shared )
+  for ( iChunk = 0; iChunk < static_cast<int>( numChunks ); ++iChunk )
+  {
+    TraceStream *chunkFile = TraceStream::openFile( fileName );
+    chunkFile->seekg( chunkBegin[ iChunk ] );
+
+    TTraceSize currentPos = chunkBegin[ iChunk ];
+    TTraceSize lastReportedPos = currentPos;
+    const char *lineBegin;
+    const char *lineEnd;
+    while ( currentPos < chunkBegin[ iChunk + 1 ] && !chunkFile->eof() )
+    {
+      chunkFile->getlineView( lineBegin, lineEnd );
+      currentPos += lineEnd - lineBegin + 1;
+
+      if ( lineBegin == lineEnd )
+        continue;
+      else if ( *lineBegin == TBodyV1::CommentRecord )
+        chunkComments[ iChunk ].emplace_back( lineBegin, lineEnd );
+      else
+        bodyV1->readRecord( lineBegin, lineEnd, *partitions[ iChunk ], traceProcessModel, traceResourceModel,
+                            chunkStates[ iChunk ], chunkEvents[ iChunk ] );
+
+      if ( currentPos - lastReportedPos >= PARALLEL_LOAD_PROGRESS_STEP )
+      {
+        #pragma omp atomic
+        bytesRead += currentPos - lastReportedPos;
+        lastReportedPos = currentPos;
+
+        bool tmpStop;
+        if ( progress != nullptr && omp_get_thread_num() == 0 )
+        {
+          TTraceSize tmpBytesRead;
+          #pragma omp atomic read
+          tmpBytesRead = bytesRead;
+          progress->setCurrentProgress( bodyBegin + tmpBytesRead );
+
+          if ( progress->getStop() )
+          {
+            #pragma omp atomic write
+            stopLoading = true;
+          }
+        }
+
+        #pragma omp atomic read
+        tmpStop = stopLoading;
+        if ( tmpStop )
+          break;
+      }
+    }
+
+    chunkFile->close();
+    delete chunkFile;
+  }
+
+  partitions.erase( partitions.begin() );
+  vectorBlocks->mergePartitions( partitions );
+  for ( auto itPartition : partitions )
+    delete itPartition;
+
+  for ( size_t iChunk = 0; iChunk < numChunks; ++iChunk )
+  {
+    for ( auto& itComment : chunkComments[ iChunk ] )
+      myTraceInfo.NewMetadata( itComment );
+    hashstates.insert( chunkStates[ iChunk ].begin(), chunkStates[ iChunk ].end() );
+    hashevents.insert( chunkEvents[ iChunk ].begin(), chunkEvents[ iChunk ].end() );
+  }
+
+  return true;
+#else
+  return false;
+#endif // PARALLEL_ENABLED
+}
+
 KTrace::~KTrace()
 {
   delete blocks;
@@ -817,6 +987,29 @@ bool KTrace::findNextEvent( TThreadOrder whichThread,
                             TRecordTime& foundTime ) const
 {
   bool found = false;
+
+  // Loaded traces are scanned in place, without creating iterators for every thread
+  vector<TRecordSpan> spans;
+  if ( memTrace->getThreadRecords( whichThread,
+                                   std::nextafter( whichTime, std::numeric_limits<TRecordTime>::max() ),
+                                   std::numeric_limits<TRecordTime>::max(),
+                                   spans ) )
+  {
+    for ( const TRecordSpan& span : spans )
+    {
+      for ( const Plain::TRecord *record = span.first; record != span.last; ++record )
+      {
+        if ( ( record->type & EVENT ) && record->URecordInfo.eventRecord.type == whichEvent )
+        {
+          foundTime = record->time;
+          return true;
+        }
+      }
+    }
+
+    return false;
+  }
+
   vector<MemoryTrace::iterator *> listIter;
   MemoryTrace::iterator *it;
 
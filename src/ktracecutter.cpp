@@ -28,6 +28,8 @@
 #include <sys/types.h>
 #include <math.h>
 #include <algorithm>
+#include <map>
+#include <tuple>
 #include <vector>
 #include <string>
 #include <sstream>
@@ -51,6 +53,7 @@
 
 #ifdef _WIN32
 #define atoll _atoi64
+#define strtok_r strtok_s
 #endif
 
 #include <iostream>
@@ -143,6 +146,7 @@ void KTraceCutter::setCutterApplicationCaller( std::string caller )
 /* Function for parsing program parameters */
 void KTraceCutter::read_cutter_params()
 {
+  char *tokenState;
   char *word, *buffer;
 
   by_time = exec_options->by_time;
@@ -157,7 +161,7 @@ void KTraceCutter::read_cutter_params()
     cut_tasks = true;
     int j = 0;
 
-    word = strtok( exec_options->tasks_list, "," );
+    word = strtok_r( exec_options->tasks_list, ",", &tokenState );
     do
     {
       if ( ( buffer = strchr( word, '-' ) ) != nullptr )
@@ -175,7 +179,7 @@ void KTraceCutter::read_cutter_params()
 
       j++;
     }
-    while ( ( word = strtok( nullptr, "," ) ) != nullptr );
+    while ( ( word = strtok_r( nullptr, ",", &tokenState ) ) != nullptr );
   }
 
   if ( exec_options->max_trace_size != 0 )
@@ -258,6 +262,7 @@ void KTraceCutter::parseInHeaderAndDumpOut( TraceStream *whichFile, std::fstream
 
   for ( auto i = 0; i < traceProcessModel.totalApplications(); ++i )
     appsInfo.emplace_back( traceProcessModel.totalThreads( i ) );
+  traceTotalThreads = traceProcessModel.totalThreads();
 
   // Dump header in outfile
   dumpTraceHeader( outfile, tmpDate, traceEndTime, traceTimeUnit, traceResourceModel, traceProcessModel, communicators );
@@ -267,6 +272,7 @@ void KTraceCutter::parseInHeaderAndDumpOut( TraceStream *whichFile, std::fstream
 // #Paraver (12/03/2018 at 16:11:35.687574899):100:1:1:1(1:1)
 void KTraceCutter::proces_cutter_header( const std::string& header, TraceStream *whichFile, FILE *outfile )
 {
+  char *tokenState;
   int num_comms;
   char *word;
   string auxLine;
@@ -276,11 +282,11 @@ void KTraceCutter::proces_cutter_header( const std::string& header, TraceStream
 
   // PARSE variable header
   // #Paraver (12/03/2018 at 16:11:35.687574899):
-  word = strtok( tmpHeader, ")" );
+  word = strtok_r( tmpHeader, ")", &tokenState );
   current_size += fprintf( outfile, "%s):", word );
 
   /* Obtaining the trace total time */
-  word = strtok( nullptr, ":" );
+  word = strtok_r( nullptr, ":", &tokenState );
   if ( strstr( word, "_ns" ) )
   {
     word[ strlen( word ) - 3 ] = '\0';
@@ -322,7 +328,7 @@ void KTraceCutter::proces_cutter_header( const std::string& header, TraceStream
   }
 
   /* Obtaining the number of communicators */
-  word = strtok( nullptr, "\n" ); // put in word the rest of the line
+  word = strtok_r( nullptr, "\n", &tokenState ); // put in word the rest of the line
   current_size += fprintf( outfile, "%s\n", word );
 
   // Do I have some "," looking back?
@@ -596,12 +602,15 @@ void KTraceCutter::shiftLeft_TraceTimes_ToStartFromZero( const char *originalTra
 {
   unsigned long long timeOffset = 0, time_1, time_2, time_3, time_4;
   int cpu, appl, task, thread, state, cpu_2, appl_2, task_2, thread_2;
+  const char *fieldsBegin, *fieldsEnd;
   std::string trace_header;
-  char *line = (char *) malloc( sizeof( char ) * MAX_TRACE_HEADER );
   char *outBuffer = (char *) malloc( sizeof( char ) * MAX_TRACE_HEADER );
   TraceStream *infile = TraceStream::openFile( nameIn );
 
-  fstream outfile( nameOut, ios_base::out );
+  fstream outfile;
+  vector< char > outfileBuffer( OUTPUT_BUFFER_SIZE );
+  outfile.rdbuf()->pubsetbuf( &outfileBuffer[ 0 ], outfileBuffer.size() );
+  outfile.open( nameOut, ios_base::out );
 
   /* Process header */
   total_time = last_record_time - first_record_time;
@@ -631,10 +640,14 @@ void KTraceCutter::shiftLeft_TraceTimes_ToStartFromZero( const char *originalTra
   {
     show_cutter_progress_bar( progress, infile );
 
+    // Skips the record type
+    fieldsBegin = trace_header.c_str() + std::min( trace_header.length(), (size_t)2 );
+    fieldsEnd = trace_header.c_str() + trace_header.length();
+
     switch ( trace_header[0] )
     {
       case '1':
-        sscanf( trace_header.c_str(), "%*d:%d:%d:%d:%d:%lld:%lld:%d\n", &cpu, &appl, &task, &thread, &time_1, &time_2, &state );
+        prv_atoll_v( fieldsBegin, fieldsEnd, cpu, appl, task, thread, time_1, time_2, state );
 
 
         time_1 = time_1 - timeOffset;
@@ -648,20 +661,20 @@ void KTraceCutter::shiftLeft_TraceTimes_ToStartFromZero( const char *originalTra
 
 
       case '2':
-        sscanf( trace_header.c_str(), "%*d:%d:%d:%d:%d:%lld:%s\n", &cpu, &appl, &task, &thread, &time_1, line );
+        prv_atoll_v( fieldsBegin, fieldsEnd, cpu, appl, task, thread, time_1 );
 
         time_1 = time_1 - timeOffset;
 
-        sprintf( outBuffer, "2:%d:%d:%d:%d:%lld:%s\n", cpu, appl, task, thread, time_1, line );
+        sprintf( outBuffer, "2:%d:%d:%d:%d:%lld:%s\n", cpu, appl, task, thread, time_1, fieldsBegin );
         outfile << outBuffer;
 
         ++current_tmp_lines;
         break;
 
       case '3':
-        sscanf( trace_header.c_str(), "%*d:%d:%d:%d:%d:%lld:%lld:%d:%d:%d:%d:%lld:%lld:%s\n",
-                &cpu,   &appl,   &task,   &thread,   &time_1, &time_2,
-                &cpu_2, &appl_2, &task_2, &thread_2, &time_3, &time_4, line );
+        prv_atoll_v( fieldsBegin, fieldsEnd,
+                     cpu,   appl,   task,   thread,   time_1, time_2,
+                     cpu_2, appl_2, task_2, thread_2, time_3, time_4 );
 
         time_1 = time_1 - timeOffset;
         time_2 = time_2 - timeOffset;
@@ -670,7 +683,7 @@ void KTraceCutter::shiftLeft_TraceTimes_ToStartFromZero( const char *originalTra
 
         sprintf( outBuffer, "3:%d:%d:%d:%d:%lld:%lld:%d:%d:%d:%d:%lld:%lld:%s\n",
                  cpu,   appl,   task,   thread,   time_1, time_2,
-                 cpu_2, appl_2, task_2, thread_2, time_3, time_4, line );
+                 cpu_2, appl_2, task_2, thread_2, time_3, time_4, fieldsBegin );
         outfile << outBuffer;
 
         ++current_tmp_lines;
@@ -692,7 +705,6 @@ void KTraceCutter::shiftLeft_TraceTimes_ToStartFromZero( const char *originalTra
       infile->getline( trace_header );
   }
 
-  free( line );
   free( outBuffer );
 
   infile->close();
@@ -700,6 +712,129 @@ void KTraceCutter::shiftLeft_TraceTimes_ToStartFromZero( const char *originalTra
   unlink( nameIn );
 }
 
+bool KTraceCutter::canSeekCutBegin( const std::string& fileName, TraceStream *whichFile ) const
+{
+  if ( time_min == 0 || !whichFile->canseekend() )
+    return false;
+
+#ifndef _WIN32
+  // Pipes can't seek
+  struct stat fileStat;
+  if ( stat( fileName.c_str(), &fileStat ) != 0 || !S_ISREG( fileStat.st_mode ) )
+    return false;
+#endif
+
+  return true;
+}
+
+
+// Where processing can start giving the same cut as from the body begin.
+// Records are ordered by begin time, so the first one at time_min is binary
+// searched. Then a backward scan finds the last state of every thread
+// starting before it: only those may still be open at time_min. A thread
+// whose last state is far behind makes the scan give up and return the body
+// begin, so the cut never costs much more than the forward processing.
+TTraceSize KTraceCutter::findCutBegin( TraceStream *whichFile, TTraceSize bodyBegin )
+{
+  typedef std::tuple< unsigned long long, unsigned long long, unsigned long long > TThreadKey;
+
+  const char *lineBegin, *lineEnd;
+  unsigned long long fields[ 7 ];
+  TTraceSize lowPos, highPos, midPos, linePos, cutBegin, fileEnd;
+  bool found;
+
+  whichFile->clear();
+  whichFile->seekend();
+  fileEnd = whichFile->tellg();
+
+  // Records starting before lowPos are before time_min, and the ones
+  // starting at highPos or later are not
+  lowPos = bodyBegin;
+  highPos = fileEnd;
+  while ( highPos - lowPos > SEEK_LINEAR_SIZE )
+  {
+    midPos = lowPos + ( highPos - lowPos ) / 2;
+
+    whichFile->clear();
+    whichFile->seekg( midPos - 1 );
+    whichFile->getlineView( lineBegin, lineEnd ); // line holding midPos - 1
+
+    found = false;
+    while ( !found && !whichFile->eof() )
+    {
+      linePos = whichFile->tellg();
+      if ( linePos >= highPos )
+        break;
+
+      whichFile->getlineView( lineBegin, lineEnd );
+      found = prvReadFields( lineBegin, lineEnd, fields, 6 );
+    }
+
+    if ( found && fields[ 5 ] < time_min )
+      lowPos = linePos + 1;
+    else
+      highPos = midPos;
+  }
+
+  cutBegin = fileEnd;
+  whichFile->clear();
+  whichFile->seekg( lowPos - 1 );
+  whichFile->getlineView( lineBegin, lineEnd );
+  while ( !whichFile->eof() )
+  {
+    linePos = whichFile->tellg();
+    whichFile->getlineView( lineBegin, lineEnd );
+    if ( prvReadFields( lineBegin, lineEnd, fields, 6 ) && fields[ 5 ] >= time_min )
+    {
+      cutBegin = linePos;
+      break;
+    }
+  }
+
+  // Backward scan by chunks, until every thread has shown its last state
+  std::set< TThreadKey > foundThreads;
+  TTraceSize firstOpenState = cutBegin;
+  TTraceSize chunkEnd = cutBegin;
+  while ( chunkEnd > bodyBegin && foundThreads.size() < traceTotalThreads )
+  {
+    if ( cutBegin - chunkEnd >= MAX_BACKWARD_SCAN_SIZE )
+      return bodyBegin;
+
+    TTraceSize chunkBegin = chunkEnd - bodyBegin > BACKWARD_CHUNK_SIZE ? chunkEnd - BACKWARD_CHUNK_SIZE : bodyBegin;
+    std::map< TThreadKey, std::pair< TTraceSize, bool > > chunkStates; // last state of the chunk and if it is open
+
+    whichFile->clear();
+    whichFile->seekg( chunkBegin - 1 );
+    whichFile->getlineView( lineBegin, lineEnd );
+    while ( !whichFile->eof() )
+    {
+      linePos = whichFile->tellg();
+      if ( linePos >= chunkEnd )
+        break;
+
+      whichFile->getlineView( lineBegin, lineEnd );
+      if ( lineBegin == lineEnd || *lineBegin != '1' || !prvReadFields( lineBegin, lineEnd, fields, 7 ) )
+        continue;
+
+      TThreadKey tmpThread( fields[ 2 ], fields[ 3 ], fields[ 4 ] );
+      if ( foundThreads.find( tmpThread ) == foundThreads.end() )
+        chunkStates[ tmpThread ] = std::make_pair( linePos, fields[ 6 ] > time_min );
+    }
+
+    for ( auto it = chunkStates.begin(); it != chunkStates.end(); ++it )
+    {
+      foundThreads.insert( it->first );
+      if ( it->second.second && it->second.first < firstOpenState )
+        firstOpenState = it->second.first;
+    }
+
+    chunkEnd = chunkBegin;
+  }
+
+  return firstOpenState;
+}
+
+
 /* Function for filtering tasks in cut */
 bool KTraceCutter::is_selected_task( int task_id )
 {
@@ -752,6 +887,7 @@ void KTraceCutter::execute( std::string trace_in,
 
   unsigned int id, cpu, appl, task, thread, state, cpu_2, appl_2, task_2, thread_2, size, tag;
   unsigned long long type, value, time_1, time_2, time_3, time_4;
+  const char *fieldsBegin, *fieldsEnd;
   int i;
 
   unsigned long num_iters = 0;
@@ -800,7 +936,10 @@ void KTraceCutter::execute( std::string trace_in,
   else
     strcpy( trace_file_out, trace_out.c_str() );
 
-  fstream outfile( trace_file_out, ios_base::out );
+  fstream outfile;
+  vector< char > outfileBuffer( OUTPUT_BUFFER_SIZE );
+  outfile.rdbuf()->pubsetbuf( &outfileBuffer[ 0 ], outfileBuffer.size() );
+  outfile.open( trace_file_out, ios_base::out );
 
   ini_cutter_progress_bar( trace_in, tmpKProgressControler );
 
@@ -812,11 +951,27 @@ void KTraceCutter::execute( std::string trace_in,
     writeOffsetLine( outfile, trace_in.c_str(), time_min, time_min, time_max );
   }
 
+  total_tmp_lines = 0;
+  if ( canSeekCutBegin( trace_in, inFile ) )
+  {
+    // Leading comments, like the offset line of a previous cut, are kept
+    while ( !inFile->eof() && inFile->peek() == '#' )
+    {
+      inFile->getline( line );
+      outfile << line << std::endl;
+      if( writeToTmpFile )
+        ++total_tmp_lines;
+    }
+
+    TTraceSize cutBegin = findCutBegin( inFile, inFile->tellg() );
+    inFile->clear();
+    inFile->seekg( cutBegin );
+  }
+
   /* We process the trace like the originalTime version */
 
   bool maxTimeReached = false;
   last_record_time = 0;
-  total_tmp_lines = 0;
   secondPhase = false;
 
   if( tmpKProgressControler != nullptr )
@@ -854,11 +1009,13 @@ void KTraceCutter::execute( std::string trace_in,
 
     CutterThreadInfo::iterator threadInfoIt;
 
+    fieldsBegin = line.c_str();
+    fieldsEnd = fieldsBegin + line.length();
+
     switch ( line[0] )
     {
       case '1':
-        sscanf( line.c_str(), "%d:%d:%d:%d:%d:%lld:%lld:%d\n",
-                &id, &cpu, &appl, &task, &thread, &time_1, &time_2, &state );
+        prv_atoll_v( fieldsBegin, fieldsEnd, id, cpu, appl, task, thread, time_1, time_2, state );
         
         // PROFET
         if ( exec_options->get_max_cut_time_to_finish_of_first_appl() &&
@@ -998,8 +1155,8 @@ void KTraceCutter::execute( std::string trace_in,
         break;
 
       case '2':
-        sscanf( line.c_str(), "%d:%d:%d:%d:%d:%lld:%s\n", &id, &cpu, &appl, &task, &thread, &time_1, buffer );
-        line = buffer;
+        prv_atoll_v( fieldsBegin, fieldsEnd, id, cpu, appl, task, thread, time_1 );
+        line.erase( 0, fieldsBegin - line.c_str() );
 
         // PROFET
         if ( exec_options->get_max_cut_time_to_finish_of_first_appl() &&
@@ -1072,12 +1229,12 @@ void KTraceCutter::execute( std::string trace_in,
           threadsInfo( appl - 1, task - 1, thread - 1 ).last_time = time_1;
           threadsInfo( appl - 1, task - 1, thread - 1 ).lastCPU = cpu;
 
-          std::string::const_iterator itBegin = line.begin();
-          const std::string::const_iterator itEnd = line.end();
+          fieldsBegin = line.c_str();
+          fieldsEnd = fieldsBegin + line.length();
 
-          while ( itBegin != itEnd )
+          while ( fieldsBegin != fieldsEnd )
           {
-            prv_atoll_v( itBegin, itEnd, type, value );
+            prv_atoll_v( fieldsBegin, fieldsEnd, type, value );
             update_queue( appl - 1, task - 1, thread - 1, type, value );
           }
 
@@ -1086,10 +1243,10 @@ void KTraceCutter::execute( std::string trace_in,
         break;
 
       case '3':
-        sscanf( line.c_str(), "%d:%d:%d:%d:%d:%lld:%lld:%d:%d:%d:%d:%lld:%lld:%d:%d\n",
-                &id,
-                &cpu,   &appl,   &task,   &thread,   &time_1, &time_2,
-                &cpu_2, &appl_2, &task_2, &thread_2, &time_3, &time_4, &size, &tag );
+        prv_atoll_v( fieldsBegin, fieldsEnd,
+                     id,
+                     cpu,   appl,   task,   thread,   time_1, time_2,
+                     cpu_2, appl_2, task_2, thread_2, time_3, time_4, size, tag );
 
         // PROFET
         if ( exec_options->get_max_cut_time_to_finish_of_first_appl() &&
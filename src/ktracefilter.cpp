@@ -31,18 +31,28 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <math.h>
-#include <zlib.h>
 
 //#include "filters_wait_window.h"
 #include "ktracefilter.h"
 #include "kprogresscontroller.h"
-#include "tracestream.h" // for GZIP_COMPRESSION_RATIO
+#include "tracestream.h"
+#include "traceheaderexception.h"
+#include "utils/traceparser/prvtokenizer.h"
+#include "utils/traceparser/resourcemodel.h"
+#include "utils/traceparser/traceheader.h"
+
+#ifdef PARALLEL_ENABLED
+#include "omp.h"
+#endif
 
 
 #ifdef _WIN32
 #define atoll _atoi64
+#define strtok_r strtok_s
 #endif
 
+#include <algorithm>
+#include <charconv>
 #include <iostream>
 #include <sstream>
 
@@ -102,31 +112,55 @@ void KTraceFilter::read_params()
 
 
 /* For processing the Paraver header */
-void KTraceFilter::filter_process_header( char *header )
+void KTraceFilter::filter_process_header( std::string& output )
 {
-  int num_comms;
-  char *word;
+  int num_comms = 0;
+  std::string header;
+  std::string::size_type pos;
+
+  infile->getline( header );
+  output = header + '\n';
 
   /* Obtaining the number of communicators */
-  word = strrchr( header, ',' );
-  if ( word != nullptr )
-  {
-    strcpy( line, word + 1 );
-    if ( strchr( line, ')' ) != nullptr )
-      return;
+  pos = header.rfind( ',' );
+  if ( pos != std::string::npos && header.find( ')', pos ) == std::string::npos )
+    num_comms = atoi( header.c_str() + pos + 1 );
 
-    num_comms = atoi( line );
-    while ( num_comms > 0 )
-    {
-      if ( !is_zip_filter )
-        fgets( header, MAX_HEADER_SIZE, infile );
-      else
-        gzgets( gzInfile, header, MAX_HEADER_SIZE );
+  while ( num_comms > 0 && !infile->eof() )
+  {
+    infile->getline( header );
+    output += header + '\n';
+    num_comms--;
+  }
 
-      fprintf( outfile, "%s", header );
-      num_comms--;
-    }
+  /* Per thread tables are sized from the process model */
+  std::istringstream headerStream( output );
+  std::string tmpDate;
+  TTimeUnit tmpTimeUnit;
+  unsigned long long tmpEndTime;
+  ResourceModel<> tmpResourceModel;
+  std::vector< std::string > tmpCommunicators;
+  try
+  {
+    parseTraceHeader( headerStream, tmpDate, tmpTimeUnit, tmpEndTime, tmpResourceModel, traceProcessModel, tmpCommunicators );
+  }
+  catch( TraceHeaderException& e )
+  {
+    traceProcessModel = ProcessModel<>();
   }
+
+  thread_call_info.assign( traceProcessModel.totalThreads(), nullptr );
+}
+
+
+/* Record ids are 1-based; nullptr if the thread isn't in the header */
+struct KTraceFilter::buffer_elem **KTraceFilter::get_call_info( int appl, int task, int thread )
+{
+  if ( appl < 1 || task < 1 || thread < 1 ||
+       !traceProcessModel.isValidThread( appl - 1, task - 1, thread - 1 ) )
+    return nullptr;
+
+  return &thread_call_info[ traceProcessModel.getGlobalThread( appl - 1, task - 1, thread - 1 ) ];
 }
 
 
@@ -204,16 +238,17 @@ int KTraceFilter::filter_allowed_type(  int appl, int task, int thread,
     else
     {
       /* Event de sortida, cal mirar si supera el temps minim */
-      if ( thread_call_info[appl][task][thread] == nullptr )
+      struct buffer_elem **callInfo = get_call_info( appl, task, thread );
+      if ( callInfo == nullptr || *callInfo == nullptr )
         type_allowed = 0;
       else
       {
-        if ( time - thread_call_info[appl][task][thread]->event_time >= exec_options->filter_types[i].min_call_time )
+        if ( time - ( *callInfo )->event_time >= exec_options->filter_types[i].min_call_time )
           type_allowed = 2;
         else
         {
           type_allowed = 0;
-          thread_call_info[appl][task][thread] = nullptr;
+          *callInfo = nullptr;
         }
       }
     }
@@ -234,7 +269,11 @@ void KTraceFilter::ini_progress_bar( char *file_name, ProgressController *progre
     exit( 1 );
   }
 
-  total_trace_size = file_info.st_size;
+  // Compressed traces are read by uncompressed offsets
+  if ( is_zip_filter )
+    total_trace_size = TraceStream::getTraceFileSize( file_name );
+  else
+    total_trace_size = file_info.st_size;
 
   if ( total_trace_size < 500000000 )
     total_iters = 10000;
@@ -250,31 +289,7 @@ void KTraceFilter::ini_progress_bar( char *file_name, ProgressController *progre
 
 void KTraceFilter::show_progress_bar( ProgressController *progress )
 {
-//  double current_showed, i, j;
-#if defined(__FreeBSD__) || defined(__APPLE__)
-  if ( !is_zip_filter )
-    current_read_size = ( unsigned long long )ftello( infile );
-  else
-    current_read_size = ( unsigned long )gztell( gzInfile );
-#elif defined(_WIN32)
-  if ( !is_zip_filter )
-    current_read_size = ( unsigned long long )_ftelli64( infile );
-  else
-    current_read_size = ( unsigned long )gztell( gzInfile );
-#else
-  if ( !is_zip_filter )
-    current_read_size = ( unsigned long long )ftello64( infile );
-  else
-    current_read_size = ( unsigned long )gztell( gzInfile );
-#endif
-
-/*  i = ( double )( current_read_size );
-  j = ( double )( total_trace_size );
-
-  current_showed = i / j;
-*/
-  if ( is_zip_filter )
-    current_read_size = current_read_size / TraceStream::GZIP_COMPRESSION_RATIO;
+  current_read_size = ( unsigned long long )infile->tellg();
 
   if( progress != nullptr)
     progress->setCurrentProgress( current_read_size );
@@ -329,7 +344,7 @@ void KTraceFilter::load_pcf( char *pcf_name )
 }
 
 
-void KTraceFilter::dump_buffer()
+void KTraceFilter::dump_buffer( std::string& output )
 {
   struct buffer_elem *elem, *elem_aux;
 
@@ -337,7 +352,7 @@ void KTraceFilter::dump_buffer()
   while ( elem != nullptr && elem->dump )
   {
     if ( elem->dump )
-      fputs( elem->record, outfile );
+      output += elem->record;
 
     free( elem->record );
     elem_aux = elem;
@@ -351,24 +366,419 @@ void KTraceFilter::dump_buffer()
 }
 
 
-void KTraceFilter::execute( char *trace_in, char *trace_out,ProgressController *progress )
+template< typename T >
+static void append_number( std::string& output, T number )
+{
+  char digits[ 24 ];
+  output.append( digits, std::to_chars( digits, digits + sizeof( digits ), number ).ptr );
+}
+
+
+/* Kept records are output as read, ending in newline */
+static void append_record( std::string& output, const char *lineBegin, const char *lineEnd )
+{
+  output.append( lineBegin, lineEnd );
+  output += '\n';
+}
+
+
+static char *copy_record( const char *lineBegin, const char *lineEnd )
+{
+  size_t length = lineEnd - lineBegin;
+  char *record = ( char * )malloc( length + 2 );
+  if ( record == nullptr )
+  {
+    printf( "NO MORE MEMORY!\n" );
+    exit( 1 );
+  }
+
+  memcpy( record, lineBegin, length );
+  record[ length ] = '\n';
+  record[ length + 1 ] = '\0';
+
+  return record;
+}
+
+
+/* Appends to output what is kept of one trace record. Malformed records are skipped */
+void KTraceFilter::filter_record( const char *lineBegin, const char *lineEnd, std::string& output )
 {
-  bool end_line, print_record;
-  int i, j, k, num_char, state, size, appl, task, thread, cpu;
-  unsigned long long time_1, time_2, type, value;
-  // char *word, event_record[MAX_LINE_SIZE], trace_name[2048], *c, *trace_header;
-  //char *word, *event_record, *trace_name, *c, *trace_header;
-  char *word, *trace_name, *c, *trace_header;
+  bool print_record;
+  int i, state = 0, size = 0, cpu = 0;
+  int appl = 0, task = 0, thread = 0;
+  unsigned long long time_1 = 0, time_2 = 0, type = 0, value = 0;
+  const char *fields;
+  bool dump_event_buffer, call_in;
+  struct buffer_elem *new_elem, **callInfo;
+  size_t event_record_begin;
+
+  if ( lineBegin == lineEnd || ( lineBegin[0] != '#' && lineEnd - lineBegin < 2 ) )
+    return;
+
+  /* 1: state; 2: event; 3: comm; 4: global comm */
+  switch ( lineBegin[0] )
+  {
+    case '1':
+      if ( !show_states )
+        break;
+
+      fields = lineBegin + 2;
+      if ( !prvSkipFields( fields, lineEnd, 4 ) ||
+           !prv_atoll_v( fields, lineEnd, time_1, time_2, state ) )
+        break;
+
+      if ( !all_states )
+      {
+        for ( i = 0; i < states_info.last_id; i++ )
+          if ( states_info.ids[i] == state )
+            break;
+
+        if ( i == states_info.last_id )
+          break;
+      }
+
+      if ( ( !min_state_time ) || ( time_2 - time_1 >= min_state_time ) )
+      {
+        if ( !filter_by_call_time )
+          append_record( output, lineBegin, lineEnd );
+        else
+        {
+          /* Insert on event buffer */
+          if ( ( new_elem = ( struct buffer_elem * )malloc( sizeof( struct buffer_elem ) ) ) == nullptr )
+          {
+            printf( "NO MORE MEMORY!\n" );
+            exit( 1 );
+          }
+
+          new_elem->record = copy_record( lineBegin, lineEnd );
+          new_elem->dump = true;
+          new_elem->appl = appl;
+          new_elem->task = task;
+          new_elem->thread = thread;
+          new_elem->next = nullptr;
+
+          if ( buffer_first == nullptr )
+          {
+            buffer_first = new_elem;
+            buffer_last = new_elem;
+          }
+
+          buffer_last->next = new_elem;
+          buffer_last = new_elem;
+        }
+      }
+
+      break;
+
+    case '2':
+      if ( !show_events )
+        break;
+
+      if ( filter_all_types )
+      {
+        append_record( output, lineBegin, lineEnd );
+        break;
+      }
+
+      fields = lineBegin + 2;
+      if ( !prv_atoll_v( fields, lineEnd, cpu, appl, task, thread, time_1 ) || fields == lineEnd )
+        break;
+
+      // The kept types are appended straight to output, and taken back if
+      // none is kept or the record is buffered
+      event_record_begin = output.size();
+      output += "2:";
+      append_number( output, cpu );
+      output += ':';
+      append_number( output, appl );
+      output += ':';
+      append_number( output, task );
+      output += ':';
+      append_number( output, thread );
+      output += ':';
+      append_number( output, time_1 );
+
+      call_in = false;
+      dump_event_buffer = false;
+
+      /* Event type and values */
+      print_record = false;
+      do
+      {
+        if ( !prv_atoll_v( fields, lineEnd, type, value ) )
+        {
+          print_record = false;
+          break;
+        }
+
+        if ( translationTable.size() > 0 )
+        {
+          TTypeValuePair p = std::make_pair( type, value );
+
+          std::map< TTypeValuePair, TTypeValuePair >::const_iterator it = translationTable.find(p);
+          if ( it != translationTable.end() )
+          {
+            type  = it->second.first;
+            value = it->second.second;
+          }
+        }
+
+        if ( ( i = filter_allowed_type( appl, task, thread, time_1, type, value ) ) > 0 )
+        {
+          print_record = true;
+          output += ':';
+          append_number( output, type );
+          output += ':';
+          append_number( output, value );
+
+          if ( i == 2 )
+          {
+            if ( value > 0 )
+              call_in = true;
+            else
+              dump_event_buffer = true;
+          }
+        }
+      }
+      while ( fields != lineEnd );
+
+      if ( !print_record )
+      {
+        output.resize( event_record_begin );
+        break;
+      }
+
+      output += '\n';
+
+      if ( filter_by_call_time )
+      {
+        /* Insert on buffer */
+        if ( ( new_elem = ( struct buffer_elem * )malloc( sizeof( struct buffer_elem ) ) ) == nullptr )
+        {
+          printf( "NO MORE MEMORY!!\n" );
+          exit( 1 );
+        }
+
+        new_elem->record = strdup( output.c_str() + event_record_begin );
+        output.resize( event_record_begin );
+
+        if ( call_in )
+          new_elem->dump = false;
+        else
+          new_elem->dump = true;
+
+        new_elem->appl = appl;
+        new_elem->task = task;
+        new_elem->thread = thread;
+        new_elem->event_time = time_1;
+        new_elem->next = nullptr;
+
+        if ( buffer_first == nullptr )
+          buffer_first = new_elem;
+
+        if ( buffer_last == nullptr )
+          buffer_last = new_elem;
+        else
+        {
+          buffer_last->next = new_elem;
+          buffer_last = new_elem;
+        }
+
+        callInfo = get_call_info( appl, task, thread );
+
+        if ( call_in && callInfo != nullptr )
+          *callInfo = new_elem;
+
+        if ( dump_event_buffer )
+        {
+          if ( callInfo != nullptr && *callInfo != nullptr )
+            ( *callInfo )->dump = true;
+
+          dump_buffer( output );
+          if ( callInfo != nullptr )
+            *callInfo = nullptr;
+        }
+      }
+
+      break;
+
+    case '3':
+      if ( !show_comms )
+        break;
+
+      if ( exec_options->min_comm_size > 0 )
+      {
+        fields = lineBegin + 2;
+        if ( !prvSkipFields( fields, lineEnd, 12 ) ||
+             !prv_atoll_v( fields, lineEnd, size ) )
+          break;
+
+        if ( size < exec_options->min_comm_size )
+          break;
+      }
+
+
+      if ( !filter_by_call_time )
+        append_record( output, lineBegin, lineEnd );
+      else
+      {
+        /* Insert on event buffer */
+        if ( ( new_elem = ( struct buffer_elem * )malloc( sizeof( struct buffer_elem ) ) ) == nullptr )
+        {
+          printf( "NO MORE MEMORY!!!\n" );
+          exit( 1 );
+        }
+
+        new_elem->record = copy_record( lineBegin, lineEnd );
+        new_elem->dump = true;
+        new_elem->appl = appl;
+        new_elem->task = task;
+        new_elem->thread = thread;
+        new_elem->next = nullptr;
+
+        if ( buffer_first == nullptr )
+        {
+          buffer_first = new_elem;
+          buffer_last = new_elem;
+        }
+
+        buffer_last->next = new_elem;
+        buffer_last = new_elem;
+      }
+      break;
+
+
+    case '4':
+      if ( !filter_by_call_time )
+        append_record( output, lineBegin, lineEnd );
+      else
+      {
+        /* Insert on event buffer */
+        if ( ( new_elem = ( struct buffer_elem * )malloc( sizeof( struct buffer_elem ) ) ) == nullptr )
+        {
+          printf( "NO MORE MEMORY!!!!\n" );
+          exit( 1 );
+        }
+
+        new_elem->record = copy_record( lineBegin, lineEnd );
+        new_elem->dump = true;
+        new_elem->appl = appl;
+        new_elem->task = task;
+        new_elem->thread = thread;
+        new_elem->next = nullptr;
+
+        if ( buffer_first == nullptr )
+        {
+          buffer_first = new_elem;
+          buffer_last = new_elem;
+        }
+
+        buffer_last->next = new_elem;
+        buffer_last = new_elem;
+      }
+      break;
+
+    case '#':
+      append_record( output, lineBegin, lineEnd );
+      break;
+
+    default:
+      break;
+  }
+}
+
+
+#if defined(PARALLEL_ENABLED) && !defined(_WIN32)
+/* Records are independent unless they are held until their call ends */
+bool KTraceFilter::can_filter_ranges( char *file_name ) const
+{
+  struct stat file_info;
+
+  if ( is_zip_filter || filter_by_call_time || omp_get_max_threads() < 2 )
+    return false;
+
+  if ( stat( file_name, &file_info ) < 0 || !S_ISREG( file_info.st_mode ) )
+    return false;
+
+  return (unsigned long long)file_info.st_size > (unsigned long long)infile->tellg() + RANGE_SIZE;
+}
+
+
+/* Ranges of the body are filtered concurrently, a round of them at a time,
+   and their output is written in trace order */
+void KTraceFilter::filter_ranges( char *file_name, ProgressController *progress )
+{
+  unsigned long long bodyBegin = (unsigned long long)infile->tellg();
+  unsigned long long bodyEnd;
+  int numRanges = omp_get_max_threads();
+  std::vector< TraceStream * > rangeFiles( numRanges );
+  std::vector< std::string > rangeOutputs( numRanges );
+
+  for ( int iRange = 0; iRange < numRanges; ++iRange )
+    rangeFiles[ iRange ] = TraceStream::openFile( file_name );
+
+  infile->seekend();
+  bodyEnd = (unsigned long long)infile->tellg();
+
+  for ( unsigned long long roundBegin = bodyBegin; roundBegin < bodyEnd; roundBegin += numRanges * RANGE_SIZE )
+  {
+    if ( progress != nullptr && progress->getStop() )
+      break;
+
+    #pragma omp parallel for schedule( dynamic, 1 )
+    for ( int iRange = 0; iRange < numRanges; ++iRange )
+    {
+      TraceStream *rangeFile = rangeFiles[ omp_get_thread_num() ];
+      std::string& rangeOutput = rangeOutputs[ iRange ];
+      unsigned long long rangeBegin = roundBegin + iRange * RANGE_SIZE;
+      unsigned long long rangeEnd = std::min( rangeBegin + RANGE_SIZE, bodyEnd );
+      const char *lineBegin, *lineEnd;
+
+      rangeOutput.clear();
+      if ( rangeBegin >= bodyEnd )
+        continue;
+
+      // A record belongs to the range where it starts
+      rangeFile->seekg( rangeBegin - 1 );
+      rangeFile->getlineView( lineBegin, lineEnd );
+
+      while ( !rangeFile->eof() && (unsigned long long)rangeFile->tellg() < rangeEnd )
+      {
+        rangeFile->getlineView( lineBegin, lineEnd );
+        if ( lineBegin == lineEnd && rangeFile->eof() )
+          break;
+
+        filter_record( lineBegin, lineEnd, rangeOutput );
+      }
+    }
+
+    for ( int iRange = 0; iRange < numRanges; ++iRange )
+      fwrite( rangeOutputs[ iRange ].data(), 1, rangeOutputs[ iRange ].size(), outfile );
+
+    if ( progress != nullptr )
+      progress->setCurrentProgress( std::min( roundBegin + numRanges * RANGE_SIZE, bodyEnd ) );
+  }
+
+  for ( int iRange = 0; iRange < numRanges; ++iRange )
+  {
+    rangeFiles[ iRange ]->close();
+    delete rangeFiles[ iRange ];
+  }
+}
+#endif
+
+
+void KTraceFilter::execute( char *trace_in, char *trace_out, ProgressController *progress )
+{
+  char *c;
   char *pcf_file;
+  const char *lineBegin, *lineEnd;
+  std::string output;
   unsigned long num_iters = 0;
   bool end_parsing = false;
-  bool dump_event_buffer, call_in;
   struct buffer_elem *new_elem, *elem_aux;
 
-  //event_record = (char *) malloc( sizeof(char) * MAX_LINE_SIZE );
-
-  trace_name   = (char *) malloc( sizeof(char) * MAX_FILENAME_SIZE );
-  pcf_file     = (char *) malloc( sizeof(char) * MAX_FILENAME_SIZE );
+  pcf_file = (char *) malloc( sizeof(char) * MAX_FILENAME_SIZE );
 
   /* ini vars. */
   show_states = false;
@@ -381,15 +791,9 @@ void KTraceFilter::execute( char *trace_in, char *trace_out,ProgressController *
   buffer_first = nullptr;
   buffer_last = nullptr;
 
-  for ( i = 0; i < MAX_APPL; i++ )
-    for ( j = 0; j < MAX_TASK; j++ )
-      for ( k = 0; k < MAX_THREAD; k++ )
-        thread_call_info[i][j][k] = nullptr;
-
   /* Reading of the program arguments */
 
   read_params();
-  strcpy( trace_name, trace_in );
 
   /* Is the trace zipped ? */
   if ( ( c = strrchr( trace_in, '.' ) ) != nullptr )
@@ -401,39 +805,12 @@ void KTraceFilter::execute( char *trace_in, char *trace_out,ProgressController *
       is_zip_filter = false;
   }
 
-  /* Open the files.  If nullptr is returned there was an error */
-  if ( !is_zip_filter )
+  /* Open the files; compressed traces are read through the same stream */
+  infile = TraceStream::openFile( trace_in );
+  if ( !infile->good() )
   {
-#if defined(__FreeBSD__) || defined(__APPLE__)
-    if ( ( infile = fopen( trace_name, "r" ) ) == nullptr )
-    {
-      perror( "ERROR" );
-      printf( "Error Opening File %s\n", trace_in );
-      exit( 1 );
-    }
-#elif defined(_WIN32)
-    if ( fopen_s( &infile, trace_name, "r" ) != 0 )
-    {
-      perror( "ERROR" );
-      printf( "Error Opening File %s\n", trace_in );
-      exit( 1 );
-    }
-#else
-    if ( ( infile = fopen64( trace_name, "r" ) ) == nullptr )
-    {
-      perror( "ERROR" );
-      printf( "Error Opening File %s\n", trace_in );
-      exit( 1 );
-    }
-#endif
-  }
-  else
-  {
-    if ( ( gzInfile = gzopen( trace_name, "rb" ) ) == nullptr )
-    {
-      printf( "Filter: Error opening compressed trace\n" );
-      exit( 1 );
-    }
+    printf( "Error Opening File %s\n", trace_in );
+    exit( 1 );
   }
 
 #if defined(__FreeBSD__) || defined(__APPLE__)
@@ -456,12 +833,12 @@ void KTraceFilter::execute( char *trace_in, char *trace_out,ProgressController *
   }
 #endif
 
-  ini_progress_bar( trace_name, progress );
+  ini_progress_bar( trace_in, progress );
 
   /* Symbol loading of the .pcf file */
   if ( show_states && !all_states )
   {
-    strcpy( pcf_file, trace_name );
+    strcpy( pcf_file, trace_in );
     c = strrchr( pcf_file, '.' );
     if (is_zip_filter)
     {
@@ -476,23 +853,21 @@ void KTraceFilter::execute( char *trace_in, char *trace_out,ProgressController *
   }
 
   /* Process header */
-  trace_header = ( char * ) malloc( sizeof( char ) * MAX_HEADER_SIZE );
-  if ( !is_zip_filter ) fgets( trace_header, MAX_HEADER_SIZE, infile );
-  else
-  {
-    gzgets( gzInfile, trace_header, MAX_HEADER_SIZE );
-  }
-
-  fprintf( outfile, "%s", trace_header );
-  filter_process_header( trace_header );
-  free( trace_header );
+  filter_process_header( output );
+  fwrite( output.data(), 1, output.size(), outfile );
 
   if ( progress != nullptr )
     end_parsing = progress->getStop();
 
+#if defined(PARALLEL_ENABLED) && !defined(_WIN32)
+  if ( !end_parsing && can_filter_ranges( trace_in ) )
+  {
+    filter_ranges( trace_in, progress );
+    end_parsing = true;
+  }
+#endif
 
   /* Processing the trace records */
-  //int tmpline =0;
   while ( !end_parsing )
   {
     if ( progress != nullptr )
@@ -503,21 +878,11 @@ void KTraceFilter::execute( char *trace_in, char *trace_out,ProgressController *
     }
 
     /* Read one more record is possible */
-    if ( !is_zip_filter )
+    infile->getlineView( lineBegin, lineEnd );
+    if ( lineBegin == lineEnd && infile->eof() )
     {
-      if ( fgets( line, sizeof( line ), infile ) == nullptr )
-      {
-        end_parsing = true;
-        continue;
-      }
-    }
-    else
-    {
-      if ( gzgets( gzInfile, line, sizeof( line ) ) == nullptr )
-      {
-        end_parsing = true;
-        continue;
-      }
+      end_parsing = true;
+      continue;
     }
 
     if ( num_iters == total_iters )
@@ -528,307 +893,12 @@ void KTraceFilter::execute( char *trace_in, char *trace_out,ProgressController *
     else
       num_iters++;
 
-    std::ostringstream event_record;
-
-    // std::cout << tmpline++ << std::endl;
-
-    /* 1: state; 2: event; 3: comm; 4: global comm */
-    switch ( line[0] )
-    {
-      case '1':
-        if ( !show_states )
-          break;
-
-        sscanf( line, "%*d:%*d:%*d:%*d:%*d:%lld:%lld:%d\n", &time_1, &time_2, &state );
-
-        if ( !all_states )
-        {
-          for ( i = 0; i < states_info.last_id; i++ )
-            if ( states_info.ids[i] == state )
-              break;
-
-          if ( i == states_info.last_id )
-            break;
-        }
-
-        if ( ( !min_state_time ) || ( time_2 - time_1 >= min_state_time ) )
-        {
-          if ( !filter_by_call_time )
-            fputs( line, outfile );
-          else
-          {
-            /* Insert on event buffer */
-            if ( ( new_elem = ( struct buffer_elem * )malloc( sizeof( struct buffer_elem ) ) ) == nullptr )
-            {
-              printf( "NO MORE MEMORY!\n" );
-              exit( 1 );
-            }
-
-            new_elem->record = strdup( line );
-            new_elem->dump = true;
-            new_elem->appl = appl;
-            new_elem->task = task;
-            new_elem->thread = thread;
-            new_elem->next = nullptr;
-
-            if ( buffer_first == nullptr )
-            {
-              buffer_first = new_elem;
-              buffer_last = new_elem;
-            }
-
-            buffer_last->next = new_elem;
-            buffer_last = new_elem;
-          }
-        }
-
-        break;
-
-      case '2':
-        if ( !show_events )
-          break;
-
-        if ( filter_all_types )
-        {
-          fputs( line, outfile );
-          break;
-        }
-
-        sscanf( line, "%*d:%d:%d:%d:%d:%lld:%*s\n", &cpu, &appl, &task, &thread, &time_1 );
-
-        i = 0;
-        num_char = 0;
-        while ( 1 )
-        {
-          if ( line[i] == ':' )
-          {
-            num_char++;
-            if ( num_char == 6 )
-            {
-              // line[i] = '\0';
-              break;
-            }
-          }
-          i++;
-        }
-
-        //sprintf( event_record, "2:%d:%d:%d:%d:%lld", cpu, appl, task, thread, time_1 );
-        event_record << "2:" << cpu << ":" << appl << ":" << task << ":" << thread << ":" << time_1;
-
-        call_in = false;
-        dump_event_buffer = false;
-
-        /* Event type and values */
-        end_line = false;
-        print_record = false;
-        word = strtok( &line[i+1], ":" );
-        type = atoll( word );
-        word = strtok( nullptr, ":" );
-        value = atoll( word );
-
-        if ( translationTable.size() > 0 )
-        {
-          TTypeValuePair p = std::make_pair( type, value );
-
-          std::map< TTypeValuePair, TTypeValuePair >::const_iterator it = translationTable.find(p);
-          if ( it != translationTable.end() )
-          {
-            type  = it->second.first;
-            value = it->second.second;
-          }
-        }
-
-        if ( ( i = filter_allowed_type( appl, task, thread, time_1, type, value ) ) > 0 )
-        {
-          print_record = true;
-          //sprintf( event_record, "%s:%lld:%lld", event_record, type, value );
-          event_record << ":" << type << ":" << value;
-
-          if ( i == 2 )
-          {
-            if ( value > 0 ) call_in = true;
-            else dump_event_buffer = true;
-          }
-        }
-
-        while ( !end_line )
-        {
-          if ( ( word = strtok( nullptr, ":" ) ) != nullptr )
-          {
-            type = atoll( word );
-            word = strtok( nullptr, ":" );
-            value = atoll( word );
-
-            if ( translationTable.size() > 0 )
-            {
-              TTypeValuePair p = std::make_pair( type, value );
-
-              std::map< TTypeValuePair, TTypeValuePair >::const_iterator it = translationTable.find(p);
-              if ( it != translationTable.end() )
-              {
-                type  = it->second.first;
-                value = it->second.second;
-              }
-            }
-
-            if ( ( i = filter_allowed_type( appl, task, thread, time_1, type, value ) ) > 0 )
-            {
-              print_record = true;
-              //sprintf( event_record, "%s:%lld:%lld", event_record, type, value );
-              event_record << ":" << type << ":" << value;
-
-              if ( i == 2 )
-              {
-                if ( value > 0 )
-                  call_in = true;
-                else
-                  dump_event_buffer = true;
-              }
-            }
-          }
-          else
-          {
-            end_line = true;
-            //sprintf( event_record, "%s\n", event_record );
-            event_record << std::endl;
-          }
-        }
-
-        if ( print_record )
-        {
-          if ( !filter_by_call_time )
-          {
-            fputs( event_record.str().c_str(), outfile );
-          }
-          else
-          {
-            /* Insert on buffer */
-            if ( ( new_elem = ( struct buffer_elem * )malloc( sizeof( struct buffer_elem ) ) ) == nullptr )
-            {
-              printf( "NO MORE MEMORY!!\n" );
-              exit( 1 );
-            }
-
-            new_elem->record = strdup( event_record.str().c_str() );
-
-            if ( call_in )
-              new_elem->dump = false;
-            else
-              new_elem->dump = true;
-
-            new_elem->appl = appl;
-            new_elem->task = task;
-            new_elem->thread = thread;
-            new_elem->event_time = time_1;
-            new_elem->next = nullptr;
-
-            if ( buffer_first == nullptr )
-              buffer_first = new_elem;
-
-            if ( buffer_last == nullptr )
-              buffer_last = new_elem;
-            else
-            {
-              buffer_last->next = new_elem;
-              buffer_last = new_elem;
-            }
-
-            if ( call_in )
-              thread_call_info[appl][task][thread] = new_elem;
-
-            if ( dump_event_buffer )
-            {
-              if ( thread_call_info[appl][task][thread] != nullptr )
-                thread_call_info[appl][task][thread]->dump = true;
-
-              dump_buffer();
-              thread_call_info[appl][task][thread] = nullptr;
-            }
-          }
-        }
-
-        break;
-
-      case '3':
-        if ( !show_comms )
-          break;
-
-        if ( exec_options->min_comm_size > 0 )
-        {
-          sscanf( line, "%*d:%*d:%*d:%*d:%*d:%*d:%*d:%*d:%*d:%*d:%*d:%*d:%*d:%d:%*d\n", &size );
+    output.clear();
+    filter_record( lineBegin, lineEnd, output );
+    fwrite( output.data(), 1, output.size(), outfile );
 
-          if ( size < exec_options->min_comm_size )
-            break;
-        }
-
-
-        if ( !filter_by_call_time )
-          fputs( line, outfile );
-        else
-        {
-          /* Insert on event buffer */
-          if ( ( new_elem = ( struct buffer_elem * )malloc( sizeof( struct buffer_elem ) ) ) == nullptr )
-          {
-            printf( "NO MORE MEMORY!!!\n" );
-            exit( 1 );
-          }
-
-          new_elem->record = strdup( line );
-          new_elem->dump = true;
-          new_elem->appl = appl;
-          new_elem->task = task;
-          new_elem->thread = thread;
-          new_elem->next = nullptr;
-
-          if ( buffer_first == nullptr )
-          {
-            buffer_first = new_elem;
-            buffer_last = new_elem;
-          }
-
-          buffer_last->next = new_elem;
-          buffer_last = new_elem;
-        }
-        break;
-
-
-      case '4':
-        if ( !filter_by_call_time )
-          fputs( line, outfile );
-        else
-        {
-          /* Insert on event buffer */
-          if ( ( new_elem = ( struct buffer_elem * )malloc( sizeof( struct buffer_elem ) ) ) == nullptr )
-          {
-            printf( "NO MORE MEMORY!!!!\n" );
-            exit( 1 );
-          }
-
-          new_elem->record = strdup( line );
-          new_elem->dump = true;
-          new_elem->appl = appl;
-          new_elem->task = task;
-          new_elem->thread = thread;
-          new_elem->next = nullptr;
-
-          if ( buffer_first == nullptr )
-          {
-            buffer_first = new_elem;
-            buffer_last = new_elem;
-          }
-
-          buffer_last->next = new_elem;
-          buffer_last = new_elem;
-        }
-        break;
-
-      case '#':
-        fputs( line, outfile );
-        break;
-
-      default:
-        break;
-    }
+    if ( infile->eof() )
+      end_parsing = true;
   }
 
   /* Dumping the elems left in the buffer */
@@ -851,12 +921,8 @@ void KTraceFilter::execute( char *trace_in, char *trace_out,ProgressController *
 
   /* Close the files */
   fclose( outfile );
-  if ( !is_zip_filter )
-    fclose( infile );
-  else
-    gzclose( gzInfile );
+  infile->close();
+  delete infile;
 
-//  free( event_record );
-  free( trace_name );
   free( pcf_file );
 }
@@ -0,0 +1,233 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                               libparaver-api                              *
+ *                       Paraver Main Computing Library                      *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+
+
+// Stress test of concurrent trace loading: synthetic traces, some of them
+// gzipped, are loaded once serially and then all at the same time from
+// several threads, every trace by two of them. Every concurrent load must
+// give the same records as the serial one.
+// Usage: ktraceloadtest [traces] [rounds]
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "ktrace.h"
+
+using namespace std;
+
+namespace
+{
+  // Sorted by begin time, like the tracer writes them
+  string buildTrace( unsigned int seed )
+  {
+    mt19937_64 generator( seed );
+    unsigned int numTasks = 4 + generator() % 13;
+    unsigned long long endTime = 0;
+    vector< tuple< unsigned long long, unsigned int, string > > records;
+
+    for ( unsigned int iTask = 1; iTask <= numTasks; ++iTask )
+    {
+      string location = to_string( iTask ) + ":1:" + to_string( iTask ) + ":1:";
+      unsigned long long time = generator() % 100;
+      // Some threads get long states, as open states at a cut would be
+      unsigned long long maxDuration = iTask % 4 == 0 ? 1000000 : 1000;
+      while ( time < 500000 )
+      {
+        unsigned long long stateEnd = time + 1 + generator() % maxDuration;
+        records.emplace_back( time, records.size(),
+                              "1:" + location + to_string( time ) + ":" + to_string( stateEnd ) + ":" + to_string( generator() % 16 ) );
+
+        string tmpEvent = "2:" + location + to_string( time );
+        for ( unsigned int iPair = 0; iPair < 1 + generator() % 3; ++iPair )
+          tmpEvent += ":" + to_string( 50000000 + generator() % 10 ) + ":" + to_string( generator() % 1000 );
+        records.emplace_back( time, records.size(), tmpEvent );
+
+        if ( generator() % 8 == 0 )
+        {
+          unsigned int partner = 1 + generator() % numTasks;
+          unsigned long long receive = time + 1 + generator() % 500;
+          records.emplace_back( time, records.size(),
+                                "3:" + location + to_string( time ) + ":" + to_string( time ) + ":" +
+                                to_string( partner ) + ":1:" + to_string( partner ) + ":1:" +
+                                to_string( receive ) + ":" + to_string( receive ) + ":" +
+                                to_string( generator() % 100000 ) + ":" + to_string( generator() % 100 ) );
+        }
+
+        endTime = max( endTime, stateEnd );
+        time = stateEnd;
+      }
+    }
+    sort( records.begin(), records.end() );
+
+    ostringstream trace;
+    trace << "#Paraver (01/01/2020 at 10:00):" << endTime << "_ns:1(" << numTasks << "):1:" << numTasks << "(";
+    for ( unsigned int iTask = 1; iTask <= numTasks; ++iTask )
+      trace << ( iTask > 1 ? "," : "" ) << "1:1";
+    trace << ")\n";
+    for ( const auto& record : records )
+      trace << get< 2 >( record ) << "\n";
+
+    return trace.str();
+  }
+
+  bool writeTrace( const string& fileName, const string& contents )
+  {
+    if ( fileName.substr( fileName.length() - 3 ) == ".gz" )
+    {
+      gzFile file = gzopen( fileName.c_str(), "wb" );
+      if ( file == nullptr )
+        return false;
+      bool written = gzwrite( file, contents.data(), contents.size() ) == static_cast< int >( contents.size() );
+      return gzclose( file ) == Z_OK && written;
+    }
+
+    FILE *file = fopen( fileName.c_str(), "w" );
+    if ( file == nullptr )
+      return false;
+    bool written = fwrite( contents.data(), 1, contents.size(), file ) == contents.size();
+    return fclose( file ) == 0 && written;
+  }
+
+  // Every record of every thread and CPU, and the communications
+  string loadTrace( const string& fileName )
+  {
+    ostringstream result;
+    result << fixed << setprecision( 0 );
+
+    try
+    {
+      KTrace trace( fileName, nullptr, false );
+
+      for ( TThreadOrder iThread = 0; iThread < trace.totalThreads(); ++iThread )
+      {
+        // Past the empty record at the beginning
+        MemoryTrace::iterator *it = trace.threadBegin( iThread );
+        for ( ++( *it ); !it->isNull(); ++( *it ) )
+        {
+          result << "T" << iThread << " " << it->getTime() << " " << it->getRecordType();
+          if ( it->getRecordType() & STATE )
+            result << " " << it->getState() << " " << it->getStateEndTime();
+          else if ( it->getRecordType() & EVENT )
+            result << " " << it->getEventType() << " " << it->getEventValueAsIs();
+          result << "\n";
+        }
+        delete it;
+      }
+
+      for ( TCPUOrder iCPU = 0; iCPU < trace.totalCPUs(); ++iCPU )
+      {
+        MemoryTrace::iterator *it = trace.CPUBegin( iCPU );
+        for ( ++( *it ); !it->isNull(); ++( *it ) )
+          result << "C" << iCPU << " " << it->getTime() << " " << it->getRecordType() << " " << it->getThread() << "\n";
+        delete it;
+      }
+
+      for ( TCommID iComm = 0; iComm < trace.getTotalComms(); ++iComm )
+        result << "M" << trace.getSenderThread( iComm ) << " " << trace.getReceiverThread( iComm ) << " "
+               << trace.getPhysicalSend( iComm ) << " " << trace.getPhysicalReceive( iComm ) << " "
+               << trace.getCommSize( iComm ) << " " << trace.getCommTag( iComm ) << "\n";
+
+      result << "end " << trace.getEndTime() << "\n";
+    }
+    catch ( ... )
+    {
+      result << "exception\n";
+    }
+
+    return result.str();
+  }
+}
+
+
+int main( int argc, char *argv[] )
+{
+  unsigned int numTraces = argc > 1 ? atoi( argv[ 1 ] ) : 6;
+  unsigned int numRounds = argc > 2 ? atoi( argv[ 2 ] ) : 2;
+
+  char tmpDir[] = "/tmp/ktraceloadtestXXXXXX";
+  if ( mkdtemp( tmpDir ) == nullptr )
+  {
+    cerr << "Cannot create a temporary directory" << endl;
+    return EXIT_FAILURE;
+  }
+
+  vector< string > fileNames;
+  vector< string > expected;
+  bool ok = true;
+  for ( unsigned int iTrace = 0; iTrace < numTraces && ok; ++iTrace )
+  {
+    fileNames.push_back( string( tmpDir ) + "/trace" + to_string( iTrace ) + ( iTrace % 3 == 2 ? ".prv.gz" : ".prv" ) );
+    ok = writeTrace( fileNames.back(), buildTrace( iTrace + 1 ) );
+    if ( ok )
+    {
+      expected.push_back( loadTrace( fileNames.back() ) );
+      ok = expected.back().find( "exception" ) == string::npos;
+      if ( !ok )
+        cerr << "Cannot load " << fileNames.back() << endl;
+    }
+  }
+
+  for ( unsigned int iRound = 0; iRound < numRounds && ok; ++iRound )
+  {
+    // Two threads per trace
+    vector< string > results( 2 * numTraces );
+    vector< thread > loaders;
+    for ( unsigned int iLoad = 0; iLoad < results.size(); ++iLoad )
+      loaders.emplace_back( [&, iLoad]() { results[ iLoad ] = loadTrace( fileNames[ iLoad / 2 ] ); } );
+    for ( thread& loader : loaders )
+      loader.join();
+
+    for ( unsigned int iLoad = 0; iLoad < results.size(); ++iLoad )
+    {
+      if ( results[ iLoad ] != expected[ iLoad / 2 ] )
+      {
+        cerr << "Round " << iRound << ": " << fileNames[ iLoad / 2 ] << " differs from its serial load" << endl;
+        ok = false;
+      }
+    }
+  }
+
+  for ( const string& fileName : fileNames )
+  {
+    unlink( fileName.c_str() );
+    unlink( ( fileName + ".gzi" ).c_str() );
+  }
+  rmdir( tmpDir );
+
+  if ( ok )
+    cout << numTraces << " traces loaded concurrently " << numRounds << " times, same as serially" << endl;
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
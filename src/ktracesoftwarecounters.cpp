@@ -33,18 +33,41 @@
 #ifndef _WIN32
 #include <unistd.h>
 #endif
+#include <algorithm>
+#include <functional>
+#include <queue>
 #include <sstream>
 
 #include "ktracesoftwarecounters.h"
 #include "ktraceoptions.h"
 #include "kprogresscontroller.h"
 //#include "filters_wait_window.h"
-#include "paraverconfig.h"
+#include "tracestream.h"
+#include "utils/traceparser/prvtokenizer.h"
 
 #ifdef _WIN32
 #define atoll _atoi64
+#define strtok_r strtok_s
 #endif
 
+
+static inline size_t counter_hash( unsigned long long type, unsigned long long value )
+{
+  unsigned long long hash = ( type * 0x9E3779B97F4A7C15ULL ) ^ ( ( value + 0x632BE59BD9B4E019ULL ) * 0xC2B2AE3D27D4EB4FULL );
+
+  return hash ^ ( hash >> 29 );
+}
+
+
+/* Exact for up to 65535 applications and 2^24 tasks and threads */
+static inline unsigned long long thread_key( int appl, int task, int thread )
+{
+  return ( (unsigned long long)( appl & 0xFFFF ) << 48 ) |
+         ( (unsigned long long)( task & 0xFFFFFF ) << 24 ) |
+         (unsigned long long)( thread & 0xFFFFFF );
+}
+
+
 KTraceSoftwareCounters::KTraceSoftwareCounters( char *trace_in,
                                                 char *trace_out,
                                                 TraceOptions *options,
@@ -56,7 +79,7 @@ KTraceSoftwareCounters::KTraceSoftwareCounters( char *trace_in,
   keep_events = false;
   frequency = 1;
   total_iters = 0;
-  first_state_elem = nullptr;
+  free_events = nullptr;
 
   exec_options = new KTraceOptions( (KTraceOptions *) options );
 
@@ -73,6 +96,7 @@ KTraceSoftwareCounters::~KTraceSoftwareCounters()
 /* Function for parsing program arguments */
 void KTraceSoftwareCounters::read_sc_args()
 {
+  char *tokenState;
   int i, j, k;
   char *words[16], *word_type, *word_values, *word_value;
 
@@ -99,29 +123,29 @@ void KTraceSoftwareCounters::read_sc_args()
   if ( strlen( exec_options->types ) > 0 )
   {
     all_types = false;
-    words[0] = strtok( exec_options->types, ";" );
+    words[0] = strtok_r( exec_options->types, ";", &tokenState );
 
     i = 1;
-    while ( ( words[i] = strtok( nullptr, ";" ) ) != nullptr )
+    while ( ( words[i] = strtok_r( nullptr, ";", &tokenState ) ) != nullptr )
       i++;
 
     k = 0;
     while ( k < i )
     {
-      word_type = strtok( words[k], ":" );
+      word_type = strtok_r( words[k], ":", &tokenState );
       types.type_values[types.next_free_slot].type = atoll( word_type );
-      if ( ( word_values = strtok( nullptr, ":" ) ) == nullptr )
+      if ( ( word_values = strtok_r( nullptr, ":", &tokenState ) ) == nullptr )
       {
         types.type_values[types.next_free_slot].all_values = true;
       }
       else
       {
-        word_value = strtok( word_values, "," );
+        word_value = strtok_r( word_values, ",", &tokenState );
         types.type_values[types.next_free_slot].all_values = false;
         types.type_values[types.next_free_slot].values[0] = atoll( word_value );
         types.type_values[types.next_free_slot].values[1] = 0;
         j = 1;
-        while ( ( word_value = strtok( nullptr, "," ) ) != nullptr )
+        while ( ( word_value = strtok_r( nullptr, ",", &tokenState ) ) != nullptr )
         {
           types.type_values[types.next_free_slot].values[j] = atoll( word_value );
           j++;
@@ -139,11 +163,11 @@ void KTraceSoftwareCounters::read_sc_args()
   if ( strlen( exec_options->types_kept ) > 0 )
   {
     keep_events = true;
-    words[0] = strtok( exec_options->types_kept, ";" );
+    words[0] = strtok_r( exec_options->types_kept, ";", &tokenState );
     types_to_keep.type[types_to_keep.next_free_slot] = atoll( words[0] );
     types_to_keep.next_free_slot++;
 
-    while ( ( words[0] = strtok( nullptr, ";" ) ) != nullptr )
+    while ( ( words[0] = strtok_r( nullptr, ";", &tokenState ) ) != nullptr )
     {
       types_to_keep.type[types_to_keep.next_free_slot] = atoll( words[0] );
       types_to_keep.next_free_slot++;
@@ -166,43 +190,214 @@ void KTraceSoftwareCounters::read_sc_args()
 
 
 /* For processing the Paraver header */
-void KTraceSoftwareCounters::proces_header( char *header, FILE *in, FILE *out )
+void KTraceSoftwareCounters::proces_header()
 {
   int num_comms = 0;
-  char *word;
+  std::string header;
+  std::string::size_type pos, timeBegin, timeEnd;
 
-  fprintf( out, "%s", header );
+  infile->getline( header );
+  fprintf( outfile, "%s\n", header.c_str() );
 
   /* Get the number of communicators*/
-  word = strrchr( header, ',' );
-  if ( word != nullptr )
-  {
-    strcpy( line, word + 1 );
-    if ( strchr( line, ')' ) == nullptr )
-      num_comms = atoi( line );
-  }
+  pos = header.rfind( ',' );
+  if ( pos != std::string::npos && header.find( ')', pos ) == std::string::npos )
+    num_comms = atoi( header.c_str() + pos + 1 );
 
   /* Obtaining the trace total time */
   // #Paraver (12/03/2018 at 16:11:35.687574899):123_ns:
-  word = strtok( header, ")" );
-  word = strtok( nullptr, ":" );
-  char *tmpTimeUnitSuffix = strstr( word, "_" );
-  if ( tmpTimeUnitSuffix )
+  trace_time = 0;
+  pos = header.find( ')' );
+  if ( pos != std::string::npos )
   {
-    word[ strlen( word ) - strlen( tmpTimeUnitSuffix ) ] = '\0';
+    timeBegin = header.find_first_not_of( ':', pos + 1 );
+    if ( timeBegin != std::string::npos )
+    {
+      timeEnd = header.find_first_of( ":_", timeBegin );
+      trace_time = atoll( header.substr( timeBegin, timeEnd - timeBegin ).c_str() );
+    }
   }
-  trace_time = atoll( word );
 
   /* Copy communicators */
-  while ( num_comms > 0 )
+  while ( num_comms > 0 && !infile->eof() )
   {
-    fgets( header, MAX_HEADER_SIZE, in );
-    fprintf( out, "%s", header );
+    infile->getline( header );
+    fprintf( outfile, "%s\n", header.c_str() );
     num_comms--;
   }
 }
 
 
+/* Gives the common fields of the next state or event record and the range */
+/* of its remaining fields. Comments and unknown lines are skipped */
+bool KTraceSoftwareCounters::read_record( int& id, int& cpu, int& appl, int& task, int& thread,
+                                          unsigned long long& time, const char *&fields, const char *&fieldsEnd )
+{
+  const char *lineBegin;
+
+  while ( true )
+  {
+    infile->getlineView( lineBegin, fieldsEnd );
+    if ( lineBegin == fieldsEnd && infile->eof() )
+      return false;
+
+    fields = lineBegin;
+    if ( prvReadField( fields, fieldsEnd, id ) &&
+         prvReadField( fields, fieldsEnd, cpu ) &&
+         prvReadField( fields, fieldsEnd, appl ) &&
+         prvReadField( fields, fieldsEnd, task ) &&
+         prvReadField( fields, fieldsEnd, thread ) &&
+         prvReadField( fields, fieldsEnd, time ) )
+      return true;
+
+    if ( infile->eof() )
+      return false;
+  }
+}
+
+
+int KTraceSoftwareCounters::find_thread( int appl, int task, int thread ) const
+{
+  std::unordered_map< unsigned long long, int >::const_iterator it = thread_pointer.find( thread_key( appl, task, thread ) );
+
+  if ( it == thread_pointer.end() )
+    return -1;
+
+  return it->second;
+}
+
+
+/* We create the thread in the struct saving: appl, task, thread, */
+/* an empty counters list, and an empty call stack */
+int KTraceSoftwareCounters::new_thread( int appl, int task, int thread )
+{
+  struct thread_info newThread;
+
+  newThread.appl = appl;
+  newThread.task = task;
+  newThread.thread = thread;
+  newThread.calls.top = -1;
+  newThread.last_time_of_sc = 0;
+  newThread.ini_burst_time = 0;
+  newThread.end_burst_time = 0;
+  newThread.total_burst_time = 0;
+  newThread.first_event_counter = nullptr;
+  newThread.last_event_counter = nullptr;
+
+  threads.push_back( std::move( newThread ) );
+  thread_pointer[ thread_key( appl, task, thread ) ] = threads.size() - 1;
+
+  return threads.size() - 1;
+}
+
+
+/* Counters are keyed by type, and also by value unless they are global or accumulated */
+int KTraceSoftwareCounters::find_counter( const struct thread_info& whichThread,
+                                          unsigned long long type, unsigned long long value ) const
+{
+  size_t mask, pos;
+  bool byValue = !global_counters && !acumm_values;
+
+  if ( whichThread.counter_index.empty() )
+    return -1;
+
+  mask = whichThread.counter_index.size() - 1;
+  pos = counter_hash( type, byValue ? value : 0 ) & mask;
+  while ( whichThread.counter_index[ pos ] != -1 )
+  {
+    const struct counter& tmpCounter = whichThread.counters[ whichThread.counter_index[ pos ] ];
+    if ( tmpCounter.type == type && ( tmpCounter.value == value || !byValue ) )
+      return whichThread.counter_index[ pos ];
+
+    pos = ( pos + 1 ) & mask;
+  }
+
+  return -1;
+}
+
+
+int KTraceSoftwareCounters::add_counter( struct thread_info& whichThread,
+                                         unsigned long long type, unsigned long long value )
+{
+  struct counter newCounter;
+
+  newCounter.type = type;
+  newCounter.value = value;
+  newCounter.num = 0;
+  newCounter.last_is_zero = false;
+  whichThread.counters.push_back( newCounter );
+
+  /* Keeping the table at most half full */
+  if ( whichThread.counters.size() * 2 > whichThread.counter_index.size() )
+  {
+    whichThread.counter_index.assign( std::max( (size_t)16, whichThread.counter_index.size() * 2 ), -1 );
+    for ( size_t i = 0; i < whichThread.counters.size(); ++i )
+      index_counter( whichThread, i );
+  }
+  else
+    index_counter( whichThread, whichThread.counters.size() - 1 );
+
+  return whichThread.counters.size() - 1;
+}
+
+
+void KTraceSoftwareCounters::index_counter( struct thread_info& whichThread, int whichCounter )
+{
+  size_t mask = whichThread.counter_index.size() - 1;
+  const struct counter& tmpCounter = whichThread.counters[ whichCounter ];
+  size_t pos = counter_hash( tmpCounter.type, global_counters || acumm_values ? 0 : tmpCounter.value ) & mask;
+
+  while ( whichThread.counter_index[ pos ] != -1 )
+    pos = ( pos + 1 ) & mask;
+
+  whichThread.counter_index[ pos ] = whichCounter;
+}
+
+
+struct KTraceSoftwareCounters::counter_event *KTraceSoftwareCounters::new_counter_event()
+{
+  struct counter_event *event;
+
+  if ( free_events == nullptr )
+  {
+    event_blocks.emplace_back( new struct counter_event[ EVENT_BLOCK_SIZE ] );
+    for ( size_t i = 0; i < EVENT_BLOCK_SIZE; ++i )
+    {
+      event_blocks.back()[ i ].next = free_events;
+      free_events = &event_blocks.back()[ i ];
+    }
+  }
+
+  event = free_events;
+  free_events = event->next;
+  event->next = nullptr;
+
+  return event;
+}
+
+
+void KTraceSoftwareCounters::free_counter_event( struct counter_event *event )
+{
+  event->next = free_events;
+  free_events = event;
+}
+
+
+void KTraceSoftwareCounters::append_counter_event( struct thread_info& whichThread, struct counter_event *event )
+{
+  if ( whichThread.first_event_counter == nullptr )
+  {
+    whichThread.first_event_counter = event;
+    whichThread.last_event_counter = event;
+  }
+  else
+  {
+    whichThread.last_event_counter->next = event;
+    whichThread.last_event_counter = event;
+  }
+}
+
+
 /* For copy .pcf and add the counter types and values */
 void KTraceSoftwareCounters::write_pcf( char *file_out )
 {
@@ -303,55 +498,29 @@ int KTraceSoftwareCounters::inc_counter( int appl, int task, int thread, unsigne
 {
   int i, j;
 
-  /* If the pointer is -1, we haven't registered yet the thread into the */
-  /* threads struct. We create the thread in the struct saving:appl, task, */
-  /* thread, create a empty counters list, and an empty call stack */
-  if ( ( i = thread_pointer[appl][task][thread] ) == -1 )
-  {
-    threads[next_thread_slot].appl = appl;
-    threads[next_thread_slot].task = task;
-    threads[next_thread_slot].thread = thread;
-    threads[next_thread_slot].next_free_counter = 0;
-    threads[next_thread_slot].calls.top = -1;
-    i = next_thread_slot;
-    next_thread_slot++;
-    thread_pointer[appl][task][thread] = i;
-  }
+  /* If the thread isn't found, we haven't registered it yet */
+  if ( ( i = find_thread( appl, task, thread ) ) == -1 )
+    i = new_thread( appl, task, thread );
 
   if ( ( all_types && value > 0 ) || allowed_type( type, value ) )
   {
     /* Searching of the specified counter for the given thread */
-    for ( j = 0; j < threads[i].next_free_counter; j++ )
+    if ( ( j = find_counter( threads[i], type, value ) ) != -1 )
     {
-      if ( threads[i].counters[j].type == type && ( threads[i].counters[j].value == value || global_counters || acumm_values ) )
-      {
-        if ( !acumm_values )
-          threads[i].counters[j].num++;
-        else
-        {
-          threads[i].counters[j].num += value;
-
-        }
-        break;
-      }
+      if ( !acumm_values )
+        threads[i].counters[j].num++;
+      else
+        threads[i].counters[j].num += value;
     }
-
-    /* The counter doesn't exist. Create it */
-    if ( j == threads[i].next_free_counter )
+    else
     {
-      threads[i].counters[j].type = type;
-      threads[i].counters[j].value = value;
-      threads[i].counters[j].last_is_zero = false;
+      /* The counter doesn't exist. Create it */
+      j = add_counter( threads[i], type, value );
 
       if ( !acumm_values )
         threads[i].counters[j].num = 1;
       else
         threads[i].counters[j].num = value;
-
-      threads[i].next_free_counter++;
-
-//std::cout << "next_free_counter=" << threads[i].next_free_counter << std::endl;
-//std::cout << "type=" << threads[i].next_free_counter << std::endl;
     }
   }
 
@@ -366,10 +535,10 @@ void KTraceSoftwareCounters::put_zeros( void )
   unsigned long long type_mask;
 
   /* We pass over all the threads in the struct */
-  for ( i = 0; i < next_thread_slot; i++ )
+  for ( i = 0; i < (int)threads.size(); i++ )
   {
     /* For every thread, we look over all its counters */
-    for ( j = 0; j < threads[i].next_free_counter; j++ )
+    for ( j = 0; j < (int)threads[i].counters.size(); j++ )
     {
       /* If we have to put a counter and in the last interval we haven't */
       /* put any counter of the same type and value, it's time to put */
@@ -428,7 +597,7 @@ void KTraceSoftwareCounters::flush_all_events( void )
         /* After that, we upgrade the call stack for the current */
         /* thread*/
         thread_id = p->thread_id;
-        for ( j = 0; j < threads[thread_id].next_free_counter; j++ )
+        for ( j = 0; j < (int)threads[thread_id].counters.size(); j++ )
         {
           if ( threads[thread_id].counters[j].type == p->type[i] && ( threads[thread_id].counters[j].value == p->value[i] || global_counters ) )
           {
@@ -454,7 +623,7 @@ void KTraceSoftwareCounters::flush_all_events( void )
 
         /* Don't exist counter for that type-value, we have to put */
         /* this event on the trace */
-        if ( j == threads[thread_id].next_free_counter )
+        if ( j == (int)threads[thread_id].counters.size() )
         {
           //sprintf( record_aux, ":%lld:%lld", p->type[i], p->value[i] );
           //strcat( record, record_aux );
@@ -517,10 +686,10 @@ void KTraceSoftwareCounters::put_all_counters( void )
   unsigned long long type_mask;
 
   /* We pass over all the threads on the struct */
-  for ( i = 0; i < next_thread_slot; i++ )
+  for ( i = 0; i < (int)threads.size(); i++ )
   {
     /* For every thread, we pass over all its counters */
-    for ( j = 0; j < threads[i].next_free_counter; j++ )
+    for ( j = 0; j < (int)threads[i].counters.size(); j++ )
     {
       if ( acumm_values )
         type_mask = threads[i].counters[j].type;
@@ -557,20 +726,11 @@ void KTraceSoftwareCounters::put_counters_by_thread( int appl, int task, int thr
   struct counter_event *event;
 
   /* We search the thread on the struct */
-  for ( i = 0; i < next_thread_slot; i++ )
-  {
-    if ( threads[i].appl == appl && threads[i].task == task && threads[i].thread == thread ) break;
-  }
-
-  if ( i == next_thread_slot )
+  if ( ( i = find_thread( appl, task, thread ) ) == -1 )
     return;
 
   /* First of all put zeros if needed */
-  if ( i == next_thread_slot )
-    return;
-
-  /* First of all put zeros if needed */
-  for ( j = 0; j < threads[i].next_free_counter; j++ )
+  for ( j = 0; j < (int)threads[i].counters.size(); j++ )
   {
     if ( !global_counters )
     {
@@ -582,35 +742,20 @@ void KTraceSoftwareCounters::put_counters_by_thread( int appl, int task, int thr
 
     if ( threads[i].counters[j].num >= ( unsigned long long )frequency && !threads[i].counters[j].last_is_zero )
     {
-      if ( ( event = ( struct counter_event * )malloc( sizeof( struct counter_event ) ) ) == nullptr )
-      {
-        perror( "No more memory!!!!\n" );
-        exit( 1 );
-      }
-
+      event = new_counter_event();
       event->cpu = cpu;
       event->time = threads[i].last_time_of_sc;
       event->type = type_mask;
       event->value = 0;
-      event->next = nullptr;
 
       threads[i].counters[j].last_is_zero = true;
 
-      if ( threads[thread_pointer[appl][task][thread]].first_event_counter == nullptr )
-      {
-        threads[thread_pointer[appl][task][thread]].first_event_counter = event;
-        threads[thread_pointer[appl][task][thread]].last_event_counter = event;
-      }
-      else
-      {
-        threads[thread_pointer[appl][task][thread]].last_event_counter->next = event;
-        threads[thread_pointer[appl][task][thread]].last_event_counter = event;
-      }
+      append_counter_event( threads[i], event );
     }
   }
 
   /* we pass over all its counters */
-  for ( j = 0; j < threads[i].next_free_counter; j++ )
+  for ( j = 0; j < (int)threads[i].counters.size(); j++ )
   {
     if ( !global_counters )
     {
@@ -622,30 +767,15 @@ void KTraceSoftwareCounters::put_counters_by_thread( int appl, int task, int thr
 
     if ( threads[i].counters[j].num >= ( unsigned long long )frequency )
     {
-      if ( ( event = ( struct counter_event * )malloc( sizeof( struct counter_event ) ) ) == nullptr )
-      {
-        perror( "No more memory!!!!\n" );
-        exit( 1 );
-      }
-
+      event = new_counter_event();
       event->cpu = cpu;
       event->time = last_time;
       event->type = type_mask;
       event->value = threads[i].counters[j].num;
-      event->next = nullptr;
 
       threads[i].counters[j].last_is_zero = false;
 
-      if ( threads[thread_pointer[appl][task][thread]].first_event_counter == nullptr )
-      {
-        threads[thread_pointer[appl][task][thread]].first_event_counter = event;
-        threads[thread_pointer[appl][task][thread]].last_event_counter = event;
-      }
-      else
-      {
-        threads[thread_pointer[appl][task][thread]].last_event_counter->next = event;
-        threads[thread_pointer[appl][task][thread]].last_event_counter = event;
-      }
+      append_counter_event( threads[i], event );
     }
     threads[i].counters[j].num = 0;
   }
@@ -681,7 +811,11 @@ void KTraceSoftwareCounters::ini_progress_bar( char *file_name, ProgressControll
     exit( 1 );
   }
 #endif
-  total_trace_size = file_info.st_size;
+  // Compressed traces are read by uncompressed offsets
+  if ( is_zip )
+    total_trace_size = TraceStream::getTraceFileSize( file_name );
+  else
+    total_trace_size = file_info.st_size;
 
   /* Depen mida tra\E7a mostrem percentatge amb un interval diferent de temps */
   if ( total_trace_size < 500000000 )
@@ -698,24 +832,7 @@ void KTraceSoftwareCounters::ini_progress_bar( char *file_name, ProgressControll
 
 void KTraceSoftwareCounters::show_progress_bar( ProgressController *progress )
 {
-//  double current_showed, i, j;
-
-#if defined(__FreeBSD__) || defined(__APPLE__)
-  current_read_size = ftello( infile );
-#elif defined(_WIN32)
-  current_read_size = _ftelli64( infile );
-#else
-  current_read_size = ftello64( infile );
-#endif
-
-/*  i = ( double )( current_read_size );
-  j = ( double )( total_trace_size );
-  current_showed = i / j;
-*/
-
-// DOESN'T WORK ON COMPRESSED TRACE
-//  if ( is_zip_filter )
-//    current_read_size = current_read_size / COMPRESSION_RATIO_GZIP;
+  current_read_size = ( unsigned long long )infile->tellg();
 
   if( progress != nullptr)
     progress->setCurrentProgress( current_read_size );
@@ -728,17 +845,11 @@ void KTraceSoftwareCounters::put_counters_on_state_by_thread( int appl, int task
   unsigned long long type_mask;
 
   /* We search the thread on the struct */
-  for ( i = 0; i < next_thread_slot; i++ )
-  {
-    if ( threads[i].appl == appl && threads[i].task == task && threads[i].thread == thread )
-      break;
-  }
-
-  if ( i == next_thread_slot )
+  if ( ( i = find_thread( appl, task, thread ) ) == -1 )
     return;
 
   /* we pass over all its counters */
-  for ( j = 0; j < threads[i].next_free_counter; j++ )
+  for ( j = 0; j < (int)threads[i].counters.size(); j++ )
   {
     if ( acumm_values )
       type_mask = threads[i].counters[j].type;
@@ -783,15 +894,12 @@ void KTraceSoftwareCounters::sc_by_time( ProgressController *progress )
 {
   int id, cpu, appl, task, thread, state;
   unsigned long long time_1, time_2, type, value;
-  // char *word, buffer[MAX_LINE_SIZE];
-  //char *word, *buffer;
-  char *word;
+  const char *fields, *fieldsEnd;
+  std::string buffer; // only for events
   bool print_line = false;
   int thread_id, i, j;
   unsigned long num_iters = 0;
 
-  //buffer = (char *) malloc( sizeof(char) * MAX_LINE_SIZE );
-
   bool end_parsing;
 
   if ( progress != nullptr )
@@ -800,8 +908,7 @@ void KTraceSoftwareCounters::sc_by_time( ProgressController *progress )
     end_parsing = false;
 
   /* Trace processing */
-  while ( fscanf( infile, "%d:%d:%d:%d:%d:%lld:", &id, &cpu, &appl, &task, &thread, &time_1 ) != EOF &&
-          !end_parsing )
+  while ( !end_parsing && read_record( id, cpu, appl, task, thread, time_1, fields, fieldsEnd ) )
   {
     if ( progress != nullptr )
     {
@@ -819,28 +926,17 @@ void KTraceSoftwareCounters::sc_by_time( ProgressController *progress )
     else
       num_iters++;
 
-    std::ostringstream buffer; // only for events
-
     switch ( id )
     {
       case 1:
-        fscanf( infile, "%lld:%d\n", &time_2, &state );
+        if ( !prvReadField( fields, fieldsEnd, time_2 ) || !prvReadField( fields, fieldsEnd, state ) )
+          break;
 
         if ( state != 1 )
           break;
 
-        if ( ( i = thread_pointer[appl][task][thread] ) == -1 )
-        {
-          threads[next_thread_slot].appl = appl;
-          threads[next_thread_slot].task = task;
-          threads[next_thread_slot].thread = thread;
-          threads[next_thread_slot].next_free_counter = 0;
-          threads[next_thread_slot].last_time_of_sc = 0;
-          threads[next_thread_slot].total_burst_time = 0;
-          i = next_thread_slot;
-          next_thread_slot++;
-          thread_pointer[appl][task][thread] = i;
-        }
+        if ( ( i = find_thread( appl, task, thread ) ) == -1 )
+          i = new_thread( appl, task, thread );
 
         threads[i].ini_burst_time = time_1;
         threads[i].end_burst_time = time_2;
@@ -862,105 +958,51 @@ void KTraceSoftwareCounters::sc_by_time( ProgressController *progress )
         break;
 
       case 2:
-        if ( ( i = thread_pointer[appl][task][thread] ) == -1 )
-        {
-          threads[next_thread_slot].appl = appl;
-          threads[next_thread_slot].task = task;
-          threads[next_thread_slot].thread = thread;
-          threads[next_thread_slot].next_free_counter = 0;
-          threads[next_thread_slot].last_time_of_sc = 0;
-          threads[next_thread_slot].ini_burst_time = 0;
-          threads[next_thread_slot].end_burst_time = 0;
-          threads[next_thread_slot].total_burst_time = 0;
-          i = next_thread_slot;
-          next_thread_slot++;
-          thread_pointer[appl][task][thread] = i;
-        }
-
-        /* Flush buffer and put counters */
-        /*                if(time_1 >= (threads[i].last_time_of_sc + interval)) {
-                         last_time = time_1;
-                         put_counters_on_state_by_thread(appl, task, thread);
-                        }
-        */
-        fgets( line, sizeof( line ), infile );
-
-        /* Event type and values */
-        word = strtok( line, ":" );
-        type = atoll( word );
-        word = strtok( nullptr, ":" );
-        value = atoll( word );
+        if ( ( i = find_thread( appl, task, thread ) ) == -1 )
+          i = new_thread( appl, task, thread );
 
         /* For keeping some events */
         if ( keep_events )
         {
-          //sprintf( buffer, "2:%d:%d:%d:%d:%lld:", cpu, appl, task, thread, time_1 );
-          buffer << "2:" << cpu << ":" << appl << ":" << task << ":" << thread << ":" << time_1;
-
-          for ( j = 0; j < types_to_keep.next_free_slot; j++ )
-          {
-            if ( types_to_keep.type[i] == type )
-            {
-              //sprintf( buffer, "%s%lld:%lld", buffer, type, value );
-              buffer << ":" << type << ":" << value;
-              print_line = true;
-              break;
-            }
-          }
-        }
-
-        /* Counting events */
-        if ( only_in_bursts )
-        {
-          if ( time_1 > threads[i].ini_burst_time && time_1 <= threads[i].end_burst_time )
-            thread_id = inc_counter( appl, task, thread, type, value );
+          buffer = "2:" + std::to_string( cpu ) + ":" + std::to_string( appl ) + ":" + std::to_string( task ) +
+                   ":" + std::to_string( thread ) + ":" + std::to_string( time_1 );
         }
-        else
-          thread_id = inc_counter( appl, task, thread, type, value );
 
-        /* Parsing of multiple events on a single line */
-        while ( ( word = strtok( nullptr, ":" ) ) != nullptr )
+        /* Event types and values, maybe multiple events on a single line */
+        while ( prvReadField( fields, fieldsEnd, type ) && prvReadField( fields, fieldsEnd, value ) )
         {
-          type = atoll( word );
-          word = strtok( nullptr, ":" );
-          value = atoll( word );
-
           if ( keep_events )
           {
-            int j;
             for ( j = 0; j < types_to_keep.next_free_slot; j++ )
             {
               if ( types_to_keep.type[i] == type )
               {
-                //sprintf( buffer, "%s%lld:%lld", buffer, type, value );
-                buffer << ":" << type << ":" << value;
+                buffer += ":" + std::to_string( type ) + ":" + std::to_string( value );
                 print_line = true;
                 break;
               }
             }
           }
 
+          /* Counting events */
           if ( only_in_bursts )
           {
             if ( time_1 > threads[i].ini_burst_time && time_1 <= threads[i].end_burst_time )
               thread_id = inc_counter( appl, task, thread, type, value );
           }
           else
-            inc_counter( appl, task, thread, type, value );
+            thread_id = inc_counter( appl, task, thread, type, value );
         }
 
         if ( print_line )
         {
-          buffer << std::endl;
-          //fprintf( outfile, "%s\n", buffer );
-          fprintf( outfile, "%s", buffer.str().c_str() );
+          fprintf( outfile, "%s\n", buffer.c_str() );
           print_line = false;
         }
 
         break;
 
       default:
-        fgets( line, sizeof( line ), infile );
         break;
     }
   }
@@ -969,54 +1011,42 @@ void KTraceSoftwareCounters::sc_by_time( ProgressController *progress )
   last_time = trace_time - 10;
   put_all_counters();
   // ok_sc_wait_window();
-
-  // free( buffer );
 }
 
 
 void KTraceSoftwareCounters::flush_counter_buffers( void )
 {
-  int i, end_flush = 0, current_thread = 0;
-  unsigned long long current_time = 0;
+  int current_thread;
+  unsigned long long current_time;
   struct counter_event *printed_event;
 
-  while ( !end_flush )
+  /* Threads by time of their first event, the lowest thread first on ties */
+  std::priority_queue< std::pair< unsigned long long, int >,
+                       std::vector< std::pair< unsigned long long, int > >,
+                       std::greater< std::pair< unsigned long long, int > > > first_events;
+
+  for ( int i = 0; i < (int)threads.size(); i++ )
   {
-    /* Take the first event */
-    for ( i = 0; i < next_thread_slot; i++ )
-    {
-      if ( threads[i].first_event_counter != nullptr )
-      {
-        current_time = threads[i].first_event_counter->time;
-        current_thread = i;
-        break;
-      }
-    }
-    if ( i == next_thread_slot )
-    {
-      end_flush = 1;
-      continue;
-    }
+    if ( threads[i].first_event_counter != nullptr )
+      first_events.push( std::make_pair( threads[i].first_event_counter->time, i ) );
+  }
 
+  while ( !first_events.empty() )
+  {
     /* Take the event with min time */
-    for ( i = 0; i < next_thread_slot; i++ )
-    {
-      if ( threads[i].first_event_counter != nullptr )
-      {
-        if ( threads[i].first_event_counter->time < current_time )
-        {
-          current_time = threads[i].first_event_counter->time;
-          current_thread = i;
-        }
-      }
-    }
+    current_time = first_events.top().first;
+    current_thread = first_events.top().second;
+    first_events.pop();
 
     /* Put the event on the trace */
     fprintf( outfile, "2:%d:%d:%d:%d:%lld:%lld:%lld\n", threads[current_thread].first_event_counter->cpu, threads[current_thread].appl, threads[current_thread].task, threads[current_thread].thread, current_time, threads[current_thread].first_event_counter->type, threads[current_thread].first_event_counter->value );
 
     printed_event = threads[current_thread].first_event_counter;
     threads[current_thread].first_event_counter = threads[current_thread].first_event_counter->next;
-    free( printed_event );
+    free_counter_event( printed_event );
+
+    if ( threads[current_thread].first_event_counter != nullptr )
+      first_events.push( std::make_pair( threads[current_thread].first_event_counter->time, current_thread ) );
   }
 }
 
@@ -1025,7 +1055,7 @@ void KTraceSoftwareCounters::sc_by_event( ProgressController *progress )
 {
   int id, cpu, appl, task, thread, i;
   unsigned long long time_1, type, value;
-  char *word;
+  const char *fields, *fieldsEnd;
   struct counter_event *event;
   int thread_id, find_mark = 0;
   unsigned long num_iters = 0;
@@ -1038,8 +1068,7 @@ void KTraceSoftwareCounters::sc_by_event( ProgressController *progress )
     end_parsing = false;
 
   /* Trace processing */
-  while ( fscanf( infile, "%d:%d:%d:%d:%d:%lld:", &id, &cpu, &appl, &task, &thread, &time_1 ) != EOF &&
-          !end_parsing )
+  while ( !end_parsing && read_record( id, cpu, appl, task, thread, time_1, fields, fieldsEnd ) )
   {
     if ( progress != nullptr )
       end_parsing = progress->getStop();
@@ -1056,93 +1085,22 @@ void KTraceSoftwareCounters::sc_by_event( ProgressController *progress )
     {
       /* Saving of the current event on the buffer and upgrading */
       /* the value of the counters                               */
-      fgets( line, sizeof( line ), infile );
-
-      if ( ( i = thread_pointer[appl][task][thread] ) == -1 )
-      {
-        threads[next_thread_slot].appl = appl;
-        threads[next_thread_slot].task = task;
-        threads[next_thread_slot].thread = thread;
-        threads[next_thread_slot].next_free_counter = 0;
-        threads[next_thread_slot].last_time_of_sc = 0;
-        threads[next_thread_slot].first_event_counter = nullptr;
-        threads[next_thread_slot].last_event_counter = nullptr;
-        threads[next_thread_slot].calls.top = -1;
-        i = next_thread_slot;
-        next_thread_slot++;
-        thread_pointer[appl][task][thread] = i;
-      }
-
-      /* Event type and values */
-      word = strtok( line, ":" );
-      type = atoll( word );
-      word = strtok( nullptr, ":" );
-      value = atoll( word );
-
-      if ( allowed_type_mark( type ) )
-      {
-        find_mark = 1;
-        if ( ( event = ( struct counter_event * )malloc( sizeof( struct counter_event ) ) ) == nullptr )
-        {
-          perror( "No more memory!!!!\n" );
-          exit( 1 );
-        }
+      if ( ( i = find_thread( appl, task, thread ) ) == -1 )
+        i = new_thread( appl, task, thread );
 
-        event->cpu = cpu;
-        event->time = time_1;
-        event->type = type;
-        event->value = value;
-        event->next = nullptr;
-
-        if ( threads[thread_pointer[appl][task][thread]].first_event_counter == nullptr )
-        {
-          threads[thread_pointer[appl][task][thread]].first_event_counter = event;
-          threads[thread_pointer[appl][task][thread]].last_event_counter = event;
-        }
-        else
-        {
-          threads[thread_pointer[appl][task][thread]].last_event_counter->next = event;
-          threads[thread_pointer[appl][task][thread]].last_event_counter = event;
-        }
-
-        last_time = time_1;
-        put_counters_by_thread( appl, task, thread, cpu );
-      }
-      else
-        thread_id = inc_counter( appl, task, thread, type, value );
-
-      /* Parsing of multiple events on a single line */
-      while ( ( word = strtok( nullptr, ":" ) ) != nullptr )
+      /* Event types and values, maybe multiple events on a single line */
+      while ( prvReadField( fields, fieldsEnd, type ) && prvReadField( fields, fieldsEnd, value ) )
       {
-        type = atoll( word );
-        word = strtok( nullptr, ":" );
-        value = atoll( word );
-
         if ( allowed_type_mark( type ) )
         {
           find_mark = 1;
-          if ( ( event = ( struct counter_event * )malloc( sizeof( struct counter_event ) ) ) == nullptr )
-          {
-            perror( "No more memory!!!!\n" );
-            exit( 1 );
-          }
-
+          event = new_counter_event();
           event->cpu = cpu;
           event->time = time_1;
           event->type = type;
           event->value = value;
-          event->next = nullptr;
 
-          if ( threads[thread_pointer[appl][task][thread]].first_event_counter == nullptr )
-          {
-            threads[thread_pointer[appl][task][thread]].first_event_counter = event;
-            threads[thread_pointer[appl][task][thread]].last_event_counter = event;
-          }
-          else
-          {
-            threads[thread_pointer[appl][task][thread]].last_event_counter->next = event;
-            threads[thread_pointer[appl][task][thread]].last_event_counter = event;
-          }
+          append_counter_event( threads[i], event );
 
           last_time = time_1;
           put_counters_by_thread( appl, task, thread, cpu );
@@ -1151,12 +1109,10 @@ void KTraceSoftwareCounters::sc_by_event( ProgressController *progress )
           thread_id = inc_counter( appl, task, thread, type, value );
       }
     }
-    else
-      fgets( line, sizeof( line ), infile );
 
     if ( find_mark )
     {
-      threads[thread_pointer[appl][task][thread]].last_time_of_sc = time_1;
+      threads[i].last_time_of_sc = time_1;
       find_mark = 0;
     }
   }
@@ -1167,62 +1123,19 @@ void KTraceSoftwareCounters::sc_by_event( ProgressController *progress )
 
 void KTraceSoftwareCounters::insert_in_queue_state( int thread_id, unsigned long long time )
 {
-  struct state_queue_elem *p, *q, *new_elem;
-  p = nullptr;
-  q = nullptr;
-  new_elem = nullptr;
-
-  if ( ( new_elem = ( struct state_queue_elem * )malloc( sizeof( struct state_queue_elem ) ) ) == nullptr )
-  {
-    perror( "No more memory for state queue!!!!\n" );
-    exit( 1 );
-  }
-
-  new_elem->last_state_end_time = time;
-  new_elem->thread_id = thread_id;
-  new_elem->next = nullptr;
-
-  if ( first_state_elem == nullptr )
-  {
-    first_state_elem = new_elem;
-    return;
-  }
-
-  for ( p = first_state_elem; p != nullptr; p = p->next )
-  {
-    if ( p->last_state_end_time > time )
-    {
-      if ( first_state_elem == p )
-      {
-        new_elem->next = p;
-        first_state_elem = new_elem;
-      }
-      else
-      {
-        new_elem->next = p;
-        q->next = new_elem;
-      }
-      break;
-    }
-    else
-      q = p;
-  }
-  if ( p == nullptr )
-  {
-    q->next = new_elem;
-  }
+  /* Equal times keep their arrival order */
+  state_queue.insert( std::make_pair( time, thread_id ) );
 }
 
 
-void KTraceSoftwareCounters::put_counters_on_state( struct KTraceSoftwareCounters::state_queue_elem *p,
-                                                    struct KTraceSoftwareCounters::state_queue_elem *q )
+void KTraceSoftwareCounters::put_counters_on_state( std::multimap< unsigned long long, int >::iterator p )
 {
   int i, j;
   unsigned long long type_mask;
 
-  i = p->thread_id;
+  i = p->second;
   /* For every thread, we pass over all its counters */
-  for ( j = 0; j < threads[i].next_free_counter; j++ )
+  for ( j = 0; j < (int)threads[i].counters.size(); j++ )
   {
     if ( acumm_values )
       type_mask = threads[i].counters[j].type;
@@ -1236,27 +1149,12 @@ void KTraceSoftwareCounters::put_counters_on_state( struct KTraceSoftwareCounter
       else
         type_mask = threads[i].counters[j].type / 10000 + 20000 + threads[i].counters[j].type % 10000;
     }
-    /*
-      if(threads[i].counters[j].num > 0 || !threads[i].counters[j].last_is_zero)
-    */
-    fprintf( outfile, "2:0:%d:%d:%d:%lld:%lld:%lld\n", threads[i].appl, threads[i].task, threads[i].thread, p->last_state_end_time, type_mask, threads[i].counters[j].num );
+    fprintf( outfile, "2:0:%d:%d:%d:%lld:%lld:%lld\n", threads[i].appl, threads[i].task, threads[i].thread, p->first, type_mask, threads[i].counters[j].num );
 
     threads[i].counters[j].num = 0;
-    /*
-             if(threads[i].counters[j].num == 0)
-                    threads[i].counters[j].last_is_zero = true;
-             else {
-                    threads[i].counters[j].num=0;
-                    threads[i].counters[j].last_is_zero = false;
-             }*/
   }
 
-  if ( first_state_elem == p )
-    first_state_elem = p->next;
-  else
-    q->next = p->next;
-
-  free( p );
+  state_queue.erase( p );
 }
 
 
@@ -1264,19 +1162,13 @@ void KTraceSoftwareCounters::sc_by_states( ProgressController *progress )
 {
   int id, cpu, appl, task, thread, state;
   unsigned long long time_1, time_2, type, value;
-  // char *word, buffer[MAX_LINE_SIZE];
-  //char *word, *buffer;
-  char *word;
+  const char *fields, *fieldsEnd;
+  std::string buffer;
   bool print_line = false;
-  struct state_queue_elem *p, *q;
+  bool first_pair;
   int i, j;
   unsigned long num_iters = 0;
 
-  //buffer = (char *) malloc( sizeof(char) * MAX_LINE_SIZE );
-
-  p = nullptr;
-  q = nullptr;
-
   bool end_parsing;
 
   if ( progress != nullptr )
@@ -1285,8 +1177,7 @@ void KTraceSoftwareCounters::sc_by_states( ProgressController *progress )
     end_parsing = false;
 
   /* Trace processing */
-  while ( fscanf( infile, "%d:%d:%d:%d:%d:%lld:", &id, &cpu, &appl, &task, &thread, &time_1 ) != EOF &&
-          !end_parsing )
+  while ( !end_parsing && read_record( id, cpu, appl, task, thread, time_1, fields, fieldsEnd ) )
   {
     if ( progress != nullptr )
     {
@@ -1305,31 +1196,11 @@ void KTraceSoftwareCounters::sc_by_states( ProgressController *progress )
 
     if ( id == 1 )
     {
-      fscanf( infile, "%lld:%d\n", &time_2, &state );
-
-      if ( ( i = thread_pointer[appl][task][thread] ) == -1 )
-      {
-        threads[next_thread_slot].appl = appl;
-        threads[next_thread_slot].task = task;
-        threads[next_thread_slot].thread = thread;
-        threads[next_thread_slot].next_free_counter = 0;
-        threads[next_thread_slot].last_time_of_sc = 0;
-        i = next_thread_slot;
-        next_thread_slot++;
-        thread_pointer[appl][task][thread] = i;
-      }
+      if ( !prvReadField( fields, fieldsEnd, time_2 ) || !prvReadField( fields, fieldsEnd, state ) )
+        continue;
 
-
-      /* Bolcar tots els threads que hagin de posar contadors */
-      /*            for(p = first_state_elem; p!=nullptr; p = p->next) {
-        if(p->last_state_end_time <= time_1)
-         put_counters_on_state(p, q);
-        else {
-         q = p;
-         break;
-        }
-                  }
-      */
+      if ( ( i = find_thread( appl, task, thread ) ) == -1 )
+        i = new_thread( appl, task, thread );
 
       if ( ( min_state_time != 0 && ( time_2 - time_1 >= min_state_time ) && state == 1 ) || !min_state_time )
       {
@@ -1349,77 +1220,31 @@ void KTraceSoftwareCounters::sc_by_states( ProgressController *progress )
 
     if ( id == 2 )
     {
-      std::ostringstream buffer;
-
       /* Incrementing the counters */
-      fgets( line, sizeof( line ), infile );
-      if ( line[0] == '#' )
-        continue;
-
-      if ( ( i = thread_pointer[appl][task][thread] ) == -1 )
-      {
-        threads[next_thread_slot].appl = appl;
-        threads[next_thread_slot].task = task;
-        threads[next_thread_slot].thread = thread;
-        threads[next_thread_slot].next_free_counter = 0;
-        threads[next_thread_slot].last_time_of_sc = 0;
-        i = next_thread_slot;
-        next_thread_slot++;
-        thread_pointer[appl][task][thread] = i;
-      }
+      if ( ( i = find_thread( appl, task, thread ) ) == -1 )
+        i = new_thread( appl, task, thread );
 
       /* Bolcar tots els threads que hagin de posar contadors */
-      for ( p = first_state_elem; p != nullptr; p = p->next )
-      {
-        if ( p->last_state_end_time < time_1 )
-          put_counters_on_state( p, q );
-        else
-        {
-          q = p;
-          break;
-        }
-      }
-
-      /* Event type and values */
-      word = strtok( line, ":" );
-      type = atoll( word );
-      word = strtok( nullptr, ":" );
-      value = atoll( word );
+      while ( !state_queue.empty() && state_queue.begin()->first < time_1 )
+        put_counters_on_state( state_queue.begin() );
 
       if ( keep_events )
       {
-        //sprintf( buffer, "2:%d:%d:%d:%d:%lld:", cpu, appl, task, thread, time_1 );
-        buffer << "2:" << cpu << ":" << appl << ":" << task << ":" << thread << ":" << time_1;
-        for ( j = 0; j < types_to_keep.next_free_slot; j++ )
-        {
-          if ( types_to_keep.type[j] == type )
-          {
-            //sprintf( buffer, "%s%lld:%lld", buffer, type, value );
-            buffer << ":" << type << ":" << value;
-            print_line = true;
-            break;
-          }
-        }
+        buffer = "2:" + std::to_string( cpu ) + ":" + std::to_string( appl ) + ":" + std::to_string( task ) +
+                 ":" + std::to_string( thread ) + ":" + std::to_string( time_1 );
       }
 
-      inc_counter( appl, task, thread, type, value );
-
-      /* Parsing of multiple events on a single line */
-      while ( ( word = strtok( nullptr, ":" ) ) != nullptr )
+      /* Event types and values, maybe multiple events on a single line */
+      first_pair = true;
+      while ( prvReadField( fields, fieldsEnd, type ) && prvReadField( fields, fieldsEnd, value ) )
       {
-        type = atoll( word );
-        word = strtok( nullptr, ":" );
-        value = atoll( word );
-
         if ( keep_events )
         {
-          int j;
           for ( j = 0; j < types_to_keep.next_free_slot; j++ )
           {
-            if ( types_to_keep.type[i] == type )
+            if ( types_to_keep.type[first_pair ? j : i] == type )
             {
-              //sprintf( buffer, "%s%lld:%lld", buffer, type, value );
-              buffer << ":" << type << ":" << value;
+              buffer += ":" + std::to_string( type ) + ":" + std::to_string( value );
               print_line = true;
               break;
             }
@@ -1427,112 +1252,70 @@ void KTraceSoftwareCounters::sc_by_states( ProgressController *progress )
         }
 
         inc_counter( appl, task, thread, type, value );
+        first_pair = false;
       }
 
       if ( print_line )
       {
-        buffer << std::endl;
-        //fprintf( outfile, "%s\n", buffer );
-        fprintf( outfile, "%s", buffer.str().c_str() );
+        fprintf( outfile, "%s\n", buffer.c_str() );
         print_line = false;
       }
 
       continue;
     }
     /* Record ni d'estat ni event, el saltem */
-    else
-      fgets( line, sizeof( line ), infile );
   }
 
 
   /* Posem els contadors que falten */
-  for ( p = first_state_elem; p != nullptr; p = p->next )
-  {
-    put_counters_on_state( p, nullptr );
-  }
+  while ( !state_queue.empty() )
+    put_counters_on_state( state_queue.begin() );
 
 //  ok_sc_wait_window();
-
-  //free( buffer );
 }
 
 
 void KTraceSoftwareCounters::execute( char *trace_in, char *trace_out, ProgressController *progress )
 {
-  bool is_zip = false;
-  // char *tmp_dir = nullptr, *c, trace_name[512], *trace_header;
-  char *c, *trace_name, *trace_header;
-  std::string tmp_dir;
-  int i, j, k;
-
-  trace_name = (char *) malloc( sizeof(char) * MAX_FILENAME_SIZE );
+  char *c;
 
   /* Ini data */
   first_Paraver_event = nullptr;
   last_Paraver_event = nullptr;
-  next_thread_slot = 0;
   types.next_free_slot = 0;
   types_to_keep.next_free_slot = 0;
-
-  for ( i = 0;i < MAX_APPL;i++ )
-    for ( j = 0;j < MAX_TASK;j++ )
-      for ( k = 0;k < MAX_THREAD;k++ )
-        thread_pointer[i][j][k] = -1;
+  threads.clear();
+  thread_pointer.clear();
+  state_queue.clear();
+  event_blocks.clear();
+  free_events = nullptr;
 
   /* Reading of program args */
   read_sc_args();
 
-  /* Open the files.  If nullptr is returned there was an error */
-  /* Is a zipped trace ? */
-  if ( ( c = strrchr( trace_in, '.' ) ) != nullptr )
-  {
-    /* The name finishes with -gz */
-    if ( strlen( c ) == 3 )
-    {
-      tmp_dir = ParaverConfig::getInstance()->getGlobalTmpPath();
-      sprintf( line, "gzip -dc %s > %s/tmp.prv", trace_in, tmp_dir.c_str() );
-//      printf( "\nDecompressing zipped trace...\n" );
-      system( line );
-      sprintf( line, "%s/tmp.prv", tmp_dir.c_str() );
-      strcpy( trace_name, line );
-      is_zip = true;
-    }
-    else
-    {
-      strcpy( trace_name, trace_in );
-    }
-  }
+  /* Open the files. Zipped traces are read through the same stream */
+  is_zip = ( c = strrchr( trace_in, '.' ) ) != nullptr && !strcmp( c, ".gz" );
 
-#if defined(__FreeBSD__) || defined(__APPLE__)
-  if ( ( infile = fopen( trace_name, "r" ) ) == nullptr )
+  infile = TraceStream::openFile( trace_in );
+  if ( !infile->good() )
   {
-    printf( "Error Opening File %s\n", trace_name );
+    printf( "Error Opening File %s\n", trace_in );
     exit( 1 );
   }
+
+#if defined(__FreeBSD__) || defined(__APPLE__)
   if ( ( outfile = fopen( trace_out, "w" ) ) == nullptr )
   {
     printf( "Error Opening File %s\n", trace_out );
     exit( 1 );
   }
 #elif defined(_WIN32)
-  if ( fopen_s( &infile, trace_name, "r" ) != 0 )
-  {
-    printf( "Error Opening File %s\n", trace_name );
-    exit( 1 );
-  }
-
   if ( fopen_s( &outfile, trace_out, "w" ) != 0 )
   {
     printf( "Error Opening File %s\n", trace_out );
     exit( 1 );
   }
 #else
-  if ( ( infile = fopen64( trace_name, "r" ) ) == nullptr )
-  {
-    printf( "Error Opening File %s\n", trace_name );
-    exit( 1 );
-  }
-
   if ( ( outfile = fopen64( trace_out, "w" ) ) == nullptr )
   {
     printf( "Error Opening File %s\n", trace_out );
@@ -1542,13 +1325,10 @@ void KTraceSoftwareCounters::execute( char *trace_in, char *trace_out, ProgressC
 
   write_pcf( trace_out );
 
-  ini_progress_bar( trace_name, progress );
+  ini_progress_bar( trace_in, progress );
 
   /* Read header */
-  trace_header = ( char * )malloc( sizeof( char ) * MAX_HEADER_SIZE );
-  fgets( trace_header, MAX_HEADER_SIZE, infile );
-  proces_header( trace_header, infile, outfile );
-  free( trace_header );
+  proces_header();
 
   if ( type_of_counters )
     sc_by_time( progress );
@@ -1556,14 +1336,7 @@ void KTraceSoftwareCounters::execute( char *trace_in, char *trace_out, ProgressC
     sc_by_states( progress );
 
   /* Close the files */
-  fclose( infile );
+  infile->close();
+  delete infile;
   fclose( outfile );
-  if ( is_zip )
-  {
-    sprintf( line, "rm %s/tmp.prv", tmp_dir.c_str() );
-    system( line );
-  }
-
-  free( trace_name );
 }
-
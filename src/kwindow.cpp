@@ -21,6 +21,8 @@
  *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
 \*****************************************************************************/
 
+#include <limits>
+#include <sstream>
 #include <typeinfo>
 #include "kwindow.h"
 #include "semanticcomposefunctions.h"
@@ -33,6 +35,29 @@
 
 using namespace std;
 
+static void writeFunctionSignature( ostream& onStream, SemanticFunction *whichFunction )
+{
+  onStream << whichFunction->getName() << '(';
+  for( TParamIndex iParam = 0; iParam < whichFunction->getMaxParam(); ++iParam )
+  {
+    for( auto value : whichFunction->getParam( iParam ) )
+      onStream << value << ' ';
+    onStream << ',';
+  }
+  onStream << ')';
+}
+
+static void writeExtraComposeSignature( ostream& onStream,
+                                        const map< TWindowLevel, vector< SemanticFunction * > >& whichFunctions )
+{
+  for( auto& itMap : whichFunctions )
+  {
+    for( auto itFunction : itMap.second )
+      writeFunctionSignature( onStream, itFunction );
+    onStream << ';';
+  }
+}
+
 KTimeline::~KTimeline()
 {
   for( map< TWindowLevel, vector< vector< IntervalCompose * > > >::iterator itMap = extraCompose.begin();
@@ -378,6 +403,11 @@ void KSingleWindow::init( TRecordTime initialTime, TCreateList create, bool upda
       functions[ i ]->init( this );
   }
 
+  if( initFromBegin() )
+    updateCheckpointSignature();
+
+  updateEventIndex();
+
   for( map< TWindowLevel, vector< SemanticFunction * > >::iterator itMap = extraComposeFunctions.begin();
        itMap != extraComposeFunctions.end(); ++itMap )
   {
@@ -422,6 +452,28 @@ void KSingleWindow::init( TRecordTime initialTime, TCreateList create, bool upda
   }
 }
 
+void KSingleWindow::updateCheckpointSignature()
+{
+  checkpointSignature = getSemanticSignature();
+}
+
+// CPU level windows look ahead along the CPU records, which the index by
+// thread can't answer
+void KSingleWindow::updateEventIndex()
+{
+  if( level > TTraceLevel::THREAD || !( ( SemanticThread * )functions[ THREAD ] )->getNeedsEventIndex() )
+  {
+    eventIndex.reset();
+    return;
+  }
+
+  ostringstream tmpSignature;
+  myFilter->getSignature( tmpSignature );
+
+  if( eventIndex == nullptr || eventIndex->getSignature() != tmpSignature.str() )
+    eventIndex = std::make_shared<FilteredEventIndex>( tmpSignature.str(), myTrace->totalThreads() );
+}
+
 void KSingleWindow::initRow( TObjectOrder whichRow, TRecordTime initialTime, TCreateList create, bool updateLimits )
 {
   if( extraCompose[ TOPCOMPOSE1 ].size() > 0 )
@@ -870,6 +922,24 @@ Interval *KSingleWindow::getLevelInterval( TWindowLevel whichLevel,
   return nullptr;
 }
 
+string KSingleWindow::getSemanticSignature() const
+{
+  ostringstream tmpSignature;
+  tmpSignature.precision( numeric_limits<TSemanticValue>::max_digits10 );
+
+  tmpSignature << static_cast<int>( level ) << ' ' << timeUnit << ';';
+  for( PRV_UINT8 i = WORKLOAD; i <= COMPOSECPU; i++ )
+  {
+    if( functions[ i ] != nullptr )
+      writeFunctionSignature( tmpSignature, functions[ i ] );
+    tmpSignature << ';';
+  }
+  writeExtraComposeSignature( tmpSignature, extraComposeFunctions );
+  myFilter->getSignature( tmpSignature );
+
+  return tmpSignature.str();
+}
+
 SemanticInfoType KSingleWindow::getSemanticInfoType() const
 {
   map< TWindowLevel, vector<SemanticFunction *> >::const_iterator itMap = extraComposeFunctions.find( TOPCOMPOSE1 );
@@ -983,6 +1053,7 @@ KTimeline *KSingleWindow::clone( bool recursiveClone )
 
   delete clonedKSWindow->myFilter;
   clonedKSWindow->myFilter = myFilter->clone( clonedKSWindow );
+  clonedKSWindow->eventIndex = eventIndex;
 
   clonedKSWindow->recordsByTimeCPU.clear();
   for( vector<MemoryTrace::iterator *>::const_iterator it = recordsByTimeCPU.begin();
@@ -1748,6 +1819,31 @@ KTimeline *KDerivedWindow::clone( bool recursiveClone )
 }
 
 
+string KDerivedWindow::getSemanticSignature() const
+{
+  ostringstream tmpSignature;
+  tmpSignature.precision( numeric_limits<TSemanticValue>::max_digits10 );
+
+  tmpSignature << static_cast<int>( level ) << ' ' << timeUnit << ';';
+  for( PRV_UINT8 i = WORKLOAD; i <= DERIVED; i++ )
+  {
+    if( functions[ i ] != nullptr )
+      writeFunctionSignature( tmpSignature, functions[ i ] );
+    tmpSignature << ';';
+  }
+  writeExtraComposeSignature( tmpSignature, extraComposeFunctions );
+
+  for( PRV_UINT16 i = 0; i < parents.size(); ++i )
+  {
+    tmpSignature << factor[ i ] << ' ' << shift[ i ] << '{';
+    if( parents[ i ] != nullptr )
+      tmpSignature << parents[ i ]->getSemanticSignature();
+    tmpSignature << '}';
+  }
+
+  return tmpSignature.str();
+}
+
 SemanticInfoType KDerivedWindow::getSemanticInfoType() const
 {
   map< TWindowLevel, vector<SemanticFunction *> >::const_iterator itMap = extraComposeFunctions.find( TOPCOMPOSE1 );
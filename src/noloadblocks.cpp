@@ -21,6 +21,8 @@
  *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
 \*****************************************************************************/
 
+#include <algorithm>
+
 #include "noloadblocks.h"
 #include "noloadexception.h"
 #include "paraverkernelexception.h"
@@ -29,9 +31,10 @@ using namespace NoLoad;
 
 
 NoLoadBlocks::NoLoadBlocks( const ResourceModel<>& resource, const ProcessModel<>& process,
-                            TraceBodyIO< PARAM_TRACEBODY_CLASS > *whichBody, TraceStream *whichFile, TRecordTime endTime )
+                            TraceBodyIO< PARAM_TRACEBODY_CLASS > *whichBody, TraceStream *whichFile, TRecordTime endTime,
+                            size_t whichMaxCacheSize )
     : resourceModel( resource ), processModel( process ),
-    body( whichBody ), file( whichFile )
+    body( whichBody ), file( whichFile ), maxCacheSize( whichMaxCacheSize )
 {
   fileLoaded = false;
 
@@ -60,13 +63,17 @@ NoLoadBlocks::NoLoadBlocks( const ResourceModel<>& resource, const ProcessModel<
 
 NoLoadBlocks::~NoLoadBlocks()
 {
-  for ( PRV_UINT32 i = 0; i < communications.size(); ++i )
-    delete communications[i];
+  for ( auto it : pages )
+    delete it.second;
+  pages.clear();
 
   communications.clear();
 
   if( file != nullptr )
+  {
     file->close();
+    delete file;
+  }
 }
 
 TData *NoLoadBlocks::getLastRecord( PRV_UINT16 position ) const
@@ -80,31 +87,34 @@ void NoLoadBlocks::newRecord()
   {
     if ( lastData == nullptr )
     {
-      lastData = new fileLineData();
-      lastData->numUseds = 0;
+      loadingPage->lines.push_back( fileLineData() );
+      lastData = &loadingPage->lines.back();
+      lastData->offset = lastPos;
       lastData->endOffset = file->tellg();
-      lastData->records.push_back( TRecord() );
-      lastRecord = 0;
-      blocks[ lastPos ] = lastData;
-    }
-    else
-    {
-      lastData->records.push_back( TRecord() );
-      ++lastRecord;
+      lastData->firstRecord = loadingPage->records.size();
+      lastData->numRecords = 0;
     }
+    loadingPage->records.push_back( TRecord() );
+    lastRecord = loadingPage->records.size() - 1;
+    ++lastData->numRecords;
   }
 }
 
+void NoLoadBlocks::newRecord( TThreadOrder whichThread )
+{
+  newRecord();
+}
+
 void NoLoadBlocks::setRecordType( TRecordType whichType )
 {
   if ( fileLoaded )
-    lastData->records[ lastRecord ].type = whichType;
+    loadingPage->records[ lastRecord ].type = whichType;
 }
 
 void NoLoadBlocks::setTime( TRecordTime whichTime )
 {
   if ( fileLoaded )
-    lastData->records[ lastRecord ].time = whichTime;
+    loadingPage->records[ lastRecord ].time = whichTime;
   else
     loadingRec.time = whichTime;
 }
@@ -126,7 +136,7 @@ void NoLoadBlocks::setThread( TThreadOrder whichThread )
   else
   {
     lastData->thread = whichThread;
-    lastData->records[ lastRecord ].thread = whichThread;
+    loadingPage->records[ lastRecord ].thread = whichThread;
   }
 }
 
@@ -159,44 +169,44 @@ void NoLoadBlocks::setThread( TApplOrder whichAppl,
                                                 whichTask,
                                                 whichThread );
     lastData->thread = whichThread;
-    lastData->records[ lastRecord ].thread = whichThread;
+    loadingPage->records[ lastRecord ].thread = whichThread;
   }
 }
 
 void NoLoadBlocks::setCPU( TCPUOrder whichCPU )
 {
   if ( fileLoaded )
-    lastData->records[ lastRecord ].CPU = whichCPU;
+    loadingPage->records[ lastRecord ].CPU = whichCPU;
 }
 
 void NoLoadBlocks::setEventType( TEventType whichType )
 {
   if ( fileLoaded )
-    lastData->records[ lastRecord ].URecordInfo.eventRecord.type = whichType;
+    loadingPage->records[ lastRecord ].URecordInfo.eventRecord.type = whichType;
 }
 
 void NoLoadBlocks::setEventValue( TEventValue whichValue )
 {
   if ( fileLoaded )
-    lastData->records[ lastRecord ].URecordInfo.eventRecord.value = whichValue;
+    loadingPage->records[ lastRecord ].URecordInfo.eventRecord.value = whichValue;
 }
 
 void NoLoadBlocks::setState( TState whichState )
 {
   if ( fileLoaded )
-    lastData->records[ lastRecord ].URecordInfo.stateRecord.state = whichState;
+    loadingPage->records[ lastRecord ].URecordInfo.stateRecord.state = whichState;
 }
 
 void NoLoadBlocks::setStateEndTime( TRecordTime whichTime )
 {
   if ( fileLoaded )
-    lastData->records[ lastRecord ].URecordInfo.stateRecord.endTime = whichTime;
+    loadingPage->records[ lastRecord ].URecordInfo.stateRecord.endTime = whichTime;
 }
 
 void NoLoadBlocks::setCommIndex( TCommID whichID )
 {
   if ( fileLoaded )
-    lastData->records[ lastRecord ].URecordInfo.commRecord.index = whichID;
+    loadingPage->records[ lastRecord ].URecordInfo.commRecord.index = whichID;
 }
 
 
@@ -216,25 +226,38 @@ void NoLoadBlocks::newComm( bool createRecords )
     newRecord();
     setRecordType( COMM + PHY + RECV );
 
-    logSend = &lastData->records[ lastRecord - 3 ];
-    logRecv = &lastData->records[ lastRecord - 2 ];
-    phySend = &lastData->records[ lastRecord - 1 ];
-    phyRecv = &lastData->records[ lastRecord ];
+    logSend = &loadingPage->records[ lastRecord - 3 ];
+    logRecv = &loadingPage->records[ lastRecord - 2 ];
+    phySend = &loadingPage->records[ lastRecord - 1 ];
+    phyRecv = &loadingPage->records[ lastRecord ];
   }
 
   lastPos = file->tellg();
 
-  communications.push_back( new TCommInfo() );
-  currentComm = communications.size() - 1;
+  if ( fileLoaded && !body->ordered() )
+  {
+    currentComm = loadingPage->index * pageSize + loadingPage->comms.size();
+    loadingPage->comms.push_back( TCommInfo() );
+  }
+  else
+  {
+    communications.push_back( TCommInfo() );
+    currentComm = communications.size() - 1;
+  }
   logSend->URecordInfo.commRecord.index = currentComm;
   logRecv->URecordInfo.commRecord.index = currentComm;
   phySend->URecordInfo.commRecord.index = currentComm;
   phyRecv->URecordInfo.commRecord.index = currentComm;
 }
 
+void NoLoadBlocks::newComm( TThreadOrder whichSenderThread, TThreadOrder whichReceiverThread, bool createRecords )
+{
+  newComm( createRecords );
+}
+
 void NoLoadBlocks::setSenderThread( TThreadOrder whichThread )
 {
-  communications[currentComm]->senderThread = whichThread;
+  getCurrentComm().senderThread = whichThread;
   logSend->thread = whichThread;
   phySend->thread = whichThread;
 }
@@ -246,21 +269,21 @@ void NoLoadBlocks::setSenderThread( TApplOrder whichAppl,
   TThreadOrder globalThread = processModel.getGlobalThread( whichAppl,
                               whichTask,
                               whichThread );
-  communications[currentComm]->senderThread = globalThread;
+  getCurrentComm().senderThread = globalThread;
   logSend->thread = globalThread;
   phySend->thread = globalThread;
 }
 
 void NoLoadBlocks::setSenderCPU( TCPUOrder whichCPU )
 {
-  communications[currentComm]->senderCPU = whichCPU;
+  getCurrentComm().senderCPU = whichCPU;
   logSend->CPU = whichCPU;
   phySend->CPU = whichCPU;
 }
 
 void NoLoadBlocks::setReceiverThread( TThreadOrder whichThread )
 {
-  communications[currentComm]->receiverThread = whichThread;
+  getCurrentComm().receiverThread = whichThread;
   logRecv->thread = whichThread;
   phyRecv->thread = whichThread;
 }
@@ -272,70 +295,70 @@ void NoLoadBlocks::setReceiverThread( TApplOrder whichAppl,
   TThreadOrder globalThread = processModel.getGlobalThread( whichAppl,
                               whichTask,
                               whichThread );
-  communications[currentComm]->receiverThread = globalThread;
+  getCurrentComm().receiverThread = globalThread;
   logRecv->thread = globalThread;
   phyRecv->thread = globalThread;
 }
 
 void NoLoadBlocks::setReceiverCPU( TCPUOrder whichCPU )
 {
-  communications[currentComm]->receiverCPU = whichCPU;
+  getCurrentComm().receiverCPU = whichCPU;
   logRecv->CPU = whichCPU;
   phyRecv->CPU = whichCPU;
 }
 
 void NoLoadBlocks::setCommTag( TCommTag whichTag )
 {
-  communications[currentComm]->tag = whichTag;
+  getCurrentComm().tag = whichTag;
 }
 
 void NoLoadBlocks::setCommSize( TCommSize whichSize )
 {
-  communications[currentComm]->size = whichSize;
+  getCurrentComm().size = whichSize;
 }
 
 void NoLoadBlocks::setLogicalSend( TRecordTime whichTime )
 {
-  communications[currentComm]->logicalSendTime = whichTime;
+  getCurrentComm().logicalSendTime = whichTime;
   logSend->time = whichTime;
 }
 
 void NoLoadBlocks::setLogicalReceive( TRecordTime whichTime )
 {
-  communications[currentComm]->logicalReceiveTime = whichTime;
+  getCurrentComm().logicalReceiveTime = whichTime;
   logRecv->time = whichTime;
 }
 
 void NoLoadBlocks::setPhysicalSend( TRecordTime whichTime )
 {
-  communications[currentComm]->physicalSendTime = whichTime;
+  getCurrentComm().physicalSendTime = whichTime;
   phySend->time = whichTime;
 }
 
 void NoLoadBlocks::setPhysicalReceive( TRecordTime whichTime )
 {
-  communications[currentComm]->physicalReceiveTime = whichTime;
+  getCurrentComm().physicalReceiveTime = whichTime;
   phyRecv->time = whichTime;
 }
 
 void NoLoadBlocks::setLogicalSend( TCommID whichComm, TRecordTime whichTime )
 {
-  communications[whichComm]->logicalSendTime = whichTime;
+  getComm( whichComm ).logicalSendTime = whichTime;
 }
 
 void NoLoadBlocks::setLogicalReceive( TCommID whichComm, TRecordTime whichTime )
 {
-  communications[whichComm]->logicalReceiveTime = whichTime;
+  getComm( whichComm ).logicalReceiveTime = whichTime;
 }
 
 void NoLoadBlocks::setPhysicalSend( TCommID whichComm, TRecordTime whichTime )
 {
-  communications[whichComm]->physicalSendTime = whichTime;
+  getComm( whichComm ).physicalSendTime = whichTime;
 }
 
 void NoLoadBlocks::setPhysicalReceive( TCommID whichComm, TRecordTime whichTime )
 {
-  communications[whichComm]->physicalReceiveTime = whichTime;
+  getComm( whichComm ).physicalReceiveTime = whichTime;
 }
 
 TCommID NoLoadBlocks::getTotalComms() const
@@ -345,52 +368,52 @@ TCommID NoLoadBlocks::getTotalComms() const
 
 TThreadOrder NoLoadBlocks::getSenderThread( TCommID whichComm ) const
 {
-  return communications[whichComm]->senderThread;
+  return getComm( whichComm ).senderThread;
 }
 
 TCPUOrder NoLoadBlocks::getSenderCPU( TCommID whichComm ) const
 {
-  return communications[whichComm]->senderCPU;
+  return getComm( whichComm ).senderCPU;
 }
 
 TThreadOrder NoLoadBlocks::getReceiverThread( TCommID whichComm ) const
 {
-  return communications[whichComm]->receiverThread;
+  return getComm( whichComm ).receiverThread;
 }
 
 TCPUOrder NoLoadBlocks::getReceiverCPU( TCommID whichComm ) const
 {
-  return communications[whichComm]->receiverCPU;
+  return getComm( whichComm ).receiverCPU;
 }
 
 TCommTag NoLoadBlocks::getCommTag( TCommID whichComm ) const
 {
-  return communications[whichComm]->tag;
+  return getComm( whichComm ).tag;
 }
 
 TCommSize NoLoadBlocks::getCommSize( TCommID whichComm ) const
 {
-  return communications[whichComm]->size;
+  return getComm( whichComm ).size;
 }
 
 TRecordTime NoLoadBlocks::getLogicalSend( TCommID whichComm ) const
 {
-  return communications[whichComm]->logicalSendTime;
+  return getComm( whichComm ).logicalSendTime;
 }
 
 TRecordTime NoLoadBlocks::getLogicalReceive( TCommID whichComm ) const
 {
-  return communications[whichComm]->logicalReceiveTime;
+  return getComm( whichComm ).logicalReceiveTime;
 }
 
 TRecordTime NoLoadBlocks::getPhysicalSend( TCommID whichComm ) const
 {
-  return communications[whichComm]->physicalSendTime;
+  return getComm( whichComm ).physicalSendTime;
 }
 
 TRecordTime NoLoadBlocks::getPhysicalReceive( TCommID whichComm ) const
 {
-  return communications[whichComm]->physicalReceiveTime;
+  return getComm( whichComm ).physicalReceiveTime;
 }
 
 TRecordTime NoLoadBlocks::getLastRecordTime() const
@@ -440,208 +463,166 @@ void NoLoadBlocks::getEndThreadRecord( TThreadOrder whichThread, TRecord **recor
 // Must be used with TraceBodyIO_v1
 void NoLoadBlocks::getNextRecord( TRecord **record, PRV_INT64& offset, PRV_UINT16& recPos )
 {
+  filePage *tmpPage;
+  fileLineData *tmpLine;
+
   if( *record == &globalEndRec )
   {
     *record = nullptr;
     return;
   }
-  else if ( offset != -1 )
+  else if ( offset == -1 )
+    offset = initialOffset;
+  else if ( findLoadedLine( offset, tmpPage, tmpLine ) )
   {
-    fileLineData *tmpData = blocks[ offset ];
-
-    if ( recPos < tmpData->records.size() - 1 )
+    if ( recPos < tmpLine->numRecords - 1 )
     {
       ++recPos;
-      *record = &tmpData->records[ recPos ];
-      return;
-    }
-    else if ( tmpData->endOffset == endFileOffset )
-    {
-      decNumUseds( offset );
-      offset = endFileOffset;
-      *record = nullptr;
-      recPos = 0;
+      *record = &tmpPage->records[ tmpLine->firstRecord + recPos ];
       return;
     }
 
-    decNumUseds( offset );
-    offset = tmpData->endOffset;
+    offset = tmpLine->endOffset;
+    unpinPage( tmpPage );
   }
   else
-    offset = initialOffset;
-
-  if ( blocks.count( offset ) == 0 )
-  {
-    if( body->ordered() )
-    {
-      file->clear();
-      file->seekg( offset );
-    }
-    lastData = nullptr;
-    lastPos = offset;
-  }
+    offset = endFileOffset;
 
-  while ( blocks.count( offset ) == 0 )
+  if ( offset == endFileOffset || !findNextLine( offset, tmpPage, tmpLine ) )
   {
-    if( file->tellg() == (std::streampos)endFileOffset )
-    {
-      decNumUseds( offset );
-      offset = endFileOffset;
-      *record = nullptr;
-      recPos = 0;
-      return;
-    }
-
-    body->read( *file, *this, processModel, resourceModel, notUsedStates, notUsedEvents, dummyTraceInfo, dummyEndTime );
+    offset = endFileOffset;
+    *record = nullptr;
+    recPos = 0;
+    return;
   }
 
-  fileLineData *currentData = blocks[ offset ];
-  *record = &currentData->records[ 0 ];
+  offset = tmpLine->offset;
+  *record = &tmpPage->records[ tmpLine->firstRecord ];
   recPos = 0;
-  ++currentData->numUseds;
+  pinPage( tmpPage );
 }
 
 
 // Must be used with TraceBodyIO_v1
 void NoLoadBlocks::getPrevRecord( TRecord **record, PRV_INT64& offset, PRV_UINT16& recPos )
 {
+  filePage *tmpPage;
+  fileLineData *tmpLine;
+
   if ( offset == -1 )
   {
     *record = nullptr;
     return;
   }
-  else if( *record != &globalBeginRec )
+
+  bool pinned = *record != &globalBeginRec && *record != &globalEndRec &&
+                findLoadedLine( offset, tmpPage, tmpLine );
+  if ( pinned )
   {
     if ( recPos > 0 )
     {
-      fileLineData *tmpData = blocks[ offset ];
       --recPos;
-      *record = &tmpData->records[ recPos ];
-      return;
-    }
-    else if ( offset == initialOffset )
-    {
-      decNumUseds( offset );
-      offset = -1;
-      *record = nullptr;
+      *record = &tmpPage->records[ tmpLine->firstRecord + recPos ];
       return;
     }
+    unpinPage( tmpPage );
   }
-  file->clear();
-  file->seekg( offset );
-  goToPrevLine();
 
-  if( *record != &globalBeginRec )
-    decNumUseds( offset );
-
-  offset = file->tellg();
-  if ( blocks.count( offset ) == 0 )
+  if ( offset == initialOffset || !findPrevLine( offset, tmpPage, tmpLine ) )
   {
-    lastData = nullptr;
-    lastPos = offset;
-    body->read( *file, *this, processModel, resourceModel, notUsedStates, notUsedEvents, dummyTraceInfo, dummyEndTime );
+    offset = -1;
+    *record = nullptr;
+    return;
   }
 
-  fileLineData *currentData = blocks[ offset ];
-  *record = &currentData->records[ 0 ];
-  recPos = 0;
-  ++currentData->numUseds;
+  offset = tmpLine->offset;
+  recPos = tmpLine->numRecords - 1;
+  *record = &tmpPage->records[ tmpLine->firstRecord + recPos ];
+  pinPage( tmpPage );
 }
 
 
 // Must be used with TraceBodyIO_v2
 void NoLoadBlocks::getNextRecord( TThreadOrder whichThread, TRecord **record, PRV_INT64& offset, PRV_UINT16& recPos )
 {
+  filePage *tmpPage;
+  fileLineData *tmpLine;
+
   if( *record == &emptyEndRecords[ whichThread ] )
   {
     *record = nullptr;
     return;
   }
-  else if ( offset != -1 )
+  else if ( offset == -1 )
+    offset = beginThread[ whichThread ];
+  else if ( findLoadedLine( offset, tmpPage, tmpLine ) )
   {
-    fileLineData *tmpData = blocks[ offset ];
-    if ( recPos < tmpData->records.size() - 1 )
+    if ( recPos < tmpLine->numRecords - 1 )
     {
       ++recPos;
-      *record = &tmpData->records[ recPos ];
-      return;
-    }
-    else if ( ( whichThread < processModel.totalThreads() - 1 && tmpData->endOffset == beginThread[ whichThread + 1 ] )
-              ||
-              ( whichThread == processModel.totalThreads() - 1 && tmpData->endOffset == endFileOffset ) )
-    {
-      decNumUseds( offset );
-      offset = endFileOffset;
-      *record = nullptr;
-      recPos = 0;
+      *record = &tmpPage->records[ tmpLine->firstRecord + recPos ];
       return;
     }
 
-    decNumUseds( offset );
-    offset = tmpData->endOffset;
+    offset = tmpLine->endOffset;
+    unpinPage( tmpPage );
+    if ( whichThread < processModel.totalThreads() - 1 && offset == beginThread[ whichThread + 1 ] )
+      offset = endFileOffset;
   }
   else
-    offset = beginThread[ whichThread ];
+    offset = endFileOffset;
 
-  if ( blocks.count( offset ) == 0 )
+  if ( offset == endFileOffset || !findNextLine( offset, tmpPage, tmpLine ) )
   {
-    file->clear();
-    file->seekg( offset );
-    lastData = nullptr;
-    lastPos = offset;
-    body->read( *file, *this, processModel, resourceModel, notUsedStates, notUsedEvents, dummyTraceInfo, dummyEndTime );
+    offset = endFileOffset;
+    *record = nullptr;
+    recPos = 0;
+    return;
   }
 
-  fileLineData *currentData = blocks[ offset ];
-  *record = &currentData->records[ 0 ];
+  offset = tmpLine->offset;
+  *record = &tmpPage->records[ tmpLine->firstRecord ];
   recPos = 0;
-  ++currentData->numUseds;
+  pinPage( tmpPage );
 }
 
 // Must be used with TraceBodyIO_v2
 void NoLoadBlocks::getPrevRecord( TThreadOrder whichThread, TRecord **record, PRV_INT64& offset, PRV_UINT16& recPos )
 {
+  filePage *tmpPage;
+  fileLineData *tmpLine;
+
   if ( offset == -1 )
   {
     *record = nullptr;
     return;
   }
-  else if( *record != &emptyEndRecords[ whichThread ] ) // TODO  maybe begin?
+
+  bool pinned = *record != &emptyBeginRecords[ whichThread ] && *record != &emptyEndRecords[ whichThread ] &&
+                findLoadedLine( offset, tmpPage, tmpLine );
+  if ( pinned )
   {
     if ( recPos > 0 )
     {
-      fileLineData *tmpData = blocks[ offset ];
       --recPos;
-      *record = &tmpData->records[ recPos ];
-      return;
-    }
-    else if ( offset == beginThread[ whichThread ] )
-    {
-      decNumUseds( offset );
-      offset = -1;
-      *record = nullptr;
+      *record = &tmpPage->records[ tmpLine->firstRecord + recPos ];
       return;
     }
+    unpinPage( tmpPage );
   }
-  file->clear();
-  file->seekg( offset );
-  goToPrevLine();
-
-  if( *record != &emptyEndRecords[ whichThread ] )  // TODO  maybe begin?
-    decNumUseds( offset );
 
-  offset = file->tellg();
-  if ( blocks.count( offset ) == 0 )
+  if ( offset == beginThread[ whichThread ] || !findPrevLine( offset, tmpPage, tmpLine ) ||
+       tmpLine->offset < beginThread[ whichThread ] )
   {
-    lastData = nullptr;
-    lastPos = offset;
-    body->read( *file, *this, processModel, resourceModel, notUsedStates, notUsedEvents, dummyTraceInfo, dummyEndTime );
+    offset = -1;
+    *record = nullptr;
+    return;
   }
 
-  fileLineData *currentData = blocks[ offset ];
-  *record = &currentData->records[ 0 ];
-  recPos = 0;
-  ++currentData->numUseds;
+  offset = tmpLine->offset;
+  recPos = tmpLine->numRecords - 1;
+  *record = &tmpPage->records[ tmpLine->firstRecord + recPos ];
+  pinPage( tmpPage );
 }
 
 
@@ -651,73 +632,255 @@ void NoLoadBlocks::getThreadRecordByTime( TThreadOrder whichThread, TRecordTime
   if ( !body->ordered() )
     throw NoLoad::NoLoadException( NoLoad::TNoLoadErrorCode::wrongTraceBodyVersion, "" , __FILE__, __LINE__ );
 
-  if ( !traceIndex[ whichThread ].findRecord( whichTime, offset ) )
+  filePage *tmpPage;
+  fileLineData *tmpLine;
+
+  if ( !traceIndex[ whichThread ].findRecord( whichTime, offset ) ||
+       !findNextLine( offset, tmpPage, tmpLine ) )
   {
     offset = -1;
-    record = nullptr;
+    *record = nullptr;
     return;
   }
 
-  if ( blocks.count( offset ) == 0 )
-  {
-    file->clear();
-    file->seekg( offset );
-    lastData = nullptr;
-    lastPos = offset;
-    body->read( *file, *this, processModel, resourceModel, notUsedStates, notUsedEvents, dummyTraceInfo, dummyEndTime );
-  }
-
-  fileLineData *currentData = blocks[ offset ];
-  *record = &currentData->records[ 0 ];
+  offset = tmpLine->offset;
+  *record = &tmpPage->records[ tmpLine->firstRecord ];
   recPos = 0;
-  ++currentData->numUseds;
+  pinPage( tmpPage );
 }
 
 void NoLoadBlocks::incNumUseds( PRV_INT64 offset )
 {
-  if( blocks.count( offset ) == 0 )
-    return;
-  fileLineData *tmpData = blocks[ offset ];
-  if( tmpData != nullptr )
-    ++tmpData->numUseds;
+  filePage *tmpPage;
+  fileLineData *tmpLine;
+
+  if ( findLoadedLine( offset, tmpPage, tmpLine ) )
+    pinPage( tmpPage );
 }
 
 void NoLoadBlocks::decNumUseds( PRV_INT64 offset )
 {
-  if( blocks.count( offset ) == 0 )
-    return;
-  fileLineData *tmpData = blocks[ offset ];
-  --tmpData->numUseds;
-  if ( tmpData->numUseds <= 0 )
+  filePage *tmpPage;
+  fileLineData *tmpLine;
+
+  if ( findLoadedLine( offset, tmpPage, tmpLine ) && tmpPage->numUseds > 0 )
+    unpinPage( tmpPage );
+}
+
+void NoLoadBlocks::setFileLoaded( TRecordTime traceEndTime )
+{
+  fileLoaded = true;
+}
+
+void NoLoadBlocks::setFirstOffset( PRV_INT64 whichOffset )
+{
+  lastPos = whichOffset;
+}
+
+PRV_UINT64 NoLoadBlocks::getCacheHits() const
+{
+  return cacheHits;
+}
+
+PRV_UINT64 NoLoadBlocks::getCacheMisses() const
+{
+  return cacheMisses;
+}
+
+size_t NoLoadBlocks::getCacheSize() const
+{
+  return cacheSize;
+}
+
+
+TCommInfo& NoLoadBlocks::getComm( TCommID whichComm )
+{
+  if ( body->ordered() )
+    return communications[ whichComm ];
+
+  return getPage( whichComm / pageSize )->comms[ whichComm % pageSize ];
+}
+
+
+// The page is usually pinned by the iterator on the communication record,
+// but it is loaded again if it was evicted.
+const TCommInfo& NoLoadBlocks::getComm( TCommID whichComm ) const
+{
+  return const_cast<NoLoadBlocks *>( this )->getComm( whichComm );
+}
+
+
+// The page being loaded is not in the cache yet
+TCommInfo& NoLoadBlocks::getCurrentComm()
+{
+  if ( fileLoaded && !body->ordered() )
+    return loadingPage->comms[ currentComm % pageSize ];
+
+  return communications[ currentComm ];
+}
+
+
+NoLoadBlocks::filePage *NoLoadBlocks::getPage( PRV_INT64 whichPage )
+{
+  std::unordered_map<PRV_INT64, filePage *>::iterator itPage = pages.find( whichPage );
+  if ( itPage != pages.end() )
   {
-    delete tmpData;
-    blocks.erase( offset );
+    ++cacheHits;
+    filePage *tmpPage = itPage->second;
+    if ( tmpPage->numUseds == 0 )
+      unusedPages.splice( unusedPages.end(), unusedPages, tmpPage->unusedPosition );
+    return tmpPage;
   }
+
+  ++cacheMisses;
+  filePage *tmpPage = new filePage();
+  tmpPage->index = whichPage;
+  loadPage( whichPage, tmpPage );
+  tmpPage->numUseds = 0;
+  tmpPage->memorySize = sizeof( filePage ) +
+                        tmpPage->lines.capacity() * sizeof( fileLineData ) +
+                        tmpPage->records.capacity() * sizeof( TRecord ) +
+                        tmpPage->comms.capacity() * sizeof( TCommInfo );
+  tmpPage->unusedPosition = unusedPages.insert( unusedPages.end(), whichPage );
+  pages[ whichPage ] = tmpPage;
+  cacheSize += tmpPage->memorySize;
+
+  evictPages();
+
+  return tmpPage;
 }
 
-void NoLoadBlocks::goToPrevLine()
+
+void NoLoadBlocks::loadPage( PRV_INT64 whichPage, filePage *onPage )
 {
+  PRV_INT64 pageBegin = std::max( whichPage * pageSize, initialOffset );
+  PRV_INT64 pageEnd = std::min( ( whichPage + 1 ) * pageSize, endFileOffset );
+
+  // Lines beginning before pageBegin belong to the previous page
   file->clear();
-  PRV_INT64 curOffset = file->tellg();
-  curOffset -= 2;
+  if ( pageBegin > initialOffset )
+  {
+    std::string skippedLine;
+    file->seekg( pageBegin - 1 );
+    file->getline( skippedLine );
+  }
+  else
+    file->seekg( pageBegin );
 
-  file->seekg( curOffset );
-  while ( (char)file->peek() != '\n' )
+  loadingPage = onPage;
+  PRV_INT64 lineBegin = file->tellg();
+  while ( lineBegin >= 0 && lineBegin < pageEnd && !file->eof() )
   {
-    --curOffset;
-    file->seekg( curOffset );
+    lastData = nullptr;
+    lastPos = lineBegin;
+    body->read( *file, *this, processModel, resourceModel, notUsedStates, notUsedEvents, dummyTraceInfo, dummyEndTime );
+    lineBegin = file->tellg();
   }
+  loadingPage = nullptr;
+  lastData = nullptr;
 
-  ++curOffset;
-  file->seekg( curOffset );
+  onPage->lines.shrink_to_fit();
+  onPage->records.shrink_to_fit();
+  onPage->comms.shrink_to_fit();
 }
 
-void NoLoadBlocks::setFileLoaded( TRecordTime traceEndTime )
+
+// Only pages without iterators on them are evicted; the most recently used
+// one is kept so that the page just loaded survives until it's pinned.
+void NoLoadBlocks::evictPages()
 {
-  fileLoaded = true;
+  while ( cacheSize > maxCacheSize && unusedPages.size() > 1 )
+  {
+    PRV_INT64 tmpIndex = unusedPages.front();
+    unusedPages.pop_front();
+
+    std::unordered_map<PRV_INT64, filePage *>::iterator itPage = pages.find( tmpIndex );
+    cacheSize -= itPage->second->memorySize;
+    delete itPage->second;
+    pages.erase( itPage );
+  }
 }
 
-void NoLoadBlocks::setFirstOffset( PRV_INT64 whichOffset )
+
+void NoLoadBlocks::pinPage( filePage *whichPage )
 {
-  lastPos = whichOffset;
+  if ( whichPage->numUseds == 0 )
+    unusedPages.erase( whichPage->unusedPosition );
+  ++whichPage->numUseds;
+}
+
+
+void NoLoadBlocks::unpinPage( filePage *whichPage )
+{
+  --whichPage->numUseds;
+  if ( whichPage->numUseds == 0 )
+  {
+    whichPage->unusedPosition = unusedPages.insert( unusedPages.end(), whichPage->index );
+    evictPages();
+  }
+}
+
+
+bool NoLoadBlocks::findLoadedLine( PRV_INT64 offset, filePage *&page, fileLineData *&line ) const
+{
+  if ( offset < initialOffset || offset >= endFileOffset )
+    return false;
+
+  std::unordered_map<PRV_INT64, filePage *>::const_iterator itPage = pages.find( offset / pageSize );
+  if ( itPage == pages.end() )
+    return false;
+
+  page = itPage->second;
+  std::vector<fileLineData>::iterator itLine =
+          std::lower_bound( page->lines.begin(), page->lines.end(), offset,
+                            []( const fileLineData& whichLine, PRV_INT64 whichOffset ){ return whichLine.offset < whichOffset; } );
+  if ( itLine == page->lines.end() || itLine->offset != offset )
+    return false;
+
+  line = &( *itLine );
+  return true;
+}
+
+
+bool NoLoadBlocks::findNextLine( PRV_INT64 offset, filePage *&page, fileLineData *&line )
+{
+  if ( offset < initialOffset )
+    offset = initialOffset;
+
+  for ( PRV_INT64 iPage = offset / pageSize; iPage * pageSize < endFileOffset; ++iPage )
+  {
+    page = getPage( iPage );
+    std::vector<fileLineData>::iterator itLine =
+            std::lower_bound( page->lines.begin(), page->lines.end(), offset,
+                              []( const fileLineData& whichLine, PRV_INT64 whichOffset ){ return whichLine.offset < whichOffset; } );
+    if ( itLine != page->lines.end() )
+    {
+      line = &( *itLine );
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+bool NoLoadBlocks::findPrevLine( PRV_INT64 offset, filePage *&page, fileLineData *&line )
+{
+  if ( offset <= initialOffset )
+    return false;
+
+  for ( PRV_INT64 iPage = ( offset - 1 ) / pageSize; iPage >= initialOffset / pageSize; --iPage )
+  {
+    page = getPage( iPage );
+    std::vector<fileLineData>::iterator itLine =
+            std::lower_bound( page->lines.begin(), page->lines.end(), offset,
+                              []( const fileLineData& whichLine, PRV_INT64 whichOffset ){ return whichLine.offset < whichOffset; } );
+    if ( itLine != page->lines.begin() )
+    {
+      line = &( *( itLine - 1 ) );
+      return true;
+    }
+  }
+
+  return false;
 }
@@ -69,9 +69,6 @@ PlainBlocks::~PlainBlocks()
     blocks[ iThread ].clear();
   }
 
-  for ( PRV_UINT32 i = 0; i < communications.size(); i++ )
-    delete communications[i];
-
   blocks.clear();
   communications.clear();
 }
@@ -251,13 +248,13 @@ void PlainBlocks::newComm( bool createRecords )
   if ( createRecords )
     throw ParaverKernelException();
 
-  communications.push_back( new TCommInfo() );
+  communications.push_back( TCommInfo() );
   currentComm = communications.size() - 1;
 }
 
 void PlainBlocks::setSenderThread( TThreadOrder whichThread )
 {
-  communications[currentComm]->senderThread = whichThread;
+  communications[currentComm].senderThread = whichThread;
 }
 
 void PlainBlocks::setSenderThread( TApplOrder whichAppl,
@@ -267,17 +264,17 @@ void PlainBlocks::setSenderThread( TApplOrder whichAppl,
   TThreadOrder globalThread = processModel.getGlobalThread( whichAppl,
                               whichTask,
                               whichThread );
-  communications[currentComm]->senderThread = globalThread;
+  communications[currentComm].senderThread = globalThread;
 }
 
 void PlainBlocks::setSenderCPU( TCPUOrder whichCPU )
 {
-  communications[currentComm]->senderCPU = whichCPU;
+  communications[currentComm].senderCPU = whichCPU;
 }
 
 void PlainBlocks::setReceiverThread( TThreadOrder whichThread )
 {
-  communications[currentComm]->receiverThread = whichThread;
+  communications[currentComm].receiverThread = whichThread;
 }
 
 void PlainBlocks::setReceiverThread( TApplOrder whichAppl,
@@ -287,62 +284,62 @@ void PlainBlocks::setReceiverThread( TApplOrder whichAppl,
   TThreadOrder globalThread = processModel.getGlobalThread( whichAppl,
                               whichTask,
                               whichThread );
-  communications[currentComm]->receiverThread = globalThread;
+  communications[currentComm].receiverThread = globalThread;
 }
 
 void PlainBlocks::setReceiverCPU( TCPUOrder whichCPU )
 {
-  communications[currentComm]->receiverCPU = whichCPU;
+  communications[currentComm].receiverCPU = whichCPU;
 }
 
 void PlainBlocks::setCommTag( TCommTag whichTag )
 {
-  communications[currentComm]->tag = whichTag;
+  communications[currentComm].tag = whichTag;
 }
 
 void PlainBlocks::setCommSize( TCommSize whichSize )
 {
-  communications[currentComm]->size = whichSize;
+  communications[currentComm].size = whichSize;
 }
 
 void PlainBlocks::setLogicalSend( TRecordTime whichTime )
 {
-  communications[currentComm]->logicalSendTime = whichTime;
+  communications[currentComm].logicalSendTime = whichTime;
 }
 
 void PlainBlocks::setLogicalReceive( TRecordTime whichTime )
 {
-  communications[currentComm]->logicalReceiveTime = whichTime;
+  communications[currentComm].logicalReceiveTime = whichTime;
 }
 
 void PlainBlocks::setPhysicalSend( TRecordTime whichTime )
 {
-  communications[currentComm]->physicalSendTime = whichTime;
+  communications[currentComm].physicalSendTime = whichTime;
 }
 
 void PlainBlocks::setPhysicalReceive( TRecordTime whichTime )
 {
-  communications[currentComm]->physicalReceiveTime = whichTime;
+  communications[currentComm].physicalReceiveTime = whichTime;
 }
 
 void PlainBlocks::setLogicalSend( TCommID whichComm, TRecordTime whichTime )
 {
-  communications[whichComm]->logicalSendTime = whichTime;
+  communications[whichComm].logicalSendTime = whichTime;
 }
 
 void PlainBlocks::setLogicalReceive( TCommID whichComm, TRecordTime whichTime )
 {
-  communications[whichComm]->logicalReceiveTime = whichTime;
+  communications[whichComm].logicalReceiveTime = whichTime;
 }
 
 void PlainBlocks::setPhysicalSend( TCommID whichComm, TRecordTime whichTime )
 {
-  communications[whichComm]->physicalSendTime = whichTime;
+  communications[whichComm].physicalSendTime = whichTime;
 }
 
 void PlainBlocks::setPhysicalReceive( TCommID whichComm, TRecordTime whichTime )
 {
-  communications[whichComm]->physicalReceiveTime = whichTime;
+  communications[whichComm].physicalReceiveTime = whichTime;
 }
 
 TCommID PlainBlocks::getTotalComms() const
@@ -352,52 +349,52 @@ TCommID PlainBlocks::getTotalComms() const
 
 TThreadOrder PlainBlocks::getSenderThread( TCommID whichComm ) const
 {
-  return communications[whichComm]->senderThread;
+  return communications[whichComm].senderThread;
 }
 
 TCPUOrder PlainBlocks::getSenderCPU( TCommID whichComm ) const
 {
-  return communications[whichComm]->senderCPU;
+  return communications[whichComm].senderCPU;
 }
 
 TThreadOrder PlainBlocks::getReceiverThread( TCommID whichComm ) const
 {
-  return communications[whichComm]->receiverThread;
+  return communications[whichComm].receiverThread;
 }
 
 TCPUOrder PlainBlocks::getReceiverCPU( TCommID whichComm ) const
 {
-  return communications[whichComm]->receiverCPU;
+  return communications[whichComm].receiverCPU;
 }
 
 TCommTag PlainBlocks::getCommTag( TCommID whichComm ) const
 {
-  return communications[whichComm]->tag;
+  return communications[whichComm].tag;
 }
 
 TCommSize PlainBlocks::getCommSize( TCommID whichComm ) const
 {
-  return communications[whichComm]->size;
+  return communications[whichComm].size;
 }
 
 TRecordTime PlainBlocks::getLogicalSend( TCommID whichComm ) const
 {
-  return communications[whichComm]->logicalSendTime;
+  return communications[whichComm].logicalSendTime;
 }
 
 TRecordTime PlainBlocks::getLogicalReceive( TCommID whichComm ) const
 {
-  return communications[whichComm]->logicalReceiveTime;
+  return communications[whichComm].logicalReceiveTime;
 }
 
 TRecordTime PlainBlocks::getPhysicalSend( TCommID whichComm ) const
 {
-  return communications[whichComm]->physicalSendTime;
+  return communications[whichComm].physicalSendTime;
 }
 
 TRecordTime PlainBlocks::getPhysicalReceive( TCommID whichComm ) const
 {
-  return communications[whichComm]->physicalReceiveTime;
+  return communications[whichComm].physicalReceiveTime;
 }
 
 TRecordTime PlainBlocks::getLastRecordTime() const
@@ -27,6 +27,7 @@
 #include "plainblocks.h"
 #include "utils/traceparser/processmodel.h"
 #include "utils/traceparser/resourcemodel.h"
+#include <algorithm>
 #include <iostream>
 
 using namespace Plain;
@@ -228,6 +229,34 @@ void PlainTrace::getRecordByTimeCPU( vector<MemoryTrace::iterator *>& listIter,
   }
 }
 
+bool PlainTrace::getThreadRecords( TThreadOrder whichThread,
+                                   TRecordTime beginTime,
+                                   TRecordTime endTime,
+                                   std::vector<TRecordSpan>& spans ) const
+{
+  const vector<TRecord *>& threadBlocks = myBlocks->blocks[ whichThread ];
+  PRV_UINT32 lastBlock = threadBlocks.size() - 1;
+
+  for ( PRV_UINT32 iBlock = 0; iBlock <= lastBlock; ++iBlock )
+  {
+    // First record of the first block is empty
+    const TRecord *first = threadBlocks[ iBlock ] + ( iBlock == 0 ? 1 : 0 );
+    const TRecord *last = threadBlocks[ iBlock ] +
+                          ( iBlock == lastBlock ? myBlocks->currentRecord[ whichThread ] + 1 : PlainBlocks::blockSize );
+    if ( first >= last || ( last - 1 )->time < beginTime )
+      continue;
+    if ( first->time > endTime )
+      break;
+
+    first = std::lower_bound( first, last, beginTime, []( const TRecord& el, TRecordTime time ) { return el.time < time; } );
+    last = std::upper_bound( first, last, endTime, []( TRecordTime time, const TRecord& el ) { return time < el.time; } );
+    if ( first != last )
+      spans.push_back( TRecordSpan{ first, last } );
+  }
+
+  return true;
+}
+
 PlainTrace::iterator::iterator( PlainBlocks *whichBlocks, const Trace *whichTrace )
     :  MemoryTrace::iterator( whichTrace ), blocks( whichBlocks )
 {
@@ -385,6 +414,35 @@ inline void PlainTrace::ThreadIterator::operator--()
   record -= sizeof( TRecord );
 }
 
+TRecordSpan PlainTrace::ThreadIterator::getRecords() const
+{
+  if ( record == nullptr )
+    return TRecordSpan{ nullptr, nullptr };
+
+  const TRecord *tmpBlock = blocks->blocks[ thread ][ block ];
+  return TRecordSpan{ tmpBlock + pos, tmpBlock + ( block == lastBlock ? lastPos + 1 : PlainBlocks::blockSize ) };
+}
+
+void PlainTrace::ThreadIterator::skipRecords( size_t whichCount )
+{
+  while ( whichCount > 0 && record != nullptr )
+  {
+    PRV_UINT32 tmpAvailable = ( block == lastBlock ? lastPos : PlainBlocks::blockSize - 1 ) - pos;
+    if ( whichCount <= tmpAvailable )
+    {
+      pos += whichCount;
+      record = &blocks->blocks[ thread ][ block ][ pos ];
+      return;
+    }
+
+    // Move to the last record of this block and step over its end
+    pos += tmpAvailable;
+    whichCount -= tmpAvailable;
+    ++( *this );
+    --whichCount;
+  }
+}
+
 MemoryTrace::iterator& PlainTrace::ThreadIterator::operator=( const MemoryTrace::iterator & copy )
 {
   if ( this != &copy )
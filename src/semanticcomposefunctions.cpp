@@ -25,6 +25,7 @@
 #include "semanticcomposefunctions.h"
 #include "kwindow.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cerrno>
 #include <cfenv>
@@ -356,9 +357,33 @@ TSemanticValue ComposeAbs::execute( const SemanticInfo *info )
 }
 
 
+// Compose functions may be evaluated below the window level, as in compose
+// thread, so state is sized for the levels with the most objects.
+static TObjectOrder getStateSize( KTimeline *whichWindow )
+{
+  Trace *tmpTrace = whichWindow->getTrace();
+  return std::max( { whichWindow->getWindowLevelObjects(),
+                     static_cast<TObjectOrder>( tmpTrace->totalThreads() ),
+                     static_cast<TObjectOrder>( tmpTrace->totalCPUs() ) } );
+}
+
+
 void ComposeStackedValue::init( KTimeline *whichWindow )
 {
   myStack.clear();
+  myStack.resize( getStateSize( whichWindow ) );
+}
+
+bool ComposeStackedValue::getRowState( TObjectOrder whichRow, std::vector<TSemanticValue>& onVector )
+{
+  onVector = myStack[ whichRow ];
+
+  return true;
+}
+
+void ComposeStackedValue::setRowState( TObjectOrder whichRow, const std::vector<TSemanticValue>& whichState )
+{
+  myStack[ whichRow ] = whichState;
 }
 
 
@@ -367,29 +392,36 @@ TSemanticValue ComposeStackedValue::execute( const SemanticInfo *info )
 {
   const SemanticHighInfo *myInfo = ( const SemanticHighInfo * ) info;
 
-  TObjectOrder tmpOrder = myInfo->callingInterval->getOrder();
-
-  if( myStack.find( tmpOrder ) == myStack.end() )
-    myStack[ tmpOrder ] = std::vector<TSemanticValue>{};
+  std::vector<TSemanticValue>& tmpStack = myStack[ myInfo->callingInterval->getOrder() ];
 
   if ( myInfo->values[ 0 ] != 0 )
-    myStack[ tmpOrder ].push_back( myInfo->values[ 0 ] );
-  else
-  {
-    if ( !myStack[ tmpOrder ].empty() )
-      myStack[ tmpOrder ].pop_back();
-  }
+    tmpStack.push_back( myInfo->values[ 0 ] );
+  else if ( !tmpStack.empty() )
+    tmpStack.pop_back();
 
-  if ( myStack[ tmpOrder ].empty() )
+  if ( tmpStack.empty() )
     return 0;
 
-  return myStack[ tmpOrder ].back();
+  return tmpStack.back();
 }
 
 
 void ComposeInStackedValue::init( KTimeline *whichWindow )
 {
   myStack.clear();
+  myStack.resize( getStateSize( whichWindow ) );
+}
+
+bool ComposeInStackedValue::getRowState( TObjectOrder whichRow, std::vector<TSemanticValue>& onVector )
+{
+  onVector = myStack[ whichRow ];
+
+  return true;
+}
+
+void ComposeInStackedValue::setRowState( TObjectOrder whichRow, const std::vector<TSemanticValue>& whichState )
+{
+  myStack[ whichRow ] = whichState;
 }
 
 
@@ -398,30 +430,35 @@ TSemanticValue ComposeInStackedValue::execute( const SemanticInfo *info )
 {
   const SemanticHighInfo *myInfo = ( const SemanticHighInfo * ) info;
 
-  TObjectOrder tmpOrder = myInfo->callingInterval->getOrder();
-
-  if( myStack.find( tmpOrder ) == myStack.end() )
-    myStack[ tmpOrder ] = std::vector<TSemanticValue>{};
+  std::vector<TSemanticValue>& tmpStack = myStack[ myInfo->callingInterval->getOrder() ];
 
   if ( myInfo->values[ 0 ] != 0 )
-    myStack[ tmpOrder ].push_back( myInfo->values[ 0 ] );
-  else
-  {
-    if ( !myStack[ tmpOrder ].empty() )
-      myStack[ tmpOrder ].pop_back();
-  }
+    tmpStack.push_back( myInfo->values[ 0 ] );
+  else if ( !tmpStack.empty() )
+    tmpStack.pop_back();
 
-  if ( myStack[ tmpOrder ].empty() )
+  if ( tmpStack.empty() )
     return 0;
 
-  return myStack[ tmpOrder ].back() == parameters[ VALUE ][ 0 ] ?
-         myStack[ tmpOrder ].back() : 0;
+  return tmpStack.back() == parameters[ VALUE ][ 0 ] ? tmpStack.back() : 0;
 }
 
 
 void ComposeNestingLevel::init( KTimeline *whichWindow )
 {
-  myStack.clear();
+  myStack.assign( getStateSize( whichWindow ), 0 );
+}
+
+bool ComposeNestingLevel::getRowState( TObjectOrder whichRow, std::vector<TSemanticValue>& onVector )
+{
+  onVector.push_back( myStack[ whichRow ] );
+
+  return true;
+}
+
+void ComposeNestingLevel::setRowState( TObjectOrder whichRow, const std::vector<TSemanticValue>& whichState )
+{
+  myStack[ whichRow ] = whichState[ 0 ];
 }
 
 
@@ -430,23 +467,44 @@ TSemanticValue ComposeNestingLevel::execute( const SemanticInfo *info )
 {
   const SemanticHighInfo *myInfo = ( const SemanticHighInfo * ) info;
 
-  TObjectOrder tmpOrder = myInfo->callingInterval->getOrder();
-
-  if ( myStack.find( tmpOrder ) == myStack.end() )
-    myStack[ tmpOrder ] = 0;
+  TSemanticValue& tmpLevel = myStack[ myInfo->callingInterval->getOrder() ];
 
   if ( myInfo->values[ 0 ] != 0 )
-    ++myStack[ tmpOrder ];
-  else if( myStack[ tmpOrder ] > 0 )
-    --myStack[ tmpOrder ];
+    ++tmpLevel;
+  else if( tmpLevel > 0 )
+    --tmpLevel;
 
-  return myStack[ tmpOrder ];
+  return tmpLevel;
 }
 
 
 void ComposeLRUDepth::init( KTimeline *whichWindow )
 {
   LRUStack.clear();
+  LRUStack.resize( getStateSize( whichWindow ) );
+}
+
+bool ComposeLRUDepth::getRowState( TObjectOrder whichRow, std::vector<TSemanticValue>& onVector )
+{
+  const TLRUStack& tmpStack = LRUStack[ whichRow ];
+
+  // Most recently used first
+  for ( PRV_UINT32 iSlot = tmpStack.nextSlot; iSlot > tmpStack.oldestSlot; --iSlot )
+  {
+    if ( tmpStack.slotUsed[ iSlot - 1 ] )
+      onVector.push_back( tmpStack.slotValue[ iSlot - 1 ] );
+  }
+
+  return true;
+}
+
+void ComposeLRUDepth::setRowState( TObjectOrder whichRow, const std::vector<TSemanticValue>& whichState )
+{
+  TLRUStack& tmpStack = LRUStack[ whichRow ];
+
+  setupStack( tmpStack, std::min( std::max( whichState.size(), getStackSize() ), MAX_STACK_SIZE ) );
+  for ( std::vector<TSemanticValue>::const_reverse_iterator it = whichState.rbegin(); it != whichState.rend(); ++it )
+    pushValue( tmpStack, *it );
 }
 
 
@@ -455,40 +513,132 @@ TSemanticValue ComposeLRUDepth::execute( const SemanticInfo *info )
 {
   const SemanticHighInfo *myInfo = ( const SemanticHighInfo * ) info;
 
-  if( myInfo->values[ 0 ] == 0.0 )
+  TSemanticValue tmpValue = myInfo->values[ 0 ];
+  if( tmpValue == 0.0 )
     return 0.0;
 
-  TObjectOrder tmpOrder = myInfo->callingInterval->getOrder();
-  size_t stackSize = parameters[ STACK_SIZE ][ 0 ];
+  TLRUStack& tmpStack = LRUStack[ myInfo->callingInterval->getOrder() ];
+  size_t stackSize = getStackSize();
 
-  if( LRUStack.find( tmpOrder ) == LRUStack.end() )
-    LRUStack[ tmpOrder ] = std::list<TSemanticValue>{};
+  if ( tmpStack.slotUsed.empty() )
+    setupStack( tmpStack, stackSize );
 
-  unsigned int depth = 1;
-  list<TSemanticValue>::iterator it;
-  for( it = LRUStack[ tmpOrder ].begin(); it != LRUStack[ tmpOrder ].end(); ++it )
+  std::unordered_map<TSemanticValue, PRV_UINT32>::iterator it = tmpStack.lastUse.find( tmpValue );
+  if ( it != tmpStack.lastUse.end() )
   {
-    if( *it == myInfo->values[ 0 ] )
-      break;
-      
-    ++depth;
+    PRV_UINT32 tmpSlot = it->second;
+    unsigned int depth = tmpStack.numUsed - countUsedUntil( tmpStack, tmpSlot ) + 1;
+
+    removeSlot( tmpStack, tmpSlot );
+    pushValue( tmpStack, tmpValue );
+
+    return depth;
   }
 
-  LRUStack[ tmpOrder ].push_front( myInfo->values[ 0 ] );
-  if( it != LRUStack[ tmpOrder ].end() )
+  pushValue( tmpStack, tmpValue );
+  if ( tmpStack.numUsed > stackSize )
   {
-    LRUStack[ tmpOrder ].erase( it );
+    while ( !tmpStack.slotUsed[ tmpStack.oldestSlot ] )
+      ++tmpStack.oldestSlot;
+
+    TSemanticValue oldestValue = tmpStack.slotValue[ tmpStack.oldestSlot ];
+    removeSlot( tmpStack, tmpStack.oldestSlot );
+    if ( oldestValue == oldestValue )
+      tmpStack.lastUse.erase( oldestValue );
   }
-  else
+
+  return stackSize + 1;
+}
+
+
+// Negative and NaN sizes keep no value, as a size of 0
+size_t ComposeLRUDepth::getStackSize() const
+{
+  TSemanticValue tmpSize = parameters[ STACK_SIZE ][ 0 ];
+
+  if ( !( tmpSize > 0 ) )
+    return 0;
+  else if ( tmpSize > MAX_STACK_SIZE )
+    return MAX_STACK_SIZE;
+
+  return size_t( tmpSize );
+}
+
+
+// Twice the stack size at most, so slots are renumbered at most once every
+// stackSize uses once the stack is full
+void ComposeLRUDepth::setupStack( TLRUStack& whichStack, size_t stackSize )
+{
+  whichStack.maxSlots = 2 * ( stackSize + 1 );
+  resetSlots( whichStack, std::min( whichStack.maxSlots, MIN_SLOTS ) );
+}
+
+
+void ComposeLRUDepth::resetSlots( TLRUStack& whichStack, PRV_UINT32 numSlots )
+{
+  whichStack.lastUse.clear();
+  whichStack.slotValue.assign( numSlots, 0.0 );
+  whichStack.slotUsed.assign( numSlots, false );
+  whichStack.usedTree.assign( numSlots + 1, 0 );
+  whichStack.nextSlot = 0;
+  whichStack.oldestSlot = 0;
+  whichStack.numUsed = 0;
+}
+
+
+void ComposeLRUDepth::pushValue( TLRUStack& whichStack, TSemanticValue whichValue )
+{
+  if ( whichStack.nextSlot == whichStack.slotUsed.size() )
+    compactSlots( whichStack );
+
+  PRV_UINT32 tmpSlot = whichStack.nextSlot++;
+  whichStack.slotValue[ tmpSlot ] = whichValue;
+  whichStack.slotUsed[ tmpSlot ] = true;
+  for ( PRV_UINT32 i = tmpSlot + 1; i < whichStack.usedTree.size(); i += i & -i )
+    ++whichStack.usedTree[ i ];
+  ++whichStack.numUsed;
+
+  // NaN is never found again, as it never was in the list
+  if ( whichValue == whichValue )
+    whichStack.lastUse[ whichValue ] = tmpSlot;
+}
+
+
+void ComposeLRUDepth::removeSlot( TLRUStack& whichStack, PRV_UINT32 whichSlot )
+{
+  whichStack.slotUsed[ whichSlot ] = false;
+  for ( PRV_UINT32 i = whichSlot + 1; i < whichStack.usedTree.size(); i += i & -i )
+    --whichStack.usedTree[ i ];
+  --whichStack.numUsed;
+}
+
+
+PRV_UINT32 ComposeLRUDepth::countUsedUntil( const TLRUStack& whichStack, PRV_UINT32 whichSlot )
+{
+  PRV_UINT32 tmpCount = 0;
+  for ( PRV_UINT32 i = whichSlot + 1; i > 0; i -= i & -i )
+    tmpCount += whichStack.usedTree[ i ];
+
+  return tmpCount;
+}
+
+
+void ComposeLRUDepth::compactSlots( TLRUStack& whichStack )
+{
+  std::vector<TSemanticValue> tmpValues;
+  for ( PRV_UINT32 iSlot = whichStack.oldestSlot; iSlot < whichStack.nextSlot; ++iSlot )
   {
-    if( LRUStack[ tmpOrder ].size() > stackSize )
-    {
-      LRUStack[ tmpOrder ].pop_back();
-    }
-    depth = stackSize + 1;
+    if ( whichStack.slotUsed[ iSlot ] )
+      tmpValues.push_back( whichStack.slotValue[ iSlot ] );
   }
 
-  return depth;
+  PRV_UINT32 numSlots = whichStack.slotUsed.size();
+  if ( 2 * tmpValues.size() > numSlots )
+    numSlots = std::min( 2 * numSlots, whichStack.maxSlots );
+  resetSlots( whichStack, numSlots );
+
+  for ( std::vector<TSemanticValue>::iterator it = tmpValues.begin(); it != tmpValues.end(); ++it )
+    pushValue( whichStack, *it );
 }
 
 
@@ -531,6 +681,19 @@ void ComposeDelta::init( KTimeline *whichWindow )
   semPrevValue.clear();
 }
 
+bool ComposeDelta::getRowState( TObjectOrder whichRow, std::vector<TSemanticValue>& onVector )
+{
+  auto it = semPrevValue.find( whichRow );
+  onVector.push_back( it != semPrevValue.end() ? it->second : 0 );
+
+  return true;
+}
+
+void ComposeDelta::setRowState( TObjectOrder whichRow, const std::vector<TSemanticValue>& whichState )
+{
+  semPrevValue[ whichRow ] = whichState[ 0 ];
+}
+
 
 string ComposeDelta::name = "Delta";
 TSemanticValue ComposeDelta::execute( const SemanticInfo *info )
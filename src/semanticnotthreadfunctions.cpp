@@ -22,6 +22,8 @@
 \*****************************************************************************/
 
 
+#include <algorithm>
+
 #include "semanticnotthreadfunctions.h"
 #include "utils/include/paraverstatisticfunctions.h"
 #include "kwindow.h"
@@ -34,6 +36,9 @@ TSemanticValue Adding::execute( const SemanticInfo *info )
   TSemanticValue tmp = 0;
   const SemanticHighInfo *myInfo = ( const SemanticHighInfo * ) info;
 
+  if ( myInfo->aggregation != nullptr && myInfo->aggregation->getSum( tmp ) )
+    return tmp;
+
   for ( TObjectOrder i = 0; i < myInfo->values.size(); i++ )
     tmp += myInfo->values[ i ];
 
@@ -47,8 +52,11 @@ TSemanticValue AddingSign::execute( const SemanticInfo *info )
   TSemanticValue tmp = 0;
   const SemanticHighInfo *myInfo = ( const SemanticHighInfo * ) info;
 
-  for ( TObjectOrder i = 0; i < myInfo->values.size(); i++ )
-    tmp += myInfo->values[ i ];
+  if ( myInfo->aggregation == nullptr || !myInfo->aggregation->getSum( tmp ) )
+  {
+    for ( TObjectOrder i = 0; i < myInfo->values.size(); i++ )
+      tmp += myInfo->values[ i ];
+  }
 
   return tmp > 0 ? 1 : 0;
 }
@@ -59,8 +67,11 @@ TSemanticValue Average::execute( const SemanticInfo *info )
   TSemanticValue tmp = 0;
   const SemanticHighInfo *myInfo = ( const SemanticHighInfo * ) info;
 
-  for ( TObjectOrder i = 0; i < myInfo->values.size(); i++ )
-    tmp += myInfo->values[ i ];
+  if ( myInfo->aggregation == nullptr || !myInfo->aggregation->getSum( tmp ) )
+  {
+    for ( TObjectOrder i = 0; i < myInfo->values.size(); i++ )
+      tmp += myInfo->values[ i ];
+  }
 
   return tmp / myInfo->values.size();
 }
@@ -72,6 +83,9 @@ TSemanticValue Maximum::execute( const SemanticInfo *info )
   TSemanticValue tmp = 0;
   const SemanticHighInfo *myInfo = ( const SemanticHighInfo * ) info;
 
+  if ( myInfo->aggregation != nullptr )
+    return std::max( tmp, myInfo->aggregation->getMaximum() );
+
   for ( TObjectOrder i = 0; i < myInfo->values.size(); i++ )
   {
     if ( myInfo->values[ i ] > tmp )
@@ -88,6 +102,19 @@ TSemanticValue Minimum::execute( const SemanticInfo *info )
   TSemanticValue tmp = 0;
   const SemanticHighInfo *myInfo = ( const SemanticHighInfo * ) info;
 
+  // A 0 restarts the search, so with no negative values the result is the
+  // minimum of the children after the last 0
+  const ChildrenAggregation *aggregation = myInfo->aggregation;
+  if ( aggregation != nullptr && aggregation->getNegatives() == 0 )
+  {
+    PRV_UINT32 lastZero;
+    if ( !aggregation->getLastZero( lastZero ) )
+      return aggregation->size() == 0 ? 0 : aggregation->getMinimum();
+    else if ( lastZero == aggregation->size() - 1 )
+      return 0;
+    return aggregation->getMinimum( lastZero + 1 );
+  }
+
   for ( TObjectOrder i = 0; i < myInfo->values.size(); i++ )
   {
     if ( tmp == 0 || myInfo->values[ i ] < tmp )
@@ -115,11 +142,19 @@ TSemanticValue Activity::execute( const SemanticInfo *info )
 
   if ( tmp == 0 ) return 0;
 
-  for ( TObjectOrder i = 1; i < myInfo->values.size(); i++ )
+  if ( myInfo->aggregation != nullptr )
   {
-    if ( myInfo->values[ i ] != tmp )
+    if ( myInfo->aggregation->countValue( tmp ) != myInfo->aggregation->size() )
       return 0;
   }
+  else
+  {
+    for ( TObjectOrder i = 1; i < myInfo->values.size(); i++ )
+    {
+      if ( myInfo->values[ i ] != tmp )
+        return 0;
+    }
+  }
 
   return tmp;
 }
@@ -142,11 +177,19 @@ TSemanticValue InActivity::execute( const SemanticInfo *info )
 
   if ( tmp == 0 ) return 0;
 
-  for ( TObjectOrder i = 1; i < myInfo->values.size(); i++ )
+  if ( myInfo->aggregation != nullptr )
   {
-    if ( myInfo->values[ i ] != tmp )
+    if ( myInfo->aggregation->countValue( tmp ) != myInfo->aggregation->size() )
       return 0;
   }
+  else
+  {
+    for ( TObjectOrder i = 1; i < myInfo->values.size(); i++ )
+    {
+      if ( myInfo->values[ i ] != tmp )
+        return 0;
+    }
+  }
 
   return 1;
 }
@@ -92,6 +92,30 @@ void getNextEvent( MemoryTrace::iterator *it, KSingleWindow *window )
 }
 
 
+bool getNextEvent( const SemanticThreadInfo *info, FilteredEventIndex::TEventEntry& onEvent )
+{
+  KSingleWindow *window = ( KSingleWindow * )info->callingInterval->getWindow();
+  FilteredEventIndex *eventIndex = window->getEventIndex();
+
+  if ( eventIndex != nullptr )
+    return eventIndex->getNextEvent( window, info->callingInterval->getOrder(), info->it, onEvent );
+
+  MemoryTrace::iterator *nextEvent = info->it->clone();
+  getNextEvent( nextEvent, window );
+
+  bool found = !nextEvent->isNull();
+  if ( found )
+  {
+    onEvent.time = nextEvent->getTime();
+    onEvent.type = nextEvent->getEventType();
+    onEvent.value = nextEvent->getEventValue();
+  }
+  delete nextEvent;
+
+  return found;
+}
+
+
 TSemanticValue getTotalCommSize( MemoryTrace::iterator *itBegin,
                                  MemoryTrace::iterator *itEnd,
                                  KSingleWindow *window )
@@ -582,18 +606,12 @@ TSemanticValue NextEventType::execute( const SemanticInfo *info )
   TSemanticValue tmp = 0;
 
   const SemanticThreadInfo *myInfo = ( const SemanticThreadInfo * ) info;
-  MemoryTrace::iterator *nextEvent = nullptr;
-
-  nextEvent = myInfo->it->clone();
-
-  getNextEvent( nextEvent, ( KSingleWindow * )
-                myInfo->callingInterval->getWindow() );
+  FilteredEventIndex::TEventEntry nextEvent;
 
-  if ( nextEvent->isNull() )
+  if ( !getNextEvent( myInfo, nextEvent ) )
     return 0;
 
-  tmp = nextEvent->getEventType();
-  delete nextEvent;
+  tmp = nextEvent.type;
 
   return tmp;
 }
@@ -605,18 +623,12 @@ TSemanticValue NextEventValue::execute( const SemanticInfo *info )
   TSemanticValue tmp = 0;
 
   const SemanticThreadInfo *myInfo = ( const SemanticThreadInfo * ) info;
-  MemoryTrace::iterator *nextEvent = nullptr;
+  FilteredEventIndex::TEventEntry nextEvent;
 
-  nextEvent = myInfo->it->clone();
-
-  getNextEvent( nextEvent, ( KSingleWindow * )
-                myInfo->callingInterval->getWindow() );
-
-  if ( nextEvent->isNull() )
+  if ( !getNextEvent( myInfo, nextEvent ) )
     return 0;
 
-  tmp = nextEvent->getEventValue();
-  delete nextEvent;
+  tmp = nextEvent.value;
 
   return tmp;
 }
@@ -629,24 +641,18 @@ TSemanticValue AverageNextEventValue::execute( const SemanticInfo *info )
   TSemanticValue tmpTime = 0;
 
   const SemanticThreadInfo *myInfo = ( const SemanticThreadInfo * ) info;
-  MemoryTrace::iterator *nextEvent = nullptr;
-
-  nextEvent = myInfo->it->clone();
-
-  getNextEvent( nextEvent, ( KSingleWindow * )
-                myInfo->callingInterval->getWindow() );
+  FilteredEventIndex::TEventEntry nextEvent;
 
-  if ( nextEvent->isNull() )
+  if ( !getNextEvent( myInfo, nextEvent ) )
     return 0;
 
-  tmpTime = nextEvent->getTime() - myInfo->it->getTime();
+  tmpTime = nextEvent.time - myInfo->it->getTime();
   if ( tmpTime == 0 )
     return 0;
   tmpTime = myInfo->callingInterval->getWindow()->traceUnitsToWindowUnits( tmpTime );
 
-  tmp = nextEvent->getEventValue() * parameters[ FACTOR ][ 0 ];
+  tmp = nextEvent.value * parameters[ FACTOR ][ 0 ];
   tmp = tmp / tmpTime;
-  delete nextEvent;
 
   return tmp;
 }
@@ -659,27 +665,21 @@ TSemanticValue AverageLastEventValue::execute( const SemanticInfo *info )
   TSemanticValue tmpTime = 0;
 
   const SemanticThreadInfo *myInfo = ( const SemanticThreadInfo * ) info;
-  MemoryTrace::iterator *nextEvent = nullptr;
+  FilteredEventIndex::TEventEntry nextEvent;
 
   if ( myInfo->it->getRecordType() == EMPTYREC )
     return 0;
 
-  nextEvent = myInfo->it->clone();
-
-  getNextEvent( nextEvent, ( KSingleWindow * )
-                myInfo->callingInterval->getWindow() );
-
-  if ( nextEvent->isNull() )
+  if ( !getNextEvent( myInfo, nextEvent ) )
     return 0;
 
-  tmpTime = nextEvent->getTime() - myInfo->it->getTime();
+  tmpTime = nextEvent.time - myInfo->it->getTime();
   if ( tmpTime == 0 )
     return 0;
   tmpTime = myInfo->callingInterval->getWindow()->traceUnitsToWindowUnits( tmpTime );
 
   tmp = myInfo->it->getEventValue() * parameters[ FACTOR ][ 0 ];
   tmp = tmp / tmpTime;
-  delete nextEvent;
 
   return tmp;
 }
@@ -737,22 +737,16 @@ TSemanticValue IntervalBetweenEvents::execute( const SemanticInfo *info )
   TSemanticValue tmp = 0;
 
   const SemanticThreadInfo *myInfo = ( const SemanticThreadInfo * ) info;
-  MemoryTrace::iterator *nextEvent = nullptr;
+  FilteredEventIndex::TEventEntry nextEvent;
 
   if ( myInfo->it->getRecordType() == EMPTYREC )
     return 0;
 
-  nextEvent = myInfo->it->clone();
-
-  getNextEvent( nextEvent, ( KSingleWindow * )
-                myInfo->callingInterval->getWindow() );
-
-  if ( nextEvent->isNull() )
+  if ( !getNextEvent( myInfo, nextEvent ) )
     return 0;
 
-  tmp = nextEvent->getTime() - myInfo->it->getTime();
+  tmp = nextEvent.time - myInfo->it->getTime();
   tmp = myInfo->callingInterval->getWindow()->traceUnitsToWindowUnits( tmp );
-  delete nextEvent;
 
   return tmp;
 }
@@ -21,10 +21,15 @@
  *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
 \*****************************************************************************/
 
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
 #include <string>
 #include <sstream>
 #include <iostream>
 #include "tracebodyio_v2.h"
+#include "utils/traceparser/prvtokenizer.h"
 
 using namespace std;
 
@@ -86,13 +91,16 @@ void TraceBodyIO_v2::write( std::fstream& whichStream,
                             const ResourceModel<>& whichResourceModel,
                             MemoryTrace::iterator *record ) const
 {
-  string line;
   bool writeReady;
   TRecordType type = record->getRecordType();
 
   if ( type == EMPTYREC )
     return;
-  else if ( type & STATE )
+
+  beginRecord( whichStream );
+  string& line = outputBuffer;
+
+  if ( type & STATE )
     writeReady = writeState( line, whichProcessModel, whichResourceModel, record );
   else if ( type & EVENT )
     writeReady = writeEvent( line, whichProcessModel, whichResourceModel, record, true );
@@ -112,7 +120,7 @@ void TraceBodyIO_v2::write( std::fstream& whichStream,
   if ( !writeReady )
     return;
 
-  whichStream << line << endl;
+  endRecord();
 }
 
 
@@ -121,7 +129,8 @@ void TraceBodyIO_v2::writeEvents( fstream& whichStream,
                                   const ResourceModel<>& whichResourceModel,
                                   vector<MemoryTrace::iterator *>& recordList ) const
 {
-  string line;
+  beginRecord( whichStream );
+  string& line = outputBuffer;
 
   for ( PRV_UINT16 i = 0; i < recordList.size(); i++ )
   {
@@ -134,7 +143,7 @@ void TraceBodyIO_v2::writeEvents( fstream& whichStream,
       writeEvent( line, whichProcessModel, whichResourceModel, recordList[i], true );
   }
 
-  whichStream << line << endl;
+  endRecord();
 }
 
 
@@ -150,31 +159,38 @@ void TraceBodyIO_v2::writeCommInfo( fstream& whichStream,
 
     for ( TCommID id = 0; id < whichTrace.getTotalComms(); ++id )
     {
-      ostringstream ostr;
-      ostr << fixed;
-      ostr << dec;
-      ostr.precision( 0 );
+      beginRecord( whichStream );
+      string& line = outputBuffer;
 
-      ostr << CommRecord << ':';
+      line += CommRecord;
+      line += ':';
       if ( whichTrace.existResourceInfo() )
-        ostr << whichTrace.getSenderCPU( id ) + 1 << ':';
+        appendNumber( line, whichTrace.getSenderCPU( id ) + 1 );
       else
-        ostr << '0' << ':';
-      ostr << whichTrace.getSenderThread( id ) + 1 << ':';
-      ostr << whichTrace.getLogicalSend( id ) + baseTime << ':';
-      ostr << whichTrace.getPhysicalSend( id ) + baseTime << ':';
+        line += '0';
+      line += ':';
+      appendNumber( line, whichTrace.getSenderThread( id ) + 1 );
+      line += ':';
+      appendNumber( line, whichTrace.getLogicalSend( id ) + baseTime );
+      line += ':';
+      appendNumber( line, whichTrace.getPhysicalSend( id ) + baseTime );
+      line += ':';
       if ( whichTrace.existResourceInfo() )
-        ostr << whichTrace.getReceiverCPU( id ) + 1 << ':';
+        appendNumber( line, whichTrace.getReceiverCPU( id ) + 1 );
       else
-        ostr << '0' << ':';
-      ostr << whichTrace.getReceiverThread( id ) + 1 << ':';
-      ostr << whichTrace.getLogicalReceive( id ) + baseTime << ':';
-      ostr << whichTrace.getPhysicalReceive( id ) + baseTime << ':';
-      ostr << whichTrace.getCommSize( id ) << ':';
-      ostr << whichTrace.getCommTag( id );
-
-      whichStream << ostr.str();
-      whichStream << endl;
+        line += '0';
+      line += ':';
+      appendNumber( line, whichTrace.getReceiverThread( id ) + 1 );
+      line += ':';
+      appendNumber( line, whichTrace.getLogicalReceive( id ) + baseTime );
+      line += ':';
+      appendNumber( line, whichTrace.getPhysicalReceive( id ) + baseTime );
+      line += ':';
+      appendNumber( line, whichTrace.getCommSize( id ) );
+      line += ':';
+      appendNumber( line, whichTrace.getCommTag( id ) );
+
+      endRecord();
     }
   }
 }
@@ -189,40 +205,19 @@ void TraceBodyIO_v2::readState( const string& line,
                                 MemoryBlocks& records,
                                 unordered_set<TState>& states ) const
 {
-  string tmpstring;
   TCPUOrder CPU;
   TThreadOrder thread;
   TRecordTime time;
   TRecordTime endtime;
   TState state;
 
-  istringstream strLine( line );
-
   // Discarding record type
-  std::getline( strLine, tmpstring, ':' );
+  const char *it = line.c_str() + 2;
+  const char *end = line.c_str() + line.length();
 
   // Read the common info
-  if ( !readCommon( strLine, whichProcessModel, whichResourceModel, CPU, thread, time ) )
-  {
-    cerr << "No logging system yet. TraceBodyIO_v2::readState()" << endl;
-    cerr << "Error reading state record." << endl;
-    cerr << line << endl;
-    return;
-  }
-
-  std::getline( strLine, tmpstring, ':' );
-  istringstream endtimeStream( tmpstring );
-  if ( !( endtimeStream >> endtime ) )
-  {
-    cerr << "No logging system yet. TraceBodyIO_v2::readState()" << endl;
-    cerr << "Error reading state record." << endl;
-    cerr << line << endl;
-    return;
-  }
-
-  std::getline( strLine, tmpstring );
-  istringstream stateStream( tmpstring );
-  if ( !( stateStream >> state ) )
+  if ( !readCommon( it, end, whichProcessModel, whichResourceModel, CPU, thread, time ) ||
+       !prv_atoll_v( it, end, endtime, state ) )
   {
     cerr << "No logging system yet. TraceBodyIO_v2::readState()" << endl;
     cerr << "Error reading state record." << endl;
@@ -253,20 +248,18 @@ void TraceBodyIO_v2::readEvent( const string& line,
                                 MemoryBlocks& records,
                                 unordered_set<TEventType>& events ) const
 {
-  string tmpstring;
   TCPUOrder CPU;
   TThreadOrder thread;
   TRecordTime time;
   TEventType eventtype;
   TEventValue eventvalue;
 
-  istringstream strLine( line );
-
   // Discarding record type
-  std::getline( strLine, tmpstring, ':' );
+  const char *it = line.c_str() + 2;
+  const char *end = line.c_str() + line.length();
 
   // Read the common info
-  if ( !readCommon( strLine, whichProcessModel, whichResourceModel, CPU, thread, time ) )
+  if ( !readCommon( it, end, whichProcessModel, whichResourceModel, CPU, thread, time ) )
   {
     cerr << "No logging system yet. TraceBodyIO_v2::readEvent()" << endl;
     cerr << "Error reading event record." << endl;
@@ -274,21 +267,9 @@ void TraceBodyIO_v2::readEvent( const string& line,
     return;
   }
 
-  while ( !strLine.eof() )
+  while ( it != end )
   {
-    std::getline( strLine, tmpstring, ':' );
-    istringstream eventtypeStream( tmpstring );
-    if ( !( eventtypeStream >> eventtype ) )
-    {
-      cerr << "No logging system yet. TraceBodyIO_v2::readEvent()" << endl;
-      cerr << "Error reading event record." << endl;
-      cerr << line << endl;
-      return;
-    }
-
-    std::getline( strLine, tmpstring, ':' );
-    istringstream eventvalueStream( tmpstring );
-    if ( !( eventvalueStream >> eventvalue ) )
+    if ( !prv_atoll_v( it, end, eventtype, eventvalue ) )
     {
       cerr << "No logging system yet. TraceBodyIO_v2::readEvent()" << endl;
       cerr << "Error reading event record." << endl;
@@ -314,7 +295,6 @@ void TraceBodyIO_v2::readComm( const string& line,
                                const ResourceModel<>& whichResourceModel,
                                MemoryBlocks& records ) const
 {
-  string tmpstring;
   TCPUOrder CPU;
   TThreadOrder thread;
   TRecordTime logSend;
@@ -327,63 +307,17 @@ void TraceBodyIO_v2::readComm( const string& line,
   TCommTag tag;
   TCommID commid;
 
-  istringstream strLine( line );
-
   // Discarding record type
-  std::getline( strLine, tmpstring, ':' );
+  const char *it = line.c_str() + 2;
+  const char *end = line.c_str() + line.length();
 
   if ( line[0] == CommRecord )
   {
     // Read the common info
-    if ( !readCommon( strLine, whichProcessModel, whichResourceModel, CPU, thread, logSend ) )
-    {
-      cerr << "No logging system yet. TraceBodyIO_v2::readComm()" << endl;
-      cerr << "Error reading communication record." << endl;
-      cerr << line << endl;
-      return;
-    }
-
-    std::getline( strLine, tmpstring, ':' );
-    istringstream phySendStream( tmpstring );
-    if ( !( phySendStream >> phySend ) )
-    {
-      cerr << "No logging system yet. TraceBodyIO_v2::readComm()" << endl;
-      cerr << "Error reading communication record." << endl;
-      cerr << line << endl;
-      return;
-    }
-
-    if ( !readCommon( strLine, whichProcessModel, whichResourceModel, remoteCPU, remoteThread, logReceive ) )
-    {
-      cerr << "No logging system yet. TraceBodyIO_v2::readComm()" << endl;
-      cerr << "Error reading communication record." << endl;
-      cerr << line << endl;
-      return;
-    }
-
-    std::getline( strLine, tmpstring, ':' );
-    istringstream phyReceiveStream( tmpstring );
-    if ( !( phyReceiveStream >> phyReceive ) )
-    {
-      cerr << "No logging system yet. TraceBodyIO_v2::readComm()" << endl;
-      cerr << "Error reading communication record." << endl;
-      cerr << line << endl;
-      return;
-    }
-
-    std::getline( strLine, tmpstring, ':' );
-    istringstream sizeStream( tmpstring );
-    if ( !( sizeStream >> size ) )
-    {
-      cerr << "No logging system yet. TraceBodyIO_v2::readComm()" << endl;
-      cerr << "Error reading communication record." << endl;
-      cerr << line << endl;
-      return;
-    }
-
-    std::getline( strLine, tmpstring, ':' );
-    istringstream tagStream( tmpstring );
-    if ( !( tagStream >> tag ) )
+    if ( !readCommon( it, end, whichProcessModel, whichResourceModel, CPU, thread, logSend ) ||
+         !prv_atoll_v( it, end, phySend ) || it == end ||
+         !readCommon( it, end, whichProcessModel, whichResourceModel, remoteCPU, remoteThread, logReceive ) ||
+         !prv_atoll_v( it, end, phyReceive, size, tag ) )
     {
       cerr << "No logging system yet. TraceBodyIO_v2::readComm()" << endl;
       cerr << "Error reading communication record." << endl;
@@ -405,9 +339,7 @@ void TraceBodyIO_v2::readComm( const string& line,
   }
   else
   {
-    std::getline( strLine, tmpstring );
-    istringstream commidStream( tmpstring );
-    if ( !( commidStream >> commid ) )
+    if ( !prv_atoll_v( it, end, commid ) )
     {
       cerr << "No logging system yet. TraceBodyIO_v2::readComm()" << endl;
       cerr << "Error reading communication record." << endl;
@@ -453,68 +385,93 @@ void TraceBodyIO_v2::readGlobalComm( const string& line, MemoryBlocks& records )
 {}
 
 
-bool TraceBodyIO_v2::readCommon( istringstream& line,
+// Reads CPU, thread and time, moving it past them.
+bool TraceBodyIO_v2::readCommon( const char *&it,
+                                 const char *end,
                                  const ProcessModel<>& whichProcessModel,
                                  const ResourceModel<>& whichResourceModel,
                                  TCPUOrder& CPU,
                                  TThreadOrder& thread,
                                  TRecordTime& time ) const
 {
-  string tmpstring;
+  // Every field must be followed by another one
+  return prv_atoll_v( it, end, CPU, thread ) && it != end &&
+         whichResourceModel.isValidGlobalCPU( CPU ) &&
+         whichProcessModel.isValidThread( thread - 1 ) &&
+         prv_atoll_v( it, end, time );
+}
 
-  std::getline( line, tmpstring, ':' );
-  istringstream CPUStream( tmpstring );
-  if ( !( CPUStream >> CPU ) )
-  {
-    return false;
-  }
 
-  if ( !whichResourceModel.isValidGlobalCPU( CPU ) )
-    return false;
+/**************************
+  Write records functions
+***************************/
+template< typename T >
+inline void TraceBodyIO_v2::appendNumber( string& buffer, T value )
+{
+  char tmp[ 24 ];
+  to_chars_result result = to_chars( tmp, tmp + sizeof( tmp ), value );
+  buffer.append( tmp, result.ptr );
+}
 
-  std::getline( line, tmpstring, ':' );
-  istringstream threadStream( tmpstring );
-  if ( !( threadStream >> thread ) )
+// Same output as a fixed stream with precision 0
+inline void TraceBodyIO_v2::appendNumber( string& buffer, double value )
+{
+  if ( value == floor( value ) && fabs( value ) < 9.0e18 )
   {
-    return false;
+    appendNumber( buffer, (long long)value );
+    return;
   }
 
-  if ( !whichProcessModel.isValidThread( thread - 1 ) )
-    return false;
+  char tmp[ 512 ];
+  int length = snprintf( tmp, sizeof( tmp ), "%.0f", value );
+  buffer.append( tmp, std::min( length, (int)sizeof( tmp ) - 1 ) );
+}
+
+void TraceBodyIO_v2::flushBuffer() const
+{
+  if ( outputStream != nullptr && !outputBuffer.empty() )
+    outputStream->write( outputBuffer.data(), outputBuffer.size() );
+
+  outputBuffer.clear();
+}
 
-  std::getline( line, tmpstring, ':' );
-  istringstream timeStream( tmpstring );
-  if ( !( timeStream >> time ) )
+inline void TraceBodyIO_v2::beginRecord( fstream& whichStream ) const
+{
+  if ( outputStream != &whichStream )
   {
-    return false;
+    flushBuffer();
+    outputStream = &whichStream;
+    outputBuffer.reserve( OutputBufferSize + 4096 );
   }
-
-  return true;
 }
 
+inline void TraceBodyIO_v2::endRecord() const
+{
+  outputBuffer += '\n';
+  if ( outputBuffer.size() >= OutputBufferSize )
+    flushBuffer();
+}
 
-/**************************
-  Write records functions
-***************************/
 bool TraceBodyIO_v2::writeState( string& line,
                                  const ProcessModel<>& whichProcessModel,
                                  const ResourceModel<>& whichResourceModel,
                                  MemoryTrace::iterator *record ) const
 {
-  ostringstream ostr;
-  ostr << fixed;
-  ostr << dec;
-  ostr.precision( 0 );
-
   if ( record->getRecordType() == ( STATE + BEGIN ) )
-    ostr << StateBeginRecord << ':';
+  {
+    line += StateBeginRecord;
+    line += ':';
+  }
   else if ( record->getRecordType() == ( STATE + END ) )
-    ostr << StateEndRecord << ':';
-  writeCommon( ostr, whichProcessModel, whichResourceModel, record );
-  ostr << record->getStateEndTime();
-  ostr << ':' << record->getState();
+  {
+    line += StateEndRecord;
+    line += ':';
+  }
+  writeCommon( line, whichProcessModel, whichResourceModel, record );
+  appendNumber( line, record->getStateEndTime() );
+  line += ':';
+  appendNumber( line, record->getState() );
 
-  line += ostr.str();
   return true;
 }
 
@@ -528,17 +485,16 @@ bool TraceBodyIO_v2::writeEvent( string& line,
   TRecordType firstType;
   TRecordTime firstTime;
   TThreadOrder firstThread;
-  ostringstream ostr;
-  ostr << fixed;
-  ostr << dec;
-  ostr.precision( 0 );
 
   if ( needCommons )
   {
-    ostr << EventRecord << ':';
-    writeCommon( ostr, whichProcessModel, whichResourceModel, record );
+    line += EventRecord;
+    line += ':';
+    writeCommon( line, whichProcessModel, whichResourceModel, record );
   }
-  ostr << record->getEventType() << ':' << record->getEventValueAsIs();
+  appendNumber( line, record->getEventType() );
+  line += ':';
+  appendNumber( line, record->getEventValueAsIs() );
   firstType = record->getRecordType();
   firstTime = record->getTime();
   firstThread = record->getThread();
@@ -546,13 +502,15 @@ bool TraceBodyIO_v2::writeEvent( string& line,
   while ( !record->isNull() && record->getRecordType() == firstType &&
           record->getTime() == firstTime && record->getThread() == firstThread )
   {
-    ostr << ':' << record->getEventType() << ':' << record->getEventValueAsIs();
+    line += ':';
+    appendNumber( line, record->getEventType() );
+    line += ':';
+    appendNumber( line, record->getEventValueAsIs() );
     ++( *record );
   }
   if ( !record->isNull() )
     --( *record );
 
-  line += ostr.str();
   return true;
 }
 
@@ -560,25 +518,24 @@ bool TraceBodyIO_v2::writeEvent( string& line,
 bool TraceBodyIO_v2::writeCommRecord( string& line,
                                       MemoryTrace::iterator *record ) const
 {
-  ostringstream ostr;
-  TRecordType type;
-  ostr << fixed;
-  ostr << dec;
-  ostr.precision( 0 );
-
-  type = record->getRecordType();
+  TRecordType type = record->getRecordType();
+  PRV_UINT8 recordChar = 0;
 
   if ( type == ( COMM + LOG + SEND ) )
-    ostr << LogicalSendRecord << ':';
+    recordChar = LogicalSendRecord;
   else if ( type == ( COMM + LOG + RECV ) )
-    ostr << LogicalRecvRecord << ':';
+    recordChar = LogicalRecvRecord;
   else if ( type == ( COMM + PHY + SEND ) )
-    ostr << PhysicalSendRecord << ':';
+    recordChar = PhysicalSendRecord;
   else if ( type == ( COMM + PHY + RECV ) )
-    ostr << PhysicalRecvRecord << ':';
-  ostr << record->getCommIndex();
+    recordChar = PhysicalRecvRecord;
+  if ( recordChar != 0 )
+  {
+    line += recordChar;
+    line += ':';
+  }
+  appendNumber( line, record->getCommIndex() );
 
-  line += ostr.str();
   return true;
 }
 
@@ -591,18 +548,19 @@ bool TraceBodyIO_v2::writeGlobalComm( string& line,
 }
 
 
-void TraceBodyIO_v2::writeCommon( ostringstream& line,
+void TraceBodyIO_v2::writeCommon( string& line,
                                   const ProcessModel<>& whichProcessModel,
                                   const ResourceModel<>& whichResourceModel,
                                   MemoryTrace::iterator *record ) const
 {
   if ( whichResourceModel.isReady() )
-    line << record->getCPU() + 1 << ':';
+    appendNumber( line, record->getCPU() + 1 );
   else
-    line << '0' << ':';
+    line += '0';
+  line += ':';
 
-  line << record->getThread() + 1 << ':';
-  line << ( record->getTime() ) << ':';
+  appendNumber( line, record->getThread() + 1 );
+  line += ':';
+  appendNumber( line, record->getTime() );
+  line += ':';
 }
-
-
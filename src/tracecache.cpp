@@ -0,0 +1,453 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                               libparaver-api                              *
+ *                       Paraver Main Computing Library                      *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "kprogresscontroller.h"
+#include "tracecache.h"
+#include "vectorblocks.h"
+
+using namespace Plain;
+using std::string;
+using std::vector;
+
+constexpr char TraceCache::MAGIC[ 8 ];
+
+namespace
+{
+  // Bounds checked sequential reader over the mapped cache
+  class CacheReader
+  {
+    public:
+      CacheReader( const char *whichData, size_t whichSize )
+        : data( whichData ), size( whichSize ), pos( 0 )
+      {}
+
+      template< typename T >
+      bool read( T& value )
+      {
+        return read( &value, 1 );
+      }
+
+      template< typename T >
+      bool read( T *values, size_t count )
+      {
+        if ( count > ( size - pos ) / sizeof( T ) )
+          return false;
+        memcpy( static_cast<void *>( values ), data + pos, count * sizeof( T ) );
+        pos += count * sizeof( T );
+        return true;
+      }
+
+      bool readString( string& value )
+      {
+        PRV_UINT64 length;
+        if ( !read( length ) || length > size - pos )
+          return false;
+        value.assign( data + pos, length );
+        pos += length;
+        return true;
+      }
+
+      bool atEnd() const
+      {
+        return pos == size;
+      }
+
+    private:
+      const char *data;
+      size_t size;
+      size_t pos;
+  };
+
+  template< typename T >
+  void write( std::ofstream& file, const T *values, size_t count )
+  {
+    file.write( reinterpret_cast<const char *>( values ), count * sizeof( T ) );
+  }
+
+  template< typename T >
+  void write( std::ofstream& file, const T& value )
+  {
+    write( file, &value, 1 );
+  }
+
+  // FNV-1a by 64 bit words, then the remaining bytes. Every step is
+  // invertible, so a change confined to one word always changes the hash.
+  PRV_UINT64 checksum( const char *data, size_t size, PRV_UINT64 hash )
+  {
+    size_t i = 0;
+    for ( ; i + sizeof( PRV_UINT64 ) <= size; i += sizeof( PRV_UINT64 ) )
+    {
+      PRV_UINT64 word;
+      memcpy( &word, data + i, sizeof( word ) );
+      hash ^= word;
+      hash *= 1099511628211ULL;
+      hash ^= hash >> 32;
+    }
+    for ( ; i < size; ++i )
+    {
+      hash ^= static_cast<unsigned char>( data[ i ] );
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+}
+
+
+string TraceCache::getCacheFileName( const string& whichTraceFile )
+{
+  return whichTraceFile + ".bcache";
+}
+
+
+#ifndef _WIN32
+
+bool TraceCache::readTraceStamp( const string& whichTraceFile, THeader& header )
+{
+  memcpy( header.magic, MAGIC, sizeof( MAGIC ) );
+  header.formatVersion = FORMAT_VERSION;
+  header.recordSize = sizeof( TRecord );
+  header.commSize = sizeof( TCommInfo );
+  header.padding = 0;
+
+  int fd = open( whichTraceFile.c_str(), O_RDONLY );
+  if ( fd < 0 )
+    return false;
+
+  struct stat fileStat;
+  if ( fstat( fd, &fileStat ) != 0 || !S_ISREG( fileStat.st_mode ) )
+  {
+    close( fd );
+    return false;
+  }
+  header.traceFileSize = fileStat.st_size;
+  header.traceFileTime = fileStat.st_mtime;
+
+  // The whole trace is hashed, so an edit keeping size and time is caught.
+  // When saving, the trace has just been parsed and is in the page cache.
+  vector<char> buffer( CHECKSUM_BLOCK_SIZE );
+  PRV_UINT64 hash = 14695981039346656037ULL;
+  PRV_UINT64 offset = 0;
+  while ( offset < header.traceFileSize )
+  {
+    // Blocks are filled completely, so words never depend on short reads
+    size_t blockSize = std::min<PRV_UINT64>( CHECKSUM_BLOCK_SIZE, header.traceFileSize - offset );
+    size_t blockRead = 0;
+    while ( blockRead < blockSize )
+    {
+      ssize_t bytesRead = pread( fd, &buffer[ blockRead ], blockSize - blockRead, offset + blockRead );
+      if ( bytesRead <= 0 )
+      {
+        close( fd );
+        return false;
+      }
+      blockRead += bytesRead;
+    }
+    hash = checksum( &buffer[ 0 ], blockSize, hash );
+    offset += blockSize;
+  }
+  header.traceChecksum = hash;
+
+  close( fd );
+  return true;
+}
+
+
+bool TraceCache::load( const string& whichTraceFile,
+                       VectorBlocks& blocks,
+                       std::unordered_set<TState>& states,
+                       std::unordered_set<TEventType>& events,
+                       MetadataManager& traceInfo )
+{
+  THeader traceStamp;
+  if ( !readTraceStamp( whichTraceFile, traceStamp ) )
+    return false;
+
+  int fd = open( getCacheFileName( whichTraceFile ).c_str(), O_RDONLY );
+  if ( fd < 0 )
+    return false;
+
+  struct stat cacheStat;
+  if ( fstat( fd, &cacheStat ) != 0 || (size_t)cacheStat.st_size < sizeof( THeader ) )
+  {
+    close( fd );
+    return false;
+  }
+
+  size_t cacheSize = cacheStat.st_size;
+  void *mapped = mmap( nullptr, cacheSize, PROT_READ, MAP_PRIVATE, fd, 0 );
+  close( fd );
+  if ( mapped == MAP_FAILED )
+    return false;
+  madvise( mapped, cacheSize, MADV_SEQUENTIAL );
+
+  CacheReader reader( static_cast<const char *>( mapped ), cacheSize );
+
+  THeader cacheStamp;
+  reader.read( cacheStamp );
+  bool valid = memcmp( &cacheStamp, &traceStamp, sizeof( THeader ) ) == 0;
+
+  PRV_UINT64 numThreads = 0;
+  PRV_UINT64 numCPUs = 0;
+  valid = valid && reader.read( numThreads ) && reader.read( numCPUs ) &&
+          numThreads == blocks.threadRecords.size() &&
+          numCPUs == blocks.cpuRecords.size();
+
+  TRecordTime lastRecordTime = 0;
+  valid = valid && reader.read( lastRecordTime );
+
+  vector< TThreadRecordContainer > threadRecords( valid ? numThreads : 0 );
+  for ( auto& thread : threadRecords )
+  {
+    PRV_UINT64 numRecords;
+    valid = valid && reader.read( numRecords ) && numRecords <= cacheSize / sizeof( TRecord );
+    if ( !valid )
+      break;
+    thread.resize( numRecords );
+    valid = reader.read( thread.data(), numRecords );
+  }
+
+  vector< TRecord > cpuBeginEmptyRecords( valid ? numCPUs : 0 );
+  vector< TRecord > cpuEndEmptyRecords( valid ? numCPUs : 0 );
+  vector< TCPURecordContainer > cpuRecords( valid ? numCPUs : 0 );
+  vector< PRV_UINT64 > indexes;
+  for ( size_t iCPU = 0; valid && iCPU < numCPUs; ++iCPU )
+  {
+    PRV_UINT64 numRecords;
+    valid = reader.read( cpuBeginEmptyRecords[ iCPU ] ) &&
+            reader.read( cpuEndEmptyRecords[ iCPU ] ) &&
+            reader.read( numRecords ) &&
+            numRecords <= cacheSize / sizeof( PRV_UINT64 ) &&
+            numRecords % 2 == 0;
+    if ( !valid )
+      break;
+
+    indexes.resize( numRecords );
+    valid = reader.read( indexes.data(), numRecords );
+
+    // Heap buffers are kept when swapped into blocks, so these pointers stay valid
+    cpuRecords[ iCPU ].reserve( numRecords / 2 + 2 );
+    cpuRecords[ iCPU ].push_back( &cpuBeginEmptyRecords[ iCPU ] );
+    for ( size_t i = 0; valid && i < numRecords; i += 2 )
+    {
+      // (thread, position) pairs
+      PRV_UINT64 iThread = indexes[ i ];
+      PRV_UINT64 iRecord = indexes[ i + 1 ];
+      valid = iThread < numThreads && iRecord < threadRecords[ iThread ].size();
+      if ( valid )
+        cpuRecords[ iCPU ].push_back( &threadRecords[ iThread ][ iRecord ] );
+    }
+    cpuRecords[ iCPU ].push_back( &cpuEndEmptyRecords[ iCPU ] );
+  }
+
+  vector< TCommInfo > communications;
+  PRV_UINT64 numComms;
+  valid = valid && reader.read( numComms ) && numComms <= cacheSize / sizeof( TCommInfo );
+  if ( valid )
+  {
+    communications.resize( numComms );
+    valid = reader.read( communications.data(), numComms );
+  }
+
+  vector< TState > cacheStates;
+  PRV_UINT64 numStates;
+  valid = valid && reader.read( numStates ) && numStates <= cacheSize / sizeof( TState );
+  if ( valid )
+  {
+    cacheStates.resize( numStates );
+    valid = reader.read( cacheStates.data(), numStates );
+  }
+
+  vector< TEventType > cacheEvents;
+  PRV_UINT64 numEvents;
+  valid = valid && reader.read( numEvents ) && numEvents <= cacheSize / sizeof( TEventType );
+  if ( valid )
+  {
+    cacheEvents.resize( numEvents );
+    valid = reader.read( cacheEvents.data(), numEvents );
+  }
+
+  vector< string > metadata;
+  PRV_UINT64 numMetadata;
+  valid = valid && reader.read( numMetadata ) && numMetadata <= cacheSize;
+  for ( PRV_UINT64 i = 0; valid && i < numMetadata; ++i )
+  {
+    metadata.emplace_back();
+    valid = reader.readString( metadata.back() );
+  }
+
+  valid = valid && reader.atEnd();
+
+  munmap( mapped, cacheSize );
+
+  if ( !valid )
+    return false;
+
+  blocks.threadRecords.swap( threadRecords );
+  blocks.cpuRecords.swap( cpuRecords );
+  blocks.cpuBeginEmptyRecords.swap( cpuBeginEmptyRecords );
+  blocks.cpuEndEmptyRecords.swap( cpuEndEmptyRecords );
+  blocks.communications.swap( communications );
+  blocks.lastRecordTime = lastRecordTime;
+
+  states.insert( cacheStates.begin(), cacheStates.end() );
+  events.insert( cacheEvents.begin(), cacheEvents.end() );
+  for ( const auto& line : metadata )
+    traceInfo.NewMetadata( line );
+
+  return true;
+}
+
+
+void TraceCache::save( const string& whichTraceFile,
+                       const VectorBlocks& blocks,
+                       const std::set<TState>& states,
+                       const std::set<TEventType>& events,
+                       MetadataManager& traceInfo )
+{
+  THeader traceStamp;
+  if ( !readTraceStamp( whichTraceFile, traceStamp ) )
+    return;
+
+  string cacheFileName = getCacheFileName( whichTraceFile );
+  string tmpFileName = cacheFileName + ".tmp";
+  std::ofstream file( tmpFileName.c_str(), std::ios::binary | std::ios::trunc );
+  if ( !file.good() )
+    return;
+
+  write( file, traceStamp );
+  write( file, PRV_UINT64( blocks.threadRecords.size() ) );
+  write( file, PRV_UINT64( blocks.cpuRecords.size() ) );
+  write( file, blocks.lastRecordTime );
+
+  for ( const auto& thread : blocks.threadRecords )
+  {
+    write( file, PRV_UINT64( thread.size() ) );
+    write( file, thread.data(), thread.size() );
+  }
+
+  bool valid = true;
+  vector< PRV_UINT64 > indexes;
+  for ( size_t iCPU = 0; iCPU < blocks.cpuRecords.size(); ++iCPU )
+  {
+    const TCPURecordContainer& cpu = blocks.cpuRecords[ iCPU ];
+
+    // Begin and end empty records are owned by blocks, not by any thread
+    indexes.clear();
+    for ( size_t i = 1; cpu.size() > 2 && i < cpu.size() - 1; ++i )
+    {
+      TThreadOrder iThread = cpu[ i ]->thread;
+      if ( iThread >= blocks.threadRecords.size() )
+      {
+        valid = false;
+        break;
+      }
+      const TThreadRecordContainer& thread = blocks.threadRecords[ iThread ];
+      if ( cpu[ i ] < thread.data() || cpu[ i ] >= thread.data() + thread.size() )
+      {
+        valid = false;
+        break;
+      }
+      indexes.push_back( iThread );
+      indexes.push_back( cpu[ i ] - thread.data() );
+    }
+    if ( !valid )
+      break;
+
+    write( file, blocks.cpuBeginEmptyRecords[ iCPU ] );
+    write( file, blocks.cpuEndEmptyRecords[ iCPU ] );
+    write( file, PRV_UINT64( indexes.size() ) );
+    write( file, indexes.data(), indexes.size() );
+  }
+
+  write( file, PRV_UINT64( blocks.communications.size() ) );
+  write( file, blocks.communications.data(), blocks.communications.size() );
+
+  vector< TState > cacheStates( states.begin(), states.end() );
+  write( file, PRV_UINT64( cacheStates.size() ) );
+  write( file, cacheStates.data(), cacheStates.size() );
+
+  vector< TEventType > cacheEvents( events.begin(), events.end() );
+  write( file, PRV_UINT64( cacheEvents.size() ) );
+  write( file, cacheEvents.data(), cacheEvents.size() );
+
+  // Only cutter metadata is kept by MetadataManager
+  write( file, PRV_UINT64( traceInfo.GetCutterMetadata().size() ) );
+  for ( auto metadata : traceInfo.GetCutterMetadata() )
+  {
+    std::ostringstream tmpLine;
+    tmpLine << metadata->GetDate() << ":" << metadata->GetAction() << ":"
+            << metadata->GetApplication() << ":" << metadata->GetOriginalTrace() << ":"
+            << metadata->GetOffset() << ":" << metadata->GetBeginTime() << ":" << metadata->GetEndTime();
+    string line = tmpLine.str();
+    write( file, PRV_UINT64( line.size() ) );
+    write( file, line.data(), line.size() );
+  }
+
+  file.close();
+
+  if ( valid && !file.fail() )
+    valid = rename( tmpFileName.c_str(), cacheFileName.c_str() ) == 0;
+
+  if ( !valid )
+    remove( tmpFileName.c_str() );
+}
+
+#else
+
+bool TraceCache::readTraceStamp( const string& whichTraceFile, THeader& header )
+{
+  return false;
+}
+
+bool TraceCache::load( const string& whichTraceFile,
+                       VectorBlocks& blocks,
+                       std::unordered_set<TState>& states,
+                       std::unordered_set<TEventType>& events,
+                       MetadataManager& traceInfo )
+{
+  return false;
+}
+
+void TraceCache::save( const string& whichTraceFile,
+                       const VectorBlocks& blocks,
+                       const std::set<TState>& states,
+                       const std::set<TEventType>& events,
+                       MetadataManager& traceInfo )
+{
+}
+
+#endif
@@ -25,8 +25,17 @@
 #include "tracestream.h"
 #include "paraverkernelexception.h"
 #include <iostream>
+#include <cstring>
+#include <limits>
 #ifndef _WIN32
 #include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#ifdef PARALLEL_ENABLED
+#include "omp.h"
 #endif
 
 using namespace std;
@@ -39,8 +48,15 @@ TraceStream *TraceStream::openFile( const string& filename )
 
   if ( strExt.compare( ".gz" ) == 0 )
     return new Compressed( filename );
-  else
-    return new NotCompressed( filename );
+
+#ifndef _WIN32
+  MemoryMapped *tmpMapped = new MemoryMapped( filename );
+  if ( tmpMapped->good() )
+    return tmpMapped;
+  delete tmpMapped;
+#endif
+
+  return new NotCompressed( filename );
 }
 
 TTraceSize TraceStream::getTraceFileSize( const string& filename )
@@ -48,7 +64,7 @@ TTraceSize TraceStream::getTraceFileSize( const string& filename )
   string strExt = filename.substr( filename.length() - 3 );
 
   if ( strExt.compare( ".gz" ) == 0 )
-    return NotCompressed::getTraceFileSize( filename ) * GZIP_COMPRESSION_RATIO;
+    return Compressed::getTraceFileSize( filename );
   else
     return NotCompressed::getTraceFileSize( filename );
 }
@@ -65,6 +81,14 @@ void TraceStream::setFilename( const std::string &newFile )
 }
 
 
+void TraceStream::getlineView( const char *&lineBegin, const char *&lineEnd )
+{
+  getline( lineBuffer );
+  lineBegin = lineBuffer.data();
+  lineEnd = lineBegin + lineBuffer.size();
+}
+
+
 
 
 NotCompressed::NotCompressed( const string& filename )
@@ -178,104 +202,395 @@ TTraceSize NotCompressed::getTraceFileSize( const string& filename )
 
 
 
+#ifndef _WIN32
+MemoryMapped::MemoryMapped( const string& filename )
+{
+  setFilename( filename );
+  open( filename );
+}
+
+MemoryMapped::~MemoryMapped()
+{
+  close();
+}
+
+void MemoryMapped::open( const string& filename )
+{
+  close();
+
+  // Opening a pipe here would consume its only reader
+  struct stat fileStat;
+  if ( stat( filename.c_str(), &fileStat ) == -1 || !S_ISREG( fileStat.st_mode ) )
+    return;
+
+  int fd = ::open( filename.c_str(), O_RDONLY );
+  if ( fd == -1 )
+    return;
+
+  if ( fstat( fd, &fileStat ) == -1 || !S_ISREG( fileStat.st_mode ) )
+  {
+    ::close( fd );
+    return;
+  }
+
+  mappedSize = fileStat.st_size;
+  if ( mappedSize > 0 )
+  {
+    void *tmpData = mmap( nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0 );
+    if ( tmpData == MAP_FAILED )
+    {
+      ::close( fd );
+      mappedSize = 0;
+      return;
+    }
+    madvise( tmpData, mappedSize, MADV_SEQUENTIAL );
+    mappedData = static_cast<const char *>( tmpData );
+  }
+
+  // The mapping remains valid after closing its descriptor
+  ::close( fd );
+
+  currentPos = 0;
+  endOfFile = false;
+  isOpen = true;
+}
+
+void MemoryMapped::close()
+{
+  if ( mappedData != nullptr )
+    munmap( const_cast<char *>( mappedData ), mappedSize );
+
+  mappedData = nullptr;
+  mappedSize = 0;
+  currentPos = 0;
+  isOpen = false;
+}
+
+void MemoryMapped::getline( string& strLine )
+{
+  const char *lineBegin;
+  const char *lineEnd;
+
+  getlineView( lineBegin, lineEnd );
+  strLine.assign( lineBegin, lineEnd );
+}
+
+void MemoryMapped::getlineView( const char *&lineBegin, const char *&lineEnd )
+{
+  if ( currentPos >= mappedSize )
+  {
+    lineBegin = lineEnd = mappedData + mappedSize;
+    endOfFile = true;
+    return;
+  }
+
+  lineBegin = mappedData + currentPos;
+  lineEnd = static_cast<const char *>( memchr( lineBegin, '\n', mappedSize - currentPos ) );
+  if ( lineEnd == nullptr )
+  {
+    lineEnd = mappedData + mappedSize;
+    currentPos = mappedSize;
+    endOfFile = true;
+  }
+  else
+    currentPos = lineEnd - mappedData + 1;
+}
+
+bool MemoryMapped::eof()
+{
+  return endOfFile;
+}
+
+void MemoryMapped::seekbegin()
+{
+  seekg( 0 );
+}
+
+void MemoryMapped::seekend()
+{
+  seekg( mappedSize );
+}
+
+void MemoryMapped::seekg( streampos pos )
+{
+  currentPos = pos;
+  endOfFile = false;
+}
+
+streampos MemoryMapped::tellg()
+{
+  return currentPos;
+}
+
+bool MemoryMapped::canseekend()
+{
+  return true;
+}
+
+bool MemoryMapped::good() const
+{
+  return isOpen && !endOfFile;
+}
+
+void MemoryMapped::clear()
+{
+  endOfFile = false;
+}
+
+int MemoryMapped::peek()
+{
+  if ( currentPos >= mappedSize )
+  {
+    endOfFile = true;
+    return EOF;
+  }
+
+  return static_cast<unsigned char>( mappedData[ currentPos ] );
+}
+#endif
+
+
+
+
 Compressed::Compressed( const string& filename )
 {
   setFilename( filename );
-  file = gzopen( filename.c_str(), "r" );
+  open( filename );
 }
 
 void Compressed::open( const string& filename )
 {
-  file = gzopen( filename.c_str(), "r" );
+  close();
+
+  std::ifstream tmpFile( filename.c_str(), std::ios::binary );
+  if ( !tmpFile.good() )
+    return;
+  tmpFile.close();
+
+  index = GzipIndex::getIndex( filename );
+  decoder.reset( new GzipDecoder( index ) );
+  isOpen = true;
 }
 
 void Compressed::close()
 {
-  gzclose( file );
+  decoder.reset();
+  rangeDecoders.clear();
+  index.reset();
+  decoderInPlace = false;
+  buffer.clear();
+  bufferPos = 0;
+  bufferOffset = 0;
+  isOpen = false;
+  endOfFile = false;
 }
 
 void Compressed::getline( string& strLine )
 {
-#ifndef _MSC_VER
-  gzgets( file, tmpLine, LINESIZE );
-#else
-  throw ParaverKernelException( ParaverKernelException::gzipNotSupported );
-  int c;
-  c = gzgetc( file );
-  PRV_UINT32 i = 0;
-  while( c != '\n' )
+  const char *lineBegin;
+  const char *lineEnd;
+
+  getlineView( lineBegin, lineEnd );
+  strLine.assign( lineBegin, lineEnd );
+}
+
+void Compressed::getlineView( const char *&lineBegin, const char *&lineEnd )
+{
+  size_t searchPos = bufferPos;
+  while ( true )
   {
-    if( c == '\r' )
-      continue;
-    if( c == -1 )
+    const char *newLine = static_cast<const char *>( memchr( buffer.data() + searchPos, '\n', buffer.size() - searchPos ) );
+    if ( newLine != nullptr )
+    {
+      lineBegin = buffer.data() + bufferPos;
+      lineEnd = newLine;
+      bufferPos = newLine - buffer.data() + 1;
+      return;
+    }
+
+    // fillBuffer moves the pending bytes to the beginning
+    size_t alreadySearched = buffer.size() - bufferPos;
+    if ( !fillBuffer() )
       break;
-    tmpLine[ i ] = c;
-    c = gzgetc( file );
-    ++i;
+    searchPos = bufferPos + alreadySearched;
+  }
+
+  lineBegin = buffer.data() + bufferPos;
+  lineEnd = buffer.data() + buffer.size();
+  bufferPos = buffer.size();
+  endOfFile = true;
+}
+
+bool Compressed::fillBuffer()
+{
+  if ( !isOpen )
+    return false;
+
+  buffer.erase( buffer.begin(), buffer.begin() + bufferPos );
+  bufferOffset += bufferPos;
+  bufferPos = 0;
+
+  TTraceSize nextOffset = bufferOffset + buffer.size();
+  size_t previousSize = buffer.size();
+
+#ifdef PARALLEL_ENABLED
+  if ( index->isComplete() && omp_get_max_threads() > 1 && !omp_in_parallel() )
+  {
+    vector< std::pair< TTraceSize, TTraceSize > > ranges;
+    index->getRanges( nextOffset, omp_get_max_threads(), ranges );
+    if ( ranges.empty() )
+      return false;
+
+    // Every range is decompressed straight to its place in buffer
+    buffer.resize( previousSize + ( ranges.back().second - nextOffset ) );
+    vector< size_t > rangeRead( ranges.size(), 0 );
+    while ( rangeDecoders.size() < ranges.size() )
+      rangeDecoders.emplace_back( new GzipDecoder( index ) );
+
+    int iRange;
+    #pragma omp parallel for schedule( static, 1 ) \
+                             private( iRange ) \
+                             default( shared )
+    for ( iRange = 0; iRange < static_cast<int>( ranges.size() ); ++iRange )
+    {
+      GzipDecoder& rangeDecoder = *rangeDecoders[ iRange ];
+      char *rangeBuffer = buffer.data() + previousSize + ( ranges[ iRange ].first - nextOffset );
+      size_t rangeSize = ranges[ iRange ].second - ranges[ iRange ].first;
+      size_t& bytesRead = rangeRead[ iRange ];
+      if ( rangeDecoder.seek( ranges[ iRange ].first ) == ranges[ iRange ].first )
+      {
+        size_t tmpRead;
+        while ( bytesRead < rangeSize &&
+                ( tmpRead = rangeDecoder.read( rangeBuffer + bytesRead, rangeSize - bytesRead ) ) > 0 )
+          bytesRead += tmpRead;
+      }
+    }
+
+    // A short range ends the valid data
+    size_t validSize = previousSize;
+    for ( size_t i = 0; i < ranges.size(); ++i )
+    {
+      validSize += rangeRead[ i ];
+      if ( rangeRead[ i ] < ranges[ i ].second - ranges[ i ].first )
+        break;
+    }
+    buffer.resize( validSize );
+    decoderInPlace = false;
+
+    return buffer.size() > previousSize;
   }
-  tmpLine[ i ] = '\0';
 #endif
-  strLine = tmpLine;
-  if ( strLine.back() == '\n' )
-    strLine.pop_back();
+
+  if ( !decoderInPlace )
+  {
+    if ( decoder->seek( nextOffset ) != nextOffset )
+      return false;
+    decoderInPlace = true;
+  }
+
+  return decoder->read( buffer, READ_SIZE ) > 0;
 }
 
 bool Compressed::eof()
 {
-  return gzeof( file );
+  return endOfFile;
 }
 
 void Compressed::seekbegin()
 {
-  gzseek( file, 0, SEEK_SET );
+  seekg( 0 );
 }
 
 void Compressed::seekend()
 {
-  gzseek( file, 0, SEEK_END );
+  if ( !isOpen )
+    return;
+
+  // Decompressing up to the end completes the index
+  if ( !index->isComplete() )
+  {
+    GzipDecoder endDecoder( index );
+    seekg( endDecoder.seek( std::numeric_limits<TTraceSize>::max() ) );
+  }
+  else
+    seekg( index->getUncompressedSize() );
 }
 
 void Compressed::seekg( streampos pos )
 {
-  gzseek( file, pos, SEEK_SET );
+  TTraceSize newPos = pos;
+  if ( newPos >= bufferOffset && newPos <= bufferOffset + buffer.size() )
+    bufferPos = newPos - bufferOffset;
+  else
+  {
+    buffer.clear();
+    bufferPos = 0;
+    bufferOffset = newPos;
+    decoderInPlace = false;
+  }
+  endOfFile = false;
 }
 
 streampos Compressed::tellg()
 {
-  return gztell( file );
+  return bufferOffset + bufferPos;
 }
 
 bool Compressed::canseekend()
 {
-  return false;
+  return isOpen && index->isComplete();
 }
 
 bool Compressed::good() const
 {
-  return file != nullptr;
+  return isOpen && !endOfFile;
 }
 
 void Compressed::clear()
-{}
+{
+  endOfFile = false;
+}
 
 int Compressed::peek()
 {
-  return gzgetc( file );
+  if ( bufferPos == buffer.size() && !fillBuffer() )
+  {
+    endOfFile = true;
+    return EOF;
+  }
+
+  return static_cast<unsigned char>( buffer[ bufferPos ] );
 }
 
+// Exact once the file has been decompressed, never decompressing it here
 TTraceSize Compressed::getTraceFileSize( const string& filename )
 {
   TTraceSize tmpSize;
-
-  Compressed tmpComp( filename );
-  if( !tmpComp.good() )
-  {
-    tmpComp.close();
-    return 0;
-  }
-  tmpComp.seekend();
-  tmpSize = tmpComp.tellg();
-  tmpComp.close();
-
-  return tmpSize;
+  if ( GzipIndex::getKnownUncompressedSize( filename, tmpSize ) )
+    return tmpSize;
+
+  TTraceSize compressedSize = NotCompressed::getTraceFileSize( filename );
+  tmpSize = compressedSize * GZIP_COMPRESSION_RATIO;
+
+  // The gzip trailer holds the size of the last member modulo 2^32,
+  // so the estimate is moved to the nearest size agreeing with it
+  std::ifstream tmpFile( filename.c_str(), std::ios::binary );
+  unsigned char trailer[ 4 ];
+  if ( compressedSize < 18 ||
+       !tmpFile.seekg( -4, std::ios::end ) ||
+       !tmpFile.read( reinterpret_cast<char *>( trailer ), sizeof( trailer ) ) )
+    return tmpSize;
+
+  const TTraceSize modulo = TTraceSize( 1 ) << 32;
+  TTraceSize lastMemberSize = TTraceSize( trailer[ 0 ] ) |
+                              TTraceSize( trailer[ 1 ] ) << 8 |
+                              TTraceSize( trailer[ 2 ] ) << 16 |
+                              TTraceSize( trailer[ 3 ] ) << 24;
+  TTraceSize agreeingSize = tmpSize - tmpSize % modulo + lastMemberSize;
+  if ( agreeingSize > tmpSize + modulo / 2 && agreeingSize >= modulo )
+    agreeingSize -= modulo;
+  else if ( agreeingSize + modulo / 2 < tmpSize )
+    agreeingSize += modulo;
+
+  return agreeingSize;
 }
@@ -358,6 +358,63 @@ TRecordTime VectorBlocks::getLastRecordTime() const
   return lastRecordTime;
 }
 
+void VectorBlocks::mergePartitions( std::vector< VectorBlocks * >& partitions )
+{
+  std::vector< TCommID > commOffsets;
+  TCommID totalComms = communications.size();
+  for( auto itPartition : partitions )
+  {
+    commOffsets.push_back( totalComms );
+    totalComms += itPartition->communications.size();
+  }
+
+  size_t iThread;
+  #pragma omp parallel for private( iThread ) \
+                           default( shared )
+  for( iThread = 0; iThread < threadRecords.size(); ++iThread )
+  {
+    auto &vectorThread = threadRecords[ iThread ];
+
+    size_t totalRecords = vectorThread.size();
+    for( auto itPartition : partitions )
+      totalRecords += itPartition->threadRecords[ iThread ].size() - 1;
+    vectorThread.reserve( totalRecords );
+
+    for( size_t iPartition = 0; iPartition < partitions.size(); ++iPartition )
+    {
+      auto &partitionThread = partitions[ iPartition ]->threadRecords[ iThread ];
+
+      // skip empty record
+      for( auto itRecord = ++partitionThread.begin(); itRecord != partitionThread.end(); ++itRecord )
+      {
+        vectorThread.emplace_back( *itRecord );
+        if( itRecord->type & ( COMM | RSEND | RRECV ) )
+          vectorThread.back().URecordInfo.commRecord.index += commOffsets[ iPartition ];
+      }
+
+      TThreadRecordContainer().swap( partitionThread );
+    }
+  }
+
+  communications.reserve( totalComms );
+  for( auto itPartition : partitions )
+  {
+    communications.insert( communications.end(),
+                           itPartition->communications.begin(),
+                           itPartition->communications.end() );
+    std::vector<Plain::TCommInfo>().swap( itPartition->communications );
+
+    if( itPartition->lastRecordTime > lastRecordTime )
+      lastRecordTime = itPartition->lastRecordTime;
+    countInserted += itPartition->countInserted;
+    itPartition->resetCountInserted();
+  }
+
+  // Records may have been moved by the merge
+  for( auto& c : commRecords )
+    c = nullptr;
+}
+
 void VectorBlocks::setFileLoaded( TRecordTime traceEndTime )
 {
   TRecord beginEmptyRecord;
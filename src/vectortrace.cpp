@@ -183,6 +183,23 @@ void VectorTrace::iterator::setStateEndTime( const TRecordTime whichEndTime )
     it->URecordInfo.stateRecord.endTime = whichEndTime;
 }
 
+TRecordSpan VectorTrace::iterator::getRecords() const
+{
+  if ( record != nullptr || it == myBlocks->threadRecords[ myThread ].end() )
+    return TRecordSpan{ nullptr, nullptr };
+
+  return TRecordSpan{ &( *it ), myBlocks->threadRecords[ myThread ].data() + myBlocks->threadRecords[ myThread ].size() };
+}
+
+void VectorTrace::iterator::skipRecords( size_t whichCount )
+{
+  if ( whichCount == 0 )
+    return;
+
+  record = nullptr;
+  size_t tmpRemaining = myBlocks->threadRecords[ myThread ].end() - it;
+  it += whichCount < tmpRemaining ? whichCount : tmpRemaining;
+}
 
 /********************************************************/
 /*                CPUIterator                           */
@@ -415,3 +432,37 @@ void VectorTrace::getRecordByTimeCPU( std::vector<MemoryTrace::iterator *>& list
   }
 }
 
+bool VectorTrace::getThreadRecords( TThreadOrder whichThread,
+                                    TRecordTime beginTime,
+                                    TRecordTime endTime,
+                                    std::vector<TRecordSpan>& spans ) const
+{
+  // Skip the empty records at both ends
+  const auto& v = myBlocks->threadRecords[ whichThread ];
+  if ( v.size() < 2 )
+    return true;
+
+  auto first = std::lower_bound( v.begin() + 1, v.end() - 1, beginTime, []( const auto& el, const auto& time ) { return el.time < time; } );
+  auto last = std::upper_bound( first, v.end() - 1, endTime, []( const auto& time, const auto& el ) { return time < el.time; } );
+  if ( first != last )
+    spans.push_back( TRecordSpan{ &( *first ), &( *first ) + ( last - first ) } );
+
+  return true;
+}
+
+bool VectorTrace::getCPURecords( TCPUOrder whichCPU,
+                                 TRecordTime beginTime,
+                                 TRecordTime endTime,
+                                 std::vector<TRecordPtrSpan>& spans ) const
+{
+  const auto& v = myBlocks->cpuRecords[ whichCPU ];
+  if ( v.size() < 2 )
+    return true;
+
+  auto first = std::lower_bound( v.begin() + 1, v.end() - 1, beginTime, []( const auto& el, const auto& time ) { return el->time < time; } );
+  auto last = std::upper_bound( first, v.end() - 1, endTime, []( const auto& time, const auto& el ) { return time < el->time; } );
+  if ( first != last )
+    spans.push_back( TRecordPtrSpan{ &( *first ), &( *first ) + ( last - first ) } );
+
+  return true;
+}
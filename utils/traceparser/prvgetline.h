@@ -25,6 +25,7 @@
 
 #include <string>
 #include <fstream>
+#include <sstream>
 
 template< class StreamT >
 void prvGetLine( StreamT& s, std::string& line )
@@ -37,3 +38,24 @@ inline void prvGetLine( std::fstream& s, std::string& line )
 {
   std::getline( s, line );
 }
+
+
+inline void prvGetLine( std::istringstream& s, std::string& line )
+{
+  std::getline( s, line );
+}
+
+
+template< class StreamT >
+void prvGetLine( StreamT& s, std::string& buffer, const char *&lineBegin, const char *&lineEnd )
+{
+  s.getlineView( lineBegin, lineEnd );
+}
+
+
+inline void prvGetLine( std::fstream& s, std::string& buffer, const char *&lineBegin, const char *&lineEnd )
+{
+  std::getline( s, buffer );
+  lineBegin = buffer.data();
+  lineEnd = lineBegin + buffer.size();
+}
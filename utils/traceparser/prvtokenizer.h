@@ -0,0 +1,187 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                               libparaver-api                              *
+ *                       Paraver Main Computing Library                      *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// .prv body fields are colon separated integers. These helpers work on
+// [begin, end) ranges pointing directly into the trace contents, so they
+// don't rely on a terminating character and keep no state.
+
+#if defined( _WIN32 ) || ( defined( __BYTE_ORDER__ ) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ )
+#define PRV_TOKENIZER_SWAR 1
+#endif
+
+/******************************************************************************
+******************        prvFindSeparator       ******************************
+******************************************************************************/
+// memchr is vectorized by the C library.
+inline const char *prvFindSeparator( const char *it, const char *end )
+{
+  const char *found = static_cast<const char *>( memchr( it, ':', end - it ) );
+  return found == nullptr ? end : found;
+}
+
+// Moves it past numFields separators; false if the range ends before.
+inline bool prvSkipFields( const char *&it, const char *end, int numFields )
+{
+  for ( int i = 0; i < numFields; ++i )
+  {
+    it = prvFindSeparator( it, end );
+    if ( it == end )
+      return false;
+    ++it;
+  }
+
+  return true;
+}
+
+/******************************************************************************
+******************        prvParseDigits       ********************************
+******************************************************************************/
+#ifdef PRV_TOKENIZER_SWAR
+inline bool prvEightDigits( uint64_t chunk )
+{
+  return ( ( chunk & 0xF0F0F0F0F0F0F0F0ULL ) |
+           ( ( ( chunk + 0x0606060606060606ULL ) & 0xF0F0F0F0F0F0F0F0ULL ) >> 4 ) ) == 0x3333333333333333ULL;
+}
+
+inline uint64_t prvDecodeEightDigits( uint64_t chunk )
+{
+  const uint64_t mask = 0x000000FF000000FFULL;
+
+  chunk -= 0x3030303030303030ULL;
+  chunk = ( chunk * 10 ) + ( chunk >> 8 );
+  return ( ( ( chunk & mask ) * ( 100 + ( 1000000ULL << 32 ) ) ) +
+           ( ( ( chunk >> 16 ) & mask ) * ( 1 + ( 10000ULL << 32 ) ) ) ) >> 32;
+}
+#endif
+
+// Decodes the digits at it, eight at a time while possible. Overflow wraps
+// like the former digit by digit loops.
+inline unsigned long long prvParseDigits( const char *&it, const char *end )
+{
+  unsigned long long value = 0;
+
+#ifdef PRV_TOKENIZER_SWAR
+  uint64_t chunk;
+  while ( end - it >= 8 )
+  {
+    memcpy( &chunk, it, sizeof( chunk ) );
+    if ( !prvEightDigits( chunk ) )
+      break;
+    value = value * 100000000ULL + prvDecodeEightDigits( chunk );
+    it += 8;
+  }
+#endif
+
+  while ( it != end && static_cast<unsigned char>( *it - '0' ) < 10 )
+    value = value * 10 + static_cast<unsigned char>( *it++ - '0' );
+
+  return value;
+}
+
+/******************************************************************************
+******************        prvReadField       **********************************
+******************************************************************************/
+// Reads one unsigned field and moves it past its ':' separator.
+// Fails if there is no digit at it.
+template <typename T>
+inline bool prvReadField( const char *&it, const char *end, T& value )
+{
+  if ( it == end || static_cast<unsigned char>( *it - '0' ) >= 10 )
+    return false;
+
+  value = static_cast<T>( prvParseDigits( it, end ) );
+
+  if ( it != end && *it == ':' )
+    ++it;
+
+  return true;
+}
+
+inline bool prvReadFields( const char *&it, const char *end, unsigned long long *fields, int numFields )
+{
+  for ( int i = 0; i < numFields; ++i )
+  {
+    if ( !prvReadField( it, end, fields[ i ] ) )
+      return false;
+  }
+
+  return true;
+}
+
+/******************************************************************************
+******************        prv_atoll_v       ***********************************
+******************************************************************************/
+template <typename IteratorT>
+constexpr bool prv_atoll_v( IteratorT& it, const IteratorT& end )
+{
+  return true;
+}
+
+template <typename T>
+inline void prv_atoll_digits( const char *&it, const char *end, T& result )
+{
+  result = static_cast<T>( prvParseDigits( it, end ) );
+}
+
+template <typename IteratorT, typename T>
+inline void prv_atoll_digits( IteratorT& it, const IteratorT& end, T& result )
+{
+  result = 0;
+  while( it != end && *it >= '0' && *it <= '9' )
+    result = ( result * 10 ) + ( *it++ - '0' );
+}
+
+// Doesn't rely on a terminating character: it can parse ranges that point
+// directly into the trace file contents. Every field is followed by any
+// one separator character.
+template <typename IteratorT, typename T, typename... Targs>
+inline bool prv_atoll_v( IteratorT& it, const IteratorT& end, T& result, Targs&... Fargs )
+{
+  result = 0;
+  int negative = 1;
+
+  if( it == end )
+    return false;
+
+  if( *it == '-' )
+  {
+    if( std::is_unsigned<T>::value )
+      return false;
+    negative = -1;
+    ++it;
+  }
+
+  prv_atoll_digits( it, end, result );
+  result *= negative;
+
+  if( it == end )
+    return sizeof...( Targs ) == 0;
+
+  return prv_atoll_v( ++it, end, Fargs... );
+}
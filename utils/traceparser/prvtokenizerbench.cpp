@@ -0,0 +1,258 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                               libparaver-api                              *
+ *                       Paraver Main Computing Library                      *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+
+
+// Micro-benchmark of the .prv field tokenizer on a synthetic trace body.
+// Every parser is checked against strtoull, so it also runs as a test.
+// Usage: prvtokenizerbench [lines]
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "prvtokenizer.h"
+
+using namespace std;
+
+namespace
+{
+  struct TLine
+  {
+    const char *begin;
+    const char *end;
+  };
+
+  struct TBody
+  {
+    string contents;
+    vector< TLine > lines;
+  };
+
+  // States, events with several pairs and communications, with times
+  // growing like in a real trace
+  void buildBody( size_t numLines, TBody& whichBody )
+  {
+    string& body = whichBody.contents;
+    vector< TLine >& lines = whichBody.lines;
+    mt19937_64 generator( 1 );
+    unsigned long long time = 0;
+
+    for ( size_t i = 0; i < numLines; ++i )
+    {
+      unsigned long long cpu = 1 + generator() % 64;
+      string tmpLine;
+
+      time += generator() % 5000;
+      switch ( generator() % 4 )
+      {
+        case 0:
+          tmpLine = "1:" + to_string( cpu ) + ":1:" + to_string( cpu ) + ":1:" + to_string( time ) + ":" +
+                    to_string( time + generator() % 100000 ) + ":" + to_string( generator() % 20 );
+          break;
+        case 3:
+          tmpLine = "3:" + to_string( cpu ) + ":1:" + to_string( cpu ) + ":1:" + to_string( time ) + ":" +
+                    to_string( time + 10 ) + ":" + to_string( 1 + generator() % 64 ) + ":1:1:1:" +
+                    to_string( time + 500 ) + ":" + to_string( time + 510 ) + ":" +
+                    to_string( generator() % 1000000 ) + ":" + to_string( generator() % 100 );
+          break;
+        default:
+          tmpLine = "2:" + to_string( cpu ) + ":1:" + to_string( cpu ) + ":1:" + to_string( time );
+          for ( unsigned int iPair = 0; iPair < 1 + generator() % 4; ++iPair )
+            tmpLine += ":" + to_string( 50000000 + generator() % 100 ) + ":" + to_string( generator() % 100000000000ULL );
+          break;
+      }
+      body += tmpLine + "\n";
+    }
+
+    const char *it = body.data();
+    const char *bodyEnd = body.data() + body.size();
+    while ( it != bodyEnd )
+    {
+      const char *lineEnd = static_cast< const char * >( memchr( it, '\n', bodyEnd - it ) );
+      lines.push_back( { it, lineEnd } );
+      it = lineEnd + 1;
+    }
+  }
+
+  unsigned long long sumStrtoull( const TBody& body )
+  {
+    unsigned long long sum = 0;
+    string tmpLine;
+    for ( const TLine& line : body.lines )
+    {
+      tmpLine.assign( line.begin + 2, line.end );
+      char *it = &tmpLine[ 0 ];
+      while ( *it != '\0' )
+      {
+        sum += strtoull( it, &it, 10 );
+        if ( *it == ':' )
+          ++it;
+      }
+    }
+    return sum;
+  }
+
+  unsigned long long sumReadField( const TBody& body )
+  {
+    unsigned long long sum = 0;
+    for ( const TLine& line : body.lines )
+    {
+      const char *it = line.begin + 2;
+      unsigned long long value;
+      while ( prvReadField( it, line.end, value ) )
+        sum += value;
+    }
+    return sum;
+  }
+
+  // Common fields of every record, as the loaders read them
+  unsigned long long sumAtollPointer( const TBody& body )
+  {
+    unsigned long long sum = 0;
+    for ( const TLine& line : body.lines )
+    {
+      const char *it = line.begin + 2;
+      unsigned long long cpu, appl, task, thread, time;
+      if ( prv_atoll_v( it, line.end, cpu, appl, task, thread, time ) )
+        sum += cpu + appl + task + thread + time;
+    }
+    return sum;
+  }
+
+  // Same on iterators, which takes the digit by digit path
+  unsigned long long sumAtollIterator( const TBody& body )
+  {
+    unsigned long long sum = 0;
+    for ( const TLine& line : body.lines )
+    {
+      string::const_iterator it = body.contents.cbegin() + ( line.begin - body.contents.data() ) + 2;
+      string::const_iterator end = body.contents.cbegin() + ( line.end - body.contents.data() );
+      unsigned long long cpu, appl, task, thread, time;
+      if ( prv_atoll_v( it, end, cpu, appl, task, thread, time ) )
+        sum += cpu + appl + task + thread + time;
+    }
+    return sum;
+  }
+
+  // Expected results: every field, the first five and the fifth one
+  void referenceSums( const TBody& body,
+                      unsigned long long& allFields,
+                      unsigned long long& commonFields,
+                      unsigned long long& times )
+  {
+    string tmpLine;
+    allFields = commonFields = times = 0;
+    for ( const TLine& line : body.lines )
+    {
+      tmpLine.assign( line.begin + 2, line.end );
+      char *it = &tmpLine[ 0 ];
+      for ( int i = 0; *it != '\0'; ++i )
+      {
+        unsigned long long value = strtoull( it, &it, 10 );
+        allFields += value;
+        if ( i < 5 )
+          commonFields += value;
+        if ( i == 4 )
+          times += value;
+        if ( *it == ':' )
+          ++it;
+      }
+    }
+  }
+
+  // Time of every record, skipping the fields before it
+  unsigned long long sumSkipFields( const TBody& body )
+  {
+    unsigned long long sum = 0;
+    for ( const TLine& line : body.lines )
+    {
+      const char *it = line.begin + 2;
+      unsigned long long time;
+      if ( prvSkipFields( it, line.end, 4 ) && prvReadField( it, line.end, time ) )
+        sum += time;
+    }
+    return sum;
+  }
+
+  unsigned long long sumTimes( const TBody& body )
+  {
+    unsigned long long sum = 0;
+    for ( const TLine& line : body.lines )
+    {
+      const char *it = line.begin + 2;
+      unsigned long long fields[ 5 ];
+      if ( prvReadFields( it, line.end, fields, 5 ) )
+        sum += fields[ 4 ];
+    }
+    return sum;
+  }
+
+  bool run( const string& name,
+            unsigned long long ( *parser )( const TBody& ),
+            const TBody& body,
+            unsigned long long expected )
+  {
+    auto timeBegin = chrono::steady_clock::now();
+    unsigned long long result = parser( body );
+    double seconds = chrono::duration< double >( chrono::steady_clock::now() - timeBegin ).count();
+
+    cout << setw( 20 ) << left << name << right
+         << setw( 10 ) << fixed << setprecision( 1 ) << seconds * 1e9 / body.lines.size() << " ns/line"
+         << setw( 10 ) << body.contents.size() / seconds / ( 1024 * 1024 ) << " MB/s";
+    if ( result != expected )
+    {
+      cout << "  WRONG RESULT" << endl;
+      return false;
+    }
+    cout << endl;
+    return true;
+  }
+}
+
+
+int main( int argc, char *argv[] )
+{
+  size_t numLines = argc > 1 ? strtoull( argv[ 1 ], nullptr, 10 ) : 1000000;
+  TBody body;
+
+  buildBody( numLines, body );
+  cout << body.lines.size() << " lines, " << body.contents.size() / ( 1024 * 1024 ) << " MB" << endl;
+
+  unsigned long long allFields, commonFields, times;
+  referenceSums( body, allFields, commonFields, times );
+
+  bool ok = true;
+  ok = run( "strtoull", sumStrtoull, body, allFields ) && ok;
+  ok = run( "prvReadField", sumReadField, body, allFields ) && ok;
+  ok = run( "prv_atoll_v pointer", sumAtollPointer, body, commonFields ) && ok;
+  ok = run( "prv_atoll_v iterator", sumAtollIterator, body, commonFields ) && ok;
+  ok = run( "prvReadFields", sumTimes, body, times ) && ok;
+  ok = run( "prvSkipFields", sumSkipFields, body, times ) && ok;
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
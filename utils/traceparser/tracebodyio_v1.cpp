@@ -21,6 +21,10 @@
  *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
 \*****************************************************************************/
 
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
 #include <iostream>
 #include <sstream>
 #include <fstream>
@@ -48,19 +52,6 @@
                    RecordTimeT, \
                    RecordT
 
-template< PARAM_TYPENAME >
-std::string TraceBodyIO_v1< PARAM_LIST >::multiEventLine;
-
-template< PARAM_TYPENAME >
-typename TraceBodyIO_v1< PARAM_LIST >::TMultiEventCommonInfo TraceBodyIO_v1< PARAM_LIST >::multiEventCommonInfo =
-        { nullptr, (TThreadOrder)0, (TCPUOrder)0, (RecordTimeT)0 };
-
-template< PARAM_TYPENAME >
-std::string TraceBodyIO_v1< PARAM_LIST >::line;
-
-template< PARAM_TYPENAME >
-std::ostringstream TraceBodyIO_v1< PARAM_LIST >::ostr;
-
 // Optimization on conversion string to numbers, but with no error control
 //#define USE_ATOLL
 // Even more optimization using custom function instead of atoll with error checking
@@ -83,114 +74,110 @@ void TraceBodyIO_v1< PARAM_LIST >::read( TraceStreamT& file,
                                          MetadataManagerT& traceInfo,
                                          RecordTimeT& endTime  ) const
 {
-  prvGetLine( file, line );
+  const char *lineBegin;
+  const char *lineEnd;
+
+  prvGetLine( file, line, lineBegin, lineEnd );
 
-  if ( line.size() == 0 )
+  if ( lineBegin == lineEnd )
     return;
 
-  switch ( line[0] )
+  if ( *lineBegin == CommentRecord )
+    readTraceInfo( std::string( lineBegin, lineEnd ), traceInfo );
+  else
+    readRecord( lineBegin, lineEnd, records, whichProcessModel, whichResourceModel, states, events );
+}
+
+template< PARAM_TYPENAME >
+void TraceBodyIO_v1< PARAM_LIST >::readRecord( const char *lineBegin,
+                                               const char *lineEnd,
+                                               RecordContainerT& records,
+                                               const ProcessModelT& whichProcessModel,
+                                               const ResourceModelT& whichResourceModel,
+                                               std::unordered_set<StateT>& states,
+                                               std::unordered_set<EventTypeT>& events ) const
+{
+  // Records fields begin after "<type>:"
+  if ( lineEnd - lineBegin < 2 )
   {
-    case CommentRecord:
-      readTraceInfo( line, traceInfo );
-      break;
+    std::cerr << "Unkwnown record type." << std::endl;
+    std::cerr << std::string( lineBegin, lineEnd ) << std::endl;
+    return;
+  }
 
+  switch ( *lineBegin )
+  {
     case StateRecord:
-      readState( line, whichProcessModel, whichResourceModel, records, states );
+      readState( lineBegin, lineEnd, whichProcessModel, whichResourceModel, records, states );
       break;
 
     case EventRecord:
-      readEvent( line, whichProcessModel, whichResourceModel, records, events );
+      readEvent( lineBegin, lineEnd, whichProcessModel, whichResourceModel, records, events );
       break;
 
     case CommRecord:
-      readComm( line, whichProcessModel, whichResourceModel, records );
+      readComm( lineBegin, lineEnd, whichProcessModel, whichResourceModel, records );
       break;
 
     case GlobalCommRecord:
-      //readGlobalComm( line, records );
+      //readGlobalComm( lineBegin, lineEnd, records );
       break;
 
     default:
       std::cerr << "Unkwnown record type." << std::endl;
-      std::cerr << line << std::endl;
+      std::cerr << std::string( lineBegin, lineEnd ) << std::endl;
       break;
   };
 }
 
-template< PARAM_TYPENAME >
-void TraceBodyIO_v1< PARAM_LIST >::bufferWrite( std::fstream& whichStream, bool writeReady, bool lineClear ) const
-{
-  if ( writeReady )
-  {
-    whichStream << line << '\n';
-    if ( lineClear )
-      line.clear();
-  }
-}
-
 template< PARAM_TYPENAME >
 void TraceBodyIO_v1< PARAM_LIST >::write( std::fstream& whichStream,
                             const ProcessModelT& whichProcessModel,
                             const ResourceModelT& whichResourceModel,
                             RecordT *record ) const
 {
-  bool writeReady = false;
   TRecordType type = record->getRecordType();
-  line.clear();
 
   if ( type == EMPTYREC )
   {
-    writeReady = writePendingMultiEvent( whichProcessModel );
-    bufferWrite( whichStream, writeReady );
+    writePendingMultiEvent( whichProcessModel );
+    flushBuffer();
   }
-  else
+  else if ( type & STATE )
   {
-    if ( type & STATE )
-    {
-      writeReady = writePendingMultiEvent( whichProcessModel );
-      bufferWrite( whichStream, writeReady );
-      writeReady = writeState( whichProcessModel, whichResourceModel, record );
-    }
-    else if ( type & EVENT )
-    {
-      if ( !sameMultiEvent( record ) )
-      {
-        writeReady = writePendingMultiEvent( whichProcessModel );
-
-        multiEventCommonInfo.myStream = &whichStream;
-        multiEventCommonInfo.cpu = record->getCPU();
-        multiEventCommonInfo.thread = record->getThread();
-        multiEventCommonInfo.time = record->getTime();
-
-        multiEventLine.clear();
-      }
-
-      appendEvent( record );
-    }
-    else if ( type & COMM )
+    writePendingMultiEvent( whichProcessModel );
+    writeState( whichStream, whichProcessModel, whichResourceModel, record );
+  }
+  else if ( type & EVENT )
+  {
+    if ( !sameMultiEvent( record ) )
     {
-      writeReady = writePendingMultiEvent( whichProcessModel );
-      bufferWrite( whichStream, writeReady );
+      writePendingMultiEvent( whichProcessModel );
 
-      writeReady = writeComm( whichProcessModel, whichResourceModel, record );
-    }
-    else if ( type & GLOBCOMM )
-    {
-      writeReady = writePendingMultiEvent( whichProcessModel );
-      bufferWrite( whichStream, writeReady );
+      multiEventCommonInfo.myStream = &whichStream;
+      multiEventCommonInfo.cpu = record->getCPU();
+      multiEventCommonInfo.thread = record->getThread();
+      multiEventCommonInfo.time = record->getTime();
 
-      writeReady = writeGlobalComm( whichProcessModel, record );
-    }
-    else if ( type & RSEND || type & RRECV )
-      writeReady = false;
-    else
-    {
-      writeReady = false;
-      std::cerr << "TraceBodyIO_v1::write()" << std::endl;
-      std::cerr << "Unkwnown record type in memory." << std::endl;
+      multiEventLine.clear();
     }
 
-    bufferWrite( whichStream, writeReady, false );
+    appendEvent( record );
+  }
+  else if ( type & COMM )
+  {
+    writePendingMultiEvent( whichProcessModel );
+    writeComm( whichStream, whichProcessModel, whichResourceModel, record );
+  }
+  else if ( type & GLOBCOMM )
+  {
+    writePendingMultiEvent( whichProcessModel );
+    writeGlobalComm( whichStream, whichProcessModel, record );
+  }
+  else if ( !( type & RSEND || type & RRECV ) )
+  {
+    std::cerr << "TraceBodyIO_v1::write()" << std::endl;
+    std::cerr << "Unkwnown record type in memory." << std::endl;
   }
 }
 
@@ -226,7 +213,8 @@ inline void TraceBodyIO_v1< PARAM_LIST >::readTraceInfo( const std::string& line
 }
 
 template< PARAM_TYPENAME >
-inline void TraceBodyIO_v1< PARAM_LIST >::readState( const std::string& line,
+inline void TraceBodyIO_v1< PARAM_LIST >::readState( const char *lineBegin,
+                                       const char *lineEnd,
                                        const ProcessModelT& whichProcessModel,
                                        const ResourceModelT& whichResourceModel,
                                        RecordContainerT& records,
@@ -240,20 +228,20 @@ inline void TraceBodyIO_v1< PARAM_LIST >::readState( const std::string& line,
   RecordTimeT endtime;
   StateT state;
 
-  auto it = line.begin() + 2;
+  const char *it = lineBegin + 2;
 
   // Read the common info
-  if ( !readCommon( whichProcessModel, whichResourceModel, it, line.cend(), CPU, appl, task, thread, time ) )
+  if ( !readCommon( whichProcessModel, whichResourceModel, it, lineEnd, CPU, appl, task, thread, time ) )
   {
     std::cerr << "Error reading state record." << std::endl;
-    std::cerr << line << std::endl;
+    std::cerr << std::string( lineBegin, lineEnd ) << std::endl;
     return;
   }
 
-  if( !prv_atoll_v( it, line.cend(), endtime, state ) )
+  if( !prv_atoll_v( it, lineEnd, endtime, state ) )
   {
     std::cerr << "Error reading state record." << std::endl;
-    std::cerr << line << std::endl;
+    std::cerr << std::string( lineBegin, lineEnd ) << std::endl;
     return;
   }
 
@@ -281,7 +269,8 @@ inline void TraceBodyIO_v1< PARAM_LIST >::readState( const std::string& line,
 }
 
 template< PARAM_TYPENAME >
-inline void TraceBodyIO_v1< PARAM_LIST >::readEvent( const std::string& line,
+inline void TraceBodyIO_v1< PARAM_LIST >::readEvent( const char *lineBegin,
+                                       const char *lineEnd,
                                        const ProcessModelT& whichProcessModel,
                                        const ResourceModelT& whichResourceModel,
                                        RecordContainerT& records,
@@ -295,23 +284,23 @@ inline void TraceBodyIO_v1< PARAM_LIST >::readEvent( const std::string& line,
   EventTypeT eventtype;
   TEventValue eventvalue;
 
-  auto it = line.begin() + 2;
+  const char *it = lineBegin + 2;
 
   // Read the common info
-  if ( !readCommon( whichProcessModel, whichResourceModel, it, line.cend(), CPU, appl, task, thread, time ) )
+  if ( !readCommon( whichProcessModel, whichResourceModel, it, lineEnd, CPU, appl, task, thread, time ) )
   {
     std::cerr << "Error reading event record." << std::endl;
-    std::cerr << line << std::endl;
+    std::cerr << std::string( lineBegin, lineEnd ) << std::endl;
     return;
   }
 
   thread = whichProcessModel.getGlobalThread( appl - 1, task - 1, thread - 1 );
-  while ( it != line.end() )
+  while ( it != lineEnd )
   {
-    if( !prv_atoll_v( it, line.cend(), eventtype, eventvalue ) )
+    if( !prv_atoll_v( it, lineEnd, eventtype, eventvalue ) )
     {
       std::cerr << "Error reading event record." << std::endl;
-      std::cerr << line << std::endl;
+      std::cerr << std::string( lineBegin, lineEnd ) << std::endl;
       return;
     }
 
@@ -328,7 +317,8 @@ inline void TraceBodyIO_v1< PARAM_LIST >::readEvent( const std::string& line,
 }
 
 template< PARAM_TYPENAME >
-inline void TraceBodyIO_v1< PARAM_LIST >::readComm( const std::string& line,
+inline void TraceBodyIO_v1< PARAM_LIST >::readComm( const char *lineBegin,
+                                      const char *lineEnd,
                                       const ProcessModelT& whichProcessModel,
                                       const ResourceModelT& whichResourceModel,
                                       RecordContainerT& records ) const
@@ -348,28 +338,28 @@ inline void TraceBodyIO_v1< PARAM_LIST >::readComm( const std::string& line,
   TCommSize commSize;
   TCommTag commTag;
 
-  auto it = line.begin() + 2;
+  const char *it = lineBegin + 2;
 
   // Read the common info
-  if ( !readCommon( whichProcessModel, whichResourceModel, it, line.cend(), CPU, appl, task, thread, logSend ) )
+  if ( !readCommon( whichProcessModel, whichResourceModel, it, lineEnd, CPU, appl, task, thread, logSend ) )
   {
     std::cerr << "Error reading communication record." << std::endl;
-    std::cerr << line << std::endl;
+    std::cerr << std::string( lineBegin, lineEnd ) << std::endl;
     return;
   }
 
-  if( !prv_atoll_v( it, line.cend(), phySend, remoteCPU, remoteAppl, remoteTask, remoteThread, logReceive, phyReceive, commSize, commTag ) ||
+  if( !prv_atoll_v( it, lineEnd, phySend, remoteCPU, remoteAppl, remoteTask, remoteThread, logReceive, phyReceive, commSize, commTag ) ||
       phySend < 0.0 || logReceive < 0.0 || phyReceive < 0.0 )
   {
     std::cerr << "Error reading communication record." << std::endl;
-    std::cerr << line << std::endl;
+    std::cerr << std::string( lineBegin, lineEnd ) << std::endl;
     return;
   }
 
   if( !validRecordLocation( whichProcessModel, whichResourceModel, remoteCPU, remoteAppl, remoteTask, remoteThread ) )
   {
     std::cerr << "Error reading communication record." << std::endl;
-    std::cerr << line << std::endl;
+    std::cerr << std::string( lineBegin, lineEnd ) << std::endl;
     return;
   }
 
@@ -390,15 +380,15 @@ inline void TraceBodyIO_v1< PARAM_LIST >::readComm( const std::string& line,
 
 
 template< PARAM_TYPENAME >
-inline void TraceBodyIO_v1< PARAM_LIST >::readGlobalComm( const std::string& line, RecordContainerT& records ) const
+inline void TraceBodyIO_v1< PARAM_LIST >::readGlobalComm( const char *lineBegin, const char *lineEnd, RecordContainerT& records ) const
 {}
 
 
 template< PARAM_TYPENAME >
 inline bool TraceBodyIO_v1< PARAM_LIST >::readCommon( const ProcessModelT& whichProcessModel,
                                         const ResourceModelT& whichResourceModel,
-                                        std::string::const_iterator& it,
-                                        const std::string::const_iterator& end,
+                                        const char *&it,
+                                        const char *end,
                                         TCPUOrder& CPU,
                                         TApplOrder& appl,
                                         TTaskOrder& task,
@@ -415,24 +405,75 @@ inline bool TraceBodyIO_v1< PARAM_LIST >::readCommon( const ProcessModelT& which
   Write records functions
 ***************************/
 template< PARAM_TYPENAME >
-bool TraceBodyIO_v1< PARAM_LIST >::writeState( const ProcessModelT& whichProcessModel,
+template< typename T >
+inline void TraceBodyIO_v1< PARAM_LIST >::appendNumber( std::string& buffer, T value )
+{
+  char tmp[ 24 ];
+  std::to_chars_result result = std::to_chars( tmp, tmp + sizeof( tmp ), value );
+  buffer.append( tmp, result.ptr );
+}
+
+// Same output as a fixed stream with precision 0
+template< PARAM_TYPENAME >
+inline void TraceBodyIO_v1< PARAM_LIST >::appendNumber( std::string& buffer, double value )
+{
+  if ( value == std::floor( value ) && std::fabs( value ) < 9.0e18 )
+  {
+    appendNumber( buffer, (long long)value );
+    return;
+  }
+
+  char tmp[ 512 ];
+  int length = snprintf( tmp, sizeof( tmp ), "%.0f", value );
+  buffer.append( tmp, std::min( length, (int)sizeof( tmp ) - 1 ) );
+}
+
+template< PARAM_TYPENAME >
+void TraceBodyIO_v1< PARAM_LIST >::flushBuffer() const
+{
+  if ( outputStream != nullptr && !outputBuffer.empty() )
+    outputStream->write( outputBuffer.data(), outputBuffer.size() );
+
+  outputBuffer.clear();
+}
+
+template< PARAM_TYPENAME >
+inline void TraceBodyIO_v1< PARAM_LIST >::beginRecord( std::fstream& whichStream ) const
+{
+  if ( outputStream != &whichStream )
+  {
+    flushBuffer();
+    outputStream = &whichStream;
+    outputBuffer.reserve( OutputBufferSize + 4096 );
+  }
+}
+
+template< PARAM_TYPENAME >
+inline void TraceBodyIO_v1< PARAM_LIST >::endRecord() const
+{
+  outputBuffer += '\n';
+  if ( outputBuffer.size() >= OutputBufferSize )
+    flushBuffer();
+}
+
+template< PARAM_TYPENAME >
+bool TraceBodyIO_v1< PARAM_LIST >::writeState( std::fstream& whichStream,
+                                 const ProcessModelT& whichProcessModel,
                                  const ResourceModelT& whichResourceModel,
                                  const RecordT *record ) const
 {
   if ( record->getRecordType() & END )
     return false;
 
-  ostr.clear();
-  ostr.str( "" );
-  ostr << std::fixed;
-  ostr << std::dec;
-  ostr.precision( 0 );
-
-  ostr << StateRecord << ':';
-  writeCommon( ostr, whichProcessModel, whichResourceModel, record );
-  ostr << record->getStateEndTime() << ':' << record->getState();
+  beginRecord( whichStream );
+  outputBuffer += StateRecord;
+  outputBuffer += ':';
+  writeCommon( whichProcessModel, whichResourceModel, record );
+  appendNumber( outputBuffer, record->getStateEndTime() );
+  outputBuffer += ':';
+  appendNumber( outputBuffer, record->getState() );
+  endRecord();
 
-  line += ostr.str();
   return true;
 }
 
@@ -448,24 +489,24 @@ bool TraceBodyIO_v1< PARAM_LIST >::writePendingMultiEvent( const ProcessModelT&
 
   if ( writeLine )
   {
-    ostr.clear();
-    ostr.str( "" );
-    ostr << std::fixed;
-    ostr << std::dec;
-    ostr.precision( 0 );
-
-    ostr << EventRecord << ':';
-    ostr << multiEventCommonInfo.cpu << ':';
+    beginRecord( *multiEventCommonInfo.myStream );
+    outputBuffer += EventRecord;
+    outputBuffer += ':';
+    appendNumber( outputBuffer, multiEventCommonInfo.cpu );
+    outputBuffer += ':';
 
     whichProcessModel.getThreadLocation( multiEventCommonInfo.thread, appl, task, thread );
-    ostr << appl + 1 << ':' << task + 1 << ':' << thread + 1 << ':';
-
-    ostr << multiEventCommonInfo.time << ':';
-    ostr << multiEventLine;
-
-    line += ostr.str();
-
-    bufferWrite( *multiEventCommonInfo.myStream, true );
+    appendNumber( outputBuffer, appl + 1 );
+    outputBuffer += ':';
+    appendNumber( outputBuffer, task + 1 );
+    outputBuffer += ':';
+    appendNumber( outputBuffer, thread + 1 );
+    outputBuffer += ':';
+
+    appendNumber( outputBuffer, multiEventCommonInfo.time );
+    outputBuffer += ':';
+    outputBuffer += multiEventLine;
+    endRecord();
 
     multiEventCommonInfo.myStream = nullptr;
     multiEventCommonInfo.cpu = 0;
@@ -482,23 +523,18 @@ bool TraceBodyIO_v1< PARAM_LIST >::writePendingMultiEvent( const ProcessModelT&
 template< PARAM_TYPENAME >
 void TraceBodyIO_v1< PARAM_LIST >::appendEvent( const RecordT *record ) const
 {
-  ostr.clear();
-  ostr.str( "" );
-  ostr << std::fixed;
-  ostr << std::dec;
-  ostr.precision( 0 );
-
   if ( !multiEventLine.empty() )
-    ostr << ':';
+    multiEventLine += ':';
 
-  ostr << record->getEventType() << ':' << record->getEventValueAsIs();
-
-  multiEventLine += ostr.str();
+  appendNumber( multiEventLine, record->getEventType() );
+  multiEventLine += ':';
+  appendNumber( multiEventLine, record->getEventValueAsIs() );
 }
 
 
 template< PARAM_TYPENAME >
-bool TraceBodyIO_v1< PARAM_LIST >::writeComm( const ProcessModelT& whichProcessModel,
+bool TraceBodyIO_v1< PARAM_LIST >::writeComm( std::fstream& whichStream,
+                                const ProcessModelT& whichProcessModel,
                                 const ResourceModelT& whichResourceModel,
                                 const RecordT *record ) const
 {
@@ -506,45 +542,55 @@ bool TraceBodyIO_v1< PARAM_LIST >::writeComm( const ProcessModelT& whichProcessM
   TTaskOrder recvTask;
   TThreadOrder recvThread;
 
-  ostr.clear();
-  ostr.str( "" );
-  ostr << std::fixed;
-  ostr << std::dec;
-  ostr.precision( 0 );
-
   if ( !( record->getRecordType() == ( COMM + LOG + SEND ) ) )
     return false;
 
-  ostr << CommRecord << ':';
-  writeCommon( ostr, whichProcessModel, whichResourceModel, record );
-  ostr << record->getPhysicalSend() << ':';
+  beginRecord( whichStream );
+  outputBuffer += CommRecord;
+  outputBuffer += ':';
+  writeCommon( whichProcessModel, whichResourceModel, record );
+  appendNumber( outputBuffer, record->getPhysicalSend() );
+  outputBuffer += ':';
   if ( whichResourceModel.isReady() )
-    ostr << record->getReceiverCPU() << ':';
+    appendNumber( outputBuffer, record->getReceiverCPU() );
   else
-    ostr << '0' << ':';
+    outputBuffer += '0';
+  outputBuffer += ':';
   whichProcessModel.getThreadLocation( record->getReceiverThread(),
                                 recvAppl, recvTask, recvThread );
-  ostr << recvAppl + 1 << ':' << recvTask + 1 << ':' << recvThread + 1 << ':';
-  ostr << record->getLogicalReceive() << ':';
-  ostr << record->getPhysicalReceive() << ':';
-
-  ostr << record->getCommSize() << ':';
-  ostr << record->getCommTag();
+  appendNumber( outputBuffer, recvAppl + 1 );
+  outputBuffer += ':';
+  appendNumber( outputBuffer, recvTask + 1 );
+  outputBuffer += ':';
+  appendNumber( outputBuffer, recvThread + 1 );
+  outputBuffer += ':';
+  appendNumber( outputBuffer, record->getLogicalReceive() );
+  outputBuffer += ':';
+  appendNumber( outputBuffer, record->getPhysicalReceive() );
+  outputBuffer += ':';
+
+  appendNumber( outputBuffer, record->getCommSize() );
+  outputBuffer += ':';
+  appendNumber( outputBuffer, record->getCommTag() );
+  endRecord();
 
-  line += ostr.str();
   return true;
 }
 
+// Global communications are not supported: only an empty line is written
 template< PARAM_TYPENAME >
-bool TraceBodyIO_v1< PARAM_LIST >::writeGlobalComm( const ProcessModelT& whichProcessModel,
+bool TraceBodyIO_v1< PARAM_LIST >::writeGlobalComm( std::fstream& whichStream,
+                                      const ProcessModelT& whichProcessModel,
                                       const RecordT *record ) const
 {
+  beginRecord( whichStream );
+  endRecord();
+
   return true;
 }
 
 template< PARAM_TYPENAME >
-void TraceBodyIO_v1< PARAM_LIST >::writeCommon( std::ostringstream& line,
-                                  const ProcessModelT& whichProcessModel,
+void TraceBodyIO_v1< PARAM_LIST >::writeCommon( const ProcessModelT& whichProcessModel,
                                   const ResourceModelT& whichResourceModel,
                                   const RecordT *record ) const
 {
@@ -553,13 +599,20 @@ void TraceBodyIO_v1< PARAM_LIST >::writeCommon( std::ostringstream& line,
   TThreadOrder thread;
 
   if ( whichResourceModel.isReady() )
-    line << record->getCPU() << ':';
+    appendNumber( outputBuffer, record->getCPU() );
   else
-    line << '0' << ':';
+    outputBuffer += '0';
+  outputBuffer += ':';
 
   whichProcessModel.getThreadLocation( record->getThread(), appl, task, thread );
-  line << appl + 1 << ':' << task + 1 << ':' << thread + 1 << ':';
-  line << record->getTime() << ':';
+  appendNumber( outputBuffer, appl + 1 );
+  outputBuffer += ':';
+  appendNumber( outputBuffer, task + 1 );
+  outputBuffer += ':';
+  appendNumber( outputBuffer, thread + 1 );
+  outputBuffer += ':';
+  appendNumber( outputBuffer, record->getTime() );
+  outputBuffer += ':';
 }
 
 
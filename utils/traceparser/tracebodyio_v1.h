@@ -25,49 +25,9 @@
 
 #include <string>
 
+#include "prvtokenizer.h"
 #include "tracebodyio.h"
 
-/******************************************************************************
-******************        prv_atoll_v       ***********************************
-******************************************************************************/
-constexpr bool prv_atoll_v( std::string::const_iterator& it, const std::string::const_iterator& end )
-{
-  return true;
-}
-
-template <typename T, typename... Targs>
-constexpr bool prv_atoll_v( std::string::const_iterator& it, const std::string::const_iterator& end, T& result, Targs&... Fargs )
-{
-  result = 0;
-  int negative = 1;
-
-  if( it == end )
-    return false;
-
-  if( *it == '-' )
-  {
-    if( std::is_unsigned<T>::value )
-      return false;
-    negative = -1;
-    ++it;
-  }
-
-  if( *it >= '0' && *it <= '9' )
-  {
-    result = ( *it++ - '0' );
-    while( *it >= '0' && *it <= '9' )
-      result = ( result * 10 ) + ( *it++ - '0' );
-
-    result *= negative;
-  }
-
-  if( it == end )
-    return sizeof...( Targs ) == 0;
-
-  return prv_atoll_v( ++it, end, Fargs... );
-}
-
-
 template< class    TraceStreamT,
           class    RecordContainerT,
           class    ProcessModelT,
@@ -105,11 +65,24 @@ class TraceBodyIO_v1 : public TraceBodyIO<TraceStreamT,
                std::unordered_set<EventTypeT>& events,
                MetadataManagerT& traceInfo,
                RecordTimeT& endTime ) const override;
+    // Parses one already read body line that is not a comment.
+    // It doesn't use any static buffer, so it can be called concurrently
+    // as long as every caller fills its own records container.
+    void readRecord( const char *lineBegin,
+                     const char *lineEnd,
+                     RecordContainerT& records,
+                     const ProcessModelT& whichProcessModel,
+                     const ResourceModelT& whichResourceModel,
+                     std::unordered_set<StateT>& states,
+                     std::unordered_set<EventTypeT>& events ) const;
     void write( std::fstream& whichStream,
                 const ProcessModelT& whichProcessModel,
                 const ResourceModelT& whichResourceModel,
                 RecordT *record ) const override;
     bool writePendingMultiEvent( const ProcessModelT& whichProcessModel ) const;
+    // Records are kept in a buffer until it is full, the output stream
+    // changes or an empty record is written.
+    void flushBuffer() const;
 
   protected:
 
@@ -126,11 +99,17 @@ class TraceBodyIO_v1 : public TraceBodyIO<TraceStreamT,
     }
     TMultiEventCommonInfo;
 
-    static TMultiEventCommonInfo multiEventCommonInfo;
-    static std::string multiEventLine;
+    static constexpr size_t OutputBufferSize = 4194304;
 
-    static std::string line;
-    static std::ostringstream ostr;
+    mutable TMultiEventCommonInfo multiEventCommonInfo = { nullptr, (TThreadOrder)0, (TCPUOrder)0, (RecordTimeT)0 };
+    mutable std::string multiEventLine;
+
+    mutable std::fstream *outputStream = nullptr;
+    mutable std::string outputBuffer;
+
+    // Every instance keeps its own state, so several traces can be read
+    // or written at once from different threads.
+    mutable std::string line;
 
     bool validRecordLocation( const ProcessModelT& whichProcessModel,
                               const ResourceModelT& whichResourceModel,
@@ -141,47 +120,54 @@ class TraceBodyIO_v1 : public TraceBodyIO<TraceStreamT,
 
     void readTraceInfo( const std::string& line, MetadataManagerT& traceInfo ) const;
 
-    void readState( const std::string& line,
+    void readState( const char *lineBegin,
+                    const char *lineEnd,
                     const ProcessModelT& whichProcessModel,
                     const ResourceModelT& whichResourceModel,
                     RecordContainerT& records,
                     std::unordered_set<StateT>& states ) const;
-    void readEvent( const std::string& line,
+    void readEvent( const char *lineBegin,
+                    const char *lineEnd,
                     const ProcessModelT& whichProcessModel,
                     const ResourceModelT& whichResourceModel,
                     RecordContainerT& records,
                     std::unordered_set<EventTypeT>& events ) const;
-    void readComm( const std::string& line,
+    void readComm( const char *lineBegin,
+                   const char *lineEnd,
                    const ProcessModelT& whichProcessModel,
                    const ResourceModelT& whichResourceModel,
                    RecordContainerT& records ) const;
-    void readGlobalComm( const std::string& line, RecordContainerT& records ) const;
+    void readGlobalComm( const char *lineBegin, const char *lineEnd, RecordContainerT& records ) const;
     bool readCommon( const ProcessModelT& whichProcessModel,
                      const ResourceModelT& whichResourceModel,
-                     std::string::const_iterator& it,
-                     const std::string::const_iterator& end,
+                     const char *&it,
+                     const char *end,
                      TCPUOrder& CPU,
                      TApplOrder& appl,
                      TTaskOrder& task,
                      TThreadOrder& thread,
                      RecordTimeT& time ) const;
 
-    void bufferWrite( std::fstream& whichStream, bool writeReady, bool lineClear = true  ) const;
+    template< typename T >
+    static void appendNumber( std::string& buffer, T value );
+    static void appendNumber( std::string& buffer, double value );
 
-    bool writeState( const ProcessModelT& whichProcessModel,
+    void beginRecord( std::fstream& whichStream ) const;
+    void endRecord() const;
+
+    bool writeState( std::fstream& whichStream,
+                     const ProcessModelT& whichProcessModel,
                      const ResourceModelT& whichResourceModel,
                      const RecordT *record ) const;
     void appendEvent( const RecordT *record ) const;
-    bool writeEvent( const ProcessModelT& whichProcessModel,
-                     const RecordT *record,
-                     bool needCommons = true ) const;
-    bool writeComm( const ProcessModelT& whichProcessModel,
+    bool writeComm( std::fstream& whichStream,
+                    const ProcessModelT& whichProcessModel,
                     const ResourceModelT& whichResourceModel,
                     const RecordT *record ) const;
-    bool writeGlobalComm( const ProcessModelT& whichProcessModel,
+    bool writeGlobalComm( std::fstream& whichStream,
+                          const ProcessModelT& whichProcessModel,
                           const RecordT *record ) const;
-    void writeCommon( std::ostringstream& line,
-                      const ProcessModelT& whichProcessModel,
+    void writeCommon( const ProcessModelT& whichProcessModel,
                       const ResourceModelT& whichResourceModel,
                       const RecordT *record ) const;
 